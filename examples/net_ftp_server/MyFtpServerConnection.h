@@ -382,47 +382,48 @@ inline void MyFtpServerConnection::printFileName(const FileInformation& finfo) {
 
 
 /**
- * Print out all file information
+ * Print out all file information. The line is formatted on the stack because the data
+ * connection copies it into its transfer buffer.
  */
 
 inline void MyFtpServerConnection::printFileDetails(const FileInformation& finfo) {
 
-  std::string str;
-  char buffer[20];
+  char line[300],*ptr;
   uint32_t len;
 
   // permissions string
 
   if((finfo.getAttributes() & FileInformation::ATTR_DIRECTORY)==0)
-    str="-";
+    line[0]='-';
   else
-    str="d";
+    line[0]='d';
 
   if((finfo.getAttributes() & FileInformation::ATTR_READ_ONLY)==0)
-    str+="r-xr-xr-x";
+    strcpy(line+1,"r-xr-xr-x");
   else
-    str+="rwxrwxrwx";
+    strcpy(line+1,"rwxrwxrwx");
 
   // owner/group (n/a)
 
-  str+="   1      owner      group ";
+  strcat(line,"   1      owner      group ");
 
   // size (pad to 10)
 
-  len=StringUtil::modp_uitoa10(finfo.getLength(),buffer);
-  memset(buffer+len,' ',10-len);
-  buffer[10]='\0';
+  ptr=line+strlen(line);
+  len=StringUtil::modp_uitoa10(finfo.getLength(),ptr);
 
-  str+=buffer;
+  if(len<10)
+    memset(ptr+len,' ',10-len);
+  ptr[10]='\0';
 
   // date (fake this)
 
-  str+=" Jan  1  1980 ";
-  str+=finfo.getFilename();
+  strcat(line," Jan  1  1980 ");
+  strncat(line,finfo.getFilename(),sizeof(line)-strlen(line)-1);
 
   // add to the output
 
-  _dataConnection->addString(str.c_str());
+  _dataConnection->addString(line);
 }
 
 
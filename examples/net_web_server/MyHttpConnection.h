@@ -43,7 +43,7 @@ class MyHttpConnection : public HttpServerConnection<MyHttpConnection> {
   protected:
     void processRequest();
     void closeFile();
-    FileInputStream *getErrorPageStream(const std::string& errorCode);
+    FileInputStream *getErrorPageStream(const char *errorCode);
 
   public:
     MyHttpConnection(const Parameters& params,FileSystem *fs);
@@ -52,7 +52,7 @@ class MyHttpConnection : public HttpServerConnection<MyHttpConnection> {
     bool handleClosed();
     bool handleCallback();
     State handleStateChange(State newState);
-    void handleRequestHeader(const std::string&);
+    void handleRequestHeader(const HttpStringSpan& name,const HttpStringSpan& value);
 };
 
 
@@ -131,10 +131,11 @@ inline HttpServerConnection<MyHttpConnection>::State MyHttpConnection::handleSta
 
 /**
  * We don't process headers
- * @param
+ * @param name The header name
+ * @param value The header value
  */
 
-inline void MyHttpConnection::handleRequestHeader(const std::string&) {
+inline void MyHttpConnection::handleRequestHeader(const HttpStringSpan& /* name */,const HttpStringSpan& /* value */) {
 }
 
 
@@ -146,23 +147,27 @@ inline void MyHttpConnection::processRequest() {
 
   std::string *response;
   FileInputStream *fis;
+  bool errorPage;
 
   fis=nullptr;
+  errorPage=true;
+  response=new std::string(getVersionString());
 
-  if(!strcasecmp(_action.c_str(),"GET")) {
+  if(_action.equals("GET")) {
 
-    if(_fs->openFile(_uri.c_str(),_file)) {
+    if(_fs->openFile(_uri,_file)) {
 
-      response=new std::string(_version+" 200 OK\r\n");
+      (*response)+=" 200 OK\r\n";
       fis=new FileInputStream(*_file);
+      errorPage=false;
     }
     else {
-      response=new std::string(_version+" 404 Not Found\r\n");
+      (*response)+=" 404 Not Found\r\n";
       fis=getErrorPageStream("404");
     }
   }
   else {
-    response=new std::string(_version+" 501 Not Implemented\r\n");
+    (*response)+=" 501 Not Implemented\r\n";
     fis=getErrorPageStream("501");
   }
 
@@ -171,7 +176,12 @@ inline void MyHttpConnection::processRequest() {
   addConnectionHeader(*response);
 
   if(fis) {
-    addContentTypeHeader(*response);
+
+    if(errorPage)
+      addContentTypeHeader(*response,"text/html");
+    else
+      addContentTypeHeader(*response);
+
     addContentLengthHeader(*response,_file->getLength());
   }
 
@@ -188,13 +198,16 @@ inline void MyHttpConnection::processRequest() {
 
 /**
  * Get a new stream on to an error page. First /errors/<code>.html is checked and then /error.html
- * is checked. The URI is adjusted accordingly.
+ * is checked.
  * @return An input stream on to the file
  */
 
-inline FileInputStream *MyHttpConnection::getErrorPageStream(const std::string& errorCode) {
+inline FileInputStream *MyHttpConnection::getErrorPageStream(const char *errorCode) {
+
+  std::string filename("/errors/");
 
-  std::string filename("/errors/"+errorCode+".html");
+  filename+=errorCode;
+  filename+=".html";
 
   // first try the specific error page
 
@@ -202,14 +215,12 @@ inline FileInputStream *MyHttpConnection::getErrorPageStream(const std::string&
 
     // now try the generic error page
 
-    filename="/error.html";
-    if(!_fs->openFile(filename.c_str(),_file))
+    if(!_fs->openFile("/error.html",_file))
       return nullptr;
   }
 
   // got it
 
-  _uri=filename;
   return new FileInputStream(*_file);
 }
 
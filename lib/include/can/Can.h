@@ -18,7 +18,11 @@ namespace stm32plus {
     public:
 
       enum {
-        E_TX_NO_MAILBOX = 1
+        E_TX_NO_MAILBOX = 1,
+        E_TX_QUEUE_FULL,                      ///< CanInterruptDriver software transmit queue is full
+        E_FILTER_TOO_MANY_ENTRIES,            ///< CanFilterManager entry table is full
+        E_FILTER_TOO_MANY_BANKS,              ///< CanFilterManager entries don't fit in the bank range
+        E_FILTER_INVALID_FIFO                 ///< CanFilterManager FIFO number is not 0 or 1
       };
 
     protected:
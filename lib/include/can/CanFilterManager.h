@@ -0,0 +1,377 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Builds the bxCAN acceptance filters from a list of identifiers and identifier/mask pairs
+   * and packs them into as few filter banks as possible:
+   *
+   *   4 standard identifiers per bank (16 bit list mode)
+   *   2 standard identifier/mask pairs per bank (16 bit mask mode)
+   *   2 extended identifiers per bank (32 bit list mode)
+   *   1 extended identifier/mask pair per bank (32 bit mask mode)
+   *
+   * Each entry is routed to FIFO 0 or FIFO 1. List entries match data frames only because the
+   * RTR bit is part of the list comparison. Use a mask entry with a full mask to accept both
+   * data and remote frames with a given identifier.
+   *
+   * The filter banks are shared between CAN1 and CAN2 on the F4. Give each a range of banks
+   * and set the split with CAN_SlaveStartBank() (the default split is 14).
+   *
+   * Example:
+   *   CanFilterManager filters(0,13);
+   *   filters.addStandardId(0,0x100);
+   *   filters.addStandardMask(1,0x200,0x7f0);       // 0x200..0x20f to FIFO 1
+   *   filters.addExtendedId(0,0x18fef100);
+   *   filters.apply();
+   *
+   * Use this instead of Can1FilterBypassFeature / Can2FilterBypassFeature.
+   */
+
+  class CanFilterManager {
+
+    public:
+      enum {
+#if defined(STM32PLUS_F4)
+        MAX_BANKS = 28,                     ///< filter banks shared by CAN1 and CAN2
+#else
+        MAX_BANKS = 14,                     ///< filter banks on the F1
+#endif
+        MAX_ENTRIES = 32                    ///< identifiers and masks that can be added
+      };
+
+    protected:
+
+      /*
+       * Entry types, in the order that banks are filled
+       */
+
+      enum EntryType : uint8_t {
+        STANDARD_ID,
+        STANDARD_MASK,
+        EXTENDED_ID,
+        EXTENDED_MASK,
+        ENTRY_TYPE_COUNT
+      };
+
+      struct Entry {
+        uint32_t id;
+        uint32_t mask;
+        EntryType type;
+        uint8_t fifo;
+      };
+
+      Entry _entries[MAX_ENTRIES];
+      uint8_t _entryCount;
+      uint8_t _firstBank;
+      uint8_t _lastBank;
+
+    protected:
+      bool add(EntryType type,uint8_t fifo,uint32_t id,uint32_t mask);
+      static void writeBank(uint8_t bank,EntryType type,uint8_t fifo,const uint32_t *values);
+
+    public:
+      CanFilterManager(uint8_t firstBank,uint8_t lastBank);
+
+      bool addStandardId(uint8_t fifo,uint16_t id);
+      bool addStandardMask(uint8_t fifo,uint16_t id,uint16_t mask);
+      bool addExtendedId(uint8_t fifo,uint32_t id);
+      bool addExtendedMask(uint8_t fifo,uint32_t id,uint32_t mask);
+      bool addAcceptAll(uint8_t fifo);
+
+      void clear();
+      bool apply() const;
+
+      uint8_t getBanksRequired() const;
+  };
+
+
+  /**
+   * Constructor
+   * @param firstBank The first filter bank that this manager may use
+   * @param lastBank The last filter bank that this manager may use
+   */
+
+  inline CanFilterManager::CanFilterManager(uint8_t firstBank,uint8_t lastBank)
+    : _entryCount(0),
+      _firstBank(firstBank),
+      _lastBank(lastBank) {
+  }
+
+
+  /**
+   * Remove all the entries. The hardware is not changed until apply() is called.
+   */
+
+  inline void CanFilterManager::clear() {
+    _entryCount=0;
+  }
+
+
+  /**
+   * Add an entry
+   * @return false if the table is full or the FIFO isn't 0 or 1
+   */
+
+  inline bool CanFilterManager::add(EntryType type,uint8_t fifo,uint32_t id,uint32_t mask) {
+
+    Entry *entry;
+
+    if(fifo>1)
+      return errorProvider.set(ErrorProvider::ERROR_PROVIDER_CAN,Can::E_FILTER_INVALID_FIFO);
+
+    if(_entryCount==MAX_ENTRIES)
+      return errorProvider.set(ErrorProvider::ERROR_PROVIDER_CAN,Can::E_FILTER_TOO_MANY_ENTRIES);
+
+    entry=&_entries[_entryCount++];
+    entry->type=type;
+    entry->fifo=fifo;
+    entry->id=id;
+    entry->mask=mask;
+
+    return true;
+  }
+
+
+  /**
+   * Accept data frames with a standard identifier
+   * @param fifo 0 or 1
+   * @param id The 11 bit identifier
+   * @return false if the table is full
+   */
+
+  inline bool CanFilterManager::addStandardId(uint8_t fifo,uint16_t id) {
+
+    // STID[10:0] RTR IDE EXID[17:15]
+
+    return add(STANDARD_ID,fifo,static_cast<uint32_t>(id) << 5,0);
+  }
+
+
+  /**
+   * Accept data and remote frames with a standard identifier that matches id in the bit
+   * positions that are set in mask
+   * @param fifo 0 or 1
+   * @param id The 11 bit identifier
+   * @param mask The 11 bit mask
+   * @return false if the table is full
+   */
+
+  inline bool CanFilterManager::addStandardMask(uint8_t fifo,uint16_t id,uint16_t mask) {
+
+    // the IDE bit is always compared so that extended frames don't match
+
+    return add(STANDARD_MASK,fifo,static_cast<uint32_t>(id) << 5,(static_cast<uint32_t>(mask) << 5) | 0x8);
+  }
+
+
+  /**
+   * Accept data frames with an extended identifier
+   * @param fifo 0 or 1
+   * @param id The 29 bit identifier
+   * @return false if the table is full
+   */
+
+  inline bool CanFilterManager::addExtendedId(uint8_t fifo,uint32_t id) {
+
+    // STID[10:0] EXID[17:0] IDE RTR 0
+
+    return add(EXTENDED_ID,fifo,(id << 3) | CAN_Id_Extended,0);
+  }
+
+
+  /**
+   * Accept data and remote frames with an extended identifier that matches id in the bit
+   * positions that are set in mask
+   * @param fifo 0 or 1
+   * @param id The 29 bit identifier
+   * @param mask The 29 bit mask
+   * @return false if the table is full
+   */
+
+  inline bool CanFilterManager::addExtendedMask(uint8_t fifo,uint32_t id,uint32_t mask) {
+    return add(EXTENDED_MASK,fifo,(id << 3) | CAN_Id_Extended,(mask << 3) | CAN_Id_Extended);
+  }
+
+
+  /**
+   * Accept every frame, standard and extended, into a FIFO. This is what the filter bypass
+   * features do.
+   * @param fifo 0 or 1
+   * @return false if the table is full
+   */
+
+  inline bool CanFilterManager::addAcceptAll(uint8_t fifo) {
+    return add(EXTENDED_MASK,fifo,0,0);
+  }
+
+
+  /**
+   * Get the number of filter banks that apply() will use
+   */
+
+  inline uint8_t CanFilterManager::getBanksRequired() const {
+
+    static const uint8_t perBank[ENTRY_TYPE_COUNT]={ 4,2,2,1 };
+    uint8_t counts[ENTRY_TYPE_COUNT][2];
+    uint8_t i,type,banks;
+
+    memset(counts,0,sizeof(counts));
+
+    for(i=0;i<_entryCount;i++)
+      counts[_entries[i].type][_entries[i].fifo]++;
+
+    banks=0;
+    for(type=0;type<ENTRY_TYPE_COUNT;type++)
+      for(i=0;i<2;i++)
+        banks+=(counts[type][i]+perBank[type]-1)/perBank[type];
+
+    return banks;
+  }
+
+
+  /**
+   * Program the filter banks. Banks in the range that are not needed are deactivated.
+   * @return false if the entries need more banks than the range allows
+   */
+
+  inline bool CanFilterManager::apply() const {
+
+    static const uint8_t perBank[ENTRY_TYPE_COUNT]={ 4,2,2,1 };
+
+    CAN_FilterInitTypeDef init;
+    uint32_t values[4];
+    uint8_t bank,type,fifo,used,i;
+
+    if(getBanksRequired()>_lastBank-_firstBank+1)
+      return errorProvider.set(ErrorProvider::ERROR_PROVIDER_CAN,Can::E_FILTER_TOO_MANY_BANKS);
+
+    bank=_firstBank;
+
+    // gather each type/fifo combination into banks of values. The register layout for a
+    // value is id,mask for masks and just id for lists.
+
+    for(type=0;type<ENTRY_TYPE_COUNT;type++) {
+      for(fifo=0;fifo<2;fifo++) {
+
+        used=0;
+
+        for(i=0;i<_entryCount;i++) {
+
+          if(_entries[i].type!=type || _entries[i].fifo!=fifo)
+            continue;
+
+          if(type==STANDARD_MASK || type==EXTENDED_MASK) {
+            values[used*2]=_entries[i].id;
+            values[used*2+1]=_entries[i].mask;
+          }
+          else
+            values[used]=_entries[i].id;
+
+          if(++used==perBank[type]) {
+            writeBank(bank++,static_cast<EntryType>(type),fifo,values);
+            used=0;
+          }
+        }
+
+        // a partly filled bank repeats its first entry in the unused slots
+
+        if(used) {
+
+          for(i=used;i<perBank[type];i++) {
+            if(type==STANDARD_MASK || type==EXTENDED_MASK) {
+              values[i*2]=values[0];
+              values[i*2+1]=values[1];
+            }
+            else
+              values[i]=values[0];
+          }
+
+          writeBank(bank++,static_cast<EntryType>(type),fifo,values);
+        }
+      }
+    }
+
+    // switch off the rest of the range
+
+    memset(&init,0,sizeof(init));
+    init.CAN_FilterMode=CAN_FilterMode_IdMask;
+    init.CAN_FilterScale=CAN_FilterScale_32bit;
+    init.CAN_FilterActivation=DISABLE;
+
+    while(bank<=_lastBank) {
+      init.CAN_FilterNumber=bank++;
+      CAN_FilterInit(&init);
+    }
+
+    return true;
+  }
+
+
+  /**
+   * Write one filter bank
+   * @param bank The bank number
+   * @param type The type of entries in the bank
+   * @param fifo The FIFO to route matches to
+   * @param values The register values. 4 ids, 2 id/mask pairs, 2 ids or 1 id/mask pair.
+   */
+
+  inline void CanFilterManager::writeBank(uint8_t bank,EntryType type,uint8_t fifo,const uint32_t *values) {
+
+    CAN_FilterInitTypeDef init;
+
+    init.CAN_FilterNumber=bank;
+    init.CAN_FilterFIFOAssignment=fifo;
+    init.CAN_FilterActivation=ENABLE;
+
+    switch(type) {
+
+      case STANDARD_ID:
+
+        // FR1 = id1 | id0, FR2 = id3 | id2
+
+        init.CAN_FilterMode=CAN_FilterMode_IdList;
+        init.CAN_FilterScale=CAN_FilterScale_16bit;
+        init.CAN_FilterIdLow=values[0];
+        init.CAN_FilterMaskIdLow=values[1];
+        init.CAN_FilterIdHigh=values[2];
+        init.CAN_FilterMaskIdHigh=values[3];
+        break;
+
+      case STANDARD_MASK:
+
+        // FR1 = mask0 | id0, FR2 = mask1 | id1
+
+        init.CAN_FilterMode=CAN_FilterMode_IdMask;
+        init.CAN_FilterScale=CAN_FilterScale_16bit;
+        init.CAN_FilterIdLow=values[0];
+        init.CAN_FilterMaskIdLow=values[1];
+        init.CAN_FilterIdHigh=values[2];
+        init.CAN_FilterMaskIdHigh=values[3];
+        break;
+
+      case EXTENDED_ID:
+      case EXTENDED_MASK:
+      default:
+
+        // FR1 = id, FR2 = mask or second id
+
+        init.CAN_FilterMode=type==EXTENDED_ID ? CAN_FilterMode_IdList : CAN_FilterMode_IdMask;
+        init.CAN_FilterScale=CAN_FilterScale_32bit;
+        init.CAN_FilterIdHigh=values[0] >> 16;
+        init.CAN_FilterIdLow=values[0] & 0xffff;
+        init.CAN_FilterMaskIdHigh=values[1] >> 16;
+        init.CAN_FilterMaskIdLow=values[1] & 0xffff;
+        break;
+    }
+
+    CAN_FilterInit(&init);
+  }
+}
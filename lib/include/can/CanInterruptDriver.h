@@ -0,0 +1,514 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * A received frame with the time that it was taken out of the hardware FIFO
+   */
+
+  struct CanTimestampedRxMsg {
+    CanRxMsg msg;                     ///< the frame
+    uint32_t millis;                  ///< MillisecondTimer::millis() when the frame was received
+    uint16_t hardwareTime;            ///< the 16 bit bxCAN time stamp, only valid in time triggered mode (can_TTCM)
+  };
+
+
+  /**
+   * Interrupt driven CAN transceiver with software queues.
+   *
+   * Transmit: send() puts the frame into a software queue ordered by CAN identifier, lowest
+   * first, which is the order that bus arbitration would send them. The three hardware
+   * mailboxes are refilled from the queue in the transmit mailbox empty interrupt so a burst
+   * of up to TTxQueueSize frames is accepted without the application waiting. Set can_TXFP to
+   * DISABLE in the peripheral parameters so that the hardware also picks mailboxes by
+   * identifier. The hardware breaks a tie between equal identifiers by mailbox number, not
+   * by age, so only one frame with a given identifier is ever loaded into the mailboxes. That
+   * keeps multi-frame sequences on one identifier in the order they were queued.
+   *
+   * Receive: both hardware FIFOs are drained in their message pending interrupts into
+   * single-producer single-consumer rings of TRxQueueSize frames, each stamped with the
+   * time it arrived. The application reads them with receive() at its leisure. The rings need
+   * no locking because the IRQ only ever moves the head and the application only the tail.
+   *
+   * The peripheral must include the interrupt feature for the CAN instance. The driver enables
+   * the interrupts that it needs and subscribes to the feature's events. Filters should be
+   * set up with CanFilterManager or a bypass feature.
+   *
+   * Example:
+   *   typedef Can1<Can1InterruptFeature> MyCan;
+   *   MyCan::Parameters params(500000);
+   *   params.can_TXFP=DISABLE;
+   *   MyCan can(params);
+   *   CanInterruptDriver<MyCan> driver(can);
+   *
+   * @tparam TCan The CAN peripheral type including its interrupt feature
+   * @tparam TTxQueueSize The number of frames in the transmit queue
+   * @tparam TRxQueueSize The number of frames in each receive ring. Must be a power of 2.
+   */
+
+  template<class TCan,uint16_t TTxQueueSize=16,uint16_t TRxQueueSize=16>
+  class CanInterruptDriver {
+
+    public:
+
+      /**
+       * Counters maintained by the driver
+       */
+
+      struct Statistics {
+        uint32_t txQueued;                    ///< frames accepted by send()
+        uint32_t txLoaded;                    ///< frames moved into a hardware mailbox
+        uint32_t txQueueFull;                 ///< frames rejected by send() because the queue was full
+        uint32_t rxReceived[2];               ///< frames read from each hardware FIFO
+        uint32_t rxRingOverruns[2];           ///< frames dropped because a software ring was full
+        uint32_t rxFifoOverruns[2];           ///< hardware FIFO overruns reported by the peripheral
+      };
+
+    protected:
+      static_assert((TRxQueueSize & (TRxQueueSize-1))==0,"TRxQueueSize must be a power of 2");
+
+      struct QueuedTxMsg {
+        CanTxMsg msg;
+        uint32_t priority;
+        uint32_t sequence;
+      };
+
+      struct RxRing {
+        CanTimestampedRxMsg frames[TRxQueueSize];
+        volatile uint16_t head;               // written only by the IRQ
+        volatile uint16_t tail;               // written only by the application
+      };
+
+      TCan& _can;
+      QueuedTxMsg _txQueue[TTxQueueSize];     // binary heap, highest priority at the top
+      uint16_t _txQueueSize;
+      uint32_t _txSequence;
+      uint32_t _mailboxPriority[3];           // priority of the frame loaded into each mailbox
+      RxRing _rx[2];
+      Statistics _statistics;
+
+    protected:
+      void onInterrupt(CanEventType cet);
+
+      static uint32_t getPriority(const CanTxMsg& msg);
+      static bool isBefore(const QueuedTxMsg& first,const QueuedTxMsg& second);
+
+      void loadMailboxes();
+      void drainFifo(uint8_t fifo);
+
+    public:
+      CanInterruptDriver(TCan& can);
+      ~CanInterruptDriver();
+
+      bool send(const CanTxMsg& msg);
+      bool send(uint16_t stdId,uint8_t dlc,const void *data);
+      bool sendExtended(uint32_t extId,uint8_t dlc,const void *data);
+
+      uint16_t txQueueSize() const;
+      bool isTxIdle() const;
+
+      bool available(uint8_t fifo) const;
+      bool receive(uint8_t fifo,CanTimestampedRxMsg& frame);
+      bool receive(CanTimestampedRxMsg& frame);
+
+      const Statistics& getStatistics() const;
+  };
+
+
+  /**
+   * Constructor. Subscribe to the interrupts and enable them.
+   * @param can The CAN peripheral, which must include its interrupt feature
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::CanInterruptDriver(TCan& can)
+    : _can(can),
+      _txQueueSize(0),
+      _txSequence(0) {
+
+    _rx[0].head=_rx[0].tail=0;
+    _rx[1].head=_rx[1].tail=0;
+
+    memset(&_statistics,0,sizeof(_statistics));
+    memset(_mailboxPriority,0xff,sizeof(_mailboxPriority));
+
+    _can.CanInterruptEventSender.insertSubscriber(
+        CanInterruptEventSourceSlot::bind(this,&CanInterruptDriver::onInterrupt)
+      );
+
+    _can.enableInterrupts(CAN_IT_TME | CAN_IT_FMP0 | CAN_IT_FOV0 | CAN_IT_FMP1 | CAN_IT_FOV1);
+  }
+
+
+  /**
+   * Destructor. Disable the interrupts and unsubscribe.
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::~CanInterruptDriver() {
+
+    _can.disableInterrupts(CAN_IT_TME | CAN_IT_FMP0 | CAN_IT_FOV0 | CAN_IT_FMP1 | CAN_IT_FOV1);
+
+    _can.CanInterruptEventSender.removeSubscriber(
+        CanInterruptEventSourceSlot::bind(this,&CanInterruptDriver::onInterrupt)
+      );
+  }
+
+
+  /**
+   * Arbitration priority of a frame, lower wins. A standard frame beats an extended frame
+   * with the same base identifier and a data frame beats a remote frame.
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline uint32_t CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::getPriority(const CanTxMsg& msg) {
+
+    uint32_t priority;
+
+    if(msg.IDE==CAN_Id_Standard)
+      priority=static_cast<uint32_t>(msg.StdId) << 20;
+    else
+      priority=(msg.ExtId << 2) | 2;
+
+    return msg.RTR==CAN_RTR_Remote ? priority | 1 : priority;
+  }
+
+
+  /**
+   * Heap ordering: priority, then queue order
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::isBefore(const QueuedTxMsg& first,const QueuedTxMsg& second) {
+
+    if(first.priority!=second.priority)
+      return first.priority<second.priority;
+
+    return static_cast<int32_t>(first.sequence-second.sequence)<0;
+  }
+
+
+  /**
+   * Queue a frame for transmission
+   * @param msg The frame
+   * @return false if the queue is full
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::send(const CanTxMsg& msg) {
+
+    QueuedTxMsg entry;
+    uint16_t index,parent;
+
+    IrqSuspend suspender;
+
+    if(_txQueueSize==TTxQueueSize) {
+      _statistics.txQueueFull++;
+      return errorProvider.set(ErrorProvider::ERROR_PROVIDER_CAN,Can::E_TX_QUEUE_FULL);
+    }
+
+    entry.msg=msg;
+    entry.priority=getPriority(msg);
+    entry.sequence=_txSequence++;
+
+    // sift up
+
+    for(index=_txQueueSize++;index>0;index=parent) {
+
+      parent=(index-1)/2;
+
+      if(!isBefore(entry,_txQueue[parent]))
+        break;
+
+      _txQueue[index]=_txQueue[parent];
+    }
+
+    _txQueue[index]=entry;
+    _statistics.txQueued++;
+
+    // if there's a free mailbox then the interrupt won't come, so load it now
+
+    loadMailboxes();
+    return true;
+  }
+
+
+  /**
+   * Queue a standard data frame
+   * @param stdId The 11 bit identifier
+   * @param dlc The number of data bytes, up to 8
+   * @param data The data bytes
+   * @return false if the queue is full
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::send(uint16_t stdId,uint8_t dlc,const void *data) {
+
+    CanTxMsg msg;
+
+    msg.IDE=CAN_Id_Standard;
+    msg.RTR=CAN_RTR_Data;
+    msg.StdId=stdId;
+    msg.ExtId=0;
+    msg.DLC=dlc;
+
+    memcpy(msg.Data,data,dlc);
+    return send(msg);
+  }
+
+
+  /**
+   * Queue an extended data frame
+   * @param extId The 29 bit identifier
+   * @param dlc The number of data bytes, up to 8
+   * @param data The data bytes
+   * @return false if the queue is full
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::sendExtended(uint32_t extId,uint8_t dlc,const void *data) {
+
+    CanTxMsg msg;
+
+    msg.IDE=CAN_Id_Extended;
+    msg.RTR=CAN_RTR_Data;
+    msg.StdId=0;
+    msg.ExtId=extId;
+    msg.DLC=dlc;
+
+    memcpy(msg.Data,data,dlc);
+    return send(msg);
+  }
+
+
+  /**
+   * Move frames from the top of the queue into free mailboxes. Called with the transmit
+   * interrupt unable to run, either from the IRQ itself or inside an IrqSuspend. Loading stops
+   * if the top frame has the same identifier as one still waiting in a mailbox. The transmit
+   * mailbox empty interrupt for that one will load it.
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline void CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::loadMailboxes() {
+
+    CAN_TypeDef *peripheral;
+    QueuedTxMsg last;
+    uint32_t tsr;
+    uint16_t index,child;
+    uint8_t mailbox;
+
+    peripheral=_can;
+
+    while(_txQueueSize && ((tsr=peripheral->TSR) & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2))) {
+
+      // a pending mailbox with the same identifier must go first
+
+      for(mailbox=0;mailbox<3;mailbox++)
+        if((tsr & (CAN_TSR_TME0 << mailbox))==0 && _mailboxPriority[mailbox]==_txQueue[0].priority)
+          return;
+
+      // CAN_Transmit takes a non-const message so it gets the copy at the top
+
+      if((mailbox=CAN_Transmit(peripheral,&_txQueue[0].msg))<3)
+        _mailboxPriority[mailbox]=_txQueue[0].priority;
+
+      _statistics.txLoaded++;
+
+      // sift the last entry down from the top
+
+      last=_txQueue[--_txQueueSize];
+
+      for(index=0;(child=index*2+1)<_txQueueSize;index=child) {
+
+        if(child+1<_txQueueSize && isBefore(_txQueue[child+1],_txQueue[child]))
+          child++;
+
+        if(!isBefore(_txQueue[child],last))
+          break;
+
+        _txQueue[index]=_txQueue[child];
+      }
+
+      _txQueue[index]=last;
+    }
+  }
+
+
+  /**
+   * Move everything in a hardware FIFO into its software ring
+   * @param fifo 0 or 1
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline void CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::drainFifo(uint8_t fifo) {
+
+    CAN_TypeDef *peripheral;
+    CanTimestampedRxMsg *frame;
+    RxRing& ring=_rx[fifo];
+    uint16_t next;
+    uint32_t now;
+
+    peripheral=_can;
+    now=MillisecondTimer::millis();
+
+    // a hardware overrun is flagged in FOVR, which must be cleared by software
+
+    if(CAN_GetFlagStatus(peripheral,fifo==0 ? CAN_FLAG_FOV0 : CAN_FLAG_FOV1)!=RESET) {
+      CAN_ClearFlag(peripheral,fifo==0 ? CAN_FLAG_FOV0 : CAN_FLAG_FOV1);
+      _statistics.rxFifoOverruns[fifo]++;
+    }
+
+    while(CAN_MessagePending(peripheral,fifo)) {
+
+      next=(ring.head+1) & (TRxQueueSize-1);
+
+      if(next==ring.tail) {
+
+        // the ring is full: the frame has to go or the IRQ will fire forever
+
+        CAN_FIFORelease(peripheral,fifo);
+        _statistics.rxRingOverruns[fifo]++;
+        continue;
+      }
+
+      frame=&ring.frames[ring.head];
+      frame->millis=now;
+      frame->hardwareTime=peripheral->sFIFOMailBox[fifo].RDTR >> 16;
+
+      // reads the frame and releases the FIFO output mailbox
+
+      CAN_Receive(peripheral,fifo,&frame->msg);
+
+      ring.head=next;
+      _statistics.rxReceived[fifo]++;
+    }
+  }
+
+
+  /**
+   * Interrupt handler
+   * @param cet The event type
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline void CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::onInterrupt(CanEventType cet) {
+
+    switch(cet) {
+
+      case CanEventType::EVENT_TRANSMIT_MAILBOX_EMPTY:
+        CAN_ClearITPendingBit(_can,CAN_IT_TME);
+        loadMailboxes();
+        break;
+
+      case CanEventType::EVENT_FIFO0_MESSAGE_PENDING:
+      case CanEventType::EVENT_FIFO0_FULL:
+      case CanEventType::EVENT_FIFO0_OVR:
+        drainFifo(0);
+        break;
+
+      case CanEventType::EVENT_FIFO1_MESSAGE_PENDING:
+      case CanEventType::EVENT_FIFO1_FULL:
+      case CanEventType::EVENT_FIFO1_OVR:
+        drainFifo(1);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+
+  /**
+   * Get the number of frames waiting in the software transmit queue. Frames already in a
+   * hardware mailbox are not counted.
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline uint16_t CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::txQueueSize() const {
+    return _txQueueSize;
+  }
+
+
+  /**
+   * Check if everything has been sent: the queue and all three mailboxes are empty
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::isTxIdle() const {
+
+    const CAN_TypeDef *peripheral;
+
+    peripheral=const_cast<TCan&>(_can);
+
+    return _txQueueSize==0 &&
+           (peripheral->TSR & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2))==(CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2);
+  }
+
+
+  /**
+   * Check if there's a frame waiting in a receive ring
+   * @param fifo 0 or 1
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::available(uint8_t fifo) const {
+    return _rx[fifo].head!=_rx[fifo].tail;
+  }
+
+
+  /**
+   * Take the oldest frame from a receive ring
+   * @param fifo 0 or 1
+   * @param[out] frame The frame
+   * @return false if the ring is empty
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::receive(uint8_t fifo,CanTimestampedRxMsg& frame) {
+
+    RxRing& ring=_rx[fifo];
+    uint16_t tail;
+
+    if((tail=ring.tail)==ring.head)
+      return false;
+
+    frame=ring.frames[tail];
+    ring.tail=(tail+1) & (TRxQueueSize-1);
+
+    return true;
+  }
+
+
+  /**
+   * Take the oldest frame from either ring, FIFO 0 first. If both have frames the one that
+   * arrived first is returned.
+   * @param[out] frame The frame
+   * @return false if both rings are empty
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline bool CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::receive(CanTimestampedRxMsg& frame) {
+
+    if(available(0) && available(1))
+      return receive(static_cast<int32_t>(_rx[1].frames[_rx[1].tail].millis-_rx[0].frames[_rx[0].tail].millis)<0 ? 1 : 0,frame);
+
+    return receive(0,frame) || receive(1,frame);
+  }
+
+
+  /**
+   * Get the statistics
+   */
+
+  template<class TCan,uint16_t TTxQueueSize,uint16_t TRxQueueSize>
+  inline const typename CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::Statistics& CanInterruptDriver<TCan,TTxQueueSize,TRxQueueSize>::getStatistics() const {
+    return _statistics;
+  }
+}
@@ -0,0 +1,215 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * The progress of a transaction through a TransactionQueue
+   */
+
+  enum class TransactionStatus : uint8_t {
+    IDLE,           ///< never submitted
+    QUEUED,         ///< waiting for the bus
+    RUNNING,        ///< on the bus now
+    COMPLETE,       ///< finished successfully
+    FAILED          ///< finished with an error
+  };
+
+
+  /**
+   * Base class for the transactions that are run by a TransactionQueue. The caller owns the
+   * transaction and its buffers and must keep them in scope until it has finished.
+   */
+
+  struct Transaction {
+
+    typedef TransactionStatus Status;
+
+    void *context;                    ///< free for the caller's use
+    volatile Status status;
+
+    Transaction()
+      : context(nullptr),
+        status(Status::IDLE) {
+    }
+
+    /**
+     * @return true if the transaction has finished, successfully or not
+     */
+
+    bool isDone() const {
+      return status==Status::COMPLETE || status==Status::FAILED;
+    }
+
+    /**
+     * @return the error cause reported by TransactionQueue::wait() when the transaction fails.
+     * Transactions that record why they failed hide this with their own version.
+     */
+
+    uint32_t getFailureCause() const {
+      return 0;
+    }
+  };
+
+
+  /**
+   * The queue behind the interrupt driven transaction engines such as I2CTransactionEngine
+   * and SpiTransactionScheduler. Transactions are queued with submit() and run back to back
+   * in the order they were submitted, one at a time. The running transaction is in _current.
+   *
+   * The engine derives from this class, makes it a friend and supplies:
+   *
+   *   void startTransaction();                        // put _current on the bus
+   *   void raiseTransactionEvent(TTransaction& t);    // tell the subscribers that t has finished
+   *
+   * startTransaction() is called from the IRQ or with interrupts suspended. The engine calls
+   * completeTransaction() from its IRQ handler when _current has finished.
+   *
+   * @tparam TImpl The engine class
+   * @tparam TTransaction The transaction type, derived from Transaction
+   * @tparam TQueueSize The maximum number of transactions waiting for the bus
+   * @tparam TErrorProvider The ErrorProvider code for errors raised here
+   * @tparam TQueueFullError The error code when submit() finds the queue full
+   * @tparam TFailedError The error code when wait() finds the transaction failed
+   */
+
+  template<class TImpl,class TTransaction,uint8_t TQueueSize,uint32_t TErrorProvider,uint32_t TQueueFullError,uint32_t TFailedError>
+  class TransactionQueue {
+
+    protected:
+      TTransaction *_queue[TQueueSize];
+      uint8_t _queueFirst;
+      uint8_t _queueCount;
+
+      TTransaction * volatile _current;
+
+    protected:
+      TransactionQueue();
+
+      void startNext();
+      void completeTransaction(bool success);
+
+    public:
+      bool submit(TTransaction& transaction);
+      bool wait(const TTransaction& transaction) const;
+      bool isIdle() const;
+  };
+
+
+  /**
+   * Constructor
+   */
+
+  template<class TImpl,class TTransaction,uint8_t TQueueSize,uint32_t TErrorProvider,uint32_t TQueueFullError,uint32_t TFailedError>
+  inline TransactionQueue<TImpl,TTransaction,TQueueSize,TErrorProvider,TQueueFullError,TFailedError>::TransactionQueue()
+    : _queueFirst(0),
+      _queueCount(0),
+      _current(nullptr) {
+  }
+
+
+  /**
+   * Queue a transaction. It starts immediately if the bus is idle. This can be called from
+   * the completion event handler to chain transactions.
+   * @param transaction The transaction, which must stay in scope until it's done
+   * @return false if the queue is full
+   */
+
+  template<class TImpl,class TTransaction,uint8_t TQueueSize,uint32_t TErrorProvider,uint32_t TQueueFullError,uint32_t TFailedError>
+  inline bool TransactionQueue<TImpl,TTransaction,TQueueSize,TErrorProvider,TQueueFullError,TFailedError>::submit(TTransaction& transaction) {
+
+    IrqSuspend suspender;
+
+    if(_queueCount==TQueueSize)
+      return errorProvider.set(TErrorProvider,TQueueFullError);
+
+    transaction.status=TransactionStatus::QUEUED;
+    _queue[(_queueFirst+_queueCount++) % TQueueSize]=&transaction;
+
+    if(_current==nullptr)
+      startNext();
+
+    return true;
+  }
+
+
+  /**
+   * Block until a transaction has finished. For code that wants the queueing but not the
+   * asynchrony.
+   * @param transaction The transaction
+   * @return true if it completed successfully
+   */
+
+  template<class TImpl,class TTransaction,uint8_t TQueueSize,uint32_t TErrorProvider,uint32_t TQueueFullError,uint32_t TFailedError>
+  inline bool TransactionQueue<TImpl,TTransaction,TQueueSize,TErrorProvider,TQueueFullError,TFailedError>::wait(const TTransaction& transaction) const {
+
+    while(!transaction.isDone());
+
+    if(transaction.status==TransactionStatus::FAILED)
+      return errorProvider.set(TErrorProvider,TFailedError,transaction.getFailureCause());
+
+    return true;
+  }
+
+
+  /**
+   * @return true if nothing is running or queued
+   */
+
+  template<class TImpl,class TTransaction,uint8_t TQueueSize,uint32_t TErrorProvider,uint32_t TQueueFullError,uint32_t TFailedError>
+  inline bool TransactionQueue<TImpl,TTransaction,TQueueSize,TErrorProvider,TQueueFullError,TFailedError>::isIdle() const {
+    return _current==nullptr;
+  }
+
+
+  /**
+   * Take the next transaction off the queue and hand it to the engine. Called from the IRQ or
+   * with interrupts suspended.
+   */
+
+  template<class TImpl,class TTransaction,uint8_t TQueueSize,uint32_t TErrorProvider,uint32_t TQueueFullError,uint32_t TFailedError>
+  inline void TransactionQueue<TImpl,TTransaction,TQueueSize,TErrorProvider,TQueueFullError,TFailedError>::startNext() {
+
+    if(_queueCount==0) {
+      _current=nullptr;
+      return;
+    }
+
+    _current=_queue[_queueFirst];
+    _queueFirst=(_queueFirst+1) % TQueueSize;
+    _queueCount--;
+
+    _current->status=TransactionStatus::RUNNING;
+    static_cast<TImpl *>(this)->startTransaction();
+  }
+
+
+  /**
+   * The current transaction has finished. Tell the subscribers and start the next one.
+   * @param success true if it worked
+   */
+
+  template<class TImpl,class TTransaction,uint8_t TQueueSize,uint32_t TErrorProvider,uint32_t TQueueFullError,uint32_t TFailedError>
+  inline void TransactionQueue<TImpl,TTransaction,TQueueSize,TErrorProvider,TQueueFullError,TFailedError>::completeTransaction(bool success) {
+
+    TTransaction *transaction;
+
+    transaction=_current;
+    transaction->status=success ? TransactionStatus::COMPLETE : TransactionStatus::FAILED;
+
+    // the handler may submit more work, which will queue behind anything already waiting
+
+    _current=nullptr;
+
+    static_cast<TImpl *>(this)->raiseTransactionEvent(*transaction);
+
+    if(_current==nullptr)
+      startNext();
+  }
+}
@@ -50,16 +50,16 @@ namespace stm32plus {
     template<typename T, typename U>
     struct sync_bool_compare_and_swap_internal<T, U, sizeof(long)> {
       bool operator()(T *ptr, U oldval, U newval) const {
-        register int result;
+        register int result=1;          // the store is skipped on a mismatch
         asm volatile (
             "ldrex    r0, [%1]         \n\t" /*exclusive load of ptr */
             "cmp      r0,  %2          \n\t" /*compare the oldval ==  *ptr */
             "ite eq\n\t"
             "strexeq  %0,  %3, [%1]\n\t" /*store if eq, strex+eq*/
             "clrexne"
-            : "=&r" (result)
+            : "+&r" (result)
             : "r"(ptr), "r"(oldval),"r"(newval)
-            : "r0"
+            : "r0", "cc", "memory"
         );
         return result == 0;
       }
@@ -68,16 +68,16 @@ namespace stm32plus {
     template<typename T, typename U>
     struct sync_bool_compare_and_swap_internal<T, U, sizeof(short)> {
       bool operator()(T *ptr, U oldval, U newval) const {
-        register int result;
+        register int result=1;          // the store is skipped on a mismatch
         asm volatile (
             "ldrexh   r1, [%1]         \n\t" /*exclusive load of ptr*/
             "cmp      r1,  %2          \n\t"/*compare the low reg oldval == low *ptr*/
             "ite eq\n\t"
             "strexheq %0,  %3, [%1]\n\t" /*store if eq, strex+eq*/
             "clrexne"
-            : "=&r" (result)
+            : "+&r" (result)
             : "r"(ptr), "r"(oldval),"r"(newval)
-            : "r1"
+            : "r1", "cc", "memory"
         );
         return result == 0;
       }
@@ -86,16 +86,16 @@ namespace stm32plus {
     template<typename T, typename U>
     struct sync_bool_compare_and_swap_internal<T, U, sizeof(char)> {
       bool operator()(T *ptr, U oldval, U newval) const {
-        register int result;
+        register int result=1;          // the store is skipped on a mismatch
         asm volatile (
             "ldrexb   r1, [%1]         \n\t" /*exclusive load of ptr*/
             "cmp      r1,  %2          \n\t"/*compare the low reg oldval == low *ptr*/
             "ite eq\n\t"
-            "strexbeq %0,  %3, [%1]" /*store if eq, strex+eq*/
+            "strexbeq %0,  %3, [%1]\n\t" /*store if eq, strex+eq*/
             "clrexne"
-            : "=&r" (result)
+            : "+&r" (result)
             : "r"(ptr), "r"(oldval),"r"(newval)
-            : "r1"
+            : "r1", "cc", "memory"
         );
         return result == 0;
       }
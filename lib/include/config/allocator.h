@@ -0,0 +1,24 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+/**
+ * @file
+ * Include this file to use the deterministic fixed block pool, TLSF and pool heap
+ * allocators. Build with allocator=pool to route operator new/delete and the bundled STL
+ * through the global PoolHeap.
+ */
+
+// allocator has no dependencies
+
+#include "config/stm32plus.h"
+
+#include <cstddef>
+
+#include "memory/FixedBlockPool.h"
+#include "memory/TlsfHeap.h"
+#include "memory/PoolHeap.h"
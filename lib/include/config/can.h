@@ -13,6 +13,7 @@
 #include "config/rcc.h"
 #include "config/gpio.h"
 #include "config/event.h"
+#include "config/concurrent.h"
 #include "util/Meta.h"
 
 // device-specific pin initialiser
@@ -58,3 +59,8 @@
   #include "can/features/f4/Can1InterruptFeature.h"
   #include "can/features/f4/Can2InterruptFeature.h"
 #endif
+
+// interrupt driven driver and filter management
+
+#include "can/CanFilterManager.h"
+#include "can/CanInterruptDriver.h"
@@ -11,7 +11,8 @@
 /**
  * @file
  * This config file gives access to the concurrency-related utility classes such as Mutex, Critical Section
- * and other classes. These are useful when sharing data between IRQ and normal code paths.
+ * and other classes. These are useful when sharing data between IRQ and normal code paths. The lock-free
+ * ring queues are here too.
  */
 
 #include "config/timing.h"
@@ -19,9 +20,16 @@
 #include "concurrent/CriticalSection.h"
 #include "concurrent/atomic.h"
 #include "concurrent/IrqSuspend.h"
+#include "concurrent/TransactionQueue.h"
 
 // mutex only on cortex M3 and above due to the need for strex/ldrex* instructions
 
 #if !defined(STM32PLUS_F0)
   #include "concurrent/Mutex.h"
 #endif
+
+// lock-free queues
+
+#include "memory/RingQueueBase.h"
+#include "memory/SpscRingQueue.h"
+#include "memory/MpscRingQueue.h"
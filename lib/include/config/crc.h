@@ -9,7 +9,8 @@
 /**
  * @file
  * This file gets you access to the CRC peripheral functionality. Big-endian and little-endian
- * calculation is supported.
+ * calculation is supported. CrcDma needs config/dma.h for the DMA channel classes. The
+ * table driven software CRCs work for any polynomial and do not use the peripheral.
  */
 
 // CRC depends on output stream
@@ -22,6 +23,8 @@
 #include "crc/CrcPeripheral.h"
 #include "crc/BigEndianCrc.h"
 #include "crc/LittleEndianCrc.h"
+#include "crc/CrcDma.h"
+#include "crc/SoftwareCrc.h"
 
 // utility classes
 
@@ -12,16 +12,21 @@
  * assist debugging
  */
 
-// debug depends on usart,stream,malloc.h
+// debug depends on usart,stream,allocator,malloc.h
 
 #include "config/stm32plus.h"
 
 #include <malloc.h>
 #include "config/usart.h"
 #include "config/stream.h"
+#include "config/allocator.h"
 
 // include the features
 
+// the heap profiler is always available, it's only hooked in with STM32PLUS_HEAP_PROFILER
+
+#include "debug/HeapProfiler.h"
+
 // If the MCU is supported (on the F4 and F1)
 
 #if defined(STM32PLUS_F4) || defined(STM32PLUS_F1)
@@ -33,6 +38,7 @@
 // SemiHosting is always possible
 
 #include "debug/SemiHosting.h"
+#include "debug/SemiHostingOutputStream.h"
 
 
 namespace stm32plus {
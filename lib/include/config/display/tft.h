@@ -59,9 +59,12 @@
 #include "display/graphic/ColourNames.h"
 #include "display/graphic/Backlight.h"
 #include "display/graphic/GraphicTerminal.h"
+#include "display/graphic/BufferedGraphicTerminal.h"
 #include "display/graphic/PanelConfiguration.h"
 #include "display/graphic/PicoJpeg.h"
 #include "display/graphic/JpegDecoder.h"
+#include "display/graphic/GradientStepper.h"
+#include "display/graphic/AlphaBlend.h"
 #include "display/graphic/GraphicsLibrary.h"
 
 // include the optimised GPIO drivers in specialisation order
@@ -7,12 +7,13 @@
 #pragma once
 
 
-// touch depends on event, stream, exti, millisecond timer, spi
+// touch depends on event, stream, exti, millisecond timer, spi, timer
 
 #include "config/event.h"
 #include "config/stream.h"
 #include "config/exti.h"
 #include "config/spi.h"
+#include "config/timer.h"
 #include "timing/MillisecondTimer.h"
 
 // includes for the features
@@ -28,6 +29,8 @@
 #include "display/touch/PassThroughTouchScreenPostProcessor.h"
 #include "display/touch/ThreePointTouchScreenCalibration.h"
 #include "display/touch/TouchScreenCalibrator.h"
+#include "display/touch/TouchScreenStreamingFilter.h"
 #include "display/touch/ThreePointTouchScreenCalibrator.h"
 
 #include "display/touch/ADS7843AsyncTouchScreen.h"
+#include "display/touch/ADS7843BackgroundTouchScreen.h"
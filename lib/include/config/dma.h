@@ -85,6 +85,7 @@
   #include "dma/features/f1/Dma2Channel5InterruptFeature.h"
 
   #include "dma/features/f1/DmaMemoryCopyBaseFeature.h"
+  #include "dma/features/f1/DmaCrcFeature.h"
   #include "dma/features/f1/TimerDmaFeature.h"
   #include "dma/features/f1/UsartDmaReaderFeature.h"
   #include "dma/features/f1/UsartDmaWriterFeature.h"
@@ -146,6 +147,7 @@
   #include "dma/features/f4/Dma2Stream7InterruptFeature.h"
 
   #include "dma/features/f4/DmaMemoryCopyBaseFeature.h"
+  #include "dma/features/f4/DmaCrcFeature.h"
   #include "dma/features/f4/TimerDmaFeature.h"
   #include "dma/features/f4/UsartDmaReaderFeature.h"
   #include "dma/features/f4/UsartDmaWriterFeature.h"
@@ -165,6 +167,11 @@
   #include "dma/features/f4/DacDmaWriterFeature.h"
 #endif
 
+#if defined(STM32PLUS_F4_HAS_HASH_SHA256)
+  #include "dma/features/f4/HashDmaWriterFeature.h"
+#endif
+
+  #include "dma/features/f4/DmaDoubleBufferFeature.h"
   #include "dma/features/f4/DmaPeripheralInfo.h"
 
 #elif defined(STM32PLUS_F0)
@@ -191,6 +198,7 @@
   #include "dma/features/f0/Dma1Channel5InterruptFeature.h"
 
   #include "dma/features/f0/DmaMemoryCopyBaseFeature.h"
+  #include "dma/features/f0/DmaCrcFeature.h"
   #include "dma/features/f0/TimerDmaFeature.h"
   #include "dma/features/f0/UsartDmaReaderFeature.h"
   #include "dma/features/f0/UsartDmaWriterFeature.h"
@@ -24,3 +24,7 @@
 
 #include "eeprom/AT24Cxx.h"
 #include "eeprom/BR24G32.h"
+
+// caching
+
+#include "eeprom/SerialEepromWriteBackCache.h"
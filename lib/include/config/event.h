@@ -27,8 +27,19 @@
 
 #include "event/slot.h"
 #include "event/signal.h"
+#include "event/fixed_signal.h"
 
-// macros for declaring the event signature and source class
+// macros for declaring the event signature and source class. Define STM32PLUS_EVENT_SLOTS to the maximum
+// number of subscribers per event source to keep subscribers in a fixed array instead of a heap allocated list.
+
+#if defined(STM32PLUS_EVENT_SLOTS)
+  #define DECLARE_EVENT_SIGNATURE(name,sig) typedef wink::slot<sig> name##EventSourceSlot; typedef wink::fixed_signal<name##EventSourceSlot,STM32PLUS_EVENT_SLOTS> name##EventSourceType
+#else
+  #define DECLARE_EVENT_SIGNATURE(name,sig) typedef wink::slot<sig> name##EventSourceSlot; typedef wink::signal<name##EventSourceSlot> name##EventSourceType
+#endif
 
-#define DECLARE_EVENT_SIGNATURE(name,sig) typedef wink::slot<sig> name##EventSourceSlot; typedef wink::signal<name##EventSourceSlot> name##EventSourceType
 #define DECLARE_EVENT_SOURCE(name) name##EventSourceType name##EventSender
+
+// an event source with a single handler bound at compile time. Raising the event is a direct call.
+
+#define DECLARE_STATIC_EVENT_SOURCE(name,handler) wink::static_signal<name##EventSourceSlot,handler> name##EventSender
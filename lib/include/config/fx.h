@@ -12,6 +12,7 @@
  * This config file gets you access to the 'easing functions' that can be used to provide smooth animation
  * acceleration and deceleration algorithms that you see all over the place these days in everything from
  * PC GUIs to smartphones. The 'pframe' example uses easing functions to scroll in the next image.
+ * FixedEase provides the same curves in fixed point for MCUs without an FPU.
  */
 
 // fx depends on timing, math
@@ -43,3 +44,4 @@
 #include "fx/easing/QuarticEase.h"
 #include "fx/easing/QuinticEase.h"
 #include "fx/easing/SineEase.h"
+#include "fx/easing/FixedEase.h"
@@ -10,12 +10,13 @@
  * @file
  * This config file enables access to the HASH peripheral in the F4 for performing cryptographic
  * hash functions. The functionality is emulated in software for devices that don't have the
- * peripheral.
+ * peripheral. SHA256Dma needs config/dma.h for the DMA channel classes.
  */
 
-// hash depends on timing
+// hash depends on timing and streams
 
 #include "config/timing.h"
+#include "config/stream.h"
 
 // device-specific peripheral includes
 
@@ -25,7 +26,16 @@
   #include "hash/software/SHA1.h"
 #endif
 
+#if defined(STM32PLUS_F4_HAS_HASH_SHA256)
+  #include "hash/f4/SHA256.h"
+  #include "hash/f4/SHA256Dma.h"
+#else
+  #include "hash/software/SHA256.h"
+#endif
+
 // generic peripheral includes
 
 #include "hash/HashPeripheral.h"
+#include "hash/Hmac.h"
+#include "hash/HashOutputStream.h"
 
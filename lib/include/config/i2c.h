@@ -20,6 +20,7 @@
 #include "config/event.h"
 #include "config/dma.h"
 #include "config/timing.h"
+#include "config/concurrent.h"
 
 // generic peripheral includes
 
@@ -45,6 +46,7 @@
 
 #if defined(STM32PLUS_F1) || defined(STM32PLUS_F4)
 #include "i2c/features/f1,f4/I2CSlaveFeature.h"
+#include "i2c/I2CTransactionEngine.h"
 #endif
 
 // includes for the alternate function mappings
@@ -145,6 +145,7 @@
   #define STM32PLUS_F4_HAS_DCMI
   #define STM32PLUS_F4_HAS_SAI
   #define STM32PLUS_F4_HAS_CRYPTO
+  #define STM32PLUS_F4_HAS_HASH_SHA256
   #define STM32PLUS_F4_HAS_DMA2D
   #define STM32PLUS_F4_HAS_CAN
   #define STM32PLUS_F4_HAS_ADC2_3
@@ -164,6 +165,7 @@
   #define STM32PLUS_F4_HAS_DCMI
   #define STM32PLUS_F4_HAS_SAI
   #define STM32PLUS_F4_HAS_CRYPTO
+  #define STM32PLUS_F4_HAS_HASH_SHA256
   #define STM32PLUS_F4_HAS_LTDC
   #define STM32PLUS_F4_HAS_DMA2D
   #define STM32PLUS_F4_HAS_CAN
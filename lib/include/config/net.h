@@ -15,7 +15,7 @@
 #if defined(STM32PLUS_F4) || defined(STM32PLUS_F1_CL_E)
 
 
-// net depends on GPIO, RCC, traits, timing, event, smart pointers, meta, stl slist, concurrent, rtc, string, rng, stream
+// net depends on GPIO, RCC, traits, timing, event, smart pointers, meta, stl slist, concurrent, rtc, string, rng, stream, task
 
 #include "config/gpio.h"
 #include "config/rcc.h"
@@ -25,6 +25,7 @@
 #include "config/rtc.h"
 #include "config/string.h"
 #include "config/concurrent.h"
+#include "config/task.h"
 #include "config/rng.h"
 #include "config/stream.h"
 #include "memory/scoped_array.h"
@@ -154,6 +155,8 @@
 
 #include "net/transport/udp/UdpDatagram.h"
 #include "net/transport/udp/UdpDatagramEvent.h"
+#include "net/transport/udp/UdpSocketDatagram.h"
+#include "net/transport/udp/UdpSocket.h"
 #include "net/transport/udp/Udp.h"
 
 #include "net/transport/tcp/TcpOptions.h"
@@ -186,6 +189,8 @@
 #include "net/transport/tcp/TcpOutputStreamOfStreams.h"
 #include "net/transport/tcp/TcpInputStream.h"
 #include "net/transport/tcp/TcpOutputStream.h"
+#include "net/transport/tcp/BufferedTcpOutputStream.h"
+#include "net/transport/tcp/TcpConnectionTaskSignal.h"
 #include "net/transport/TransportLayer.h"
 
 // application layer
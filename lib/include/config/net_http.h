@@ -23,7 +23,12 @@
 
 #include "net/application/http/HttpVersion.h"
 #include "net/application/http/HttpMethod.h"
+#include "net/application/http/HttpStringSpan.h"
+#include "net/application/http/HttpRequestParser.h"
 #include "net/application/http/HttpServerConnection.h"
+#include "net/application/http/HttpStaticAsset.h"
+#include "net/application/http/HttpStaticAssetBundle.h"
+#include "net/application/http/HttpStaticAssetConnection.h"
 #include "net/application/http/HttpClient.h"
 
 
@@ -17,7 +17,7 @@
 #error SDIO is not available on the F105/F107
 #endif
 
-// sdcard depends on rcc, device, gpio, nvic, dma, timing
+// sdcard depends on rcc, device, gpio, nvic, dma, timing, task
 
 #include "config/rcc.h"
 #include "config/gpio.h"
@@ -25,6 +25,7 @@
 #include "config/nvic.h"
 #include "config/dma.h"
 #include "config/timing.h"
+#include "config/task.h"
 
 // use interrupts
 
@@ -54,3 +55,4 @@
 
 #include "sdcard/SdCardDetector.h"
 #include "sdcard/SdioDmaSdCard.h"
+#include "sdcard/SdioTaskSignal.h"
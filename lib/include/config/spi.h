@@ -12,13 +12,14 @@
  * via DMA and/or interrupts.
  */
 
-// spi depends on rcc, gpio, dma, stream, event
+// spi depends on rcc, gpio, dma, stream, event, concurrent
 
 #include "config/rcc.h"
 #include "config/gpio.h"
 #include "config/dma.h"
 #include "config/stream.h"
 #include "config/event.h"
+#include "config/concurrent.h"
 
 // device-specific pin initialiser
 
@@ -96,3 +97,4 @@
 
 #include "spi/SpiPollingInputStream.h"
 #include "spi/SpiPollingOutputStream.h"
+#include "spi/SpiTransactionScheduler.h"
@@ -0,0 +1,25 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+/**
+ * @file
+ * Cooperative stackless tasks. Tasks wait for signals raised by peripheral events, or for
+ * timers on a TimerWheel, and a TaskExecutor runs whichever are ready so that several
+ * I/O operations can overlap without an RTOS. Signals for the SDIO and TCP events come in
+ * with config/sdcard.h and config/net.h.
+ */
+
+// task depends on timing, dma
+
+#include "config/timing.h"
+#include "config/dma.h"
+
+#include "task/Task.h"
+#include "task/TaskExecutor.h"
+#include "task/TaskSignal.h"
+#include "task/DmaTaskSignal.h"
@@ -13,7 +13,7 @@
  * drivers to provide a timestamp when you create or modify a file or directory.
  */
 
-// timing depends on timer, rtc
+// timing depends on timer, rtc, concurrent
 
 #include "config/timer.h"
 #include "config/rtc.h"
@@ -26,3 +26,11 @@
 #include "timing/NullTimeProvider.h"
 #include "timing/MicrosecondDelay.h"
 #include "timing/MillisecondTimer.h"
+
+// the timer wheel needs IrqSuspend. config/concurrent.h can't be used here because it
+// includes this file.
+
+#include "concurrent/atomic.h"
+#include "concurrent/IrqSuspend.h"
+#include "timing/TimerWheel.h"
+#include "timing/TimerWheelTimerDriver.h"
@@ -106,3 +106,4 @@
 
 #include "usart/UsartPollingInputStream.h"
 #include "usart/UsartPollingOutputStream.h"
+#include "usart/UsartDmaInputStream.h"
@@ -12,6 +12,8 @@
   // device base include
 
   #include "config/usb/device/device.h"
+  #include "config/stream.h"
+  #include "config/concurrent.h"
 
   // CDC device includes
 
@@ -31,6 +33,8 @@
 
   #include "usb/f4/device/cdc/CdcDevice.h"
   #include "usb/f4/device/cdc/ComPortCdcDevice.h"
+  #include "usb/f4/device/cdc/ComPortCdcInputStream.h"
+  #include "usb/f4/device/cdc/ComPortCdcOutputStream.h"
 
 #endif
 
@@ -0,0 +1,268 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Little endian CRC peripheral fed by DMA. Large word aligned buffers are transferred into
+   * the CRC data register by a DMA channel configured with DmaCrcFeature. There are two ways
+   * to use it:
+   *
+   *   beginWordBuffer() starts a transfer and returns immediately so the CPU can do other
+   *   work, for example reading the next sector of a firmware image. Call isComplete() or
+   *   waitUntilComplete() before reusing the buffer. The DMA can move at most 65535 words at
+   *   a time so a larger buffer is sent in pieces. isComplete() and waitUntilComplete()
+   *   start each piece after the last one finishes.
+   *
+   *   addNewData(const void *,uint32_t), as called by CrcOutputStream, DMAs the aligned
+   *   middle of the buffer if it's at least crc_dmaMinimumBytes long and waits for it to
+   *   finish. Anything unaligned or short goes through the CPU.
+   *
+   * Only the little endian mode is supported because the big endian mode needs each word
+   * to be bit-reversed before it reaches the CRC unit and the DMA cannot do that.
+   *
+   * Example:
+   *   Dma2Channel0Stream0<DmaCrcFeature> dma;     // F4: memory to memory needs DMA2
+   *   CrcDma<Dma2Channel0Stream0<DmaCrcFeature>> crc(dma,params);
+   *
+   * @tparam TDma The DMA channel class, including DmaCrcFeature
+   */
+
+  template<class TDma>
+  class CrcDma : public CrcLittleEndian {
+
+    public:
+      struct Parameters : CrcLittleEndian::Parameters {
+        uint32_t crc_dmaMinimumBytes;         ///< buffers smaller than this go through the CPU (default 256)
+        uint32_t crc_dmaPriority;             ///< default DMA_Priority_Medium
+
+        Parameters(uint8_t padding=0)
+          : CrcLittleEndian::Parameters(padding) {
+          crc_dmaMinimumBytes=256;
+          crc_dmaPriority=DMA_Priority_Medium;
+        }
+      };
+
+    protected:
+      TDma& _dma;
+      uint32_t _minimumBytes;
+      uint32_t _priority;
+      mutable const uint32_t *_next;
+      mutable uint32_t _remaining;
+      mutable bool _busy;
+
+    protected:
+      void beginNextTransfer() const;
+
+    public:
+      CrcDma(TDma& dma,const Parameters& params);
+
+      void reset();
+      uint32_t addNewData(uint8_t nextByte);
+      uint32_t addNewData(const void *data,uint32_t size);
+
+      bool beginWordBuffer(const uint32_t *buffer,uint32_t count);
+      bool isComplete() const;
+      bool waitUntilComplete() const;
+
+      uint32_t finish() const;
+      uint32_t currentCrc() const;
+  };
+
+
+  /**
+   * Constructor
+   * @param dma The DMA channel to use
+   * @param params The parameters
+   */
+
+  template<class TDma>
+  inline CrcDma<TDma>::CrcDma(TDma& dma,const Parameters& params)
+    : CrcLittleEndian(params),
+      _dma(dma),
+      _minimumBytes(params.crc_dmaMinimumBytes),
+      _priority(params.crc_dmaPriority),
+      _next(nullptr),
+      _remaining(0),
+      _busy(false) {
+  }
+
+
+  /**
+   * Reset the calculation. Any transfer in progress is allowed to finish first.
+   */
+
+  template<class TDma>
+  inline void CrcDma<TDma>::reset() {
+    waitUntilComplete();
+    CrcLittleEndian::reset();
+  }
+
+
+  /**
+   * Add a byte to the calculation
+   * @param nextByte The byte to add
+   * @return The current value of the CRC
+   */
+
+  template<class TDma>
+  inline uint32_t CrcDma<TDma>::addNewData(uint8_t nextByte) {
+    waitUntilComplete();
+    return CrcLittleEndian::addNewData(nextByte);
+  }
+
+
+  /**
+   * Add a buffer to the calculation. Returns when the whole buffer has been processed.
+   * @param data The data to add
+   * @param size The number of bytes
+   * @return The current value of the CRC
+   */
+
+  template<class TDma>
+  inline uint32_t CrcDma<TDma>::addNewData(const void *data,uint32_t size) {
+
+    const uint8_t *ptr;
+    uint32_t head,words;
+
+    waitUntilComplete();
+
+    ptr=reinterpret_cast<const uint8_t *>(data);
+
+    // the CPU handles the bytes up to the first word boundary. The DMA can only take over if
+    // that also leaves the CRC unit with no partially assembled word.
+
+    head=(4-(reinterpret_cast<uint32_t>(ptr) & 3)) & 3;
+
+    if(size<_minimumBytes || size<head || ((_currentIndex+head) & 3)!=0)
+      return CrcLittleEndian::addNewData(data,size);
+
+    CrcLittleEndian::addNewData(ptr,head);
+    ptr+=head;
+    size-=head;
+
+    words=size/4;
+
+    beginWordBuffer(reinterpret_cast<const uint32_t *>(ptr),words);
+    waitUntilComplete();
+
+    return CrcLittleEndian::addNewData(ptr+words*4,size & 3);
+  }
+
+
+  /**
+   * Start a DMA transfer of a buffer of words into the CRC unit and return immediately. The
+   * buffer must not be modified until the transfer is complete.
+   * @param buffer The word aligned buffer
+   * @param count The number of words
+   * @return false if there are bytes pending from previous calls to addNewData()
+   */
+
+  template<class TDma>
+  inline bool CrcDma<TDma>::beginWordBuffer(const uint32_t *buffer,uint32_t count) {
+
+    waitUntilComplete();
+
+    if(_currentIndex!=0)
+      return false;
+
+    if(count) {
+      _next=buffer;
+      _remaining=count;
+      beginNextTransfer();
+    }
+
+    return true;
+  }
+
+
+  /**
+   * Start a transfer of as much of the remaining buffer as the DMA can take in one go
+   */
+
+  template<class TDma>
+  inline void CrcDma<TDma>::beginNextTransfer() const {
+
+    uint32_t count;
+
+    count=std::min(_remaining,static_cast<uint32_t>(TDma::MAX_WORDS_PER_TRANSFER));
+
+    _dma.beginCrc(_next,count,_priority);
+
+    _next+=count;
+    _remaining-=count;
+    _busy=true;
+  }
+
+
+  /**
+   * Check if the last transfer has completed
+   * @return true if complete or if there was nothing in progress
+   */
+
+  template<class TDma>
+  inline bool CrcDma<TDma>::isComplete() const {
+
+    if(_busy && _dma.isComplete()) {
+      if(_remaining)
+        beginNextTransfer();
+      else
+        _busy=false;
+    }
+
+    return !_busy;
+  }
+
+
+  /**
+   * Wait for the last transfer to complete
+   * @return false if the DMA reported an error
+   */
+
+  template<class TDma>
+  inline bool CrcDma<TDma>::waitUntilComplete() const {
+
+    bool ok;
+
+    if(!_busy)
+      return true;
+
+    while((ok=_dma.waitUntilComplete()) && _remaining)
+      beginNextTransfer();
+
+    _remaining=0;
+    _busy=false;
+
+    return ok;
+  }
+
+
+  /**
+   * Finish the stream, waiting for any transfer and then writing any remaining bytes
+   * @return The final CRC value
+   */
+
+  template<class TDma>
+  inline uint32_t CrcDma<TDma>::finish() const {
+    waitUntilComplete();
+    return CrcLittleEndian::finish();
+  }
+
+
+  /**
+   * Return the current CRC value, waiting for any transfer to complete first
+   * @return The current CRC
+   */
+
+  template<class TDma>
+  inline uint32_t CrcDma<TDma>::currentCrc() const {
+    waitUntilComplete();
+    return CrcLittleEndian::currentCrc();
+  }
+}
@@ -12,7 +12,9 @@ namespace stm32plus {
 
 
   /**
-   * Template class for a CRC output stream.
+   * Template class for a CRC output stream. TCrc may be any of the hardware CRC classes,
+   * CrcDma or a SoftwareCrc. Buffer writes are passed to the CRC in one call so the
+   * implementation can work a word or more at a time.
    */
 
   template<class TCrc>
@@ -68,12 +70,7 @@ namespace stm32plus {
 
   template<class TCrc>
   inline bool CrcOutputStream<TCrc>::write(const void *buffer,uint32_t size) {
-
-    const uint8_t *ptr=reinterpret_cast<const uint8_t *>(buffer);
-
-    while(size--)
-      _crc.addNewData(*ptr++);
-
+    _crc.addNewData(buffer,size);
     return true;
   }
 
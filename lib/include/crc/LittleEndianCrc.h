@@ -40,6 +40,7 @@ namespace stm32plus {
     public:
       CrcPeripheral(const Parameters& params);
       uint32_t addNewData(uint8_t nextByte);
+      uint32_t addNewData(const void *data,uint32_t size);
       uint32_t calculateWordBuffer(uint32_t *buffer,uint32_t count) const;
 
       uint32_t finish() const;
@@ -93,6 +94,47 @@ namespace stm32plus {
   }
 
 
+  /**
+   * Add a buffer of bytes to the calculation. The result is identical to calling addNewData(uint8_t)
+   * for each byte but whole words are written straight to the CRC data register when there are
+   * no pending bytes, which is several times faster.
+   * @param data The data to add
+   * @param size The number of bytes
+   * @return The current value of the CRC.
+   */
+
+  inline uint32_t CrcPeripheral<Endian::LITTLE_ENDIAN_MCU>::addNewData(const void *data,uint32_t size) {
+
+    const uint8_t *ptr;
+    uint32_t word;
+
+    ptr=reinterpret_cast<const uint8_t *>(data);
+
+    // complete any partial word
+
+    while(size && _currentIndex!=0) {
+      addNewData(*ptr++);
+      size--;
+    }
+
+    // whole words. memcpy keeps this safe on the M0 when the buffer is not aligned
+
+    while(size>=4) {
+      memcpy(&word,ptr,sizeof(word));
+      CRC->DR=word;
+      ptr+=4;
+      size-=4;
+    }
+
+    // remaining bytes
+
+    while(size--)
+      addNewData(*ptr++);
+
+    return currentCrc();
+  }
+
+
   /**
    * Calculate the CRC of an whole buffer of 32-bit words
    * @param buffer The start of the buffer
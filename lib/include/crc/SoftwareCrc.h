@@ -0,0 +1,334 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Parameters for the common CRC algorithms. The names and values follow the usual
+   * Rocksoft model: POLYNOMIAL is given in normal (MSB-first) form, REFLECTED covers both
+   * input and output reflection and CHECK is the CRC of the ASCII string "123456789".
+   */
+
+  struct Crc32Traits {
+    enum { WIDTH=32 };
+    static constexpr uint32_t POLYNOMIAL=0x04C11DB7;
+    static constexpr uint32_t INITIAL=0xFFFFFFFF;
+    static constexpr uint32_t XOR_OUT=0xFFFFFFFF;
+    static constexpr bool REFLECTED=true;
+    static constexpr uint32_t CHECK=0xCBF43926;
+  };
+
+  struct Crc32CTraits {
+    enum { WIDTH=32 };
+    static constexpr uint32_t POLYNOMIAL=0x1EDC6F41;
+    static constexpr uint32_t INITIAL=0xFFFFFFFF;
+    static constexpr uint32_t XOR_OUT=0xFFFFFFFF;
+    static constexpr bool REFLECTED=true;
+    static constexpr uint32_t CHECK=0xE3069283;
+  };
+
+  struct Crc32Mpeg2Traits {
+    enum { WIDTH=32 };
+    static constexpr uint32_t POLYNOMIAL=0x04C11DB7;
+    static constexpr uint32_t INITIAL=0xFFFFFFFF;
+    static constexpr uint32_t XOR_OUT=0;
+    static constexpr bool REFLECTED=false;
+    static constexpr uint32_t CHECK=0x0376E6E7;
+  };
+
+  struct Crc16CcittFalseTraits {
+    enum { WIDTH=16 };
+    static constexpr uint32_t POLYNOMIAL=0x1021;
+    static constexpr uint32_t INITIAL=0xFFFF;
+    static constexpr uint32_t XOR_OUT=0;
+    static constexpr bool REFLECTED=false;
+    static constexpr uint32_t CHECK=0x29B1;
+  };
+
+  struct Crc16XmodemTraits {
+    enum { WIDTH=16 };
+    static constexpr uint32_t POLYNOMIAL=0x1021;
+    static constexpr uint32_t INITIAL=0;
+    static constexpr uint32_t XOR_OUT=0;
+    static constexpr bool REFLECTED=false;
+    static constexpr uint32_t CHECK=0x31C3;
+  };
+
+  struct Crc16ModbusTraits {
+    enum { WIDTH=16 };
+    static constexpr uint32_t POLYNOMIAL=0x8005;
+    static constexpr uint32_t INITIAL=0xFFFF;
+    static constexpr uint32_t XOR_OUT=0;
+    static constexpr bool REFLECTED=true;
+    static constexpr uint32_t CHECK=0x4B37;
+  };
+
+
+  /**
+   * The eight 256 entry lookup tables used by the slicing-by-8 algorithm, generated at
+   * compile time. Reflected CRCs use LSB-first tables with the CRC in the low bits. Normal
+   * CRCs use MSB-first tables with the CRC left-aligned in the 32 bit register so that every
+   * width is handled by the same code. Each table set occupies 8Kb of flash.
+   */
+
+  template<uint32_t TPolynomial,uint8_t TWidth,bool TReflected>
+  struct SoftwareCrcTables {
+
+    uint32_t entries[8][256];
+
+    static constexpr uint32_t reflect(uint32_t value,uint8_t width) {
+
+      uint32_t result=0;
+
+      for(uint8_t i=0;i<width;i++)
+        if(value & (static_cast<uint32_t>(1) << i))
+          result|=static_cast<uint32_t>(1) << (width-1-i);
+
+      return result;
+    }
+
+    constexpr SoftwareCrcTables()
+      : entries() {
+
+      uint32_t poly=0,crc=0;
+
+      if(TReflected) {
+
+        poly=reflect(TPolynomial,TWidth);
+
+        for(uint32_t i=0;i<256;i++) {
+          crc=i;
+          for(uint8_t bit=0;bit<8;bit++)
+            crc=(crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+          entries[0][i]=crc;
+        }
+
+        for(uint32_t i=0;i<256;i++)
+          for(uint8_t t=1;t<8;t++)
+            entries[t][i]=(entries[t-1][i] >> 8) ^ entries[0][entries[t-1][i] & 0xff];
+      }
+      else {
+
+        poly=TPolynomial << (32-TWidth);
+
+        for(uint32_t i=0;i<256;i++) {
+          crc=i << 24;
+          for(uint8_t bit=0;bit<8;bit++)
+            crc=(crc & 0x80000000) ? (crc << 1) ^ poly : crc << 1;
+          entries[0][i]=crc;
+        }
+
+        for(uint32_t i=0;i<256;i++)
+          for(uint8_t t=1;t<8;t++)
+            entries[t][i]=(entries[t-1][i] << 8) ^ entries[0][entries[t-1][i] >> 24];
+      }
+    }
+  };
+
+
+  /**
+   * Table driven software CRC for polynomials that the CRC peripheral cannot do and for
+   * builds where the peripheral is busy or absent. Bulk data is processed 8 bytes per step
+   * using the slicing-by-8 algorithm, single bytes use the first table.
+   *
+   * The interface matches the CRC peripheral classes so that it can be used with
+   * CrcOutputStream. Unlike the peripheral there is no word padding: the CRC is exact
+   * after every byte and finish() simply returns it.
+   *
+   * @tparam TTraits One of the traits structures, e.g. Crc32Traits, or your own with the same members.
+   */
+
+  template<class TTraits>
+  class SoftwareCrc {
+
+    protected:
+      typedef SoftwareCrcTables<TTraits::POLYNOMIAL,TTraits::WIDTH,TTraits::REFLECTED> TablesType;
+
+      static constexpr TablesType _tables=TablesType();
+      static constexpr uint8_t SHIFT=TTraits::REFLECTED ? 0 : 32-TTraits::WIDTH;
+
+      uint32_t _crc;
+
+    protected:
+      static uint32_t loadWord(const uint8_t *ptr);
+
+    public:
+      SoftwareCrc();
+
+      void reset();
+      uint32_t addNewData(uint8_t nextByte);
+      uint32_t addNewData(const void *data,uint32_t size);
+
+      uint32_t finish() const;
+      uint32_t currentCrc() const;
+
+      static uint32_t calculate(const void *data,uint32_t size);
+  };
+
+
+  template<class TTraits>
+  constexpr typename SoftwareCrc<TTraits>::TablesType SoftwareCrc<TTraits>::_tables;
+
+
+  /**
+   * Typedefs for easy use
+   */
+
+  typedef SoftwareCrc<Crc32Traits> SoftwareCrc32;
+  typedef SoftwareCrc<Crc32CTraits> SoftwareCrc32C;
+  typedef SoftwareCrc<Crc32Mpeg2Traits> SoftwareCrc32Mpeg2;
+  typedef SoftwareCrc<Crc16CcittFalseTraits> SoftwareCrc16CcittFalse;
+  typedef SoftwareCrc<Crc16XmodemTraits> SoftwareCrc16Xmodem;
+  typedef SoftwareCrc<Crc16ModbusTraits> SoftwareCrc16Modbus;
+
+
+  /**
+   * Constructor
+   */
+
+  template<class TTraits>
+  inline SoftwareCrc<TTraits>::SoftwareCrc() {
+    reset();
+  }
+
+
+  /**
+   * Reset the calculation ready for re-use
+   */
+
+  template<class TTraits>
+  inline void SoftwareCrc<TTraits>::reset() {
+    _crc=TTraits::INITIAL << SHIFT;
+  }
+
+
+  /**
+   * Load 4 bytes in the order the algorithm needs: little endian for reflected CRCs and big
+   * endian for normal CRCs. memcpy keeps this safe on the M0 when the pointer is not aligned.
+   * @param ptr Where to load from
+   * @return The word
+   */
+
+  template<class TTraits>
+  inline uint32_t SoftwareCrc<TTraits>::loadWord(const uint8_t *ptr) {
+
+    uint32_t word;
+
+    memcpy(&word,ptr,sizeof(word));
+    return TTraits::REFLECTED ? word : __builtin_bswap32(word);
+  }
+
+
+  /**
+   * Add a byte to the calculation
+   * @param nextByte The byte to add
+   * @return The current CRC value
+   */
+
+  template<class TTraits>
+  inline uint32_t SoftwareCrc<TTraits>::addNewData(uint8_t nextByte) {
+
+    if(TTraits::REFLECTED)
+      _crc=(_crc >> 8) ^ _tables.entries[0][(_crc ^ nextByte) & 0xff];
+    else
+      _crc=(_crc << 8) ^ _tables.entries[0][(_crc >> 24) ^ nextByte];
+
+    return currentCrc();
+  }
+
+
+  /**
+   * Add a buffer to the calculation. Runs of 8 bytes are processed in one step.
+   * @param data The data to add
+   * @param size The number of bytes
+   * @return The current CRC value
+   */
+
+  template<class TTraits>
+  inline uint32_t SoftwareCrc<TTraits>::addNewData(const void *data,uint32_t size) {
+
+    const uint8_t *ptr;
+    uint32_t crc,high;
+
+    ptr=reinterpret_cast<const uint8_t *>(data);
+    crc=_crc;
+
+    while(size>=8) {
+
+      crc^=loadWord(ptr);
+      high=loadWord(ptr+4);
+
+      if(TTraits::REFLECTED)
+        crc=_tables.entries[7][crc & 0xff] ^
+            _tables.entries[6][(crc >> 8) & 0xff] ^
+            _tables.entries[5][(crc >> 16) & 0xff] ^
+            _tables.entries[4][crc >> 24] ^
+            _tables.entries[3][high & 0xff] ^
+            _tables.entries[2][(high >> 8) & 0xff] ^
+            _tables.entries[1][(high >> 16) & 0xff] ^
+            _tables.entries[0][high >> 24];
+      else
+        crc=_tables.entries[7][crc >> 24] ^
+            _tables.entries[6][(crc >> 16) & 0xff] ^
+            _tables.entries[5][(crc >> 8) & 0xff] ^
+            _tables.entries[4][crc & 0xff] ^
+            _tables.entries[3][high >> 24] ^
+            _tables.entries[2][(high >> 16) & 0xff] ^
+            _tables.entries[1][(high >> 8) & 0xff] ^
+            _tables.entries[0][high & 0xff];
+
+      ptr+=8;
+      size-=8;
+    }
+
+    _crc=crc;
+
+    while(size--)
+      addNewData(*ptr++);
+
+    return currentCrc();
+  }
+
+
+  /**
+   * Finish the calculation. There is nothing pending in the software implementation.
+   * @return The final CRC value
+   */
+
+  template<class TTraits>
+  inline uint32_t SoftwareCrc<TTraits>::finish() const {
+    return currentCrc();
+  }
+
+
+  /**
+   * Return the current CRC value with the final XOR applied
+   * @return The current CRC
+   */
+
+  template<class TTraits>
+  inline uint32_t SoftwareCrc<TTraits>::currentCrc() const {
+    return (_crc >> SHIFT) ^ TTraits::XOR_OUT;
+  }
+
+
+  /**
+   * Convenience function to calculate the CRC of a single buffer
+   * @param data The data
+   * @param size The number of bytes
+   * @return The CRC
+   */
+
+  template<class TTraits>
+  inline uint32_t SoftwareCrc<TTraits>::calculate(const void *data,uint32_t size) {
+
+    SoftwareCrc<TTraits> crc;
+    return crc.addNewData(data,size);
+  }
+}
@@ -0,0 +1,414 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+/*
+ * The number of call sites that can be tracked individually. Must be a power of 2. Sites
+ * seen after the table fills up are accumulated into a single catch-all entry.
+ */
+
+#if !defined(STM32PLUS_HEAP_PROFILER_SITES)
+#define STM32PLUS_HEAP_PROFILER_SITES 32
+#endif
+
+
+namespace stm32plus {
+
+  /**
+   * Allocation profiler with call-site attribution. Each allocation is prefixed with an 8
+   * byte header that records its size and the table slot of the code that made it, so that
+   * a free can be charged back to the right site. Sites are identified by return address,
+   * which you can turn back into a source line with arm-none-eabi-addr2line.
+   *
+   * For each site the profiler keeps the number of allocations and frees, the live bytes and
+   * blocks, and the high water mark of live bytes. The same is kept for the heap as a whole.
+   *
+   * When the library is built with heapprofiler=yes (STM32PLUS_HEAP_PROFILER) the global
+   * profiler returned by getHeapProfiler() is wired into operator new/delete and the bundled
+   * STL, and HeapMonitor appends a snapshot to each of its reports. Without that define
+   * nothing is hooked and nothing is linked.
+   *
+   * This class has no MCU dependencies so it can be used in host builds to check unit tests
+   * for leaks: wrap your test's allocator with recordAllocation()/recordFree(), take
+   * getTotals() before the code under test and call leaksSince() afterwards.
+   *
+   * Snapshots are written with writeSnapshot() to anything with stream operators for strings
+   * and uint32_t, e.g.:
+   *   TextOutputStream over a UsartPollingOutputStream or a net::TcpOutputStream
+   *   TextOutputStream over a SemiHostingOutputStream
+   *   std::ostream in a host build
+   *
+   * The class itself is not interrupt safe. The global profiledAllocate() and profiledFree()
+   * suspend IRQs around it and the heap so they can be called from an IRQ handler.
+   */
+
+  class HeapProfiler {
+
+    public:
+      enum {
+        MAX_SITES = STM32PLUS_HEAP_PROFILER_SITES,
+        OTHER_SITE = MAX_SITES,             ///< slot for sites that didn't fit in the table
+        HEADER_SIZE = 8                     ///< bytes added to the front of each allocation
+      };
+
+      /**
+       * Counters for one call site
+       */
+
+      struct Site {
+        const void *address;                ///< return address of the allocating call, nullptr for the catch-all
+        uint32_t allocations;               ///< total allocations
+        uint32_t frees;                     ///< total frees of blocks allocated here
+        uint32_t liveBytes;                 ///< bytes currently allocated
+        uint32_t peakLiveBytes;             ///< high water mark of liveBytes
+        uint32_t liveBlocks;                ///< blocks currently allocated
+      };
+
+      /**
+       * Counters for the whole heap
+       */
+
+      struct Totals {
+        uint32_t allocations;
+        uint32_t frees;
+        uint32_t failures;                  ///< allocations that the underlying heap refused
+        uint32_t corruptions;               ///< frees of blocks with a damaged header, which are leaked
+        uint32_t liveBytes;
+        uint32_t peakLiveBytes;
+        uint32_t liveBlocks;
+      };
+
+    protected:
+      struct Header {
+        uint32_t size;
+        uint16_t site;
+        uint16_t guard;
+      };
+
+      enum {
+        GUARD = 0xA55A
+      };
+
+      static_assert((MAX_SITES & (MAX_SITES-1))==0,"STM32PLUS_HEAP_PROFILER_SITES must be a power of 2");
+      static_assert(sizeof(Header)==HEADER_SIZE,"Unexpected header size");
+
+      Site _sites[MAX_SITES+1];
+      Totals _totals;
+
+    protected:
+      uint16_t findSite(const void *address);
+
+      template<class TStream>
+      static void writeAddress(TStream& os,const void *address);
+
+    public:
+      HeapProfiler();
+
+      void reset();
+
+      void *recordAllocation(void *block,uint32_t size,const void *address);
+      void *recordFree(void *ptr);
+      uint32_t allocationSize(const void *ptr) const;
+
+      const Totals& getTotals() const;
+      const Site& getSite(uint16_t index) const;
+      uint32_t leaksSince(const Totals& checkpoint) const;
+
+      template<class TStream>
+      void writeSnapshot(TStream& os) const;
+  };
+
+
+#if defined(STM32PLUS_HEAP_PROFILER)
+
+  /*
+   * The global profiler and the allocation functions that feed it, all in
+   * lib/src/debug/HeapProfiler.cpp. The underlying heap is the pool heap when built with
+   * allocator=pool, otherwise newlib malloc.
+   */
+
+  HeapProfiler& getHeapProfiler();
+  void *profiledAllocate(uint32_t size,const void *address);
+  void profiledFree(void *ptr);
+
+#endif
+
+
+  /**
+   * Constructor
+   */
+
+  inline HeapProfiler::HeapProfiler() {
+    reset();
+  }
+
+
+  /**
+   * Forget everything. Don't do this while blocks allocated through the profiler are live
+   * because their frees will be charged to the wrong sites.
+   */
+
+  inline void HeapProfiler::reset() {
+    memset(_sites,0,sizeof(_sites));
+    memset(&_totals,0,sizeof(_totals));
+  }
+
+
+  /**
+   * Find or create the table slot for a call site. The table is open addressed with linear
+   * probing so a lookup is normally one or two comparisons.
+   * @param address The return address of the allocating call
+   * @return The slot index, or OTHER_SITE if the table is full
+   */
+
+  inline uint16_t HeapProfiler::findSite(const void *address) {
+
+    uint32_t hash;
+    uint16_t i,index;
+
+    hash=static_cast<uint32_t>(reinterpret_cast<uintptr_t>(address) >> 1)*2654435761u;
+
+    for(i=0;i<MAX_SITES;i++) {
+
+      index=(hash+i) & (MAX_SITES-1);
+
+      if(_sites[index].address==address)
+        return index;
+
+      if(_sites[index].address==nullptr) {
+        _sites[index].address=address;
+        return index;
+      }
+    }
+
+    return OTHER_SITE;
+  }
+
+
+  /**
+   * Record an allocation. The caller allocates size+HEADER_SIZE bytes from the real heap and
+   * passes the result here.
+   * @param block The memory from the real heap, or nullptr if it failed
+   * @param size The size that the application asked for
+   * @param address The return address of the allocating call
+   * @return The pointer to give to the application, HEADER_SIZE bytes into the block
+   */
+
+  inline void *HeapProfiler::recordAllocation(void *block,uint32_t size,const void *address) {
+
+    Header *header;
+    Site *site;
+    uint16_t index;
+
+    if(!block) {
+      _totals.failures++;
+      return nullptr;
+    }
+
+    index=findSite(address);
+    site=&_sites[index];
+
+    header=reinterpret_cast<Header *>(block);
+    header->size=size;
+    header->site=index;
+    header->guard=GUARD;
+
+    site->allocations++;
+    site->liveBlocks++;
+    if((site->liveBytes+=size)>site->peakLiveBytes)
+      site->peakLiveBytes=site->liveBytes;
+
+    _totals.allocations++;
+    _totals.liveBlocks++;
+    if((_totals.liveBytes+=size)>_totals.peakLiveBytes)
+      _totals.peakLiveBytes=_totals.liveBytes;
+
+    return header+1;
+  }
+
+
+  /**
+   * Record a free
+   * @param ptr The pointer that the application is freeing. nullptr is ignored.
+   * @return The block to give back to the real heap, or nullptr if there isn't one
+   */
+
+  inline void *HeapProfiler::recordFree(void *ptr) {
+
+    Header *header;
+    Site *site;
+
+    if(!ptr)
+      return nullptr;
+
+    header=reinterpret_cast<Header *>(ptr)-1;
+
+    // with a damaged header we can't be sure that ptr came from us at all. Count it and leak
+    // it rather than hand the heap something that might not be one of its blocks.
+
+    if(header->guard!=GUARD || header->site>OTHER_SITE) {
+      _totals.corruptions++;
+      return nullptr;
+    }
+
+    site=&_sites[header->site];
+
+    site->frees++;
+    site->liveBlocks--;
+    site->liveBytes-=header->size;
+
+    _totals.frees++;
+    _totals.liveBlocks--;
+    _totals.liveBytes-=header->size;
+
+    header->guard=0;
+    return header;
+  }
+
+
+  /**
+   * Get the size that the application asked for when it allocated a block
+   */
+
+  inline uint32_t HeapProfiler::allocationSize(const void *ptr) const {
+    return (reinterpret_cast<const Header *>(ptr)-1)->size;
+  }
+
+
+  /**
+   * Get the whole-heap counters
+   */
+
+  inline const HeapProfiler::Totals& HeapProfiler::getTotals() const {
+    return _totals;
+  }
+
+
+  /**
+   * Get a site. Slots with a nullptr address are unused, except OTHER_SITE which is the
+   * catch-all for sites that didn't fit in the table.
+   * @param index 0..MAX_SITES inclusive
+   */
+
+  inline const HeapProfiler::Site& HeapProfiler::getSite(uint16_t index) const {
+    return _sites[index];
+  }
+
+
+  /**
+   * Get the number of blocks allocated since a checkpoint that have not been freed. Blocks
+   * that were live at the checkpoint and freed since will hide the same number of leaks, so
+   * take the checkpoint when the code under test has nothing allocated.
+   * @param checkpoint A copy of getTotals() taken earlier
+   * @return The number of leaked blocks
+   */
+
+  inline uint32_t HeapProfiler::leaksSince(const Totals& checkpoint) const {
+
+    uint32_t allocated,freed;
+
+    allocated=_totals.allocations-checkpoint.allocations;
+    freed=_totals.frees-checkpoint.frees;
+
+    return allocated>freed ? allocated-freed : 0;
+  }
+
+
+  /**
+   * Write an address in hex
+   */
+
+  template<class TStream>
+  inline void HeapProfiler::writeAddress(TStream& os,const void *address) {
+
+    char buffer[sizeof(uintptr_t)*2+3],*ptr;
+    uintptr_t value;
+
+    value=reinterpret_cast<uintptr_t>(address);
+
+    ptr=buffer+sizeof(buffer)-1;
+    *ptr='\0';
+
+    do {
+      *--ptr="0123456789abcdef"[value & 0xf];
+      value>>=4;
+    } while(ptr>buffer+2);
+
+    buffer[0]='0';
+    buffer[1]='x';
+
+    os << static_cast<const char *>(buffer);
+  }
+
+
+  /**
+   * Write a snapshot as lines of comma separated values:
+   *   profile,allocations,frees,failures,corruptions,liveBytes,peakLiveBytes,liveBlocks
+   *   heap,freeBytes,freeBlocks,largestFreeBlock,fragmentationPercent
+   *   site,address,allocations,frees,liveBytes,peakLiveBytes,liveBlocks    (one per used slot)
+   *
+   * The heap line describes the global heap and is only written by the global profiler. With
+   * newlib the largest free block is not known so the releasable top chunk is reported
+   * instead, and the fragmentation is an upper bound. The catch-all site, if used, has
+   * address 0x0.
+   * @param os The stream to write to
+   */
+
+  template<class TStream>
+  inline void HeapProfiler::writeSnapshot(TStream& os) const {
+
+    os << "profile,"
+       << _totals.allocations << ","
+       << _totals.frees << ","
+       << _totals.failures << ","
+       << _totals.corruptions << ","
+       << _totals.liveBytes << ","
+       << _totals.peakLiveBytes << ","
+       << _totals.liveBlocks << "\r\n";
+
+  #if defined(STM32PLUS_HEAP_PROFILER) && defined(STM32PLUS_ALLOCATOR_POOL)
+
+    const TlsfHeap& tlsf=getPoolHeap().getTlsfHeap();
+
+    os << "heap,"
+       << tlsf.bytesFree() << ","
+       << tlsf.getStatistics().blocksFree << ","
+       << tlsf.largestFreeBlock() << ","
+       << static_cast<uint32_t>(tlsf.fragmentation()) << "\r\n";
+
+  #elif defined(STM32PLUS_HEAP_PROFILER)
+
+    struct mallinfo minfo=mallinfo();
+
+    os << "heap,"
+       << (uint32_t)minfo.fordblks << ","
+       << (uint32_t)minfo.ordblks << ","
+       << (uint32_t)minfo.keepcost << ","
+       << (uint32_t)(minfo.fordblks ? 100-(static_cast<uint64_t>(minfo.keepcost)*100)/minfo.fordblks : 0) << "\r\n";
+
+  #endif
+
+    for(uint16_t i=0;i<=MAX_SITES;i++) {
+
+      const Site& site=_sites[i];
+
+      if(!site.allocations)
+        continue;
+
+      os << "site,";
+      writeAddress(os,site.address);
+
+      os << ","
+         << site.allocations << ","
+         << site.frees << ","
+         << site.liveBytes << ","
+         << site.peakLiveBytes << ","
+         << site.liveBlocks << "\r\n";
+    }
+  }
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Output stream that writes to the debugger's console through semihosting. Output is
+   * collected in a small buffer and sent a line (or a buffer full) at a time because each
+   * semihosting call halts the core. Without SEMIHOSTING defined the output is discarded.
+   *
+   * Example:
+   *   SemiHostingOutputStream shos;
+   *   TextOutputStream tos(shos);
+   *   getHeapProfiler().writeSnapshot(tos);
+   */
+
+  class SemiHostingOutputStream : public OutputStream {
+
+    public:
+      enum {
+        BUFFER_SIZE = 64
+      };
+
+    protected:
+      char _buffer[BUFFER_SIZE+1];
+      uint8_t _used;
+
+    public:
+      SemiHostingOutputStream();
+      virtual ~SemiHostingOutputStream();
+
+      // overrides from OutputStream
+
+      virtual bool write(uint8_t c) override;
+      virtual bool write(const void *buffer,uint32_t size) override;
+      virtual bool close() override;
+      virtual bool flush() override;
+  };
+
+
+  /**
+   * Constructor
+   */
+
+  inline SemiHostingOutputStream::SemiHostingOutputStream()
+    : _used(0) {
+  }
+
+
+  /**
+   * Destructor, flush any remaining output
+   */
+
+  inline SemiHostingOutputStream::~SemiHostingOutputStream() {
+    flush();
+  }
+
+
+  /**
+   * Write a byte. Output is sent at the end of a line or when the buffer is full.
+   * @param c The byte
+   * @return true
+   */
+
+  inline bool SemiHostingOutputStream::write(uint8_t c) {
+
+    _buffer[_used++]=c;
+
+    if(c=='\n' || _used==BUFFER_SIZE)
+      flush();
+
+    return true;
+  }
+
+
+  /**
+   * Write a buffer
+   * @param buffer The data
+   * @param size The number of bytes
+   * @return true
+   */
+
+  inline bool SemiHostingOutputStream::write(const void *buffer,uint32_t size) {
+
+    const uint8_t *ptr;
+
+    for(ptr=reinterpret_cast<const uint8_t *>(buffer);size--;ptr++)
+      write(*ptr);
+
+    return true;
+  }
+
+
+  /**
+   * Send the buffered output to the debugger
+   * @return true
+   */
+
+  inline bool SemiHostingOutputStream::flush() {
+
+    if(_used) {
+      _buffer[_used]='\0';
+      SemiHosting::puts(_buffer);
+      _used=0;
+    }
+
+    return true;
+  }
+
+
+  /**
+   * Close is the same as flush
+   */
+
+  inline bool SemiHostingOutputStream::close() {
+    return flush();
+  }
+}
@@ -15,6 +15,14 @@ namespace stm32plus {
    * The heap monitor class provides a period dump of the state of the heap
    * to an output stream. The RTC is used to provide the interrupt that we
    * use to get the heap state.
+   *
+   * If a PoolHeap is being monitored then the mallinfo line is followed by
+   * one line per pool:
+   *   pool,blockSize,blockCount,blocksUsed,peakBlocksUsed,allocations,failures,overflows
+   * and one line for the TLSF heap behind the pools:
+   *   tlsf,arenaSize,bytesUsed,peakBytesUsed,blocksUsed,blocksFree,bytesFree,largestFreeBlock,failures
+   * The global pool heap is monitored automatically when built with allocator=pool.
+   * When built with heapprofiler=yes a HeapProfiler snapshot follows.
    */
 
   class HeapMonitor {
@@ -24,8 +32,12 @@ namespace stm32plus {
       TextOutputStream  *_os;
       uint32_t _frequency;
       uint32_t _currentTick;
+      const PoolHeap *_poolHeap;
 
     protected:
+      void writeStatistics();
+      void writePoolHeapStatistics();
+
     #if defined(STM32PLUS_F4)
       void onTick(uint8_t extiNumber);
     #elif defined(STM32PLUS_F1)
@@ -40,6 +52,8 @@ namespace stm32plus {
 
       void start(RtcSecondInterruptFeature& rtc,OutputStream& os,uint32_t frequency);
       void stop();
+
+      void monitorPoolHeap(const PoolHeap& heap);
   };
 
 
@@ -49,7 +63,12 @@ namespace stm32plus {
 
   inline HeapMonitor::HeapMonitor()
     : _rtc(nullptr),
-      _os(nullptr) {
+      _os(nullptr),
+  #if defined(STM32PLUS_ALLOCATOR_POOL)
+      _poolHeap(&getPoolHeap()) {
+  #else
+      _poolHeap(nullptr) {
+  #endif
   }
 
 
@@ -109,17 +128,20 @@ namespace stm32plus {
 
 
   /**
-   * We ticked.
+   * Also report on a pool heap
+   * @param heap The heap to monitor
    */
 
-#if defined(STM32PLUS_F4)
+  inline void HeapMonitor::monitorPoolHeap(const PoolHeap& heap) {
+    _poolHeap=&heap;
+  }
 
-  inline void HeapMonitor::onTick(uint8_t /* extiNumber */) {
 
-    // check frequency
+  /**
+   * Write the statistics to the output stream
+   */
 
-    if(++_currentTick<_frequency)
-      return;
+  inline void HeapMonitor::writeStatistics() {
 
     // get statistics
 
@@ -134,30 +156,77 @@ namespace stm32plus {
          << (uint32_t)minfo.uordblks << ","
          << (uint32_t)minfo.fordblks << ","
          << (uint32_t)minfo.keepcost << "\r\n";
+
+    if(_poolHeap)
+      writePoolHeapStatistics();
+
+  #if defined(STM32PLUS_HEAP_PROFILER)
+    getHeapProfiler().writeSnapshot(*_os);
+  #endif
   }
 
-#elif defined(STM32PLUS_F1)
 
-  inline void HeapMonitor::onTick(void) {
+  /**
+   * Write the per-pool and TLSF statistics to the output stream
+   */
+
+  inline void HeapMonitor::writePoolHeapStatistics() {
+
+    for(uint8_t i=0;i<_poolHeap->getPoolCount();i++) {
+
+      const FixedBlockPool::Statistics& pool=_poolHeap->getPool(i).getStatistics();
+
+      *_os << "pool,"
+           << (uint32_t)pool.blockSize << ","
+           << (uint32_t)pool.blockCount << ","
+           << (uint32_t)pool.blocksUsed << ","
+           << (uint32_t)pool.peakBlocksUsed << ","
+           << pool.allocations << ","
+           << pool.failures << ","
+           << _poolHeap->getPoolOverflows(i) << "\r\n";
+    }
+
+    const TlsfHeap& tlsf=_poolHeap->getTlsfHeap();
+    const TlsfHeap::Statistics& stats=tlsf.getStatistics();
+
+    *_os << "tlsf,"
+         << stats.arenaSize << ","
+         << stats.bytesUsed << ","
+         << stats.peakBytesUsed << ","
+         << stats.blocksUsed << ","
+         << stats.blocksFree << ","
+         << tlsf.bytesFree() << ","
+         << tlsf.largestFreeBlock() << ","
+         << stats.failures << "\r\n";
+  }
+
+
+  /**
+   * We ticked.
+   */
+
+#if defined(STM32PLUS_F4)
+
+  inline void HeapMonitor::onTick(uint8_t /* extiNumber */) {
 
     // check frequency
 
     if(++_currentTick<_frequency)
       return;
 
-    // get statistics
+    writeStatistics();
+  }
 
-    struct mallinfo minfo=mallinfo();
+#elif defined(STM32PLUS_F1)
 
-    // send to the output stream
+  inline void HeapMonitor::onTick(void) {
 
-    *_os << (uint32_t)minfo.arena << ","
-         << (uint32_t)minfo.ordblks << ","
-         << (uint32_t)minfo.hblks << ","
-         << (uint32_t)minfo.hblkhd << ","
-         << (uint32_t)minfo.uordblks << ","
-         << (uint32_t)minfo.fordblks << ","
-         << (uint32_t)minfo.keepcost << "\r\n";
+    // check frequency
+
+    if(++_currentTick<_frequency)
+      return;
+
+    writeStatistics();
   }
 
 #else
@@ -0,0 +1,214 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+/**
+ * @file
+ * Alpha blending kernels for RGB565 pixels held in memory. The blend uses the well known trick
+ * of spreading the 5-6-5 channels out into a 32-bit word (0x07E0F81F) so that all three channels
+ * can be blended with a single multiply. Alpha is supplied as 0..255 and reduced to 5 bits
+ * internally. When the buffers are word aligned the kernels move pixels in pairs so that memory
+ * traffic is halved. A 50% blend is special-cased as a pairwise masked average.
+ */
+
+namespace stm32plus {
+  namespace display {
+    namespace alphablend {
+
+
+      /**
+       * True if a device's UnpackedColour is a native-endian 5-6-5 halfword, i.e. it has a
+       * packed565 member. The 8-bit interface panels use a byte pair in transfer order
+       * instead, which is the same size but not the same layout.
+       */
+
+      template<class TUnpackedColour>
+      struct IsPacked565 {
+
+        template<class T,uint16_t T::*>
+        struct Member {};
+
+        template<class T>
+        static char test(Member<T,&T::packed565> *);
+
+        template<class T>
+        static long test(...);
+
+        enum {
+          value = sizeof(test<TUnpackedColour>(nullptr))==sizeof(char) && sizeof(TUnpackedColour)==sizeof(uint16_t)
+        };
+      };
+
+
+      /**
+       * Spread a 5-6-5 pixel out into 00000GGGGGG00000RRRRR000000BBBBB
+       * @param c the pixel
+       * @return the expanded pixel
+       */
+
+      inline uint32_t expand565(uint16_t c) {
+        return (c | (static_cast<uint32_t>(c) << 16)) & 0x07E0F81F;
+      }
+
+
+      /**
+       * Reverse of expand565
+       * @param e the expanded pixel
+       * @return the 5-6-5 pixel
+       */
+
+      inline uint16_t compress565(uint32_t e) {
+        return static_cast<uint16_t>(e | (e >> 16));
+      }
+
+
+      /**
+       * Convert an 8-bit alpha to the 0..32 range used by the kernels
+       * @param alpha 0 (transparent) to 255 (opaque)
+       * @return 0..32
+       */
+
+      inline uint32_t reduceAlpha(uint8_t alpha) {
+        return (static_cast<uint32_t>(alpha)+4) >> 3;
+      }
+
+
+      /**
+       * Blend an expanded foreground over a background pixel
+       * @param fg The expanded foreground
+       * @param bg The background 5-6-5 pixel
+       * @param alpha5 0..32
+       * @return The blended 5-6-5 pixel
+       */
+
+      inline uint16_t blendExpanded(uint32_t fg,uint16_t bg,uint32_t alpha5) {
+
+        uint32_t e;
+
+        e=expand565(bg);
+        e=((((fg-e)*alpha5) >> 5)+e) & 0x07E0F81F;
+
+        return compress565(e);
+      }
+
+
+      /**
+       * Average two pairs of 5-6-5 pixels packed into 32-bit words. The low bit of each channel is
+       * masked off before the shift so that nothing crosses a channel or pixel boundary.
+       * @param a The first pair
+       * @param b The second pair
+       * @return the averaged pair
+       */
+
+      inline uint32_t average565x2(uint32_t a,uint32_t b) {
+        return (((a ^ b) & 0xF7DEF7DE) >> 1)+(a & b);
+      }
+
+
+      /**
+       * Return true if all the pointers are word aligned and the pairwise loops can be used
+       */
+
+      inline bool isWordAligned(const void *p1,const void *p2,const void *p3) {
+        return ((reinterpret_cast<uint32_t>(p1) | reinterpret_cast<uint32_t>(p2) | reinterpret_cast<uint32_t>(p3)) & 3)==0;
+      }
+
+
+      /**
+       * Blend a solid colour over a line of background pixels
+       * @param dest Where to write the output. May be the same as background.
+       * @param background The background pixels
+       * @param count The number of pixels
+       * @param colour The 5-6-5 colour to blend
+       * @param alpha 0 (transparent) to 255 (opaque)
+       */
+
+      inline void blendColour(uint16_t *dest,const uint16_t *background,uint32_t count,uint16_t colour,uint8_t alpha) {
+
+        uint32_t fg,alpha5,pair;
+
+        alpha5=reduceAlpha(alpha);
+        fg=expand565(colour);
+
+        if(isWordAligned(dest,background,background)) {
+
+          uint32_t *dest32=reinterpret_cast<uint32_t *>(dest);
+          const uint32_t *bg32=reinterpret_cast<const uint32_t *>(background);
+
+          if(alpha5==16) {
+
+            pair=colour | (static_cast<uint32_t>(colour) << 16);
+
+            for(;count>=2;count-=2)
+              *dest32++=average565x2(pair,*bg32++);
+          }
+          else {
+
+            for(;count>=2;count-=2) {
+              pair=*bg32++;
+              *dest32++=blendExpanded(fg,pair,alpha5) | (static_cast<uint32_t>(blendExpanded(fg,pair >> 16,alpha5)) << 16);
+            }
+          }
+
+          dest=reinterpret_cast<uint16_t *>(dest32);
+          background=reinterpret_cast<const uint16_t *>(bg32);
+        }
+
+        while(count--)
+          *dest++=blendExpanded(fg,*background++,alpha5);
+      }
+
+
+      /**
+       * Blend a line of foreground pixels over a line of background pixels
+       * @param dest Where to write the output. May be the same as either of the sources.
+       * @param foreground The foreground pixels
+       * @param background The background pixels
+       * @param count The number of pixels
+       * @param alpha 0 (transparent) to 255 (opaque)
+       */
+
+      inline void blendPixels(uint16_t *dest,const uint16_t *foreground,const uint16_t *background,uint32_t count,uint8_t alpha) {
+
+        uint32_t alpha5,fpair,bpair;
+
+        alpha5=reduceAlpha(alpha);
+
+        if(isWordAligned(dest,foreground,background)) {
+
+          uint32_t *dest32=reinterpret_cast<uint32_t *>(dest);
+          const uint32_t *fg32=reinterpret_cast<const uint32_t *>(foreground);
+          const uint32_t *bg32=reinterpret_cast<const uint32_t *>(background);
+
+          if(alpha5==16) {
+            for(;count>=2;count-=2)
+              *dest32++=average565x2(*fg32++,*bg32++);
+          }
+          else {
+
+            for(;count>=2;count-=2) {
+
+              fpair=*fg32++;
+              bpair=*bg32++;
+
+              *dest32++=blendExpanded(expand565(fpair),bpair,alpha5)
+                      | (static_cast<uint32_t>(blendExpanded(expand565(fpair >> 16),bpair >> 16,alpha5)) << 16);
+            }
+          }
+
+          dest=reinterpret_cast<uint16_t *>(dest32);
+          foreground=reinterpret_cast<const uint16_t *>(fg32);
+          background=reinterpret_cast<const uint16_t *>(bg32);
+        }
+
+        while(count--)
+          *dest++=blendExpanded(expand565(*foreground++),*background++,alpha5);
+      }
+    }
+  }
+}
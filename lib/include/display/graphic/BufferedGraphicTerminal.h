@@ -0,0 +1,528 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace display {
+
+    /**
+     * Character terminal that keeps the text in a buffer of character cells and renders to the
+     * display only when flushed. Writing a character just updates a cell and marks its row as
+     * dirty. A flush then renders each dirty row exactly once, in one window, by expanding the
+     * glyphs a scan line at a time into a buffer of native pixels and raw-transferring it.
+     *
+     * write(buffer,size), writeString() and the stream operators flush once when they return so
+     * a flood of output costs one frame update rather than one window per character. Call
+     * flush() yourself if you write individual characters with writeCharacter().
+     *
+     * The cell buffer is a ring of rows. When hardware scrolling is available the ring maps
+     * directly on to the panel's GRAM and scrolling moves the scroll position by a whole text
+     * row. Without hardware scrolling the rows are shifted in the ring and the whole screen is
+     * re-rendered on the next flush, so a burst of many lines is still only drawn once.
+     *
+     * The font must be fixed width. Heap usage is one byte per character cell plus one scan line
+     * of pixels.
+     *
+     * @tparam TGraphicsLibrary The complete type of the graphics library being used.
+     * @tparam THardwareScrolling Set to true if scrolling supported.
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    class BufferedGraphicTerminal : public OutputStream {
+
+      protected:
+        typedef typename TGraphicsLibrary::UnpackedColour UnpackedColour;
+
+        TGraphicsLibrary& _gl;
+        const Font *_font;
+        bool _autoLineFeed;
+
+        Size _terminalSize;
+        Size _fontSize;
+        Point _cursor;                        // X is the column, Y is the row on screen
+        int16_t _topRow;                      // ring index of the row at the top of the screen
+        bool _scrolled;                       // hardware scroll position needs updating
+
+        scoped_array<char> _cells;            // terminal width * height characters
+        scoped_array<bool> _dirty;            // one flag per ring row
+        scoped_array<const FontChar *> _glyphs; // glyphs for the row being rendered
+        scoped_array<uint8_t> _lineBuffer;    // one scan line of native pixels
+
+      protected:
+        void calcTerminalSize();
+        void incrementY();
+        void renderRow(int16_t ringRow);
+        int16_t getRingRow(int16_t screenRow) const;
+        int16_t getDisplayRow(int16_t ringRow) const;
+        void clearRingRow(int16_t ringRow);
+
+      public:
+        BufferedGraphicTerminal(
+            TGraphicsLibrary& gl,
+            const Font *font=nullptr,
+            bool autoLineFeed=false);
+
+        virtual ~BufferedGraphicTerminal() {}
+
+        void writeCharacter(char c);
+        void writeString(const char *str);
+
+        BufferedGraphicTerminal& operator<<(const char *str);
+        BufferedGraphicTerminal& operator<<(char c);
+        BufferedGraphicTerminal& operator<<(int32_t val);
+        BufferedGraphicTerminal& operator<<(uint32_t val);
+        BufferedGraphicTerminal& operator<<(int16_t val);
+        BufferedGraphicTerminal& operator<<(uint16_t val);
+        BufferedGraphicTerminal& operator<<(const DoublePrecision& val);
+        BufferedGraphicTerminal& operator<<(double val);
+
+        void clearScreen();
+        void clearLine();
+
+        // overrides from OutputStream
+
+        virtual bool write(uint8_t c) override;
+        virtual bool write(const void *buffer,uint32_t size) override;
+
+        virtual bool close() override { return flush(); }
+        virtual bool flush() override;
+    };
+
+
+    /**
+     * Constructor. You probably want to call clearScreen before you get going.
+     * The font will default to the one selected for stream IO if none is supplied.
+     *
+     * @param gl The graphics library (LCD implementation class) to use
+     * @param font The font to use, or nullptr to get it from the graphics library selection
+     * @param autoLineFeed true to add a line feed when a carriage return is received.
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::BufferedGraphicTerminal(
+        TGraphicsLibrary& gl,
+        const Font *font,
+        bool autoLineFeed)
+      : _gl(gl),
+        _font(font==nullptr ? gl.getStreamSelectedFont() : font),
+        _autoLineFeed(autoLineFeed),
+        _topRow(0),
+        _scrolled(false) {
+
+      uint8_t *lineBuffer;
+      uint32_t bytesPerPixel;
+
+      calcTerminalSize();
+
+      // the cells start out as spaces, matching a cleared screen
+
+      _cells.reset(new char[_terminalSize.Width*_terminalSize.Height]);
+      memset(_cells.get(),' ',_terminalSize.Width*_terminalSize.Height);
+
+      _dirty.reset(new bool[_terminalSize.Height]);
+      memset(_dirty.get(),0,sizeof(bool)*_terminalSize.Height);
+
+      _glyphs.reset(new const FontChar *[_terminalSize.Width]);
+
+      _gl.allocatePixelBuffer(_terminalSize.Width*_fontSize.Width,lineBuffer,bytesPerPixel);
+      _lineBuffer.reset(lineBuffer);
+    }
+
+
+    /**
+     * Calculate the terminal size, in characters.
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::calcTerminalSize() {
+
+      const FontChar *fc;
+
+      // need to know the width of the characters. They're all the same so measure a space.
+
+      _font->getCharacter(static_cast<uint8_t>(' '),fc);
+
+      _fontSize.Height=_font->getHeight();
+      _fontSize.Width=fc->PixelWidth;
+
+      // height is rounded down if the fixed lines don't sum to a multiple of the font height
+
+      _terminalSize.Width=_gl.getWidth()/fc->PixelWidth;
+      _terminalSize.Height=_gl.getHeight()/_font->getHeight();
+    }
+
+
+    /**
+     * Clear the screen. The display is cleared immediately.
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::clearScreen() {
+
+      _gl.clearScreen();
+
+      memset(_cells.get(),' ',_terminalSize.Width*_terminalSize.Height);
+      memset(_dirty.get(),0,sizeof(bool)*_terminalSize.Height);
+
+      _cursor.X=0;
+      _cursor.Y=0;
+      _topRow=0;
+      _scrolled=false;
+
+      if(THardwareScrolling)
+        _gl.setScrollPosition(0);
+    }
+
+
+    /**
+     * Clear just the current line
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::clearLine() {
+
+      clearRingRow(getRingRow(_cursor.Y));
+      _cursor.X=0;
+    }
+
+
+    /**
+     * Write a string to the display and flush
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::writeString(const char *str) {
+
+      const char *ptr;
+
+      for(ptr=str;*ptr;writeCharacter(*ptr++));
+      flush();
+    }
+
+
+    /**
+     * Write a character into the cell buffer. It will not appear on the display until flush() is called.
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::writeCharacter(char c) {
+
+      int16_t ringRow;
+
+      if(c=='\n') {
+
+        incrementY();
+        _cursor.X=0;
+
+      } else if(c=='\r') {
+
+        if(_autoLineFeed)
+          incrementY();
+
+        _cursor.X=0;
+      } else {
+
+        ringRow=getRingRow(_cursor.Y);
+
+        _cells[ringRow*_terminalSize.Width+_cursor.X]=c;
+        _dirty[ringRow]=true;
+
+        if(++_cursor.X >= _terminalSize.Width) {
+          _cursor.X=0;
+          incrementY();
+        }
+      }
+    }
+
+
+    /**
+     * Increment the row and scroll if we have hit the bottom. Scrolling is just a rotation of the
+     * ring of rows followed by a clear of the new bottom row.
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::incrementY() {
+
+      if(++_cursor.Y<_terminalSize.Height)
+        return;
+
+      _cursor.Y=_terminalSize.Height-1;
+
+      // the old top row becomes the new bottom row
+
+      clearRingRow(_topRow);
+
+      if(++_topRow==_terminalSize.Height)
+        _topRow=0;
+
+      // with hardware scrolling only the new row needs drawing. without it every row has moved.
+
+      if(THardwareScrolling)
+        _scrolled=true;
+      else
+        memset(_dirty.get(),1,sizeof(bool)*_terminalSize.Height);
+    }
+
+
+    /**
+     * Render all the dirty rows to the display
+     * @return always true
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline bool BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::flush() {
+
+      int16_t i;
+
+      // however many lines were scrolled since the last flush, the panel only moves once
+
+      if(THardwareScrolling && _scrolled) {
+        _gl.setScrollPosition(_topRow*_fontSize.Height);
+        _scrolled=false;
+      }
+
+      for(i=0;i<_terminalSize.Height;i++) {
+
+        if(_dirty[i]) {
+          renderRow(i);
+          _dirty[i]=false;
+        }
+      }
+
+      return true;
+    }
+
+
+    /**
+     * Render a complete row of characters. The window is set once for the row and then each scan
+     * line of the row is expanded into the line buffer and transferred.
+     * @param ringRow The ring index of the row to draw
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::renderRow(int16_t ringRow) {
+
+      const char *cells;
+      const uint8_t *data;
+      UnpackedColour *dest;
+      int16_t col,line,x,bit;
+
+      const UnpackedColour& foreground(_gl.getForeground());
+      const UnpackedColour& background(_gl.getBackground());
+
+      // look up the glyphs once for the row
+
+      cells=&_cells[ringRow*_terminalSize.Width];
+
+      for(col=0;col<_terminalSize.Width;col++)
+        _font->getCharacter(static_cast<uint8_t>(cells[col]),_glyphs[col]);
+
+      _gl.moveTo(
+        Rectangle(
+          0,
+          getDisplayRow(ringRow)*_fontSize.Height,
+          _terminalSize.Width*_fontSize.Width,
+          _fontSize.Height
+        )
+      );
+
+      _gl.beginWriting();
+
+      // glyph data is packed LSB first, left to right, top to bottom with no padding
+
+      for(line=0;line<_fontSize.Height;line++) {
+
+        dest=reinterpret_cast<UnpackedColour *>(_lineBuffer.get());
+
+        for(col=0;col<_terminalSize.Width;col++) {
+
+          data=_glyphs[col]->Data;
+          bit=line*_fontSize.Width;
+
+          for(x=0;x<_fontSize.Width;x++,bit++)
+            *dest++=(data[bit >> 3] & (1 << (bit & 7)))!=0 ? foreground : background;
+        }
+
+        _gl.rawTransfer(_lineBuffer.get(),_terminalSize.Width*_fontSize.Width);
+      }
+    }
+
+
+    /**
+     * Get the ring index of a row on the screen
+     * @param screenRow 0 is the top of the screen
+     * @return The ring index
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline int16_t BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::getRingRow(int16_t screenRow) const {
+
+      screenRow+=_topRow;
+      return screenRow>=_terminalSize.Height ? screenRow-_terminalSize.Height : screenRow;
+    }
+
+
+    /**
+     * Get the text row in display memory that a ring row is drawn at. With hardware scrolling the
+     * ring maps straight on to display memory, otherwise the row is drawn where it is on screen.
+     * @param ringRow The ring index
+     * @return The display row
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline int16_t BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::getDisplayRow(int16_t ringRow) const {
+
+      if(THardwareScrolling)
+        return ringRow;
+
+      ringRow-=_topRow;
+      return ringRow<0 ? ringRow+_terminalSize.Height : ringRow;
+    }
+
+
+    /**
+     * Set a row to spaces and mark it dirty
+     * @param ringRow The ring index
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline void BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::clearRingRow(int16_t ringRow) {
+      memset(&_cells[ringRow*_terminalSize.Width],' ',_terminalSize.Width);
+      _dirty[ringRow]=true;
+    }
+
+
+    /**
+     * Write a string using the stream operator
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(const char *str) {
+
+      writeString(str);
+      return *this;
+    }
+
+    /**
+     * Write a character
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(char c) {
+
+      writeCharacter(c);
+      flush();
+      return *this;
+    }
+
+    /**
+     * Write a 16 bit signed int
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(int16_t val) {
+
+      return operator<<((int32_t)val);
+    }
+
+    /**
+     * Write a 16 bit unsigned int
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(uint16_t val) {
+
+      return operator<<((int32_t)val);
+    }
+
+    /**
+     * Write a 32 bit signed int
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(int32_t val) {
+
+      char buf[15];
+      StringUtil::itoa(val,buf,10);
+      writeString(buf);
+
+      return *this;
+    }
+
+    /**
+     * Write a 32 bit unsigned int
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(uint32_t val) {
+
+      char buf[15];
+      StringUtil::modp_uitoa10(val,buf);
+      writeString(buf);
+
+      return *this;
+    }
+
+    /**
+     * Write a double precision value with 5 fractional digits
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(double val) {
+
+      return operator<<(DoublePrecision(val,DoublePrecision::MAX_DOUBLE_FRACTION_DIGITS));
+    }
+
+    /**
+     * Write a double precision value with customisable fractional digits
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>& BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::operator<<(const DoublePrecision& val) {
+
+      char buf[25];
+
+      StringUtil::modp_dtoa(val.Value,val.Precision,buf);
+      writeString(buf);
+      return *this;
+    }
+
+
+    /**
+     * Write a single byte. This is not flushed to the display.
+     * @param c The byte to write
+     * @return always true
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline bool BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::write(uint8_t c) {
+      writeCharacter(c);
+      return true;
+    }
+
+
+    /**
+     * Write many bytes and then flush the dirty rows to the display. Each byte must be
+     * interpretable as a character to from the selected font for this to make any sense.
+     * @param[in] buffer The buffer of bytes
+     * @param[in] size The number of bytes to write
+     * @return always true
+     */
+
+    template<class TGraphicsLibrary,bool THardwareScrolling>
+    inline bool BufferedGraphicTerminal<TGraphicsLibrary,THardwareScrolling>::write(const void *buffer,uint32_t size) {
+
+      const char *ptr=reinterpret_cast<const char *>(buffer);
+
+      while(size--)
+        writeCharacter(*ptr++);
+
+      return flush();
+    }
+  }
+}
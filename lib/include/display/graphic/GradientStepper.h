@@ -0,0 +1,120 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace display {
+
+    /**
+     * Steps a colour linearly from a first to a last #rrggbb value over a number of steps. The
+     * step values are scaled up by 256 for precision and each component is only moved when its
+     * accumulator passes a whole unit, so runs of identical colours are reported by changed()
+     * and the caller can avoid re-converting them.
+     */
+
+    class GradientStepper {
+
+      protected:
+        int32_t _rstep,_gstep,_bstep;
+        int32_t _raccum,_gaccum,_baccum;
+        int16_t _r,_g,_b;
+        bool _changed;
+
+      protected:
+        static bool step(int32_t& accum,int32_t step,int16_t& component);
+
+      public:
+        GradientStepper(uint32_t first,uint32_t last,int16_t steps);
+
+        uint32_t colour() const;
+        bool changed() const;
+        void next();
+    };
+
+
+    /**
+     * Constructor
+     * @param first The first colour (#rrggbb)
+     * @param last The last colour (#rrggbb)
+     * @param steps The number of steps that it takes to get from first to last
+     */
+
+    inline GradientStepper::GradientStepper(uint32_t first,uint32_t last,int16_t steps)
+      : _raccum(0),
+        _gaccum(0),
+        _baccum(0),
+        _changed(false) {
+
+      _r=static_cast<uint8_t>(first >> 16);
+      _g=static_cast<uint8_t>(first >> 8);
+      _b=static_cast<uint8_t>(first);
+
+      _rstep=((static_cast<int32_t>(static_cast<uint8_t>(last >> 16))-_r)*256)/steps;
+      _gstep=((static_cast<int32_t>(static_cast<uint8_t>(last >> 8))-_g)*256)/steps;
+      _bstep=((static_cast<int32_t>(static_cast<uint8_t>(last))-_b)*256)/steps;
+    }
+
+
+    /**
+     * Get the current colour
+     * @return #rrggbb
+     */
+
+    inline uint32_t GradientStepper::colour() const {
+      return static_cast<uint32_t>(_r) << 16 | static_cast<uint32_t>(_g) << 8 | _b;
+    }
+
+
+    /**
+     * Check if the last call to next() changed the colour
+     * @return true if it changed
+     */
+
+    inline bool GradientStepper::changed() const {
+      return _changed;
+    }
+
+
+    /**
+     * Move to the next colour
+     */
+
+    inline void GradientStepper::next() {
+
+      bool rchanged,gchanged,bchanged;
+
+      rchanged=step(_raccum,_rstep,_r);
+      gchanged=step(_gaccum,_gstep,_g);
+      bchanged=step(_baccum,_bstep,_b);
+
+      _changed=rchanged || gchanged || bchanged;
+    }
+
+
+    /**
+     * Update one accumulator. If it has moved past a whole unit (scaled by 256) then add that
+     * to the component and reduce the accumulator accordingly.
+     * @return true if the component changed
+     */
+
+    inline bool GradientStepper::step(int32_t& accum,int32_t step,int16_t& component) {
+
+      int32_t val;
+
+      accum+=step;
+
+      if((val=accum/256)==0)
+        return false;
+
+      component+=val;
+      accum-=val*256;
+
+      return true;
+    }
+  }
+}
@@ -36,6 +36,7 @@ namespace stm32plus {
 
     protected:
       void plot4EllipsePoints(int16_t cx,int16_t cy,int16_t x,int16_t y);
+      void fillNativeLine(UnpackedColour *line,int16_t count,tCOLOUR cr) const;
 
     public:
       GraphicsLibrary(TDeviceAccessMode& accessMode);
@@ -48,6 +49,9 @@ namespace stm32plus {
       void setBackground(tCOLOUR cr);
       void setBackground(uint8_t r,uint8_t g,uint8_t b);
 
+      const UnpackedColour& getForeground() const;
+      const UnpackedColour& getBackground() const;
+
       // panel querying
 
       int16_t getXmax() const;
@@ -92,6 +96,10 @@ namespace stm32plus {
       void fillRectangle(const Rectangle& rc);
       void clearRectangle(const Rectangle& rc);
       void gradientFillRectangle(const Rectangle& rc,Direction dir,tCOLOUR first,tCOLOUR last);
+
+      template<class TDmaCopierImpl>
+      bool gradientFillRectangle(const Rectangle& rc,Direction dir,tCOLOUR first,tCOLOUR last,DmaLcdWriter<TDmaCopierImpl>& dma,uint32_t priority=DMA_Priority_High);
+
       void drawEllipse(const Point& center,const Size& size);
       void fillEllipse(const Point& center,const Size& size);
       void drawLine(const Point& p1,const Point& p2);
@@ -102,9 +110,20 @@ namespace stm32plus {
       bool drawBitmap(const Rectangle& rc,InputStream& source,DmaLcdWriter<TDmaCopierImpl>& dma,uint32_t priority=DMA_Priority_High);
       bool drawBitmap(const Rectangle& rc,InputStream& source);
 
+      template<class TDmaCopierImpl>
+      void beginRawDmaTransfer(DmaLcdWriter<TDmaCopierImpl>& dma,void *buffer,uint32_t byteCount,uint32_t priority=DMA_Priority_High);
+
+      // alpha blending (64K colour panels with a 16-bit interface)
+
+      void alphaBlendRectangle(const Rectangle& rc,const uint16_t *background,uint8_t alpha);
+      void alphaBlendBitmap(const Rectangle& rc,const uint16_t *foreground,const uint16_t *background,uint8_t alpha);
+
       // jpeg handling
 
       void drawJpeg(const Rectangle& rc,InputStream& source);
+
+      template<class TDmaCopierImpl>
+      void drawJpeg(const Rectangle& rc,InputStream& source,DmaLcdWriter<TDmaCopierImpl>& dma,uint32_t priority=DMA_Priority_High);
     };
   }
 }
@@ -121,6 +140,7 @@ namespace stm32plus {
 #include "gl/Text.inl"
 #include "gl/LzgText.inl"
 #include "gl/Bitmap.inl"
+#include "gl/AlphaBlend.inl"
 
 // the text operations use bitbanding on the f1 and f4. not available on the f0.
 
@@ -11,8 +11,15 @@ namespace stm32plus {
   namespace display {
 
     /**
-     * JPEG decoder. Implements the callback from the picoJpeg decoder to write
-     * 8x8 blocks to the screen.
+     * JPEG decoder. Decodes a whole row of MCUs at a time from the picoJpeg decoder into a
+     * staging buffer held in the panel's native pixel format and then writes the row to the
+     * display in one bulk transfer. The DMA variants double-buffer the rows so that the
+     * transfer of one row to the LCD overlaps the decoding of the next.
+     *
+     * The staging buffer costs (image width * MCU height * bytes per pixel) of heap, doubled
+     * for the DMA variants. The MCU height is 8 or 16 depending on the chroma subsampling.
+     * If a whole row can't be allocated then the CPU variant decodes each row in groups of
+     * MCUs, halving the group size until the buffer fits.
      *
      * Either call decode() to decode the whole JPEG or call beginDecode() then
      * endDecode() if you need access to the image dimensions
@@ -22,132 +29,342 @@ namespace stm32plus {
     class JpegDecoder {
 
       protected:
+        typedef typename TGraphicsLibrary::UnpackedColour UnpackedColour;
+
         pjpeg_image_info_t _imageInfo;
 
+      protected:
+        int16_t getRowHeight(int16_t mcu_y) const;
+        bool decodeMcus(UnpackedColour *buffer,int16_t firstMcu,int16_t mcuCount,int16_t width,int16_t rowHeight,TGraphicsLibrary& gl);
+        void convertBlock(UnpackedColour *dest,int16_t width,uint16_t src_ofs,int bx_limit,int by_limit,TGraphicsLibrary& gl) const;
+
       public:
+        bool decode(const Point& pt,InputStream& is,TGraphicsLibrary& gl);
+
+        template<class TDmaCopierImpl>
+        bool decode(const Point& pt,InputStream& is,TGraphicsLibrary& gl,DmaLcdWriter<TDmaCopierImpl>& dma,uint32_t priority=DMA_Priority_High);
 
-        /**
-         * Convenience method to call begin, end
-         * @param pt
-         * @param is
-         * @param gl
-         */
+        bool beginDecode(InputStream& is,Size& size);
+        bool endDecode(const Point& pt,TGraphicsLibrary& gl);
 
-        bool decode(const Point& pt,InputStream& is,TGraphicsLibrary& gl) {
+        template<class TDmaCopierImpl>
+        bool endDecode(const Point& pt,TGraphicsLibrary& gl,DmaLcdWriter<TDmaCopierImpl>& dma,uint32_t priority=DMA_Priority_High);
+    };
 
-          Size size;
 
-          if(!beginDecode(is,size))
-            return false;
+    /**
+     * Convenience method to call begin, end
+     * @param pt
+     * @param is
+     * @param gl
+     */
 
-          return endDecode(pt,gl);
-        }
+    template<class TGraphicsLibrary>
+    inline bool JpegDecoder<TGraphicsLibrary>::decode(const Point& pt,InputStream& is,TGraphicsLibrary& gl) {
+
+      Size size;
+
+      if(!beginDecode(is,size))
+        return false;
+
+      return endDecode(pt,gl);
+    }
+
+
+    /**
+     * Convenience method to call begin, end using DMA to transfer the decoded rows
+     * @param pt
+     * @param is
+     * @param gl
+     * @param dma The DMA LCD writer
+     * @param priority The DMA priority
+     */
+
+    template<class TGraphicsLibrary>
+    template<class TDmaCopierImpl>
+    inline bool JpegDecoder<TGraphicsLibrary>::decode(const Point& pt,
+                                                      InputStream& is,
+                                                      TGraphicsLibrary& gl,
+                                                      DmaLcdWriter<TDmaCopierImpl>& dma,
+                                                      uint32_t priority) {
+      Size size;
+
+      if(!beginDecode(is,size))
+        return false;
+
+      return endDecode(pt,gl,dma,priority);
+    }
+
+
+    /**
+     * Start decoding.
+     * @param is
+     * @param size
+     * @return true if it works
+     */
+
+    template<class TGraphicsLibrary>
+    inline bool JpegDecoder<TGraphicsLibrary>::beginDecode(InputStream& is,Size& size) {
+
+      // initialise the decoder
+
+      if(pjpeg_decode_init(&_imageInfo,is)!=0)
+        return false;
+
+      size.Width=_imageInfo.m_width;
+      size.Height=_imageInfo.m_height;
+
+      return true;
+    }
+
+
+    /**
+     * Decode the JPEG encoded data from the input stream, using the graphics library and display it
+     * at the point on screen. Each row of MCUs is written with a single raw transfer if there's
+     * room for a row buffer. If not then the row is decoded and written in groups of MCUs, halving
+     * the group size until the buffer can be allocated.
+     * @param pt
+     * @param gl
+     * @return false if the decoder fails or not even a single MCU buffer can be allocated
+     */
+
+    template<class TGraphicsLibrary>
+    inline bool JpegDecoder<TGraphicsLibrary>::endDecode(const Point& pt,TGraphicsLibrary& gl) {
+
+      uint8_t *buffer;
+      uint32_t bytesPerPixel;
+      int16_t mcu_x,mcu_y,rowHeight,groupSize,mcuCount,x,width;
+      bool retval;
+
+      // find the largest group of MCUs that there's room for, starting with a whole row
+
+      for(groupSize=_imageInfo.m_MCUSPerRow;;groupSize=(groupSize+1)/2) {
 
+        width=std::min<int>(groupSize*_imageInfo.m_MCUWidth,_imageInfo.m_width);
+        gl.allocatePixelBuffer(width*_imageInfo.m_MCUHeight,buffer,bytesPerPixel);
 
-        /**
-         * Start decoding.
-         * @param is
-         * @param size
-         * @return true if it works
-         */
+        if(buffer!=nullptr)
+          break;
 
-        bool beginDecode(InputStream& is,Size& size) {
+        if(groupSize==1)
+          return false;
+      }
 
-          // initialise the decoder
+      retval=false;
 
-          if(pjpeg_decode_init(&_imageInfo,is)!=0)
-            return false;
+      for(mcu_y=0;mcu_y<_imageInfo.m_MCUSPerCol;mcu_y++) {
 
-          size.Width=_imageInfo.m_width;
-          size.Height=_imageInfo.m_height;
+        rowHeight=getRowHeight(mcu_y);
 
-          return true;
+        for(mcu_x=0;mcu_x<_imageInfo.m_MCUSPerRow;mcu_x+=mcuCount) {
+
+          // the last group in the row may be short and clipped by the image width
+
+          mcuCount=std::min<int>(groupSize,_imageInfo.m_MCUSPerRow-mcu_x);
+          x=mcu_x*_imageInfo.m_MCUWidth;
+          width=std::min<int>(mcuCount*_imageInfo.m_MCUWidth,_imageInfo.m_width-x);
+
+          if(!decodeMcus(reinterpret_cast<UnpackedColour *>(buffer),mcu_x,mcuCount,width,rowHeight,gl))
+            goto finished;
+
+          gl.moveTo(Rectangle(pt.X+x,pt.Y+mcu_y*_imageInfo.m_MCUHeight,width,rowHeight));
+          gl.beginWriting();
+          gl.rawTransfer(buffer,width*rowHeight);
         }
+      }
+
+      retval=true;
+
+    finished:
+      delete[] buffer;
+      return retval;
+    }
+
+
+    /**
+     * Decode the JPEG encoded data from the input stream and display it at the point on screen.
+     * Rows of MCUs are decoded alternately into two staging buffers so that the DMA transfer
+     * of the previous row runs while the CPU decodes the next. This implies an access mode that
+     * supports DMA (e.g. the FSMC). If the two buffers can't be allocated the CPU transfer is
+     * used instead.
+     * @param pt
+     * @param gl
+     * @param dma The DMA LCD writer
+     * @param priority The DMA priority
+     */
 
+    template<class TGraphicsLibrary>
+    template<class TDmaCopierImpl>
+    inline bool JpegDecoder<TGraphicsLibrary>::endDecode(const Point& pt,
+                                                         TGraphicsLibrary& gl,
+                                                         DmaLcdWriter<TDmaCopierImpl>& dma,
+                                                         uint32_t priority) {
+      uint8_t *evenRows,*oddRows,*buffer;
+      uint32_t bytesPerPixel;
+      int16_t mcu_y,rowHeight;
+      bool retval;
+
+      gl.allocatePixelBuffer(_imageInfo.m_width*_imageInfo.m_MCUHeight,evenRows,bytesPerPixel);
+      gl.allocatePixelBuffer(_imageInfo.m_width*_imageInfo.m_MCUHeight,oddRows,bytesPerPixel);
+
+      // without room for both staging buffers fall back to the single buffer CPU transfer
+
+      if(evenRows==nullptr || oddRows==nullptr) {
+        delete[] evenRows;
+        delete[] oddRows;
+        return endDecode(pt,gl);
+      }
+
+      retval=false;
 
-        /**
-         * Decode the JPEG encoded data from the input stream, using the graphics library and display it
-         * at the point on screen.
-         * @param pt
-         * @param gl
-         */
+      for(mcu_y=0;mcu_y<_imageInfo.m_MCUSPerCol;mcu_y++) {
 
-        bool endDecode(const Point& pt,TGraphicsLibrary& gl) {
+        buffer=(mcu_y & 1)==0 ? evenRows : oddRows;
+        rowHeight=getRowHeight(mcu_y);
 
-          typename TGraphicsLibrary::UnpackedColour cr;
+        // decode while the previous row is still transferring
 
-          int16_t mcu_x=0,mcu_y=0;
+        if(!decodeMcus(reinterpret_cast<UnpackedColour *>(buffer),0,_imageInfo.m_MCUSPerRow,_imageInfo.m_width,rowHeight,gl))
+          goto finished;
 
-          for(;;) {
+        // the window cannot be moved until the last row is out
 
-            if(pjpeg_decode_mcu()!=0)
-              return false;
+        if(mcu_y>0 && !dma.waitUntilComplete())
+          goto finished;
 
-            if(mcu_y>=_imageInfo.m_MCUSPerCol)
-              return false;
+        gl.moveTo(Rectangle(pt.X,pt.Y+mcu_y*_imageInfo.m_MCUHeight,_imageInfo.m_width,rowHeight));
+        gl.beginWriting();
+        gl.beginRawDmaTransfer(dma,buffer,_imageInfo.m_width*rowHeight*bytesPerPixel,priority);
+      }
 
-            for(int y=0;y<_imageInfo.m_MCUHeight;y+=8) {
+      retval=true;
 
-              int by_limit=std::min<int>(8,_imageInfo.m_height-(mcu_y*_imageInfo.m_MCUHeight+y));
+    finished:
 
-              for(int x=0;x<_imageInfo.m_MCUWidth;x+=8) {
+      // a transfer could still be reading from one of the buffers
 
-                uint16_t src_ofs=(x*8U)+(y*16U);
+      if(mcu_y>0 && !dma.waitUntilComplete())
+        retval=false;
 
-                uint8_t *pSrcR=_imageInfo.m_pMCUBufR+src_ofs;
-                uint8_t *pSrcG=_imageInfo.m_pMCUBufG+src_ofs;
-                uint8_t *pSrcB=_imageInfo.m_pMCUBufB+src_ofs;
+      delete[] evenRows;
+      delete[] oddRows;
 
-                int bx_limit=std::min(8,_imageInfo.m_width-(mcu_x*_imageInfo.m_MCUWidth+x));
+      return retval;
+    }
 
-                gl.moveTo(Rectangle(pt.X+mcu_x*_imageInfo.m_MCUWidth+x,pt.Y+mcu_y*_imageInfo.m_MCUHeight+y,bx_limit,by_limit));
-                gl.beginWriting();
 
-                if(_imageInfo.m_scanType==PJPG_GRAYSCALE) {
+    /**
+     * Get the number of visible scan lines in an MCU row. The last row may be clipped by the
+     * image height.
+     * @param mcu_y The MCU row number
+     * @return the number of scan lines
+     */
 
-                  for(int by=0;by<by_limit;by++) {
+    template<class TGraphicsLibrary>
+    inline int16_t JpegDecoder<TGraphicsLibrary>::getRowHeight(int16_t mcu_y) const {
+      return std::min<int>(_imageInfo.m_MCUHeight,_imageInfo.m_height-mcu_y*_imageInfo.m_MCUHeight);
+    }
 
-                    for(int bx=0;bx < bx_limit;bx++) {
-                      gl.unpackColour(*pSrcR,*pSrcR,*pSrcR,cr);
-                      gl.writePixel(cr);
-                      pSrcR++;
-                    }
 
-                    pSrcR+=(8-bx_limit);
-                  }
-                } else {
-                  for(int by=0;by<by_limit;by++) {
+    /**
+     * Decode a group of consecutive MCUs from a row into the staging buffer. The buffer is laid
+     * out as the visible width of the group multiplied by the row height so it can be transferred
+     * in one go.
+     * @param buffer The staging buffer
+     * @param firstMcu The column of the first MCU in the group
+     * @param mcuCount The number of MCUs in the group
+     * @param width The visible width of the group in pixels
+     * @param rowHeight The visible height of this row
+     * @param gl The graphics library, used for colour conversion
+     * @return false if the decoder fails
+     */
+
+    template<class TGraphicsLibrary>
+    inline bool JpegDecoder<TGraphicsLibrary>::decodeMcus(UnpackedColour *buffer,
+                                                          int16_t firstMcu,
+                                                          int16_t mcuCount,
+                                                          int16_t width,
+                                                          int16_t rowHeight,
+                                                          TGraphicsLibrary& gl) {
+      int16_t mcu_x;
+      int x,y,bx_limit,by_limit;
 
-                    for(int bx=0;bx<bx_limit;bx++) {
+      for(mcu_x=firstMcu;mcu_x<firstMcu+mcuCount;mcu_x++) {
 
-                      gl.unpackColour(*pSrcR,*pSrcG,*pSrcB,cr);
+        if(pjpeg_decode_mcu()!=0)
+          return false;
 
-                      pSrcR++;
-                      pSrcG++;
-                      pSrcB++;
+        for(y=0;y<_imageInfo.m_MCUHeight;y+=8) {
 
-                      gl.writePixel(cr);
-                    }
+          if((by_limit=std::min<int>(8,rowHeight-y))<=0)
+            break;
 
-                    pSrcR+=(8-bx_limit);
-                    pSrcG+=(8-bx_limit);
-                    pSrcB+=(8-bx_limit);
-                  }
-                }
-              }
-            }
+          for(x=0;x<_imageInfo.m_MCUWidth;x+=8) {
 
-            mcu_x++;
+            if((bx_limit=std::min<int>(8,_imageInfo.m_width-(mcu_x*_imageInfo.m_MCUWidth+x)))<=0)
+              break;
 
-            if(mcu_x==_imageInfo.m_MCUSPerRow) {
-              mcu_x=0;
-              mcu_y++;
-            }
+            convertBlock(buffer+y*width+(mcu_x-firstMcu)*_imageInfo.m_MCUWidth+x,
+                         width,
+                         (x*8U)+(y*16U),
+                         bx_limit,
+                         by_limit,
+                         gl);
           }
+        }
+      }
+
+      return true;
+    }
+
+
+    /**
+     * Convert an 8x8 block from the decoder's component buffers into native pixels in the staging buffer
+     * @param dest Where to write the top-left pixel
+     * @param width The width of the staging buffer in pixels
+     * @param src_ofs Offset of the block in the MCU component buffers
+     * @param bx_limit Number of visible columns
+     * @param by_limit Number of visible rows
+     * @param gl The graphics library
+     */
+
+    template<class TGraphicsLibrary>
+    inline void JpegDecoder<TGraphicsLibrary>::convertBlock(UnpackedColour *dest,
+                                                            int16_t width,
+                                                            uint16_t src_ofs,
+                                                            int bx_limit,
+                                                            int by_limit,
+                                                            TGraphicsLibrary& gl) const {
+      int bx,by;
 
-          return true;
+      const uint8_t *pSrcR=_imageInfo.m_pMCUBufR+src_ofs;
+      const uint8_t *pSrcG=_imageInfo.m_pMCUBufG+src_ofs;
+      const uint8_t *pSrcB=_imageInfo.m_pMCUBufB+src_ofs;
+
+      if(_imageInfo.m_scanType==PJPG_GRAYSCALE) {
+
+        for(by=0;by<by_limit;by++) {
+
+          for(bx=0;bx<bx_limit;bx++)
+            gl.unpackColour(pSrcR[bx],pSrcR[bx],pSrcR[bx],dest[bx]);
+
+          pSrcR+=8;
+          dest+=width;
         }
-    };
+      }
+      else {
+
+        for(by=0;by<by_limit;by++) {
+
+          for(bx=0;bx<bx_limit;bx++)
+            gl.unpackColour(pSrcR[bx],pSrcG[bx],pSrcB[bx],dest[bx]);
+
+          pSrcR+=8;
+          pSrcG+=8;
+          pSrcB+=8;
+          dest+=width;
+        }
+      }
+    }
   }
 }
-
@@ -54,7 +54,17 @@ namespace stm32plus {
       PJPG_GRAYSCALE, PJPG_YH1V1, PJPG_YH2V1, PJPG_YH1V2, PJPG_YH2V2
     } pjpeg_scan_type_t;
 
-  #define MAX_IN_BUF_SIZE 256
+  // Size of the bulk reads made from the input stream. Keep it a multiple of 512 so that
+  // file and block device streams are asked for whole sectors. It can be overridden on the
+  // compiler command line but the library and the application must agree on the value.
+
+  #if !defined(MAX_IN_BUF_SIZE)
+  #define MAX_IN_BUF_SIZE 512
+  #endif
+
+  // bytes reserved ahead of the read area for putting back ("stuffing") chars
+
+  #define PJPG_STUFF_BUF_SIZE 4
 
     typedef struct HuffTableT {
         uint16_t mMinCode[16];
@@ -98,7 +108,7 @@ namespace stm32plus {
         int16_t gQuant0[8 * 8];
         int16_t gQuant1[8 * 8];
 
-        uint8_t gInBuf[MAX_IN_BUF_SIZE];
+        uint8_t gInBuf[PJPG_STUFF_BUF_SIZE+MAX_IN_BUF_SIZE];
 
         // DC - 192
         HuffTable gHuffTab0;
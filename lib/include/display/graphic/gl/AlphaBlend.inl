@@ -0,0 +1,93 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace display {
+
+
+    /**
+     * Blend the foreground colour over a background image and draw the result. The display cannot
+     * be read back so the background must be supplied, typically a copy of what was drawn there.
+     * The panel must be in 64K colour mode with a 16-bit interface so that the native pixel format
+     * is a 5-6-5 halfword.
+     *
+     * @param rc The rectangle on the display.
+     * @param background rc.Width*rc.Height 5-6-5 pixels, top to bottom.
+     * @param alpha The foreground opacity, 0 (transparent) to 255 (opaque).
+     */
+
+    template<class TDevice,typename TDeviceAccessMode>
+    inline void GraphicsLibrary<TDevice,TDeviceAccessMode>::alphaBlendRectangle(const Rectangle& rc,const uint16_t *background,uint8_t alpha) {
+
+      static_assert(alphablend::IsPacked565<UnpackedColour>::value,"Alpha blending requires a 5-6-5 halfword native pixel format and a 16-bit interface");
+
+      uint8_t *buffer;
+      uint32_t bytesPerPixel;
+      int16_t i;
+      uint16_t colour;
+
+      colour=*reinterpret_cast<const uint16_t *>(&_foreground);
+
+      this->allocatePixelBuffer(rc.Width,buffer,bytesPerPixel);
+
+      this->moveTo(rc);
+      this->beginWriting();
+
+      for(i=0;i<rc.Height;i++) {
+
+        alphablend::blendColour(reinterpret_cast<uint16_t *>(buffer),background,rc.Width,colour,alpha);
+        this->rawTransfer(buffer,rc.Width);
+
+        background+=rc.Width;
+      }
+
+      delete[] buffer;
+    }
+
+
+    /**
+     * Blend a foreground image over a background image and draw the result. The panel must be in
+     * 64K colour mode with a 16-bit interface so that the native pixel format is a 5-6-5 halfword.
+     *
+     * @param rc The rectangle on the display.
+     * @param foreground rc.Width*rc.Height 5-6-5 pixels, top to bottom.
+     * @param background rc.Width*rc.Height 5-6-5 pixels, top to bottom.
+     * @param alpha The foreground opacity, 0 (transparent) to 255 (opaque).
+     */
+
+    template<class TDevice,typename TDeviceAccessMode>
+    inline void GraphicsLibrary<TDevice,TDeviceAccessMode>::alphaBlendBitmap(const Rectangle& rc,
+                                                                             const uint16_t *foreground,
+                                                                             const uint16_t *background,
+                                                                             uint8_t alpha) {
+
+      static_assert(alphablend::IsPacked565<UnpackedColour>::value,"Alpha blending requires a 5-6-5 halfword native pixel format and a 16-bit interface");
+
+      uint8_t *buffer;
+      uint32_t bytesPerPixel;
+      int16_t i;
+
+      this->allocatePixelBuffer(rc.Width,buffer,bytesPerPixel);
+
+      this->moveTo(rc);
+      this->beginWriting();
+
+      for(i=0;i<rc.Height;i++) {
+
+        alphablend::blendPixels(reinterpret_cast<uint16_t *>(buffer),foreground,background,rc.Width,alpha);
+        this->rawTransfer(buffer,rc.Width);
+
+        foreground+=rc.Width;
+        background+=rc.Width;
+      }
+
+      delete[] buffer;
+    }
+  }
+}
@@ -154,10 +154,32 @@ namespace stm32plus {
     }
 
 
+    /**
+     * Start a DMA transfer of pixels that are already formatted for the panel to the current
+     * output position. The caller must have already issued the beginWriting() command and must
+     * wait for the transfer to complete before issuing any other command to the panel.
+     *
+     * @param dma The DMA class used to transfer the data.
+     * @param buffer The pixel data.
+     * @param byteCount The number of bytes to transfer.
+     * @param priority The dma priority constant
+     */
+
+    template<class TDevice,typename TDeviceAccessMode>
+    template<class TDmaCopierImpl>
+    inline void GraphicsLibrary<TDevice,TDeviceAccessMode>::beginRawDmaTransfer(DmaLcdWriter<TDmaCopierImpl>& dma,
+                                                                                void *buffer,
+                                                                                uint32_t byteCount,
+                                                                                uint32_t priority) {
+      dma.beginCopyToLcd((void *)this->_accessMode.getDataAddress(),buffer,byteCount,priority);
+    }
+
+
     /**
      * Draw a JPEG on the display. The rectangle size must match the JPEG size. The source
      * should supply the compressed data in the form of a JPEG file. Progressive JPEGs are
-     * not supported. This function will cost you about 2Kb of SRAM to call.
+     * not supported. This function will cost you about 2Kb of SRAM to call plus the heap
+     * used by one row of decoded MCUs.
      *
      * @param rc The rectangle to draw the image at.
      * @param source The source of compressed data.
@@ -171,5 +193,27 @@ namespace stm32plus {
       JpegDecoder<GraphicsLibrary<TDevice,TDeviceAccessMode>> jpeg;
       jpeg.decode(rc.getTopLeft(),source,*this);
     }
+
+
+    /**
+     * Draw a JPEG on the display using DMA to transfer each decoded row of MCUs to the panel
+     * while the next row is being decoded. Two rows of decoded MCUs are held on the heap.
+     *
+     * @param rc The rectangle to draw the image at.
+     * @param source The source of compressed data.
+     * @param dma The DMA class used to transfer the data.
+     * @param priority The dma priority constant
+     */
+
+    template<class TDevice,typename TDeviceAccessMode>
+    template<class TDmaCopierImpl>
+    inline void GraphicsLibrary<TDevice,TDeviceAccessMode>::drawJpeg(const Rectangle& rc,
+                                                                     InputStream& source,
+                                                                     DmaLcdWriter<TDmaCopierImpl>& dma,
+                                                                     uint32_t priority) {
+
+      JpegDecoder<GraphicsLibrary<TDevice,TDeviceAccessMode>> jpeg;
+      jpeg.decode(rc.getTopLeft(),source,*this,dma,priority);
+    }
   }
 }
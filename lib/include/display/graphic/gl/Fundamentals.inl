@@ -55,6 +55,24 @@ namespace stm32plus {
       this->unpackColour(r,g,b,_background);
     }
 
+    /**
+     * get the foreground in the device's native format
+     */
+
+    template<class TDevice,typename TDeviceAccessMode>
+    inline const typename GraphicsLibrary<TDevice,TDeviceAccessMode>::UnpackedColour& GraphicsLibrary<TDevice,TDeviceAccessMode>::getForeground() const {
+      return _foreground;
+    }
+
+    /**
+     * get the background in the device's native format
+     */
+
+    template<class TDevice,typename TDeviceAccessMode>
+    inline const typename GraphicsLibrary<TDevice,TDeviceAccessMode>::UnpackedColour& GraphicsLibrary<TDevice,TDeviceAccessMode>::getBackground() const {
+      return _background;
+    }
+
     /**
      * Get a full-screen rectangle
      */
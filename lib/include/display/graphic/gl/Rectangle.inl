@@ -68,7 +68,11 @@ namespace stm32plus {
 
 
     /*
-     * Gradient fill a rectangle from the foreground to the background colour
+     * Gradient fill a rectangle from the first to the last colour. The colours are converted to the
+     * device's native format once per step into a line buffer and the rectangle is then streamed
+     * to the display as a single window with rawTransfer(). For a horizontal gradient the same line
+     * is sent for every scan line. For a vertical gradient the line is only refilled when the
+     * colour actually changes.
      */
 
     template<class TDevice,typename TDeviceAccessMode>
@@ -77,101 +81,138 @@ namespace stm32plus {
                                                                                   tCOLOUR first,
                                                                                   tCOLOUR last) {
 
-      uint8_t r1,g1,b1,r2,g2,b2;
-      int32_t rstep,gstep,bstep;
-      int16_t raccum,gaccum,baccum,i,r,g,b,val,div,xdisp,ydisp,px;
-      Rectangle rcBlock;
-      tCOLOUR cr;
-      UnpackedColour lineColour;
+      uint8_t *buffer;
+      uint32_t bytesPerPixel;
+      int16_t i;
+      UnpackedColour *line;
+      GradientStepper stepper(first,last,dir==VERTICAL ? rc.Height : rc.Width);
 
-      // get the start and end colour components
+      this->allocatePixelBuffer(rc.Width,buffer,bytesPerPixel);
+      line=reinterpret_cast<UnpackedColour *>(buffer);
 
-      r1=first >> 16;
-      g1=first >> 8;
-      b1=first;
+      this->moveTo(rc);
+      this->beginWriting();
 
-      r2=last >> 16;
-      g2=last >> 8;
-      b2=last;
+      if(dir==VERTICAL) {
 
-      // calculate initial sizes and directions
+        for(i=0;i<rc.Height;i++) {
 
-      rcBlock.X=rc.X;
-      rcBlock.Y=rc.Y;
+          if(i==0 || stepper.changed())
+            fillNativeLine(line,rc.Width,stepper.colour());
 
-      if(dir==VERTICAL) {
-        rcBlock.Width=rc.Width;
-        rcBlock.Height=1;
-        xdisp=0;
-        ydisp=1;
-        div=rc.Height;
-        px=rc.Width;
+          this->rawTransfer(buffer,rc.Width);
+          stepper.next();
+        }
       }
       else {
-        rcBlock.Width=1;
-        rcBlock.Height=rc.Height;
-        xdisp=1;
-        ydisp=0;
-        div=rc.Width;
-        px=rc.Height;
+
+        // one line holds the whole gradient
+
+        for(i=0;i<rc.Width;i++) {
+          this->unpackColour(stepper.colour(),line[i]);
+          stepper.next();
+        }
+
+        for(i=0;i<rc.Height;i++)
+          this->rawTransfer(buffer,rc.Width);
       }
 
-      // calculate the step values, scaled up x256 for greater precision
+      delete[] buffer;
+    }
+
 
-      rstep=(((int32_t)r2-(int32_t)r1)*256)/div;
-      gstep=(((int32_t)g2-(int32_t)g1)*256)/div;
-      bstep=(((int32_t)b2-(int32_t)b1)*256)/div;
+    /*
+     * Gradient fill a rectangle from the first to the last colour using DMA to transfer the lines.
+     * This implies an access mode that supports DMA (e.g. the FSMC). A vertical gradient alternates
+     * between two line buffers so that the next line can be prepared while the last one transfers.
+     */
 
-      // initial colour and reset accumulators
+    template<class TDevice,typename TDeviceAccessMode>
+    template<class TDmaCopierImpl>
+    inline bool GraphicsLibrary<TDevice,TDeviceAccessMode>::gradientFillRectangle(const Rectangle& rc,
+                                                                                  Direction dir,
+                                                                                  tCOLOUR first,
+                                                                                  tCOLOUR last,
+                                                                                  DmaLcdWriter<TDmaCopierImpl>& dma,
+                                                                                  uint32_t priority) {
 
-      cr=first;
-      raccum=gaccum=baccum=0;
+      uint8_t *buffers[2];
+      uint32_t bytesPerPixel;
+      int16_t i,current;
+      bool retval;
+      GradientStepper stepper(first,last,dir==VERTICAL ? rc.Height : rc.Width);
 
-      r=r1;
-      g=g1;
-      b=b1;
+      this->allocatePixelBuffer(rc.Width,buffers[0],bytesPerPixel);
+      buffers[1]=nullptr;
 
-      for(i=0;i<div;i++) {
+      this->moveTo(rc);
+      this->beginWriting();
 
-        // draw the line
+      retval=false;
 
-        this->moveTo(rcBlock);
-        this->unpackColour(cr,lineColour);
-        this->fillPixels(px,lineColour);
+      if(dir==VERTICAL) {
 
-        // update for the next line
+        this->allocatePixelBuffer(rc.Width,buffers[1],bytesPerPixel);
+        current=0;
 
-        rcBlock.X+=xdisp;
-        rcBlock.Y+=ydisp;
+        for(i=0;i<rc.Height;i++) {
 
-        // update the accumulators
+          // only switch buffers when the colour changes, otherwise resend the last one
 
-        raccum+=rstep;
-        gaccum+=gstep;
-        baccum+=bstep;
+          if(i==0 || stepper.changed()) {
 
-        // if any accumulator has moved past 0 (scaled by 256) then add that accumulator
-        // to the colour and reduce the accumulator accordingly
+            if(i>0)
+              current^=1;
 
-        if((val=raccum/256)!=0) {
-          r+=val;
-          raccum-=val*256;
-        }
+            fillNativeLine(reinterpret_cast<UnpackedColour *>(buffers[current]),rc.Width,stepper.colour());
+          }
 
-        if((val=gaccum/256)!=0) {
-          g+=val;
-          gaccum-=val*256;
+          if(i>0 && !dma.waitUntilComplete())
+            goto finished;
+
+          beginRawDmaTransfer(dma,buffers[current],rc.Width*bytesPerPixel,priority);
+          stepper.next();
         }
+      }
+      else {
 
-        if((val=baccum/256)!=0) {
-          b+=val;
-          baccum-=val*256;
+        for(i=0;i<rc.Width;i++) {
+          this->unpackColour(stepper.colour(),reinterpret_cast<UnpackedColour *>(buffers[0])[i]);
+          stepper.next();
         }
 
-        // if any accumulator was reset then we have a new colour
+        for(i=0;i<rc.Height;i++) {
 
-        cr=(uint32_t)r<<16 | (uint32_t)g<<8 | b;
+          if(i>0 && !dma.waitUntilComplete())
+            goto finished;
+
+          beginRawDmaTransfer(dma,buffers[0],rc.Width*bytesPerPixel,priority);
+        }
       }
+
+      retval=dma.waitUntilComplete();
+
+    finished:
+      delete[] buffers[0];
+      delete[] buffers[1];
+
+      return retval;
+    }
+
+
+    /*
+     * Fill a line buffer with a single colour
+     */
+
+    template<class TDevice,typename TDeviceAccessMode>
+    inline void GraphicsLibrary<TDevice,TDeviceAccessMode>::fillNativeLine(UnpackedColour *line,int16_t count,tCOLOUR cr) const {
+
+      UnpackedColour native;
+
+      this->unpackColour(cr,native);
+
+      while(count--)
+        *line++=native;
     }
   }
 }
@@ -0,0 +1,443 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace display {
+
+    /**
+     * A debounced touch event with the time that it was detected
+     */
+
+    struct TouchEvent {
+
+      enum class Type : uint8_t {
+        PEN_DOWN,           ///< a touch has started
+        PEN_MOVE,           ///< the touch moved
+        PEN_UP              ///< the touch ended, point is the last known position
+      };
+
+      Type type;
+      Point point;          ///< calibrated display co-ordinate
+      uint32_t millis;      ///< MillisecondTimer::millis() when it happened
+    };
+
+
+    /**
+     * @brief ADS7843 touch screen sampled in the background
+     *
+     * ADS7843AsyncTouchScreen samples on the caller's thread with interrupts off. This class
+     * does all its sampling from interrupts instead. A pen-down on the PENIRQ EXTI line
+     * starts the timer, and each timer update queues one conversion frame on the
+     * SpiTransactionScheduler: a warm-up and 7 X conversions followed by a warm-up and 7 Y
+     * conversions, clocked by DMA. When a frame completes, the 7-sample medians are fed
+     * through a TouchScreenStreamingFilter and then calibrated. The result is published as a
+     * TouchEvent in a small queue, and TouchScreenReadyEventSender is raised.
+     *
+     * A touch is reported after debounceFrames consecutive frames with the pen down, and the
+     * release after releaseFrames ticks with it up, after which the timer is stopped until the
+     * next pen-down. Events are dropped if the queue is full.
+     *
+     * getCoordinates() returns the latest filtered point straight away. The post processor
+     * is not used: the streaming filter replaces it.
+     *
+     * The timer must include its interrupt feature and be set up by the caller for the frame
+     * rate that's wanted, for example every 10ms, but left disabled. The SpiDeviceConfig
+     * prescaler must keep the clock within the ADS7843's 2MHz limit.
+     *
+     * @tparam TScheduler The SpiTransactionScheduler type for the bus
+     * @tparam TTimer The timer type
+     * @tparam TQueueSize The event queue size
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize=8>
+    class ADS7843BackgroundTouchScreen : public TouchScreen {
+
+      public:
+        enum {
+          SAMPLES = 7,
+          FRAME_SIZE = (SAMPLES+1)*2*3      // warm-up + samples for each axis, 3 bytes each
+        };
+
+      protected:
+        enum ControlBits {
+          START = 0x80,
+          A2    = 0x40,
+          A1    = 0x20,
+          A0    = 0x10,
+          MODE1 = 0x8,
+          MODE0 = 0x4,
+          PD1   = 0x2,
+          PD0   = 0x1,
+
+          ChannelX =  A0,
+          ChannelY =  A2 | A0
+        };
+
+        PassThroughTouchScreenPostProcessor _passThrough;
+
+        TScheduler& _scheduler;
+        TTimer& _timer;
+        ExtiPeripheralBase& _exti;
+        GpioPinRef _irqPin;
+        TouchScreenStreamingFilter _filter;
+
+        SpiTransaction _transaction;
+        uint8_t _commands[FRAME_SIZE];
+        uint8_t _results[FRAME_SIZE];
+
+        TouchEvent _queue[TQueueSize];
+        volatile uint8_t _queueHead;
+        volatile uint8_t _queueTail;
+
+        uint8_t _debounceFrames;
+        uint8_t _releaseFrames;
+        uint8_t _pressCount;
+        uint8_t _releaseCount;
+        volatile bool _sampling;
+        volatile bool _down;
+        Point _lastPoint;
+
+      protected:
+        void onNotify(uint8_t extiNumber);
+        void onTimer(TimerEventType tet,uint8_t timerNumber);
+        void onTransaction(SpiTransaction& transaction);
+
+        void stop();
+        void publish(TouchEvent::Type type);
+        void extract(uint8_t first,uint16_t *values) const;
+
+      public:
+        ADS7843BackgroundTouchScreen(
+            TouchScreenCalibration& calibration,
+            TScheduler& scheduler,
+            const SpiDeviceConfig& device,
+            TTimer& timer,
+            const GpioPinRef& irqPin,
+            ExtiPeripheralBase& exti,
+            uint8_t debounceFrames=2,
+            uint8_t releaseFrames=2,
+            uint8_t iirShift=2);
+
+        virtual ~ADS7843BackgroundTouchScreen();
+
+        bool getEvent(TouchEvent& event);
+
+        // overrides from TouchScreen
+
+        virtual bool isTouched() const override;
+        virtual bool getCoordinates(Point& point) override;
+    };
+
+
+    /**
+     * Constructor
+     * @param calibration The class used to translate raw readings to display points
+     * @param scheduler The transaction scheduler for the SPI bus
+     * @param device The ADS7843 chip select and bus settings. Must stay in scope.
+     * @param timer The frame timer, set up for the frame rate and disabled
+     * @param irqPin The PENIRQ pin
+     * @param exti The EXTI line on the PENIRQ pin, falling edge
+     * @param debounceFrames The number of consecutive frames before a touch is reported
+     * @param releaseFrames The number of pen-up ticks before a release is reported
+     * @param iirShift The streaming filter's smoothing, see TouchScreenStreamingFilter
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::ADS7843BackgroundTouchScreen(
+        TouchScreenCalibration& calibration,
+        TScheduler& scheduler,
+        const SpiDeviceConfig& device,
+        TTimer& timer,
+        const GpioPinRef& irqPin,
+        ExtiPeripheralBase& exti,
+        uint8_t debounceFrames,
+        uint8_t releaseFrames,
+        uint8_t iirShift)
+      : TouchScreen(calibration,_passThrough),
+        _scheduler(scheduler),
+        _timer(timer),
+        _exti(exti),
+        _irqPin(irqPin),
+        _filter(iirShift),
+        _queueHead(0),
+        _queueTail(0),
+        _debounceFrames(debounceFrames),
+        _releaseFrames(releaseFrames),
+        _sampling(false),
+        _down(false) {
+
+      uint8_t *ptr;
+
+      // the frame never changes. X conversions leave the reference powered, the last Y
+      // conversion powers down so that PENIRQ is enabled again.
+
+      memset(_commands,0,sizeof(_commands));
+      ptr=_commands;
+
+      for(uint8_t i=0;i<=SAMPLES;i++,ptr+=3)
+        *ptr=ChannelX | START | PD0 | PD1;
+
+      for(uint8_t i=0;i<=SAMPLES;i++,ptr+=3)
+        *ptr=i==SAMPLES ? ChannelY | START : ChannelY | START | PD0 | PD1;
+
+      _transaction.set(device,nullptr,0,_commands,_results,FRAME_SIZE);
+
+      // run one frame to make sure the device has PENIRQ enabled
+
+      _scheduler.submit(_transaction);
+      _scheduler.wait(_transaction);
+      _exti.clearPendingInterrupt();
+
+      _scheduler.SpiTransactionEventSender.insertSubscriber(
+          SpiTransactionEventSourceSlot::bind(this,&ADS7843BackgroundTouchScreen::onTransaction)
+        );
+
+      _timer.TimerInterruptEventSender.insertSubscriber(
+          TimerInterruptEventSourceSlot::bind(this,&ADS7843BackgroundTouchScreen::onTimer)
+        );
+
+      _timer.enableInterrupts(TIM_IT_Update);
+
+      _exti.ExtiInterruptEventSender.insertSubscriber(
+          ExtiInterruptEventSourceSlot::bind(this,&ADS7843BackgroundTouchScreen::onNotify)
+        );
+    }
+
+
+    /**
+     * Destructor
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::~ADS7843BackgroundTouchScreen() {
+
+      _exti.ExtiInterruptEventSender.removeSubscriber(
+          ExtiInterruptEventSourceSlot::bind(this,&ADS7843BackgroundTouchScreen::onNotify)
+        );
+
+      _timer.Timer::disablePeripheral();
+      _timer.disableInterrupts(TIM_IT_Update);
+
+      _timer.TimerInterruptEventSender.removeSubscriber(
+          TimerInterruptEventSourceSlot::bind(this,&ADS7843BackgroundTouchScreen::onTimer)
+        );
+
+      while(!_transaction.isDone());
+
+      _scheduler.SpiTransactionEventSender.removeSubscriber(
+          SpiTransactionEventSourceSlot::bind(this,&ADS7843BackgroundTouchScreen::onTransaction)
+        );
+    }
+
+
+    /**
+     * PENIRQ has gone low. Start sampling if we aren't already.
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline void ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::onNotify(uint8_t /* extiNumber */) {
+
+      if(_sampling)
+        return;
+
+      _sampling=true;
+      _down=false;
+      _pressCount=0;
+      _releaseCount=0;
+      _filter.reset();
+
+      _timer.setCounter(0);
+      _timer.Timer::enablePeripheral();
+    }
+
+
+    /**
+     * Frame timer tick. PENIRQ is only valid between frames so this is where the pen state
+     * is checked.
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline void ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::onTimer(TimerEventType tet,uint8_t /* timerNumber */) {
+
+      if(tet!=TimerEventType::EVENT_UPDATE || !_sampling)
+        return;
+
+      // skip the tick if the bus is too busy to have finished the last frame
+
+      if(!_transaction.isDone())
+        return;
+
+      if(!_irqPin.read()) {
+        _releaseCount=0;
+        _scheduler.submit(_transaction);
+      }
+      else if(++_releaseCount>=_releaseFrames) {
+
+        if(_down)
+          publish(TouchEvent::Type::PEN_UP);
+
+        stop();
+      }
+    }
+
+
+    /**
+     * A frame has been clocked in. Filter it and publish the result.
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline void ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::onTransaction(SpiTransaction& transaction) {
+
+      uint16_t xvalues[SAMPLES],yvalues[SAMPLES];
+      Point raw,point;
+
+      if(&transaction!=&_transaction)
+        return;
+
+      // PENIRQ toggles during conversions
+
+      _exti.clearPendingInterrupt();
+
+      if(!_sampling || transaction.status!=SpiTransaction::Status::COMPLETE)
+        return;
+
+      extract(1,xvalues);
+      extract(SAMPLES+2,yvalues);
+
+      raw=_filter.update(TouchScreenStreamingFilter::median7(xvalues),TouchScreenStreamingFilter::median7(yvalues));
+      point=_calibration->translate(raw);
+
+      if(!_down) {
+
+        _lastPoint=point;
+
+        if(++_pressCount>=_debounceFrames) {
+          _down=true;
+          publish(TouchEvent::Type::PEN_DOWN);
+        }
+      }
+      else if(point.X!=_lastPoint.X || point.Y!=_lastPoint.Y) {
+        _lastPoint=point;
+        publish(TouchEvent::Type::PEN_MOVE);
+      }
+    }
+
+
+    /**
+     * The touch is over. Stop the timer and wait for the next pen-down.
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline void ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::stop() {
+
+      _timer.Timer::disablePeripheral();
+
+      _down=false;
+      _sampling=false;
+
+      _exti.clearPendingInterrupt();
+    }
+
+
+    /**
+     * Add an event to the queue and tell the subscribers
+     * @param type The event type
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline void ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::publish(TouchEvent::Type type) {
+
+      uint8_t head,next;
+
+      head=_queueHead;
+
+      if((next=(head+1) % TQueueSize)==_queueTail)
+        return;
+
+      _queue[head].type=type;
+      _queue[head].point=_lastPoint;
+      _queue[head].millis=MillisecondTimer::millis();
+
+      _queueHead=next;
+
+      TouchScreenReadyEventSender.raiseEvent();
+    }
+
+
+    /**
+     * Pull the 12-bit conversion results for one axis out of the frame. Each conversion is
+     * a command byte then two bytes holding a busy bit, 12 data bits and 3 padding bits.
+     * @param first The index of the first conversion to use
+     * @param values Where to put the SAMPLES results
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline void ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::extract(uint8_t first,uint16_t *values) const {
+
+      const uint8_t *ptr;
+
+      ptr=_results+first*3;
+
+      for(uint8_t i=0;i<SAMPLES;i++,ptr+=3)
+        values[i]=static_cast<uint16_t>(ptr[1] & 0x7f) << 5 | (ptr[2] >> 3);
+    }
+
+
+    /**
+     * Get the next touch event
+     * @param[out] event The event
+     * @return false if there are none waiting
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline bool ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::getEvent(TouchEvent& event) {
+
+      uint8_t tail;
+
+      if((tail=_queueTail)==_queueHead)
+        return false;
+
+      event=_queue[tail];
+      _queueTail=(tail+1) % TQueueSize;
+
+      return true;
+    }
+
+
+    /**
+     * The debounced touch state. PENIRQ can't be read directly while frames are running.
+     * @return true if a touch is in progress
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline bool ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::isTouched() const {
+      return _down;
+    }
+
+
+    /**
+     * Get the latest filtered position. This doesn't sample the panel so it returns
+     * straight away.
+     * @param[out] point The display co-ordinate
+     * @return false with E_NO_TOUCH if there's no touch in progress
+     */
+
+    template<class TScheduler,class TTimer,uint8_t TQueueSize>
+    inline bool ADS7843BackgroundTouchScreen<TScheduler,TTimer,TQueueSize>::getCoordinates(Point& point) {
+
+      IrqSuspend suspender;
+
+      if(!_down)
+        return errorProvider.set(ErrorProvider::ERROR_PROVIDER_TOUCH_SCREEN,E_NO_TOUCH,0);
+
+      point=_lastPoint;
+      return true;
+    }
+  }
+}
@@ -0,0 +1,187 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace display {
+
+    /**
+     * @brief Incremental filter for raw touch panel co-ordinates
+     *
+     * Fed one raw point per sampling frame. Each axis goes through a median of the last 3
+     * frames, which removes single-frame spikes, and then a first order IIR low pass filter
+     * that smooths the jitter that's left. The IIR state is kept with 4 fractional bits and
+     * the coefficient is 1/2^iirShift, so a shift of 0 disables smoothing.
+     *
+     * Nothing here blocks or allocates so it can be updated from an IRQ.
+     */
+
+    class TouchScreenStreamingFilter {
+
+      protected:
+        enum {
+          WINDOW = 3,
+          FRACTION_BITS = 4
+        };
+
+        uint16_t _window[2][WINDOW];
+        int32_t _state[2];
+        uint8_t _count;
+        uint8_t _next;
+        uint8_t _iirShift;
+
+      protected:
+        uint16_t windowMedian(uint8_t axis) const;
+        int16_t smooth(uint8_t axis,uint16_t value);
+
+      public:
+        TouchScreenStreamingFilter(uint8_t iirShift=2);
+
+        void reset();
+        Point update(uint16_t x,uint16_t y);
+
+        static uint16_t median3(uint16_t a,uint16_t b,uint16_t c);
+        static uint16_t median7(uint16_t *samples);
+    };
+
+
+    /**
+     * Constructor
+     * @param iirShift The IIR coefficient is 1/2^iirShift. Larger is smoother but lags more.
+     */
+
+    inline TouchScreenStreamingFilter::TouchScreenStreamingFilter(uint8_t iirShift)
+      : _iirShift(iirShift) {
+      reset();
+    }
+
+
+    /**
+     * Forget the history. Call at the start of each touch.
+     */
+
+    inline void TouchScreenStreamingFilter::reset() {
+      _count=0;
+      _next=0;
+    }
+
+
+    /**
+     * Add the median of one sampling frame and get the filtered point
+     * @param x The raw X value
+     * @param y The raw Y value
+     * @return The filtered raw point
+     */
+
+    inline Point TouchScreenStreamingFilter::update(uint16_t x,uint16_t y) {
+
+      _window[0][_next]=x;
+      _window[1][_next]=y;
+
+      if(++_next==WINDOW)
+        _next=0;
+
+      if(_count<WINDOW)
+        _count++;
+
+      return Point(smooth(0,windowMedian(0)),smooth(1,windowMedian(1)));
+    }
+
+
+    /**
+     * Median of what's in the window. Until it has filled up the newest value is used for one
+     * entry and the mean of two for two.
+     */
+
+    inline uint16_t TouchScreenStreamingFilter::windowMedian(uint8_t axis) const {
+
+      const uint16_t *w;
+
+      w=_window[axis];
+
+      if(_count==1)
+        return w[0];
+
+      if(_count==2)
+        return (w[0]+w[1])/2;
+
+      return median3(w[0],w[1],w[2]);
+    }
+
+
+    /**
+     * Run one axis through the IIR filter. The first value of a touch primes the state.
+     */
+
+    inline int16_t TouchScreenStreamingFilter::smooth(uint8_t axis,uint16_t value) {
+
+      int32_t input;
+
+      input=static_cast<int32_t>(value) << FRACTION_BITS;
+
+      if(_count==1)
+        _state[axis]=input;
+      else
+        _state[axis]+=(input-_state[axis]) >> _iirShift;
+
+      return (_state[axis]+(1 << (FRACTION_BITS-1))) >> FRACTION_BITS;
+    }
+
+
+    /**
+     * Median of three values
+     */
+
+    inline uint16_t TouchScreenStreamingFilter::median3(uint16_t a,uint16_t b,uint16_t c) {
+
+      uint16_t lo,hi;
+
+      if(a<b) {
+        lo=a;
+        hi=b;
+      }
+      else {
+        lo=b;
+        hi=a;
+      }
+
+      if(hi>c)
+        hi=c;
+
+      return lo>hi ? lo : hi;
+    }
+
+
+    /**
+     * Median of 7 samples using a selection network that avoids a full sort. The samples are
+     * reordered.
+     * @param samples Pointer to 7 samples
+     * @return The median
+     */
+
+    inline uint16_t TouchScreenStreamingFilter::median7(uint16_t *samples) {
+
+      auto sort=[](uint16_t& a,uint16_t& b) {
+        uint16_t temp;
+        if(a>b) {
+          temp=a;
+          a=b;
+          b=temp;
+        }
+      };
+
+      sort(samples[0],samples[5]); sort(samples[0],samples[3]); sort(samples[1],samples[6]);
+      sort(samples[2],samples[4]); sort(samples[0],samples[1]); sort(samples[3],samples[5]);
+      sort(samples[2],samples[6]); sort(samples[2],samples[3]); sort(samples[3],samples[6]);
+      sort(samples[4],samples[5]); sort(samples[1],samples[4]); sort(samples[1],samples[3]);
+      sort(samples[3],samples[4]);
+
+      return samples[3];
+    }
+  }
+}
@@ -17,6 +17,8 @@ namespace stm32plus {
     EVENT_COMPLETE,
     EVENT_HALF_COMPLETE,
     EVENT_TRANSFER_ERROR,
+    EVENT_MEMORY0_COMPLETE,     // double buffer mode (F4): memory 0 is finished and can be refilled
+    EVENT_MEMORY1_COMPLETE      // double buffer mode (F4): memory 1 is finished and can be refilled
   };
 
 
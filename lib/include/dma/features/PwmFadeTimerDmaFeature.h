@@ -25,6 +25,9 @@ namespace stm32plus {
       PwmFadeTimerDmaFeature(Dma& dma);
 
       void beginFadeByTimer(Timer& timer,const uint8_t *percents,uint16_t numPercents);
+
+      template<class TEase>
+      void beginEasedFadeByTimer(Timer& timer,typename TEase::Mode mode,uint8_t fromPercent,uint8_t toPercent,uint16_t numSteps);
       void repeatFadeByTimer(const Timer& timer);
   };
 
@@ -78,6 +81,48 @@ namespace stm32plus {
   }
 
 
+  /**
+   * Start a fade that follows an easing curve. The compare values are rendered directly at the
+   * timer's resolution by one of the fx::FixedEase classes so there's no floating point and
+   * no intermediate percentage array. Example:
+   *
+   *   dma.beginEasedFadeByTimer<fx::FixedSineEase>(timer,fx::FixedSineEase::EASE_IN_OUT,0,100,200);
+   *
+   * @tparam TEase The fixed point easing class, e.g. fx::FixedSineEase
+   * @param timer The timer
+   * @param mode EASE_IN, EASE_OUT or EASE_IN_OUT
+   * @param fromPercent The starting duty cycle
+   * @param toPercent The final duty cycle
+   * @param numSteps The number of timer events the fade lasts for
+   */
+
+  template<class TPeripheralInfo,uint16_t TTimerEvent,uint32_t TPriority,uint32_t TDmaMode>
+  template<class TEase>
+  inline void PwmFadeTimerDmaFeature<TPeripheralInfo,TTimerEvent,TPriority,TDmaMode>::beginEasedFadeByTimer(Timer& timer,typename TEase::Mode mode,uint8_t fromPercent,uint8_t toPercent,uint16_t numSteps) {
+
+    uint32_t period;
+
+    // get the timer period from the base class
+
+    period=timer.getPeriod()+1;
+
+    // allocate space for the compare values and render the curve into it
+
+    _compareValues.reset(new uint16_t[numSteps]);
+    _numCompareValues=numSteps;
+
+    TEase::render(mode,
+                  static_cast<int32_t>((static_cast<uint64_t>(period)*fromPercent)/100),
+                  static_cast<int32_t>((static_cast<uint64_t>(period)*toPercent)/100),
+                  _compareValues.get(),
+                  numSteps);
+
+    // set the DMA off
+
+    this->beginWriteByTimer(timer,_compareValues.get(),numSteps);
+  }
+
+
   /**
    * Repeat (start again) a timer-based fade. This is only valid for when the DMA is not
    * running in circular (continuous) mode.
@@ -0,0 +1,82 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+// ensure the MCU series is correct
+#ifndef STM32PLUS_F1
+#error This class can only be used with the STM32F1 series
+#endif
+
+
+namespace stm32plus {
+
+  /**
+   * Dma feature to feed a buffer of 32-bit words into the CRC data register. This is a memory
+   * to memory transfer where the source is incremented and the destination (CRC->DR) is fixed.
+   * The CPU is free while the transfer runs. Use with CrcDma rather than directly. Example:
+   *
+   * Dma1Channel1<DmaCrcFeature> dma;
+   */
+
+  class DmaCrcFeature : public DmaFeatureBase {
+
+    public:
+      enum {
+        MAX_WORDS_PER_TRANSFER = 65535      ///< CNDTR is 16 bits
+      };
+
+    public:
+      DmaCrcFeature(Dma& dma);
+      void beginCrc(const void *source,uint32_t wordCount,uint32_t priority);
+  };
+
+
+  /**
+   * Constructor
+   */
+
+  inline DmaCrcFeature::DmaCrcFeature(Dma& dma)
+    : DmaFeatureBase(dma) {
+
+    DMA_StructInit(&_init);
+
+    _init.DMA_MemoryBaseAddr=reinterpret_cast<uint32_t>(&CRC->DR);
+    _init.DMA_DIR=DMA_DIR_PeripheralSRC;                        // 'peripheral' is source
+    _init.DMA_PeripheralInc=DMA_PeripheralInc_Enable;           // source buffer is incremented
+    _init.DMA_MemoryInc=DMA_MemoryInc_Disable;                  // CRC data register is not incremented
+    _init.DMA_PeripheralDataSize=DMA_PeripheralDataSize_Word;   // the CRC unit works in words
+    _init.DMA_MemoryDataSize=DMA_MemoryDataSize_Word;
+    _init.DMA_Mode=DMA_Mode_Normal;                             // not a circular buffer
+    _init.DMA_M2M=DMA_M2M_Enable;                               // memory->memory configuration
+  }
+
+
+  /**
+   * Start feeding words into the CRC unit. The source must be word aligned.
+   *
+   * @param[in] source The word aligned source buffer.
+   * @param[in] wordCount The number of 32-bit words to transfer, up to MAX_WORDS_PER_TRANSFER.
+   * @param[in] priority The DMA priority level
+   */
+
+  inline void DmaCrcFeature::beginCrc(const void *source,uint32_t wordCount,uint32_t priority) {
+
+    DMA_Channel_TypeDef *peripheralAddress;
+
+    _init.DMA_PeripheralBaseAddr=reinterpret_cast<uint32_t>(source);
+    _init.DMA_BufferSize=wordCount;
+    _init.DMA_Priority=priority;
+
+    // this class is always in a hierarchy with DmaPeripheral
+
+    peripheralAddress=_dma;
+
+    DMA_Cmd(peripheralAddress,DISABLE);
+    DMA_Init(peripheralAddress,&_init);
+    DMA_Cmd(peripheralAddress,ENABLE);
+  }
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+// ensure the MCU series is correct
+#ifndef STM32PLUS_F4
+#error This class can only be used with the STM32F4 series
+#endif
+
+
+namespace stm32plus {
+
+  /**
+   * DMA feature that runs a peripheral feature in the F4 stream's hardware double buffer mode.
+   * The stream alternates between two memory targets (M0AR, M1AR) without stopping and the CT
+   * bit says which one it is currently using. Wrap one of the peripheral features with this
+   * class, for example:
+   *
+   *   Dma1Channel0Stream5<
+   *     DmaDoubleBufferFeature<I2SDmaWriterFeature<I2S3PeripheralTraits,DMA_Priority_High,DMA_Mode_Circular>>,
+   *     Dma1Stream5InterruptFeature
+   *   > dma;
+   *
+   * When the interrupt feature is enabled for COMPLETE then the DmaInterruptEventSender raises
+   * EVENT_MEMORY0_COMPLETE or EVENT_MEMORY1_COMPLETE as each buffer is finished with. That buffer
+   * can then be refilled in place, or replaced with a different buffer by calling setNextBuffer()
+   * before the stream gets back round to it. The stream never stops, so the output is gapless
+   * as long as the handler keeps up.
+   *
+   * @tparam TPeripheralFeature The peripheral feature to wrap, e.g. I2SDmaWriterFeature,
+   *   DacDmaWriterFeature, AdcDmaFeature, AdcMultiDmaFeature, UsartDmaReaderFeature.
+   */
+
+  template<class TPeripheralFeature>
+  class DmaDoubleBufferFeature : public TPeripheralFeature {
+
+    protected:
+      void configureDoubleBuffer(const volatile void *memory1);
+
+    public:
+      DmaDoubleBufferFeature(Dma& dma);
+
+      void beginRead(void *memory0,void *memory1,uint32_t count);
+      void beginWrite(const void *memory0,const void *memory1,uint32_t count);
+
+      void setNextBuffer(const volatile void *buffer);
+      uint8_t getCurrentMemoryTarget() const;
+  };
+
+
+  /**
+   * Constructor
+   * @param dma the base class reference
+   */
+
+  template<class TPeripheralFeature>
+  inline DmaDoubleBufferFeature<TPeripheralFeature>::DmaDoubleBufferFeature(Dma& dma)
+    : TPeripheralFeature(dma) {
+
+    // double buffer mode implies circular mode
+
+    this->_init.DMA_Mode=DMA_Mode_Circular;
+  }
+
+
+  /**
+   * Start a double buffered read from the peripheral into memory. Requires a peripheral
+   * feature that has a beginRead() method.
+   * @param memory0 The first buffer to fill
+   * @param memory1 The second buffer to fill
+   * @param count The number of transfers in each buffer. Both buffers are the same size.
+   */
+
+  template<class TPeripheralFeature>
+  inline void DmaDoubleBufferFeature<TPeripheralFeature>::beginRead(void *memory0,void *memory1,uint32_t count) {
+    configureDoubleBuffer(memory1);
+    TPeripheralFeature::beginRead(memory0,count);
+  }
+
+
+  /**
+   * Start a double buffered write from memory to the peripheral. Requires a peripheral
+   * feature that has a beginWrite() method.
+   * @param memory0 The first buffer to send
+   * @param memory1 The second buffer to send
+   * @param count The number of transfers in each buffer. Both buffers are the same size.
+   */
+
+  template<class TPeripheralFeature>
+  inline void DmaDoubleBufferFeature<TPeripheralFeature>::beginWrite(const void *memory0,const void *memory1,uint32_t count) {
+    configureDoubleBuffer(memory1);
+    TPeripheralFeature::beginWrite(memory0,count);
+  }
+
+
+  /**
+   * Set up the stream for double buffer mode. The stream must be disabled and have stopped
+   * before DBM, CT and M1AR can be written. DMA_Init() leaves DBM and CT alone so the
+   * peripheral feature's own begin method can be called afterwards to complete the setup.
+   * @param memory1 The second memory target
+   */
+
+  template<class TPeripheralFeature>
+  inline void DmaDoubleBufferFeature<TPeripheralFeature>::configureDoubleBuffer(const volatile void *memory1) {
+
+    DMA_Stream_TypeDef *stream;
+
+    stream=this->_dma;
+
+    DMA_Cmd(stream,DISABLE);
+    while(DMA_GetCmdStatus(stream)==ENABLE);
+
+    this->_init.DMA_Mode=DMA_Mode_Circular;
+
+    DMA_DoubleBufferModeConfig(stream,reinterpret_cast<uint32_t>(memory1),DMA_Memory_0);
+    DMA_DoubleBufferModeCmd(stream,ENABLE);
+  }
+
+
+  /**
+   * Replace the buffer that the stream is not currently using. Call this from the
+   * EVENT_MEMORYn_COMPLETE handler to swap a fresh buffer in without stopping the stream.
+   * The hardware ignores writes to the memory address register that it is using.
+   * @param buffer The new buffer. It must be the same size as the original.
+   */
+
+  template<class TPeripheralFeature>
+  inline void DmaDoubleBufferFeature<TPeripheralFeature>::setNextBuffer(const volatile void *buffer) {
+
+    DMA_Stream_TypeDef *stream;
+
+    stream=this->_dma;
+
+    DMA_MemoryTargetConfig(stream,
+                           reinterpret_cast<uint32_t>(buffer),
+                           DMA_GetCurrentMemoryTarget(stream)==0 ? DMA_Memory_1 : DMA_Memory_0);
+  }
+
+
+  /**
+   * Get the memory target that the stream is currently transferring
+   * @return 0 or 1
+   */
+
+  template<class TPeripheralFeature>
+  inline uint8_t DmaDoubleBufferFeature<TPeripheralFeature>::getCurrentMemoryTarget() const {
+    return DMA_GetCurrentMemoryTarget(this->_dma)==0 ? 0 : 1;
+  }
+}
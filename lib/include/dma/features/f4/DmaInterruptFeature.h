@@ -90,6 +90,8 @@ namespace stm32plus {
 
       void enableInterrupts(uint16_t interruptMask);
       void disableInterrupts(uint16_t interruptMask);
+
+      static DmaEventType getCompleteEventType(DMA_Stream_TypeDef *stream);
   };
 
 
@@ -167,6 +169,28 @@ namespace stm32plus {
   }
 
 
+  /**
+   * Get the event type to raise for a transfer complete interrupt. In double buffer mode the
+   * hardware has already switched CT to the other memory target when TC fires so the memory
+   * that has just finished is the one that CT does not point at.
+   * @param stream The stream that raised the interrupt
+   * @return The event type
+   */
+
+  template<uint8_t TDmaNumber,uint8_t TStreamNumber>
+  inline DmaEventType DmaInterruptFeature<TDmaNumber,TStreamNumber>::getCompleteEventType(DMA_Stream_TypeDef *stream) {
+
+    uint32_t cr;
+
+    cr=stream->CR;
+
+    if((cr & DMA_SxCR_DBM)==0)
+      return DmaEventType::EVENT_COMPLETE;
+
+    return (cr & DMA_SxCR_CT)!=0 ? DmaEventType::EVENT_MEMORY0_COMPLETE : DmaEventType::EVENT_MEMORY1_COMPLETE;
+  }
+
+
   /**
    * Enabler specialisations, DMA1
    */
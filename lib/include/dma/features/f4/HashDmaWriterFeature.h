@@ -0,0 +1,97 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+// ensure the MCU series is correct
+#ifndef STM32PLUS_F4
+#error This class can only be used with the STM32F4 series
+#endif
+
+
+namespace stm32plus {
+
+  /**
+   * DMA feature to write words into the HASH processor's input FIFO. The HASH_IN request
+   * is on DMA2 stream 7 channel 2. Use with SHA256Dma rather than directly. Example:
+   *
+   * Dma2Channel2Stream7<HashDmaWriterFeature<>> dma;
+   *
+   * @tparam TPriority The DMA relative priority level
+   */
+
+  template<uint32_t TPriority=DMA_Priority_Medium>
+  class HashDmaWriterFeature : public DmaFeatureBase {
+
+    public:
+      enum {
+        MAX_WORDS_PER_TRANSFER = 65535      ///< NDTR is 16 bits
+      };
+
+    public:
+      HashDmaWriterFeature(Dma& dma);
+      void beginWrite(const void *source,uint32_t wordCount);
+  };
+
+
+  /**
+   * Constructor, store the reference to the DMA base class
+   * @param dma the base class reference
+   */
+
+  template<uint32_t TPriority>
+  inline HashDmaWriterFeature<TPriority>::HashDmaWriterFeature(Dma& dma)
+    : DmaFeatureBase(dma) {
+
+    DMA_StructInit(&_init);
+
+    _init.DMA_Channel=dma.getChannelNumber();                   // channel id
+    _init.DMA_PeripheralBaseAddr=reinterpret_cast<uint32_t>(&HASH->DIN);
+    _init.DMA_DIR=DMA_DIR_MemoryToPeripheral;                   // 'peripheral' is destination
+    _init.DMA_PeripheralInc=DMA_PeripheralInc_Disable;          // 'peripheral' does not increment
+    _init.DMA_MemoryInc=DMA_MemoryInc_Enable;                   // memory is incremented
+    _init.DMA_PeripheralDataSize=DMA_PeripheralDataSize_Word;   // the processor takes words
+    _init.DMA_MemoryDataSize=DMA_MemoryDataSize_Word;
+    _init.DMA_Mode=DMA_Mode_Normal;                             // not a circular buffer
+    _init.DMA_Priority=TPriority;                               // user-configurable priority
+    _init.DMA_FIFOMode=DMA_FIFOMode_Enable;                     // FIFO mode
+    _init.DMA_FIFOThreshold=DMA_FIFOThreshold_HalfFull;         // flush on half-full
+    _init.DMA_MemoryBurst=DMA_MemoryBurst_Single;               // burst size
+    _init.DMA_PeripheralBurst=DMA_PeripheralBurst_Single;       // burst size
+  }
+
+
+  /**
+   * Start a transfer of words to the HASH processor. The processor's DMA enable bit is
+   * cleared by hardware at the end of each transfer so it's set again here.
+   *
+   * @param[in] source word aligned memory address of the source data.
+   * @param[in] wordCount The number of words to transfer, up to MAX_WORDS_PER_TRANSFER.
+   */
+
+  template<uint32_t TPriority>
+  inline void HashDmaWriterFeature<TPriority>::beginWrite(const void *source,uint32_t wordCount) {
+
+    DMA_Stream_TypeDef *peripheralAddress;
+
+    // set up the parameters for this transfer
+
+    _init.DMA_Memory0BaseAddr=reinterpret_cast<uint32_t>(source);
+    _init.DMA_BufferSize=wordCount;
+
+    // this class is always in a hierarchy with DmaPeripheral
+
+    peripheralAddress=_dma;
+
+    // disable and then re-enable
+
+    DMA_Cmd(peripheralAddress,DISABLE);
+    DMA_Init(peripheralAddress,&_init);
+
+    HASH_DMACmd(ENABLE);
+    DMA_Cmd(peripheralAddress,ENABLE);
+  }
+}
@@ -30,12 +30,23 @@ namespace stm32plus {
     public:
       enum {
         SIZE_IN_BYTES = TSizeInBytes,   ///< 32kbit/64Kbit
-        SLAVE_ADDRESS = 0xa0            ///< I2C bus address
+        SLAVE_ADDRESS = 0xa0,           ///< I2C bus address
+        PAGE_SIZE = 32,                 ///< bytes in a page write
+        WRITE_CYCLE_TIMEOUT = 20        ///< milliseconds to ACK poll before giving up (tWR is 5-10ms)
       };
 
+    protected:
+      bool _writeCyclePending;
+      uint32_t _writeCycleStart;
+
+    protected:
+      bool waitUntilReady();
+
     public:
       AT24Cxx(typename TI2C::Parameters& params);
 
+      bool isReady();
+
       // methods to support SerialEeprom
 
       bool writeByte(uint8_t c);
@@ -70,7 +81,9 @@ namespace stm32plus {
   template<class TI2C,int TSizeInBytes>
   inline AT24Cxx<TI2C,TSizeInBytes>::AT24Cxx(typename TI2C::Parameters& params)
     : TI2C(params),
-      SerialEeprom<AT24Cxx<TI2C,TSizeInBytes> >(*this) {
+      SerialEeprom<AT24Cxx<TI2C,TSizeInBytes> >(*this),
+      _writeCyclePending(false),
+      _writeCycleStart(0) {
 
     // set the I2C slave address
 
@@ -82,6 +95,41 @@ namespace stm32plus {
   }
 
 
+  /**
+   * Check if the device has finished its last internal write cycle. The device doesn't
+   * acknowledge its address while the cycle is running so this is a single address-only
+   * transaction and does not block. Use it to schedule other work instead of waiting.
+   * @return true if the device can be read or written now
+   */
+
+  template<class TI2C,int TSizeInBytes>
+  inline bool AT24Cxx<TI2C,TSizeInBytes>::isReady() {
+
+    if(!_writeCyclePending)
+      return true;
+
+    // a device that never answers is left for the next transaction to report
+
+    if(this->isSlaveReady() || MillisecondTimer::hasTimedOut(_writeCycleStart,WRITE_CYCLE_TIMEOUT))
+      _writeCyclePending=false;
+
+    return !_writeCyclePending;
+  }
+
+
+  /**
+   * ACK poll until the last write cycle has finished. This returns as soon as the device
+   * is ready, typically after 3-5ms, instead of waiting for the worst case.
+   * @return true
+   */
+
+  template<class TI2C,int TSizeInBytes>
+  inline bool AT24Cxx<TI2C,TSizeInBytes>::waitUntilReady() {
+    while(!isReady());
+    return true;
+  }
+
+
   /**
    * Write a single byte to the device
    * @param c The byte to write
@@ -91,9 +139,14 @@ namespace stm32plus {
   template<class TI2C,int TSizeInBytes>
   inline bool AT24Cxx<TI2C,TSizeInBytes>::writeByte(uint8_t c) {
 
+    waitUntilReady();
+
     if(!TI2C::writeBytes(this->_position,&c,1))
       return false;
 
+    _writeCyclePending=true;
+    _writeCycleStart=MillisecondTimer::millis();
+
     this->_position++;
     return true;
   }
@@ -101,7 +154,9 @@ namespace stm32plus {
 
   /**
    * Write multiple bytes to the device. We take advantage of the ability to write
-   * multiple bytes in one go when those bytes are all in one page.
+   * multiple bytes in one go when those bytes are all in one page. Each page write is
+   * started as soon as ACK polling shows that the previous one has finished. The method
+   * returns without waiting for the last one, which is waited for by the next access.
    * @param[in] buffer The source of data to write
    * @param[in] count The number of bytes to write
    * @return true if it worked
@@ -115,15 +170,17 @@ namespace stm32plus {
 
     for(ptr=buffer;count;count-=toWrite) {
 
-      toWrite=std::min<uint8_t>(count,0x20-(this->_position & 0x1f));
+      waitUntilReady();
+
+      toWrite=std::min<uint32_t>(count,PAGE_SIZE-(this->_position & (PAGE_SIZE-1)));
       if(!TI2C::writeBytes(this->_position,ptr,toWrite))
         return false;
 
+      _writeCyclePending=true;
+      _writeCycleStart=MillisecondTimer::millis();
+
       ptr+=toWrite;
       this->_position+=toWrite;
-
-      if(count>0)
-        MillisecondTimer::delay(10);
     }
 
     return true;
@@ -139,6 +196,8 @@ namespace stm32plus {
   template<class TI2C,int TSizeInBytes>
   inline bool AT24Cxx<TI2C,TSizeInBytes>::readByte(uint8_t& c) {
 
+    waitUntilReady();
+
     if(!TI2C::readBytes(this->_position,&c,1))
       return false;
 
@@ -160,9 +219,11 @@ namespace stm32plus {
     uint32_t toRead;
     uint8_t *ptr;
 
+    waitUntilReady();
+
     for(ptr=buffer;count;count-=toRead) {
 
-      toRead=std::min<uint8_t>(count,0x20-(this->_position & 0x1f));
+      toRead=std::min<uint32_t>(count,PAGE_SIZE-(this->_position & (PAGE_SIZE-1)));
       if(!TI2C::readBytes(this->_position,ptr,toRead))
         return false;
 
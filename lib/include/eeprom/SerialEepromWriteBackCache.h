@@ -0,0 +1,394 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * A RAM write-back cache of EEPROM pages that presents the same SerialEeprom stream
+   * interface as the device it sits in front of.
+   *
+   * Writes go into cached copies of the pages and return immediately. Repeated writes to the
+   * same page, such as a settings structure being updated field by field, are coalesced into
+   * a single page write of the bytes that actually changed. The dirty pages are written back
+   * one at a time by service(), which never waits for the device: it ACK polls once and
+   * returns if the last write cycle is still running. Call it from the main loop. flush()
+   * writes everything back and waits.
+   *
+   * Reads are served from the cache when the page is cached. A write to a page that isn't
+   * cached reads it in first, unless the write covers the whole page. When all the slots are
+   * dirty, the least recently used one is written back synchronously to make room.
+   *
+   * The cache and the device must only be used from one context: don't call service() from
+   * an IRQ while the application is reading.
+   *
+   * Example:
+   *   typedef AT24C32<I2C1_Default<I2CTwoByteMasterPollingFeature> > MyEeprom;
+   *   MyEeprom eeprom(params);
+   *   SerialEepromWriteBackCache<MyEeprom> settings(eeprom);
+   *
+   *   settings.seek(0x100);
+   *   settings.write(&config,sizeof(config));     // returns at once
+   *   ...
+   *   settings.service();                          // in the main loop
+   *
+   * @tparam TEeprom The EEPROM device class, e.g. AT24C32<...>
+   * @tparam TPages The number of pages to cache
+   */
+
+  template<class TEeprom,uint8_t TPages=4>
+  class SerialEepromWriteBackCache : public SerialEeprom<SerialEepromWriteBackCache<TEeprom,TPages> > {
+
+    public:
+      enum {
+        SIZE_IN_BYTES = TEeprom::SIZE_IN_BYTES,
+        PAGE_SIZE = TEeprom::PAGE_SIZE
+      };
+
+    protected:
+
+      /*
+       * A cached page. The dirty range is [dirtyFirst,dirtyLast).
+       */
+
+      struct Slot {
+        uint8_t data[PAGE_SIZE];
+        uint16_t page;
+        uint8_t dirtyFirst;
+        uint8_t dirtyLast;
+        uint32_t lastUsed;
+        bool valid;
+      };
+
+      static_assert(PAGE_SIZE<=128,"Pages larger than 128 bytes are not supported");
+
+      TEeprom& _eeprom;
+      Slot _slots[TPages];
+      uint32_t _useCounter;
+
+    protected:
+      Slot *findSlot(uint16_t page);
+      Slot *allocateSlot(uint16_t page,bool fill);
+      bool writeBack(Slot& slot);
+      void touch(Slot& slot);
+
+    public:
+      SerialEepromWriteBackCache(TEeprom& eeprom);
+
+      bool service();
+      bool isDirty() const;
+
+      // methods to support SerialEeprom
+
+      bool writeByte(uint8_t c);
+      bool writeBytes(const uint8_t *buffer,uint32_t count);
+
+      bool readByte(uint8_t& c);
+      bool readBytes(uint8_t *buffer,uint32_t count);
+
+      // overrides from SerialEeprom
+
+      virtual bool flush() override;
+      virtual bool close() override;
+  };
+
+
+  /**
+   * Constructor
+   * @param eeprom The EEPROM device
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline SerialEepromWriteBackCache<TEeprom,TPages>::SerialEepromWriteBackCache(TEeprom& eeprom)
+    : SerialEeprom<SerialEepromWriteBackCache<TEeprom,TPages> >(*this),
+      _eeprom(eeprom),
+      _useCounter(0) {
+
+    for(uint8_t i=0;i<TPages;i++)
+      _slots[i].valid=false;
+  }
+
+
+  /**
+   * Mark a slot as the most recently used
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline void SerialEepromWriteBackCache<TEeprom,TPages>::touch(Slot& slot) {
+    slot.lastUsed=++_useCounter;
+  }
+
+
+  /**
+   * Find the slot holding a page
+   * @param page The page number
+   * @return The slot, or nullptr if the page is not cached
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline typename SerialEepromWriteBackCache<TEeprom,TPages>::Slot *SerialEepromWriteBackCache<TEeprom,TPages>::findSlot(uint16_t page) {
+
+    for(uint8_t i=0;i<TPages;i++)
+      if(_slots[i].valid && _slots[i].page==page)
+        return &_slots[i];
+
+    return nullptr;
+  }
+
+
+  /**
+   * Get a slot for a page that isn't cached. A free slot is used if there is one, then the
+   * least recently used clean slot and finally the least recently used dirty slot, which is
+   * written back first.
+   * @param page The page number
+   * @param fill true to read the page from the device
+   * @return The slot, or nullptr if the device failed
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline typename SerialEepromWriteBackCache<TEeprom,TPages>::Slot *SerialEepromWriteBackCache<TEeprom,TPages>::allocateSlot(uint16_t page,bool fill) {
+
+    Slot *victim,*slot;
+    bool victimDirty,dirty;
+
+    victim=nullptr;
+    victimDirty=true;
+
+    for(slot=_slots;slot<_slots+TPages;slot++) {
+
+      if(!slot->valid) {
+        victim=slot;
+        break;
+      }
+
+      dirty=slot->dirtyFirst!=slot->dirtyLast;
+
+      if(victim==nullptr || (victimDirty && !dirty) || (victimDirty==dirty && slot->lastUsed<victim->lastUsed)) {
+        victim=slot;
+        victimDirty=dirty;
+      }
+    }
+
+    if(victim->valid && victim->dirtyFirst!=victim->dirtyLast && !writeBack(*victim))
+      return nullptr;
+
+    victim->valid=false;
+
+    if(fill) {
+      _eeprom.seek(static_cast<uint32_t>(page)*PAGE_SIZE);
+      if(!_eeprom.readBytes(victim->data,PAGE_SIZE))
+        return nullptr;
+    }
+
+    victim->page=page;
+    victim->dirtyFirst=victim->dirtyLast=0;
+    victim->valid=true;
+    touch(*victim);
+
+    return victim;
+  }
+
+
+  /**
+   * Write the dirty part of a slot to the device as one page write. The device's own
+   * ACK polling waits for any write cycle that is still running.
+   * @param slot The slot
+   * @return true if it worked
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::writeBack(Slot& slot) {
+
+    if(!_eeprom.seek(static_cast<uint32_t>(slot.page)*PAGE_SIZE+slot.dirtyFirst))
+      return false;
+
+    if(!_eeprom.writeBytes(slot.data+slot.dirtyFirst,slot.dirtyLast-slot.dirtyFirst))
+      return false;
+
+    slot.dirtyFirst=slot.dirtyLast=0;
+    return true;
+  }
+
+
+  /**
+   * Write back one dirty page if the device is ready for it. This does not wait for the
+   * device so it can be called from the main loop as often as you like.
+   * @return false if a page write failed
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::service() {
+
+    Slot *oldest;
+
+    // find the least recently used dirty page
+
+    oldest=nullptr;
+
+    for(Slot *slot=_slots;slot<_slots+TPages;slot++)
+      if(slot->valid && slot->dirtyFirst!=slot->dirtyLast && (oldest==nullptr || slot->lastUsed<oldest->lastUsed))
+        oldest=slot;
+
+    if(oldest==nullptr || !_eeprom.isReady())
+      return true;
+
+    return writeBack(*oldest);
+  }
+
+
+  /**
+   * Check if there are pages waiting to be written back
+   * @return true if there are
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::isDirty() const {
+
+    for(uint8_t i=0;i<TPages;i++)
+      if(_slots[i].valid && _slots[i].dirtyFirst!=_slots[i].dirtyLast)
+        return true;
+
+    return false;
+  }
+
+
+  /**
+   * Write a single byte into the cache
+   * @param c The byte to write
+   * @return true if it worked
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::writeByte(uint8_t c) {
+    return writeBytes(&c,1);
+  }
+
+
+  /**
+   * Write multiple bytes into the cache
+   * @param[in] buffer The source of data to write
+   * @param[in] count The number of bytes to write
+   * @return true if it worked
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::writeBytes(const uint8_t *buffer,uint32_t count) {
+
+    uint32_t toWrite;
+    uint16_t page;
+    uint8_t offset;
+    Slot *slot;
+
+    for(;count;count-=toWrite) {
+
+      page=this->_position/PAGE_SIZE;
+      offset=this->_position % PAGE_SIZE;
+      toWrite=std::min<uint32_t>(count,PAGE_SIZE-offset);
+
+      // a write of the whole page doesn't need the old contents
+
+      if((slot=findSlot(page))==nullptr && (slot=allocateSlot(page,toWrite!=PAGE_SIZE))==nullptr)
+        return false;
+
+      memcpy(slot->data+offset,buffer,toWrite);
+
+      // widen the dirty range. Clean bytes inside the range are rewritten with the same value.
+
+      if(slot->dirtyFirst==slot->dirtyLast) {
+        slot->dirtyFirst=offset;
+        slot->dirtyLast=offset+toWrite;
+      }
+      else {
+        slot->dirtyFirst=std::min<uint8_t>(slot->dirtyFirst,offset);
+        slot->dirtyLast=std::max<uint8_t>(slot->dirtyLast,offset+toWrite);
+      }
+
+      touch(*slot);
+
+      buffer+=toWrite;
+      this->_position+=toWrite;
+    }
+
+    return true;
+  }
+
+
+  /**
+   * Read a single byte
+   * @param[out] c A reference to the byte to read
+   * @return true if it worked
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::readByte(uint8_t& c) {
+    return readBytes(&c,1);
+  }
+
+
+  /**
+   * Read multiple bytes. Cached pages come from RAM, the rest from the device. Reads
+   * don't allocate slots so a large read doesn't flush the pages being written.
+   * @param[out] buffer Where to read the data to
+   * @param[in] count The number of bytes to read
+   * @return true if it worked
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::readBytes(uint8_t *buffer,uint32_t count) {
+
+    uint32_t toRead;
+    uint8_t offset;
+    Slot *slot;
+
+    for(;count;count-=toRead) {
+
+      offset=this->_position % PAGE_SIZE;
+      toRead=std::min<uint32_t>(count,PAGE_SIZE-offset);
+
+      if((slot=findSlot(this->_position/PAGE_SIZE))!=nullptr)
+        memcpy(buffer,slot->data+offset,toRead);
+      else {
+        if(!_eeprom.seek(this->_position) || !_eeprom.readBytes(buffer,toRead))
+          return false;
+      }
+
+      buffer+=toRead;
+      this->_position+=toRead;
+    }
+
+    return true;
+  }
+
+
+  /**
+   * Write back all the dirty pages and wait for the last write cycle to finish
+   * @return true if it worked
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::flush() {
+
+    for(Slot *slot=_slots;slot<_slots+TPages;slot++)
+      if(slot->valid && slot->dirtyFirst!=slot->dirtyLast && !writeBack(*slot))
+        return false;
+
+    while(!_eeprom.isReady());
+    return true;
+  }
+
+
+  /**
+   * Flush the cache
+   * @return true if it worked
+   */
+
+  template<class TEeprom,uint8_t TPages>
+  inline bool SerialEepromWriteBackCache<TEeprom,TPages>::close() {
+    return flush();
+  }
+}
@@ -110,7 +110,9 @@ namespace stm32plus {
         ERROR_PROVIDER_USB_IN_ENDPOINT                            = 71,
         ERROR_PROVIDER_INTERNAL_FLASH                             = 72,
         ERROR_PROVIDER_INTERNAL_FLASH_SETTINGS                    = 73,
-        ERROR_PROVIDER_CAN                                        = 74
+        ERROR_PROVIDER_CAN                                        = 74,
+        ERROR_PROVIDER_NET_HTTP_REQUEST_PARSER                    = 75,
+        ERROR_PROVIDER_EVENT_SIGNAL                               = 76
       };
 
     public:
@@ -0,0 +1,166 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace wink {
+
+  /**
+   * A drop-in alternative to signal that keeps its subscribers in an inline array sized by a
+   * template parameter. Nothing is allocated. Raising an event is a loop over the array
+   * with no list nodes to chase, and removal searches at most TCapacity entries.
+   *
+   * Subscribers are called newest first, the same order as signal. A subscriber may remove
+   * itself or any other subscriber, or insert a new subscriber, while it's being called. A
+   * removed subscriber that hasn't been called yet is skipped and a new subscriber isn't
+   * called until the next event.
+   *
+   * The library's event sources use this instead of signal when STM32PLUS_EVENT_SLOTS is
+   * defined to the capacity, see config/event.h.
+   *
+   * Running out of places sets the error provider to E_TOO_MANY_SUBSCRIBERS. Increase
+   * STM32PLUS_EVENT_SLOTS if that happens.
+   *
+   * @tparam Slot The slot type, from DECLARE_EVENT_SIGNATURE
+   * @tparam TCapacity The maximum number of subscribers
+   */
+
+  template<class Slot,uint8_t TCapacity>
+  struct fixed_signal {
+
+    public:
+      enum {
+        E_TOO_MANY_SUBSCRIBERS = 1      ///< insertSubscriber() found all TCapacity places taken
+      };
+
+    protected:
+      typedef Slot slot_type;
+
+      slot_type _slots[TCapacity];
+      uint8_t _count;
+      mutable uint8_t _raising;           // during raiseEvent() the index of the slot being called
+
+    public:
+
+      /**
+       * Constructor
+       */
+
+      fixed_signal()
+        : _count(0),
+          _raising(0) {
+      }
+
+
+      /**
+       * Connect a slot to the signal
+       * @param slot The slot to connect
+       * @return false if all TCapacity places are taken
+       */
+
+      bool insertSubscriber(const slot_type& slot) {
+
+        if(_count==TCapacity)
+          return stm32plus::errorProvider.set(stm32plus::ErrorProvider::ERROR_PROVIDER_EVENT_SIGNAL,E_TOO_MANY_SUBSCRIBERS,TCapacity);
+
+        _slots[_count++]=slot;
+        return true;
+      }
+
+
+      /**
+       * Disconnect a slot from the signal. The remaining slots keep their order.
+       * @param slot The slot to disconnect
+       * @return true if it was connected
+       */
+
+      bool removeSubscriber(const slot_type& slot) {
+
+        for(uint8_t i=0;i<_count;i++) {
+
+          if(_slots[i]==slot) {
+
+            // slots below the one being raised move down one place, so follow them
+
+            if(i<_raising)
+              _raising--;
+
+            for(_count--;i<_count;i++)
+              _slots[i]=_slots[i+1];
+
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+
+      /**
+       * Call every connected slot
+       * @param args The arguments to pass to the slots
+       */
+
+      template<class ...Args>
+      void raiseEvent(Args&&... args) const {
+
+        uint8_t outer;
+
+        // work down from the newest. removeSubscriber() adjusts _raising so that a subscriber
+        // that removes itself or another isn't called twice and doesn't cause one to be skipped.
+        // the outer position is saved in case a subscriber raises this event again.
+
+        outer=_raising;
+
+        for(_raising=_count;_raising;) {
+          _raising--;
+          _slots[_raising](args...);
+        }
+
+        _raising=outer;
+      }
+
+
+      /**
+       * @return the number of connected slots
+       */
+
+      uint8_t getSubscriberCount() const {
+        return _count;
+      }
+  };
+
+
+  /**
+   * A signal with one handler that's fixed at compile time. raiseEvent() is a direct call
+   * to the handler, which the compiler can inline into the IRQ handler. There's no
+   * subscription so there is nothing to store.
+   *
+   *   void onComplete(DmaEventType det);
+   *
+   *   struct MyEventSource {
+   *     DECLARE_STATIC_EVENT_SOURCE(DmaInterrupt,onComplete);
+   *   };
+   *
+   * @tparam Slot The slot type, from DECLARE_EVENT_SIGNATURE
+   * @tparam THandler The function to call
+   */
+
+  template<class Slot,typename Slot::FnPtr *THandler>
+  struct static_signal {
+
+    /**
+     * Call the handler
+     * @param args The arguments to pass to it
+     */
+
+    template<class ...Args>
+    void raiseEvent(Args&&... args) const {
+      THandler(args...);
+    }
+  };
+}
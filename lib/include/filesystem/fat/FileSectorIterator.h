@@ -37,6 +37,10 @@ namespace stm32plus {
         bool readSector(void *buffer);
         bool writeSector(void *buffer);
 
+        uint32_t getSectorsRemainingInCluster() const;
+        bool readSectors(void *buffer,uint32_t count);
+        bool writeSectors(const void *buffer,uint32_t count);
+
         void reset(uint32_t firstClusterNumber);
 
         // overrides from Iterator
@@ -34,6 +34,13 @@ namespace stm32plus {
     };
 
 
+    /**
+     * Compatibility typedef
+     */
+
+    typedef BackEaseT<float> BackEase;
+
+
     /**
      * Constructor - sets a default value for the overshoot
      */
@@ -0,0 +1,629 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace fx {
+
+    /**
+     * constexpr maths used to generate the fixed point easing tables at compile time. These
+     * are only ever evaluated by the compiler so they favour accuracy over speed.
+     */
+
+    struct FixedEaseMath {
+
+      static constexpr double PI=3.14159265358979323846;
+
+      static constexpr double sine(double x) {
+
+        double term=0,sum=0;
+
+        // reduce to -pi..pi
+
+        x-=2*PI*static_cast<double>(static_cast<int32_t>(x/(2*PI)));
+
+        if(x>PI)
+          x-=2*PI;
+        else if(x<-PI)
+          x+=2*PI;
+
+        term=x;
+        sum=x;
+
+        for(int i=1;i<20;i++) {
+          term*=-x*x/((2*i)*(2*i+1));
+          sum+=term;
+        }
+
+        return sum;
+      }
+
+      static constexpr double cosine(double x) {
+        return sine(x+PI/2);
+      }
+
+      static constexpr double squareRoot(double x) {
+
+        double r=x>1 ? x : 1;
+
+        if(x<=0)
+          return 0;
+
+        for(int i=0;i<60;i++)
+          r=(r+x/r)/2;
+
+        return r;
+      }
+
+      static constexpr double power2(double x) {
+
+        double y=0,term=1,sum=1;
+        bool negative=false;
+
+        // e^|x.ln2| by series then invert for negative x
+
+        negative=x<0;
+        y=(negative ? -x : x)*0.69314718055994530942;
+
+        for(int i=1;i<60;i++) {
+          term*=y/i;
+          sum+=term;
+        }
+
+        return negative ? 1/sum : sum;
+      }
+    };
+
+
+    /**
+     * Base for the curves. Each curve supplies the normalised ease-in function that maps
+     * time 0..1 to position 0..1, matching the corresponding float easing class with default
+     * parameters. Ease-out and ease-in-out are derived from it by symmetry. Curves whose float
+     * ease-in-out uses different parameters set SEPARATE_IN_OUT and supply the first half in
+     * easeInOutHalf(). Curves that cannot be interpolated accurately set EXACT and supply an
+     * integer implementation in exactIn().
+     */
+
+    struct FixedEaseCurve {
+
+      enum {
+        SEPARATE_IN_OUT = 0,
+        EXACT = 0
+      };
+
+      static constexpr double easeInOutHalf(double) { return 0; }
+      static int32_t exactIn(uint32_t) { return 0; }
+    };
+
+
+    struct LinearEaseCurve : FixedEaseCurve {
+      static constexpr double easeIn(double t) { return t; }
+    };
+
+    struct QuadraticEaseCurve : FixedEaseCurve {
+      static constexpr double easeIn(double t) { return t*t; }
+    };
+
+    struct CubicEaseCurve : FixedEaseCurve {
+      static constexpr double easeIn(double t) { return t*t*t; }
+    };
+
+    struct QuarticEaseCurve : FixedEaseCurve {
+      static constexpr double easeIn(double t) { return t*t*t*t; }
+    };
+
+    struct QuinticEaseCurve : FixedEaseCurve {
+      static constexpr double easeIn(double t) { return t*t*t*t*t; }
+    };
+
+    struct SineEaseCurve : FixedEaseCurve {
+      static constexpr double easeIn(double t) { return 1-FixedEaseMath::cosine(t*FixedEaseMath::PI/2); }
+    };
+
+    struct ExponentialEaseCurve : FixedEaseCurve {
+      static constexpr double easeIn(double t) { return t==0 ? 0 : FixedEaseMath::power2(10*(t-1)); }
+    };
+
+
+    /**
+     * The slope of the circular curve is infinite at the end so it's calculated with an
+     * integer square root instead of a table: 1-sqrt(1-t^2) in Q16.
+     */
+
+    struct CircularEaseCurve : FixedEaseCurve {
+
+      enum { EXACT = 1 };
+
+      static constexpr double easeIn(double t) { return 1-FixedEaseMath::squareRoot(1-t*t); }
+
+      static int32_t exactIn(uint32_t t) {
+
+        uint32_t value,root,bit;
+
+        if(t==0)
+          return 0;
+
+        // 1-t^2 in Q32, then the bitwise square root gives Q16
+
+        value=static_cast<uint32_t>((static_cast<uint64_t>(1) << 32)-static_cast<uint64_t>(t)*t);
+        root=0;
+
+        for(bit=static_cast<uint32_t>(1) << 30;bit;bit>>=2) {
+          if(value>=root+bit) {
+            value-=root+bit;
+            root=(root >> 1)+bit;
+          }
+          else
+            root>>=1;
+        }
+
+        return 65536-static_cast<int32_t>(root);
+      }
+    };
+
+
+    /**
+     * The float back ease-in-out uses 1.525 times the overshoot
+     */
+
+    struct BackEaseCurve : FixedEaseCurve {
+
+      enum { SEPARATE_IN_OUT = 1 };
+
+      static constexpr double easeIn(double t,double s=1.70158) { return t*t*((s+1)*t-s); }
+      static constexpr double easeInOutHalf(double t) { return easeIn(t,1.70158*1.525); }
+    };
+
+
+    /**
+     * The float elastic ease-in-out uses a period of 0.45 instead of 0.3
+     */
+
+    struct ElasticEaseCurve : FixedEaseCurve {
+
+      enum { SEPARATE_IN_OUT = 1 };
+
+      static constexpr double easeIn(double t,double p=0.3) {
+        return t==0 || t==1 ? t : -FixedEaseMath::power2(10*(t-1))*FixedEaseMath::sine((t-1-p/4)*2*FixedEaseMath::PI/p);
+      }
+
+      static constexpr double easeInOutHalf(double t) { return easeIn(t,0.45); }
+    };
+
+
+    struct BounceEaseCurve : FixedEaseCurve {
+
+      static constexpr double easeOut(double t) {
+
+        if(t<1/2.75)
+          return 7.5625*t*t;
+
+        if(t<2/2.75) {
+          t-=1.5/2.75;
+          return 7.5625*t*t+0.75;
+        }
+
+        if(t<2.5/2.75) {
+          t-=2.25/2.75;
+          return 7.5625*t*t+0.9375;
+        }
+
+        t-=2.625/2.75;
+        return 7.5625*t*t+0.984375;
+      }
+
+      static constexpr double easeIn(double t) { return 1-easeOut(1-t); }
+    };
+
+
+    /**
+     * The ease-in curve, or the first half of the ease-in-out curve, sampled at 257 evenly
+     * spaced points in Q16 (65536 = 1.0). Values are signed because the back and elastic
+     * curves overshoot. 1028 bytes of flash per table. The single instance is a member of
+     * this class so that curves using the same table for both modes only get one copy.
+     */
+
+    template<class TCurve,bool TInOutHalf>
+    struct FixedEaseTable {
+
+      enum {
+        SEGMENTS = 256
+      };
+
+      int32_t entries[SEGMENTS+1];
+
+      static const FixedEaseTable instance;
+
+      constexpr FixedEaseTable()
+        : entries() {
+
+        double t=0,v=0;
+
+        for(int i=0;i<=SEGMENTS;i++) {
+          t=static_cast<double>(i)/SEGMENTS;
+          v=(TInOutHalf ? TCurve::easeInOutHalf(t) : TCurve::easeIn(t))*65536;
+          entries[i]=static_cast<int32_t>(v<0 ? v-0.5 : v+0.5);
+        }
+      }
+
+      int32_t lookup(uint32_t t) const {
+
+        uint32_t index;
+        int32_t v0,v1;
+
+        if(t>=65536)
+          return entries[SEGMENTS];
+
+        index=t >> 8;
+        v0=entries[index];
+        v1=entries[index+1];
+
+        return v0+(((v1-v0)*static_cast<int32_t>(t & 0xff)) >> 8);
+      }
+    };
+
+
+    template<class TCurve,bool TInOutHalf>
+    constexpr FixedEaseTable<TCurve,TInOutHalf> FixedEaseTable<TCurve,TInOutHalf>::instance=FixedEaseTable<TCurve,TInOutHalf>();
+
+
+    /**
+     * Non-template base holding the mode enumeration
+     */
+
+    struct FixedEaseBase {
+      enum Mode {
+        EASE_IN,          ///< starts from zero velocity and accelerates
+        EASE_OUT,         ///< starts fast and decelerates to zero velocity
+        EASE_IN_OUT       ///< accelerates then decelerates
+      };
+    };
+
+
+    /**
+     * Fixed point, table driven easing. This is the integer equivalent of the float easing
+     * classes for MCUs without an FPU. The curve is fixed at compile time and evaluated by
+     * linear interpolation in a constexpr generated table so there's no floating point, no
+     * virtual call and no maths library at runtime.
+     *
+     * Times and positions are integers in your own units, as they are in the float classes:
+     * set the duration and total change then call easeIn(), easeOut() or easeInOut().
+     * The static curve functions work directly in Q16 and render() writes a complete
+     * animation into a buffer, for example the compare values for PwmFadeTimerDmaFeature.
+     *
+     * Against the float classes the error is within 0.02% of the full change for the
+     * polynomial, sine and back curves, 0.1% for the circular, exponential and elastic curves
+     * and 0.3% for bounce, where the table has to bridge the discontinuities.
+     *
+     * @tparam TCurve One of the curve structures, e.g. SineEaseCurve
+     */
+
+    template<class TCurve>
+    class FixedEase : public FixedEaseBase {
+
+      protected:
+        typedef FixedEaseTable<TCurve,false> InTableType;
+        typedef FixedEaseTable<TCurve,TCurve::SEPARATE_IN_OUT!=0> InOutTableType;
+
+        int32_t _change;
+        uint32_t _duration;
+
+      protected:
+        uint32_t toQ16(uint32_t time) const;
+        int32_t scale(int32_t q16) const;
+
+        static int32_t inOutHalf(uint32_t t);
+
+        template<typename T>
+        static T clamp(int32_t value);
+
+      public:
+        FixedEase();
+
+        void setDuration(uint32_t duration);
+        void setTotalChangeInPosition(int32_t totalChangeInPosition);
+
+        uint32_t getDuration() const;
+        int32_t getTotalChangeInPosition() const;
+
+        int32_t easeIn(uint32_t time) const;
+        int32_t easeOut(uint32_t time) const;
+        int32_t easeInOut(uint32_t time) const;
+
+        static int32_t curveIn(uint32_t t);
+        static int32_t curveOut(uint32_t t);
+        static int32_t curveInOut(uint32_t t);
+        static int32_t curve(Mode mode,uint32_t t);
+
+        template<typename T>
+        static void render(Mode mode,int32_t from,int32_t to,T *output,uint16_t count);
+    };
+
+
+    /**
+     * Typedefs for easy use
+     */
+
+    typedef FixedEase<LinearEaseCurve> FixedLinearEase;
+    typedef FixedEase<QuadraticEaseCurve> FixedQuadraticEase;
+    typedef FixedEase<CubicEaseCurve> FixedCubicEase;
+    typedef FixedEase<QuarticEaseCurve> FixedQuarticEase;
+    typedef FixedEase<QuinticEaseCurve> FixedQuinticEase;
+    typedef FixedEase<SineEaseCurve> FixedSineEase;
+    typedef FixedEase<CircularEaseCurve> FixedCircularEase;
+    typedef FixedEase<ExponentialEaseCurve> FixedExponentialEase;
+    typedef FixedEase<BackEaseCurve> FixedBackEase;
+    typedef FixedEase<ElasticEaseCurve> FixedElasticEase;
+    typedef FixedEase<BounceEaseCurve> FixedBounceEase;
+
+
+    /**
+     * Constructor
+     */
+
+    template<class TCurve>
+    inline FixedEase<TCurve>::FixedEase()
+      : _change(0),
+        _duration(1) {
+    }
+
+
+    /**
+     * Set the duration
+     * @param[in] duration The duration, must not be zero
+     */
+
+    template<class TCurve>
+    inline void FixedEase<TCurve>::setDuration(uint32_t duration) {
+      _duration=duration;
+    }
+
+
+    /**
+     * Set the total change in position
+     * @param[in] totalChangeInPosition The total change in position.
+     */
+
+    template<class TCurve>
+    inline void FixedEase<TCurve>::setTotalChangeInPosition(int32_t totalChangeInPosition) {
+      _change=totalChangeInPosition;
+    }
+
+
+    /**
+     * Get the duration
+     * @return the duration
+     */
+
+    template<class TCurve>
+    inline uint32_t FixedEase<TCurve>::getDuration() const {
+      return _duration;
+    }
+
+
+    /**
+     * Get the total change in position
+     * @return the total change in position
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::getTotalChangeInPosition() const {
+      return _change;
+    }
+
+
+    /**
+     * Ease-in curve in Q16
+     * @param t The time, 0..65536
+     * @return The position, 65536 = 1.0
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::curveIn(uint32_t t) {
+
+      if(TCurve::EXACT)
+        return TCurve::exactIn(t>65536 ? 65536 : t);
+
+      return InTableType::instance.lookup(t);
+    }
+
+
+    /**
+     * The curve used for each half of ease-in-out, before scaling
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::inOutHalf(uint32_t t) {
+
+      if(TCurve::EXACT)
+        return TCurve::exactIn(t);
+
+      return InOutTableType::instance.lookup(t);
+    }
+
+
+    /**
+     * Ease-out curve in Q16, the ease-in curve rotated about the centre
+     * @param t The time, 0..65536
+     * @return The position, 65536 = 1.0
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::curveOut(uint32_t t) {
+
+      if(t>=65536)
+        return 65536;
+
+      return 65536-curveIn(65536-t);
+    }
+
+
+    /**
+     * Ease-in-out curve in Q16, ease-in to the half way point and ease-out after it
+     * @param t The time, 0..65536
+     * @return The position, 65536 = 1.0
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::curveInOut(uint32_t t) {
+
+      if(t>=65536)
+        return 65536;
+
+      if(t<32768)
+        return inOutHalf(t*2)/2;
+
+      return 65536-inOutHalf(131072-t*2)/2;
+    }
+
+
+    /**
+     * Curve selected by mode, in Q16
+     * @param mode The easing mode
+     * @param t The time, 0..65536
+     * @return The position, 65536 = 1.0
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::curve(Mode mode,uint32_t t) {
+
+      switch(mode) {
+        case EASE_IN:
+          return curveIn(t);
+
+        case EASE_OUT:
+          return curveOut(t);
+
+        default:
+          return curveInOut(t);
+      }
+    }
+
+
+    /**
+     * Convert a time in user units to Q16
+     */
+
+    template<class TCurve>
+    inline uint32_t FixedEase<TCurve>::toQ16(uint32_t time) const {
+
+      if(time>=_duration)
+        return 65536;
+
+      return (static_cast<uint64_t>(time) << 16)/_duration;
+    }
+
+
+    /**
+     * Scale a Q16 position to the total change, rounding to nearest
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::scale(int32_t q16) const {
+      return static_cast<int32_t>((static_cast<int64_t>(_change)*q16+32768) >> 16);
+    }
+
+
+    /**
+     * Ease a transition in
+     * @param[in] time The current animation time, 0..duration
+     * @return the position at the time
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::easeIn(uint32_t time) const {
+      return scale(curveIn(toQ16(time)));
+    }
+
+
+    /**
+     * Ease a transition out
+     * @param[in] time The current animation time, 0..duration
+     * @return the position at the time
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::easeOut(uint32_t time) const {
+      return scale(curveOut(toQ16(time)));
+    }
+
+
+    /**
+     * Ease a transition in and out
+     * @param[in] time The current animation time, 0..duration
+     * @return the position at the time
+     */
+
+    template<class TCurve>
+    inline int32_t FixedEase<TCurve>::easeInOut(uint32_t time) const {
+      return scale(curveInOut(toQ16(time)));
+    }
+
+
+    /**
+     * Clamp a value to the range of an unsigned output type. Signed types are not clamped.
+     */
+
+    template<class TCurve>
+    template<typename T>
+    inline T FixedEase<TCurve>::clamp(int32_t value) {
+
+      if(static_cast<T>(-1)>0) {
+
+        if(value<0)
+          return 0;
+
+        if(static_cast<uint32_t>(value)>static_cast<T>(~static_cast<T>(0)))
+          return static_cast<T>(~static_cast<T>(0));
+      }
+
+      return static_cast<T>(value);
+    }
+
+
+    /**
+     * Render a complete animation into a buffer. The first entry is 'from' and the last is
+     * 'to'. The time step is accumulated in 16.16 fixed point so there is no division per
+     * sample. Overshoot below zero or beyond the range of an unsigned output type is clamped.
+     * @param mode The easing mode
+     * @param from The starting position
+     * @param to The final position
+     * @param output Where to write the positions
+     * @param count The number of positions to write
+     */
+
+    template<class TCurve>
+    template<typename T>
+    inline void FixedEase<TCurve>::render(Mode mode,int32_t from,int32_t to,T *output,uint16_t count) {
+
+      uint64_t step,t;
+      int64_t change;
+
+      if(count==0)
+        return;
+
+      if(count==1) {
+        *output=clamp<T>(to);
+        return;
+      }
+
+      change=static_cast<int64_t>(to)-from;
+      step=(static_cast<uint64_t>(65536) << 16)/(count-1);
+      t=0;
+
+      while(count--) {
+        *output++=clamp<T>(from+static_cast<int32_t>((change*curve(mode,t >> 16)+32768) >> 16));
+        t+=step;
+      }
+
+      // make sure the last one lands exactly
+
+      output[-1]=clamp<T>(to);
+    }
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+
+  /**
+   * Template class for a hash output stream. Everything written is passed to the hash's
+   * update() method so that a file or network stream can be hashed as it goes past without
+   * buffering it. close() finishes the hash and the digest is then available from getDigest().
+   *
+   * @tparam THash Any class with the incremental hash interface, e.g. SHA256 or HmacSHA256.
+   */
+
+  template<class THash>
+  class HashOutputStream : public OutputStream {
+
+    protected:
+      THash& _hash;
+      uint8_t _digest[THash::DIGEST_SIZE];
+
+    public:
+
+      HashOutputStream(THash& hash);
+      virtual ~HashOutputStream() {}
+
+      const uint8_t *getDigest() const;
+
+      // overrides from OutputStream
+
+      virtual bool write(uint8_t c) override;
+      virtual bool write(const void *buffer,uint32_t size) override;
+      virtual bool flush() override;
+      virtual bool close() override;
+  };
+
+
+  /**
+   * Constructor
+   * @param hash The hash implementation. It should be freshly reset.
+   */
+
+  template<class THash>
+  inline HashOutputStream<THash>::HashOutputStream(THash& hash)
+    : _hash(hash) {
+  }
+
+
+  /**
+   * Get the digest. Only valid after close() has been called.
+   * @return A pointer to THash::DIGEST_SIZE bytes
+   */
+
+  template<class THash>
+  inline const uint8_t *HashOutputStream<THash>::getDigest() const {
+    return _digest;
+  }
+
+
+  /**
+   * Write a byte
+   * @param c The byte
+   * @return always true
+   */
+
+  template<class THash>
+  inline bool HashOutputStream<THash>::write(uint8_t c) {
+    _hash.update(&c,1);
+    return true;
+  }
+
+
+  /**
+   * Write a buffer of bytes
+   * @param buffer the buffer
+   * @param size The number of bytes
+   * @return Always true
+   */
+
+  template<class THash>
+  inline bool HashOutputStream<THash>::write(const void *buffer,uint32_t size) {
+    _hash.update(buffer,size);
+    return true;
+  }
+
+
+  /**
+   * Always true.
+   * @return always true
+   */
+
+  template<class THash>
+  inline bool HashOutputStream<THash>::flush() {
+    return true;
+  }
+
+
+  /**
+   * Finish the hash and store the digest
+   * @return false if the hash failed
+   */
+
+  template<class THash>
+  inline bool HashOutputStream<THash>::close() {
+    return _hash.finish(_digest);
+  }
+}
@@ -30,4 +30,5 @@ namespace stm32plus {
    */
 
   template<class... Features> using SHA1HashPeripheral=HashPeripheral<SHA1,Features...>;
+  template<class... Features> using SHA256HashPeripheral=HashPeripheral<SHA256,Features...>;
 }
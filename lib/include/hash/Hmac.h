@@ -0,0 +1,238 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * HMAC (RFC 2104) over any hash class that has the incremental reset()/update()/finish()
+   * interface and the BLOCK_SIZE and DIGEST_SIZE constants, hardware or software. Use it like
+   * the hash itself:
+   *
+   * 1. Call setKey() once, or use the key constructor.
+   * 2. Call update() zero or more times with the message.
+   * 3. Call finish() to receive the MAC.
+   * 4. To use again with the same key, call reset() and go back to step (2).
+   *
+   * The key padded to the block size is kept so that the outer hash can be started in
+   * finish() without the caller having to supply it again.
+   *
+   * A hash class that can't be default constructed, such as SHA256Dma, is constructed from
+   * the first argument of the hash argument constructors:
+   *
+   *   Hmac<SHA256Dma<MyDma>> hmac(dma,key,sizeof(key));
+   */
+
+  template<class THash>
+  class Hmac {
+
+    public:
+      enum {
+        BLOCK_SIZE = THash::BLOCK_SIZE,
+        DIGEST_SIZE = THash::DIGEST_SIZE
+      };
+
+    protected:
+      THash _hash;
+      uint8_t _key[BLOCK_SIZE];
+
+    protected:
+      void startPass(uint8_t pad);
+
+    public:
+      Hmac();
+      Hmac(const void *key,uint32_t keyLength);
+
+      template<class THashArg>
+      explicit Hmac(THashArg& hashArg);
+
+      template<class THashArg>
+      Hmac(THashArg& hashArg,const void *key,uint32_t keyLength);
+      ~Hmac();
+
+      void setKey(const void *key,uint32_t keyLength);
+
+      void reset();
+      void update(const void *data,uint32_t size);
+      bool finish(void *mac);
+
+      bool hash(const void *data,uint32_t size,void *mac);
+  };
+
+
+  /**
+   * Constructor. Call setKey() before use.
+   */
+
+  template<class THash>
+  inline Hmac<THash>::Hmac() {
+    memset(_key,0,sizeof(_key));
+  }
+
+
+  /**
+   * Constructor
+   * @param key The secret key
+   * @param keyLength The key length in bytes
+   */
+
+  template<class THash>
+  inline Hmac<THash>::Hmac(const void *key,uint32_t keyLength) {
+    setKey(key,keyLength);
+  }
+
+
+  /**
+   * Constructor for a hash that takes an argument, e.g. the DMA channel for SHA256Dma. Call
+   * setKey() before use.
+   * @param hashArg The hash constructor argument
+   */
+
+  template<class THash>
+  template<class THashArg>
+  inline Hmac<THash>::Hmac(THashArg& hashArg)
+    : _hash(hashArg) {
+    memset(_key,0,sizeof(_key));
+  }
+
+
+  /**
+   * Constructor for a hash that takes an argument, e.g. the DMA channel for SHA256Dma
+   * @param hashArg The hash constructor argument
+   * @param key The secret key
+   * @param keyLength The key length in bytes
+   */
+
+  template<class THash>
+  template<class THashArg>
+  inline Hmac<THash>::Hmac(THashArg& hashArg,const void *key,uint32_t keyLength)
+    : _hash(hashArg) {
+    setKey(key,keyLength);
+  }
+
+
+  /**
+   * Destructor. Don't leave the key lying around in memory.
+   */
+
+  template<class THash>
+  inline Hmac<THash>::~Hmac() {
+    memset(_key,0,sizeof(_key));
+  }
+
+
+  /**
+   * Set the key and start a new message. Keys longer than the block size are hashed first.
+   * @param key The secret key
+   * @param keyLength The key length in bytes
+   */
+
+  template<class THash>
+  inline void Hmac<THash>::setKey(const void *key,uint32_t keyLength) {
+
+    memset(_key,0,sizeof(_key));
+
+    if(keyLength>BLOCK_SIZE) {
+      _hash.reset();
+      _hash.update(key,keyLength);
+      _hash.finish(_key);
+    }
+    else
+      memcpy(_key,key,keyLength);
+
+    reset();
+  }
+
+
+  /**
+   * Start a new message with the current key
+   */
+
+  template<class THash>
+  inline void Hmac<THash>::reset() {
+    startPass(0x36);
+  }
+
+
+  /**
+   * Reset the hash and feed it the key XOR'd with the inner or outer pad
+   * @param pad 0x36 for the inner pass, 0x5c for the outer
+   */
+
+  template<class THash>
+  inline void Hmac<THash>::startPass(uint8_t pad) {
+
+    uint8_t block[BLOCK_SIZE];
+    uint16_t i;
+
+    for(i=0;i<BLOCK_SIZE;i++)
+      block[i]=_key[i] ^ pad;
+
+    _hash.reset();
+    _hash.update(block,BLOCK_SIZE);
+
+    memset(block,0,sizeof(block));
+  }
+
+
+  /**
+   * Add message data
+   * @param data The data to add
+   * @param size The number of bytes
+   */
+
+  template<class THash>
+  inline void Hmac<THash>::update(const void *data,uint32_t size) {
+    _hash.update(data,size);
+  }
+
+
+  /**
+   * Finish the inner hash, run the outer hash and output the MAC. After this is called
+   * you will need to call reset() to start a new message.
+   * @param mac A pointer to at least DIGEST_SIZE bytes of memory to receive the MAC
+   * @return false if the underlying hash failed
+   */
+
+  template<class THash>
+  inline bool Hmac<THash>::finish(void *mac) {
+
+    uint8_t inner[DIGEST_SIZE];
+
+    if(!_hash.finish(inner))
+      return false;
+
+    startPass(0x5c);
+    _hash.update(inner,DIGEST_SIZE);
+
+    return _hash.finish(mac);
+  }
+
+
+  /**
+   * Convenience function to MAC a single buffer with the current key
+   * @param data The message
+   * @param size The number of bytes
+   * @param mac A pointer to at least DIGEST_SIZE bytes of memory to receive the MAC
+   * @return false if the underlying hash failed
+   */
+
+  template<class THash>
+  inline bool Hmac<THash>::hash(const void *data,uint32_t size,void *mac) {
+    reset();
+    update(data,size);
+    return finish(mac);
+  }
+
+
+  /**
+   * Typedefs for easy use
+   */
+
+  typedef Hmac<SHA256> HmacSHA256;
+}
@@ -0,0 +1,218 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+#if !defined(STM32PLUS_F4_HAS_HASH_SHA256)
+#error Incorrect MCU - this file is for the F4 devices that have SHA256 in the hash processor (F437/F439)
+#endif
+
+
+namespace stm32plus {
+
+
+  /**
+   * SHA256 implementation for the F4 hash processor with the same incremental interface as
+   * the software implementation. After construction, use it like this:
+   *
+   * 1. Call update() zero or more times with any amount of data.
+   * 2. Call finish() to receive the 32 byte digest.
+   * 3. To use again, call reset() and go back to step (1).
+   *
+   * The hash processor takes whole words so up to 3 trailing bytes from each update() are
+   * held back until the next call. The multiple DMA transfer bit is set so that SHA256Dma
+   * can feed the processor in several DMA transfers without it starting the final digest.
+   */
+
+  class SHA256 {
+
+    public:
+      enum {
+        BLOCK_SIZE = 64,          ///< bytes per compression block
+        DIGEST_SIZE = 32          ///< bytes in the digest
+      };
+
+      enum {
+        E_TIMED_OUT = 1,          ///< The digest operation timed out
+      };
+
+    protected:
+      uint32_t _pendingWord;
+      uint8_t _pendingBytes;
+
+    public:
+      SHA256();
+      ~SHA256();
+
+      void reset();
+      void update(const void *data,uint32_t size);
+      bool finish(void *digest,uint32_t timeout=0);
+
+      bool hash(const void *data,uint32_t size,void *digest,uint32_t timeout=0);
+  };
+
+
+  /**
+   * Constructor, start the peripheral clock
+   */
+
+  inline SHA256::SHA256() {
+
+    // clock on
+
+    ClockControl<PERIPHERAL_HASH>::On();
+
+    // reset and init
+
+    reset();
+  }
+
+
+  /**
+   * Destructor, stop the peripheral clock
+   */
+
+  inline SHA256::~SHA256() {
+
+    // de-init and clock off
+
+    HASH_DeInit();
+    ClockControl<PERIPHERAL_HASH>::Off();
+  }
+
+
+  /**
+   * Reset the peripheral and get it ready for a new round of hashing
+   */
+
+  inline void SHA256::reset() {
+
+    HASH_InitTypeDef hinit;
+
+    // close down the peripheral
+
+    HASH_DeInit();
+
+    // set it up. HASH_Init() clears MDMAT so it has to be set afterwards
+
+    hinit.HASH_AlgoSelection=HASH_AlgoSelection_SHA256;
+    hinit.HASH_AlgoMode=HASH_AlgoMode_HASH;
+    hinit.HASH_DataType=HASH_DataType_8b;
+
+    HASH_Init(&hinit);
+    HASH->CR|=HASH_CR_MDMAT;
+
+    _pendingWord=0;
+    _pendingBytes=0;
+  }
+
+
+  /**
+   * Add data to the hash
+   * @param data The data to add
+   * @param size The number of bytes
+   */
+
+  inline void SHA256::update(const void *data,uint32_t size) {
+
+    const uint8_t *ptr;
+    uint32_t word;
+
+    ptr=reinterpret_cast<const uint8_t *>(data);
+
+    // complete a partial word. The processor swaps the bytes so words go in memory order.
+
+    while(size && _pendingBytes) {
+
+      _pendingWord|=static_cast<uint32_t>(*ptr++) << (_pendingBytes*8);
+      size--;
+
+      if(++_pendingBytes==4) {
+        HASH->DIN=_pendingWord;
+        _pendingWord=0;
+        _pendingBytes=0;
+      }
+    }
+
+    // whole words
+
+    while(size>=4) {
+      memcpy(&word,ptr,sizeof(word));
+      HASH->DIN=word;
+      ptr+=4;
+      size-=4;
+    }
+
+    // hold back the remainder
+
+    while(size--) {
+      _pendingWord|=static_cast<uint32_t>(*ptr++) << (_pendingBytes*8);
+      _pendingBytes++;
+    }
+  }
+
+
+  /**
+   * Write the last partial word, run the final digest and get the result. After this is
+   * called you will need to call reset() to use this class for new hash computations.
+   * @param digest A pointer to at least 32 bytes of memory to receive the digest
+   * @param timeout How long to wait for the computation, 0 = forever. 0 is the default.
+   * @return true if it worked, false if we timed out waiting
+   */
+
+  inline bool SHA256::finish(void *digest,uint32_t timeout) {
+
+    uint32_t start,i;
+    HASH_MsgDigest md;
+
+    // tell the peripheral how much is valid in the last word
+
+    HASH_SetLastWordValidBitsNbr(_pendingBytes*8);
+
+    if(_pendingBytes)
+      HASH->DIN=_pendingWord;
+
+    // start the digest process
+
+    HASH_StartDigest();
+
+    // wait for BUSY to go low
+
+    if(timeout)
+      start=MillisecondTimer::millis();
+
+    while(HASH_GetFlagStatus(HASH_FLAG_BUSY)!=RESET) {
+      if(timeout && MillisecondTimer::hasTimedOut(start,timeout))
+        return errorProvider.set(ErrorProvider::ERROR_PROVIDER_HASH,E_TIMED_OUT);
+    }
+
+    // the digest registers hold big-endian words
+
+    HASH_GetDigest(&md);
+
+    for(i=0;i<8;i++)
+      md.Data[i]=__REV(md.Data[i]);
+
+    memcpy(digest,md.Data,DIGEST_SIZE);
+    return true;
+  }
+
+
+  /**
+   * Convenience function to hash a single buffer. The peripheral is reset first.
+   * @param data The data to hash
+   * @param size The number of bytes
+   * @param digest A pointer to at least 32 bytes of memory to receive the digest
+   * @param timeout How long to wait for the computation, 0 = forever. 0 is the default.
+   * @return true if it worked, false if we timed out waiting
+   */
+
+  inline bool SHA256::hash(const void *data,uint32_t size,void *digest,uint32_t timeout) {
+    reset();
+    update(data,size);
+    return finish(digest,timeout);
+  }
+}
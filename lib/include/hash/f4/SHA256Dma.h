@@ -0,0 +1,252 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+#if !defined(STM32PLUS_F4_HAS_HASH_SHA256)
+#error Incorrect MCU - this file is for the F4 devices that have SHA256 in the hash processor (F437/F439)
+#endif
+
+
+namespace stm32plus {
+
+
+  /**
+   * Hardware SHA256 fed by DMA. The DMA channel must be DMA2 stream 7 channel 2 with the
+   * HashDmaWriterFeature. There are two ways to use it:
+   *
+   *   beginUpdate() starts a transfer and returns immediately so the CPU can service the
+   *   network stack or read the next block of the image. Poll isComplete() or call
+   *   waitUntilComplete() before reusing the buffer. The DMA can move at most 65535 words at
+   *   a time so a larger buffer is sent in pieces, each started by isComplete() or
+   *   waitUntilComplete() when the last one finishes.
+   *
+   *   update(), as called by HashOutputStream, DMAs the aligned middle of the
+   *   buffer if it's at least 'minimumBytes' long and waits for it to finish.
+   *
+   * Example:
+   *   typedef Dma2Channel2Stream7<HashDmaWriterFeature<>> MyDma;
+   *   MyDma dma;
+   *   SHA256Dma<MyDma> sha(dma);
+   *   Hmac<SHA256Dma<MyDma>> hmac(dma,key,sizeof(key));
+   *
+   * @tparam TDma The DMA channel class, including HashDmaWriterFeature
+   */
+
+  template<class TDma>
+  class SHA256Dma : public SHA256 {
+
+    protected:
+      TDma& _dma;
+      uint32_t _minimumBytes;
+      const uint32_t *_next;
+      uint32_t _remaining;
+      bool _busy;
+
+    protected:
+      void beginNextTransfer();
+
+    public:
+      SHA256Dma(TDma& dma,uint32_t minimumBytes=256);
+
+      void reset();
+      void update(const void *data,uint32_t size);
+      bool finish(void *digest,uint32_t timeout=0);
+      bool hash(const void *data,uint32_t size,void *digest,uint32_t timeout=0);
+
+      bool beginUpdate(const uint32_t *buffer,uint32_t count);
+      bool isComplete();
+      bool waitUntilComplete();
+  };
+
+
+  /**
+   * Constructor
+   * @param dma The DMA channel
+   * @param minimumBytes update() calls with less data than this are fed by the CPU
+   */
+
+  template<class TDma>
+  inline SHA256Dma<TDma>::SHA256Dma(TDma& dma,uint32_t minimumBytes)
+    : _dma(dma),
+      _minimumBytes(minimumBytes),
+      _next(nullptr),
+      _remaining(0),
+      _busy(false) {
+  }
+
+
+  /**
+   * Reset the peripheral. Any transfer in progress is allowed to finish first.
+   */
+
+  template<class TDma>
+  inline void SHA256Dma<TDma>::reset() {
+    waitUntilComplete();
+    SHA256::reset();
+  }
+
+
+  /**
+   * Add data to the hash, returning when it has all been written to the processor
+   * @param data The data to add
+   * @param size The number of bytes
+   */
+
+  template<class TDma>
+  inline void SHA256Dma<TDma>::update(const void *data,uint32_t size) {
+
+    const uint8_t *ptr;
+    uint32_t head,words;
+
+    waitUntilComplete();
+
+    ptr=reinterpret_cast<const uint8_t *>(data);
+
+    // the CPU handles the bytes up to the first word boundary. The DMA can only take over if
+    // that also leaves no partial word pending.
+
+    head=(4-(reinterpret_cast<uint32_t>(ptr) & 3)) & 3;
+
+    if(size<_minimumBytes || ((_pendingBytes+head) & 3)!=0) {
+      SHA256::update(data,size);
+      return;
+    }
+
+    SHA256::update(ptr,head);
+    ptr+=head;
+    size-=head;
+
+    words=size/4;
+
+    beginUpdate(reinterpret_cast<const uint32_t *>(ptr),words);
+    waitUntilComplete();
+
+    SHA256::update(ptr+words*4,size & 3);
+  }
+
+
+  /**
+   * Start a DMA transfer of a word buffer into the processor and return immediately. The
+   * buffer must not be modified until the transfer is complete.
+   * @param buffer The word aligned buffer
+   * @param count The number of words
+   * @return false if there are bytes pending from a previous call to update()
+   */
+
+  template<class TDma>
+  inline bool SHA256Dma<TDma>::beginUpdate(const uint32_t *buffer,uint32_t count) {
+
+    waitUntilComplete();
+
+    if(_pendingBytes)
+      return false;
+
+    if(count) {
+      _next=buffer;
+      _remaining=count;
+      beginNextTransfer();
+    }
+
+    return true;
+  }
+
+
+  /**
+   * Start a transfer of as much of the remaining buffer as the DMA can take in one go. The
+   * processor's multiple DMA transfer bit stops it starting the digest between pieces.
+   */
+
+  template<class TDma>
+  inline void SHA256Dma<TDma>::beginNextTransfer() {
+
+    uint32_t count;
+
+    count=std::min(_remaining,static_cast<uint32_t>(TDma::MAX_WORDS_PER_TRANSFER));
+
+    _dma.beginWrite(_next,count);
+
+    _next+=count;
+    _remaining-=count;
+    _busy=true;
+  }
+
+
+  /**
+   * Check if the last transfer has completed
+   * @return true if complete or if there was nothing in progress
+   */
+
+  template<class TDma>
+  inline bool SHA256Dma<TDma>::isComplete() {
+
+    if(_busy && _dma.isComplete()) {
+      if(_remaining)
+        beginNextTransfer();
+      else
+        _busy=false;
+    }
+
+    return !_busy;
+  }
+
+
+  /**
+   * Wait for the last transfer to complete
+   * @return false if the DMA reported an error
+   */
+
+  template<class TDma>
+  inline bool SHA256Dma<TDma>::waitUntilComplete() {
+
+    bool ok;
+
+    if(!_busy)
+      return true;
+
+    while((ok=_dma.waitUntilComplete()) && _remaining)
+      beginNextTransfer();
+
+    _remaining=0;
+    _busy=false;
+
+    return ok;
+  }
+
+
+  /**
+   * Wait for any transfer then finish the digest
+   * @param digest A pointer to at least 32 bytes of memory to receive the digest
+   * @param timeout How long to wait for the computation, 0 = forever
+   * @return false if the DMA failed or the digest timed out
+   */
+
+  template<class TDma>
+  inline bool SHA256Dma<TDma>::finish(void *digest,uint32_t timeout) {
+
+    if(!waitUntilComplete())
+      return false;
+
+    return SHA256::finish(digest,timeout);
+  }
+
+
+  /**
+   * Convenience function to hash a single buffer
+   * @param data The data to hash
+   * @param size The number of bytes
+   * @param digest A pointer to at least 32 bytes of memory to receive the digest
+   * @param timeout How long to wait for the computation, 0 = forever
+   * @return false if the DMA failed or the digest timed out
+   */
+
+  template<class TDma>
+  inline bool SHA256Dma<TDma>::hash(const void *data,uint32_t size,void *digest,uint32_t timeout) {
+    reset();
+    update(data,size);
+    return finish(digest,timeout);
+  }
+}
@@ -0,0 +1,311 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+#if defined(STM32PLUS_F4_HAS_HASH_SHA256)
+#error Incorrect MCU - this file is for devices without SHA256 in hardware
+#endif
+
+
+namespace stm32plus {
+
+  /**
+   * Software SHA-256 (FIPS 180-4) with an incremental interface. After construction, use it
+   * like this:
+   *
+   * 1. Call update() zero or more times with any amount of data.
+   * 2. Call finish() to receive the 32 byte digest.
+   * 3. To use again, call reset() and go back to step (1).
+   *
+   * Only a 64 byte partial block is held between calls so arbitrarily large files and network
+   * streams can be hashed a buffer at a time. The rounds are unrolled 8 at a time and the
+   * message schedule is kept in a rolling 16 word window that's extended a word per round.
+   */
+
+  class SHA256 {
+
+    public:
+      enum {
+        BLOCK_SIZE = 64,          ///< bytes per compression block
+        DIGEST_SIZE = 32          ///< bytes in the digest
+      };
+
+    protected:
+      uint32_t _state[8];
+      uint8_t _buffer[BLOCK_SIZE];
+      uint8_t _bufferUsed;
+      uint64_t _length;
+
+    protected:
+      static uint32_t rotr(uint32_t value,uint32_t steps);
+      static uint32_t loadBigEndian(const uint8_t *ptr);
+      static void storeBigEndian(uint8_t *ptr,uint32_t value);
+
+      void transform(const uint8_t *block);
+
+    public:
+      SHA256();
+
+      void reset();
+      void update(const void *data,uint32_t size);
+      bool finish(void *digest);
+
+      bool hash(const void *data,uint32_t size,void *digest);
+  };
+
+
+  /**
+   * Constructor
+   */
+
+  inline SHA256::SHA256() {
+    reset();
+  }
+
+
+  /**
+   * Reset to the initial state ready for a new message
+   */
+
+  inline void SHA256::reset() {
+
+    _state[0]=0x6a09e667;
+    _state[1]=0xbb67ae85;
+    _state[2]=0x3c6ef372;
+    _state[3]=0xa54ff53a;
+    _state[4]=0x510e527f;
+    _state[5]=0x9b05688c;
+    _state[6]=0x1f83d9ab;
+    _state[7]=0x5be0cd19;
+
+    _bufferUsed=0;
+    _length=0;
+  }
+
+
+  /**
+   * Rotate right
+   */
+
+  inline uint32_t SHA256::rotr(uint32_t value,uint32_t steps) {
+    return (value >> steps) | (value << (32-steps));
+  }
+
+
+  /**
+   * Load a big endian word. memcpy keeps this safe on the M0 when the pointer is not aligned.
+   */
+
+  inline uint32_t SHA256::loadBigEndian(const uint8_t *ptr) {
+
+    uint32_t word;
+
+    memcpy(&word,ptr,sizeof(word));
+    return __builtin_bswap32(word);
+  }
+
+
+  /**
+   * Store a big endian word
+   */
+
+  inline void SHA256::storeBigEndian(uint8_t *ptr,uint32_t value) {
+
+    value=__builtin_bswap32(value);
+    memcpy(ptr,&value,sizeof(value));
+  }
+
+
+  /**
+   * Add data to the hash
+   * @param data The data to add
+   * @param size The number of bytes
+   */
+
+  inline void SHA256::update(const void *data,uint32_t size) {
+
+    const uint8_t *ptr;
+    uint32_t count;
+
+    ptr=reinterpret_cast<const uint8_t *>(data);
+    _length+=size;
+
+    // top up a partial block
+
+    if(_bufferUsed) {
+
+      count=BLOCK_SIZE-_bufferUsed;
+      if(count>size)
+        count=size;
+
+      memcpy(_buffer+_bufferUsed,ptr,count);
+      _bufferUsed+=count;
+      ptr+=count;
+      size-=count;
+
+      if(_bufferUsed<BLOCK_SIZE)
+        return;
+
+      transform(_buffer);
+      _bufferUsed=0;
+    }
+
+    // whole blocks are processed straight from the caller's buffer
+
+    while(size>=BLOCK_SIZE) {
+      transform(ptr);
+      ptr+=BLOCK_SIZE;
+      size-=BLOCK_SIZE;
+    }
+
+    // keep the remainder
+
+    if(size) {
+      memcpy(_buffer,ptr,size);
+      _bufferUsed=size;
+    }
+  }
+
+
+  /**
+   * Pad the message and output the digest. After this is called you will need to call reset()
+   * to use this class for new hash computations.
+   * @param digest A pointer to at least 32 bytes of memory to receive the digest
+   * @return always true
+   */
+
+  inline bool SHA256::finish(void *digest) {
+
+    uint8_t *out;
+    uint64_t bits;
+
+    bits=_length*8;
+
+    // the 0x80 terminator, then zeros up to the 8 byte length at the end of the last block
+
+    _buffer[_bufferUsed++]=0x80;
+
+    if(_bufferUsed>BLOCK_SIZE-8) {
+      memset(_buffer+_bufferUsed,0,BLOCK_SIZE-_bufferUsed);
+      transform(_buffer);
+      _bufferUsed=0;
+    }
+
+    memset(_buffer+_bufferUsed,0,BLOCK_SIZE-8-_bufferUsed);
+    storeBigEndian(_buffer+BLOCK_SIZE-8,bits >> 32);
+    storeBigEndian(_buffer+BLOCK_SIZE-4,bits);
+    transform(_buffer);
+
+    out=reinterpret_cast<uint8_t *>(digest);
+
+    for(uint8_t i=0;i<8;i++)
+      storeBigEndian(out+i*4,_state[i]);
+
+    return true;
+  }
+
+
+  /**
+   * Convenience function to hash a single buffer. The object is reset first.
+   * @param data The data to hash
+   * @param size The number of bytes
+   * @param digest A pointer to at least 32 bytes of memory to receive the digest
+   * @return always true
+   */
+
+  inline bool SHA256::hash(const void *data,uint32_t size,void *digest) {
+    reset();
+    update(data,size);
+    return finish(digest);
+  }
+
+
+  /**
+   * Process one 64 byte block
+   * @param block The block
+   */
+
+  inline void SHA256::transform(const uint8_t *block) {
+
+    static const uint32_t k[64]={
+      0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+      0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+      0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+      0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+      0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+      0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+      0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+      0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+    };
+
+    uint32_t w[16];
+    uint32_t a,b,c,d,e,f,g,h,t;
+    uint8_t i;
+
+    a=_state[0];
+    b=_state[1];
+    c=_state[2];
+    d=_state[3];
+    e=_state[4];
+    f=_state[5];
+    g=_state[6];
+    h=_state[7];
+
+    // one round. The caller rotates the variable names instead of moving the values.
+
+  #define sha256round(a,b,c,d,e,f,g,h,j,word) \
+    t=h+(rotr(e,6) ^ rotr(e,11) ^ rotr(e,25))+((e & f) ^ (~e & g))+k[j]+(word); \
+    d+=t; \
+    h=t+(rotr(a,2) ^ rotr(a,13) ^ rotr(a,22))+((a & b) ^ (a & c) ^ (b & c));
+
+    // the first 16 rounds consume the block directly
+
+  #define sha256load(j) (w[j]=loadBigEndian(block+(j)*4))
+
+    for(i=0;i<16;i+=8) {
+      sha256round(a,b,c,d,e,f,g,h,i+0,sha256load(i+0))
+      sha256round(h,a,b,c,d,e,f,g,i+1,sha256load(i+1))
+      sha256round(g,h,a,b,c,d,e,f,i+2,sha256load(i+2))
+      sha256round(f,g,h,a,b,c,d,e,i+3,sha256load(i+3))
+      sha256round(e,f,g,h,a,b,c,d,i+4,sha256load(i+4))
+      sha256round(d,e,f,g,h,a,b,c,i+5,sha256load(i+5))
+      sha256round(c,d,e,f,g,h,a,b,i+6,sha256load(i+6))
+      sha256round(b,c,d,e,f,g,h,a,i+7,sha256load(i+7))
+    }
+
+    // the remaining 48 extend the schedule in place, one word per round
+
+  #define sha256schedule(j) \
+    (w[(j) & 15]+=(rotr(w[((j)-2) & 15],17) ^ rotr(w[((j)-2) & 15],19) ^ (w[((j)-2) & 15] >> 10)) \
+                 +w[((j)-7) & 15] \
+                 +(rotr(w[((j)-15) & 15],7) ^ rotr(w[((j)-15) & 15],18) ^ (w[((j)-15) & 15] >> 3)))
+
+    for(i=16;i<64;i+=8) {
+      sha256round(a,b,c,d,e,f,g,h,i+0,sha256schedule(i+0))
+      sha256round(h,a,b,c,d,e,f,g,i+1,sha256schedule(i+1))
+      sha256round(g,h,a,b,c,d,e,f,i+2,sha256schedule(i+2))
+      sha256round(f,g,h,a,b,c,d,e,i+3,sha256schedule(i+3))
+      sha256round(e,f,g,h,a,b,c,d,i+4,sha256schedule(i+4))
+      sha256round(d,e,f,g,h,a,b,c,i+5,sha256schedule(i+5))
+      sha256round(c,d,e,f,g,h,a,b,i+6,sha256schedule(i+6))
+      sha256round(b,c,d,e,f,g,h,a,i+7,sha256schedule(i+7))
+    }
+
+  #undef sha256schedule
+  #undef sha256load
+  #undef sha256round
+
+    _state[0]+=a;
+    _state[1]+=b;
+    _state[2]+=c;
+    _state[3]+=d;
+    _state[4]+=e;
+    _state[5]+=f;
+    _state[6]+=g;
+    _state[7]+=h;
+  }
+}
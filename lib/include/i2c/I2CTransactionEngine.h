@@ -0,0 +1,701 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+#if !defined(STM32PLUS_F1) && !defined(STM32PLUS_F4)
+#error This class can only be used with the STM32F1 and STM32F4 series
+#endif
+
+
+namespace stm32plus {
+
+  /**
+   * A write, read or write-then-read exchange with a slave. For a register read put the
+   * register address in the write buffer and the result buffer in the read buffer and the
+   * engine will use a repeated start between the two phases. A FAILED transaction has the
+   * error in 'failure'.
+   */
+
+  struct I2CTransaction : Transaction {
+
+    uint8_t slaveAddress;             ///< left aligned 7-bit address, as for setSlaveAddress()
+    const uint8_t *writeData;         ///< bytes to write, usually the register address first
+    uint16_t writeLength;             ///< zero for a read-only transaction
+    uint8_t *readData;                ///< where to put the bytes read
+    uint16_t readLength;              ///< zero for a write-only transaction
+    I2CEventType failure;             ///< the error event when status is FAILED
+
+    I2CTransaction()
+      : slaveAddress(0),
+        writeData(nullptr),
+        writeLength(0),
+        readData(nullptr),
+        readLength(0),
+        failure(I2CEventType::EVENT_ERROR) {
+    }
+
+    /**
+     * Set up the transaction
+     */
+
+    void set(uint8_t slave,const void *wdata,uint16_t wlength,void *rdata,uint16_t rlength) {
+      slaveAddress=slave;
+      writeData=static_cast<const uint8_t *>(wdata);
+      writeLength=wlength;
+      readData=static_cast<uint8_t *>(rdata);
+      readLength=rlength;
+    }
+
+    /**
+     * @return the failure event, as the cause of the error set by wait()
+     */
+
+    uint32_t getFailureCause() const {
+      return static_cast<uint32_t>(failure);
+    }
+  };
+
+
+  /**
+   * The signature for transaction completion events: void myHandler(I2CTransaction& t);
+   */
+
+  DECLARE_EVENT_SIGNATURE(I2CTransaction,void(I2CTransaction&));
+
+
+  /**
+   * Placeholder for the DMA channel types when the engine runs without DMA
+   */
+
+  struct I2CNoDma : DmaEventSource {
+    operator Dma::DMA_PeripheralType *() { return nullptr; }
+    void beginWrite(const void * /* source */,uint32_t /* count */) {}
+    void beginRead(void * /* dest */,uint32_t /* count */) {}
+    void enableInterrupts(uint16_t /* interruptMask */) {}
+  };
+
+
+  /**
+   * Non-blocking master mode transaction engine for the F1/F4 I2C peripheral. The transactions
+   * queued with submit() are run from the I2C event and error interrupts, so the CPU is only
+   * involved for a few microseconds per byte instead of the whole transaction. Completion is
+   * signalled through the transaction's status and the I2CTransactionEventSender event, which
+   * is raised from the IRQ. See TransactionQueue for submit(), wait() and isIdle().
+   *
+   * With DMA channels supplied, payloads of at least the DMA threshold are moved by the
+   * I2CDmaWriterFeature/I2CDmaReaderFeature channels and the CPU is only interrupted at the
+   * start and end of the phase. The reader channel must include its DMA interrupt feature
+   * because the end of a DMA read is signalled by the DMA transfer complete interrupt.
+   *
+   * The peripheral must include its I2CInterruptFeature. Give the I2C interrupts a high NVIC
+   * priority: the F1/F4 I2C needs some events to be handled before the next byte finishes.
+   *
+   * Example, reading 6 bytes from register 0x3b of an MPU-6050:
+   *
+   *   typedef I2C1_Default<I2C1InterruptFeature> MyI2C;
+   *   MyI2C i2c(params);
+   *   I2CTransactionEngine<MyI2C> engine(i2c);
+   *
+   *   static const uint8_t reg=0x3b;
+   *   uint8_t data[6];
+   *   I2CTransaction t;
+   *
+   *   t.set(0xd0,&reg,1,data,sizeof(data));
+   *   engine.submit(t);
+   *   ... do other work, or subscribe to engine.I2CTransactionEventSender ...
+   *   if(t.status==I2CTransaction::Status::COMPLETE) ...
+   *
+   * @tparam TI2C The I2C peripheral type including its interrupt feature
+   * @tparam TDmaWriter The TX DMA channel type with I2CDmaWriterFeature, or I2CNoDma
+   * @tparam TDmaReader The RX DMA channel type with I2CDmaReaderFeature and its interrupt feature, or I2CNoDma
+   * @tparam TQueueSize The maximum number of transactions waiting for the bus
+   */
+
+  template<class TI2C,class TDmaWriter=I2CNoDma,class TDmaReader=I2CNoDma,uint8_t TQueueSize=8>
+  class I2CTransactionEngine : public TransactionQueue<I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>,
+                                                       I2CTransaction,
+                                                       TQueueSize,
+                                                       ErrorProvider::ERROR_PROVIDER_I2C,
+                                                       I2C::E_QUEUE_FULL,
+                                                       I2C::E_TRANSACTION_FAILED> {
+
+    public:
+      DECLARE_EVENT_SOURCE(I2CTransaction);
+
+      typedef TransactionQueue<I2CTransactionEngine,
+                               I2CTransaction,
+                               TQueueSize,
+                               ErrorProvider::ERROR_PROVIDER_I2C,
+                               I2C::E_QUEUE_FULL,
+                               I2C::E_TRANSACTION_FAILED> TransactionQueueType;
+
+      friend TransactionQueueType;
+
+    protected:
+      enum class State : uint8_t {
+        IDLE,
+        WRITE_ADDRESS,
+        WRITING,
+        WRITING_DMA,
+        READ_ADDRESS,
+        READING,
+        READING_DMA
+      };
+
+      TI2C& _i2c;
+      TDmaWriter *_dmaWriter;
+      TDmaReader *_dmaReader;
+      uint16_t _dmaThreshold;
+
+      State _state;
+      uint16_t _index;
+
+    protected:
+      void initialise();
+
+      void onInterrupt(I2CEventType iet);
+      void onDmaInterrupt(DmaEventType det);
+
+      void onEvent();
+      void onStartBit();
+      void onAddress();
+      void onTransmit();
+      void onReceive();
+      void onByteTransferFinished();
+      void onError(I2CEventType iet);
+
+      void finishWrite();
+      void finish(bool success);
+
+      void startTransaction();
+      void raiseTransactionEvent(I2CTransaction& transaction);
+
+      void clearAddress() const;
+      void enableBufferInterrupts(bool enable) const;
+
+    public:
+      I2CTransactionEngine(TI2C& i2c);
+      I2CTransactionEngine(TI2C& i2c,TDmaWriter& dmaWriter,TDmaReader& dmaReader,uint16_t dmaThreshold=8);
+      ~I2CTransactionEngine();
+  };
+
+
+  /**
+   * Constructor for interrupt-only operation
+   * @param i2c The I2C peripheral
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::I2CTransactionEngine(TI2C& i2c)
+    : _i2c(i2c),
+      _dmaWriter(nullptr),
+      _dmaReader(nullptr),
+      _dmaThreshold(0xffff) {
+
+    initialise();
+  }
+
+
+  /**
+   * Constructor for DMA operation
+   * @param i2c The I2C peripheral
+   * @param dmaWriter The TX DMA channel
+   * @param dmaReader The RX DMA channel, which must have its interrupt feature
+   * @param dmaThreshold Payloads of at least this many bytes use DMA. Reads need at least 2.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::I2CTransactionEngine(TI2C& i2c,TDmaWriter& dmaWriter,TDmaReader& dmaReader,uint16_t dmaThreshold)
+    : _i2c(i2c),
+      _dmaWriter(&dmaWriter),
+      _dmaReader(&dmaReader),
+      _dmaThreshold(dmaThreshold<2 ? 2 : dmaThreshold) {
+
+    _dmaReader->DmaInterruptEventSender.insertSubscriber(
+        DmaInterruptEventSourceSlot::bind(this,&I2CTransactionEngine::onDmaInterrupt)
+      );
+
+    _dmaReader->enableInterrupts(DMA_IT_TC);
+
+    initialise();
+  }
+
+
+  /**
+   * Common initialisation
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::initialise() {
+
+    _state=State::IDLE;
+
+    // the DMA features switch on DMA requests permanently. We want them per phase.
+
+    I2C_DMACmd(_i2c,DISABLE);
+
+    _i2c.I2CInterruptEventSender.insertSubscriber(
+        I2CInterruptEventSourceSlot::bind(this,&I2CTransactionEngine::onInterrupt)
+      );
+
+    // the buffer interrupts are switched on and off as the transaction needs them
+
+    _i2c.enableInterrupts(I2C_IT_EVT | I2C_IT_ERR);
+  }
+
+
+  /**
+   * Destructor
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::~I2CTransactionEngine() {
+
+    _i2c.disableInterrupts(I2C_IT_EVT | I2C_IT_ERR | I2C_IT_BUF);
+
+    _i2c.I2CInterruptEventSender.removeSubscriber(
+        I2CInterruptEventSourceSlot::bind(this,&I2CTransactionEngine::onInterrupt)
+      );
+
+    if(_dmaReader)
+      _dmaReader->DmaInterruptEventSender.removeSubscriber(
+          DmaInterruptEventSourceSlot::bind(this,&I2CTransactionEngine::onDmaInterrupt)
+        );
+  }
+
+
+  /**
+   * Generate the START for the transaction that TransactionQueue has just made current.
+   * Called from the IRQ or with interrupts suspended.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::startTransaction() {
+
+    I2C_TypeDef *peripheral;
+
+    _index=0;
+
+    // a write-only or address-only transaction starts with a write
+
+    _state=this->_current->writeLength || !this->_current->readLength ? State::WRITE_ADDRESS : State::READ_ADDRESS;
+
+    // the STOP from the previous transaction must be on the bus before the next START.
+    // It's cleared by hardware a few microseconds after it's set.
+
+    peripheral=_i2c;
+    while(peripheral->CR1 & I2C_CR1_STOP);
+
+    I2C_AcknowledgeConfig(peripheral,ENABLE);
+    I2C_GenerateSTART(peripheral,ENABLE);
+  }
+
+
+  /**
+   * I2C interrupt handler
+   * @param iet The event type
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onInterrupt(I2CEventType iet) {
+
+    if(this->_current==nullptr)
+      return;
+
+    switch(iet) {
+
+      case I2CEventType::EVENT_ACK_FAILURE:
+      case I2CEventType::EVENT_ARBITRATION_LOSS:
+      case I2CEventType::EVENT_BUS_ERROR:
+      case I2CEventType::EVENT_OVERRUN:
+      case I2CEventType::EVENT_TIMEOUT:
+        onError(iet);
+        break;
+
+      case I2CEventType::EVENT_START_BIT_SENT:
+      case I2CEventType::EVENT_ADDRESS_SENT:
+      case I2CEventType::EVENT_READY_TO_TRANSMIT:
+      case I2CEventType::EVENT_RECEIVE:
+      case I2CEventType::EVENT_BYTE_TRANSFER_SENT:
+        onEvent();
+        break;
+
+      default:
+        break;
+    }
+  }
+
+
+  /**
+   * Event interrupt. The IRQ handler tests TXE and RXNE before BTF, and I2C_GetITStatus()
+   * reports them even when the buffer interrupts are off, so the event it raises can't be
+   * trusted. Work out what happened from SR1 here: BTF must win over TXE and RXNE, and
+   * TXE and RXNE only count when the buffer interrupts are on.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onEvent() {
+
+    I2C_TypeDef *peripheral;
+    uint16_t sr1;
+
+    peripheral=_i2c;
+    sr1=peripheral->SR1;
+
+    if(sr1 & I2C_SR1_SB)
+      onStartBit();
+    else if(sr1 & I2C_SR1_ADDR)
+      onAddress();
+    else if(sr1 & I2C_SR1_BTF)
+      onByteTransferFinished();
+    else if(peripheral->CR2 & I2C_CR2_ITBUFEN) {
+      if(sr1 & I2C_SR1_TXE)
+        onTransmit();
+      else if(sr1 & I2C_SR1_RXNE)
+        onReceive();
+    }
+  }
+
+
+  /**
+   * DMA interrupt handler. A DMA read is over when the last byte has been moved to memory.
+   * The peripheral has already NACKed it because of the LAST bit.
+   * @param det The event type
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onDmaInterrupt(DmaEventType det) {
+
+    I2C_TypeDef *peripheral;
+
+    if(det!=DmaEventType::EVENT_COMPLETE || _state!=State::READING_DMA)
+      return;
+
+    peripheral=_i2c;
+
+    I2C_GenerateSTOP(peripheral,ENABLE);
+    I2C_DMACmd(peripheral,DISABLE);
+    I2C_DMALastTransferCmd(peripheral,DISABLE);
+
+    finish(true);
+  }
+
+
+  /**
+   * SB: send the slave address. Reading SR1 in the IRQ handler and writing DR here clears it.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onStartBit() {
+
+    I2C_TypeDef *peripheral;
+
+    peripheral=_i2c;
+
+    if(_state==State::WRITE_ADDRESS)
+      I2C_Send7bitAddress(peripheral,this->_current->slaveAddress,I2C_Direction_Transmitter);
+    else if(_state==State::READ_ADDRESS)
+      I2C_Send7bitAddress(peripheral,this->_current->slaveAddress,I2C_Direction_Receiver);
+  }
+
+
+  /**
+   * ADDR: the slave acknowledged. The clock is stretched until ADDR is cleared so everything
+   * that must be set up for the first data byte is done here, as the reference manual requires
+   * for 1 and 2 byte receptions.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onAddress() {
+
+    I2C_TypeDef *peripheral;
+    uint16_t length;
+
+    peripheral=_i2c;
+
+    if(_state==State::WRITE_ADDRESS) {
+
+      if((length=this->_current->writeLength)==0) {
+
+        // address only, e.g. ACK polling
+
+        clearAddress();
+        finishWrite();
+      }
+      else if(_dmaWriter && length>=_dmaThreshold) {
+
+        // DMA moves the data. BTF with the DMA counter at zero signals the end.
+
+        _state=State::WRITING_DMA;
+        I2C_DMACmd(peripheral,ENABLE);
+        _dmaWriter->beginWrite(this->_current->writeData,length);
+        clearAddress();
+      }
+      else {
+        _state=State::WRITING;
+        clearAddress();
+        enableBufferInterrupts(true);
+      }
+
+      return;
+    }
+
+    if(_state!=State::READ_ADDRESS)
+      return;
+
+    length=this->_current->readLength;
+
+    if(_dmaReader && length>=_dmaThreshold) {
+
+      // LAST makes the peripheral NACK the final byte that DMA reads
+
+      _state=State::READING_DMA;
+      I2C_DMALastTransferCmd(peripheral,ENABLE);
+      I2C_DMACmd(peripheral,ENABLE);
+      _dmaReader->beginRead(this->_current->readData,length);
+      clearAddress();
+    }
+    else if(length==1) {
+
+      // NACK the only byte and set STOP immediately after clearing ADDR
+
+      _state=State::READING;
+      I2C_AcknowledgeConfig(peripheral,DISABLE);
+
+      {
+        IrqSuspend suspender;
+
+        clearAddress();
+        I2C_GenerateSTOP(peripheral,ENABLE);
+      }
+
+      enableBufferInterrupts(true);
+    }
+    else if(length==2) {
+
+      // NACK the second byte and wait for BTF with both bytes received
+
+      _state=State::READING;
+      I2C_AcknowledgeConfig(peripheral,DISABLE);
+      I2C_NACKPositionConfig(peripheral,I2C_NACKPosition_Next);
+      clearAddress();
+    }
+    else {
+
+      // RXNE until 3 bytes are left, then BTF for the careful part at the end
+
+      _state=State::READING;
+      I2C_AcknowledgeConfig(peripheral,ENABLE);
+      clearAddress();
+
+      if(length>3)
+        enableBufferInterrupts(true);
+    }
+  }
+
+
+  /**
+   * TXE: load the next byte. After the last one wait for BTF.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onTransmit() {
+
+    if(_state!=State::WRITING || _index>=this->_current->writeLength)
+      return;
+
+    I2C_SendData(_i2c,this->_current->writeData[_index++]);
+
+    if(_index==this->_current->writeLength)
+      enableBufferInterrupts(false);
+  }
+
+
+  /**
+   * RXNE: store a byte. When 3 are left switch to BTF so that the NACK and STOP can be
+   * placed correctly.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onReceive() {
+
+    uint16_t remaining;
+
+    if(_state!=State::READING)
+      return;
+
+    this->_current->readData[_index++]=I2C_ReceiveData(_i2c);
+
+    if((remaining=this->_current->readLength-_index)==0)
+      finish(true);
+    else if(remaining==3)
+      enableBufferInterrupts(false);
+  }
+
+
+  /**
+   * BTF: the end of a write phase, or the last few bytes of a read. BTF is also set if we
+   * fall behind mid-transfer, in which case it's handled as TXE or RXNE: accessing DR
+   * clears it.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onByteTransferFinished() {
+
+    I2C_TypeDef *peripheral;
+    uint16_t remaining;
+
+    peripheral=_i2c;
+
+    switch(_state) {
+
+      case State::WRITING_DMA:
+
+        // BTF can be seen mid-transfer if the DMA is held up by a higher priority stream
+
+        if(DMA_GetCurrDataCounter(*_dmaWriter)!=0)
+          break;
+
+        I2C_DMACmd(peripheral,DISABLE);
+        finishWrite();
+        break;
+
+      case State::WRITING:
+
+        if(_index<this->_current->writeLength)
+          onTransmit();
+        else
+          finishWrite();
+        break;
+
+      case State::READING:
+
+        remaining=this->_current->readLength-_index;
+
+        if(remaining>3)
+          onReceive();
+        else if(remaining==3) {
+
+          // N-2 in DR, N-1 in the shift register
+
+          I2C_AcknowledgeConfig(peripheral,DISABLE);
+          this->_current->readData[_index++]=I2C_ReceiveData(peripheral);
+        }
+        else if(remaining==2) {
+
+          // N-1 in DR, N in the shift register and already NACKed
+
+          I2C_GenerateSTOP(peripheral,ENABLE);
+          this->_current->readData[_index++]=I2C_ReceiveData(peripheral);
+          enableBufferInterrupts(true);
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+
+  /**
+   * Error interrupt. The failed transaction is finished and the next one started.
+   * @param iet The error
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::onError(I2CEventType iet) {
+
+    I2C_TypeDef *peripheral;
+
+    peripheral=_i2c;
+
+    // after arbitration loss the peripheral is already a slave and must not send STOP
+
+    if(iet!=I2CEventType::EVENT_ARBITRATION_LOSS)
+      I2C_GenerateSTOP(peripheral,ENABLE);
+
+    if(_state==State::WRITING_DMA || _state==State::READING_DMA) {
+
+      I2C_DMACmd(peripheral,DISABLE);
+      I2C_DMALastTransferCmd(peripheral,DISABLE);
+
+      if(_state==State::WRITING_DMA)
+        DMA_Cmd(*_dmaWriter,DISABLE);
+      else
+        DMA_Cmd(*_dmaReader,DISABLE);
+    }
+
+    this->_current->failure=iet;
+    finish(false);
+  }
+
+
+  /**
+   * The write phase is over. Either restart for the read phase or stop.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::finishWrite() {
+
+    if(this->_current->readLength) {
+      _state=State::READ_ADDRESS;
+      _index=0;
+      I2C_GenerateSTART(_i2c,ENABLE);
+    }
+    else {
+      I2C_GenerateSTOP(_i2c,ENABLE);
+      finish(true);
+    }
+  }
+
+
+  /**
+   * Return the peripheral to idle and finish the current transaction
+   * @param success true if it worked
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::finish(bool success) {
+
+    enableBufferInterrupts(false);
+    I2C_NACKPositionConfig(_i2c,I2C_NACKPosition_Current);
+
+    _state=State::IDLE;
+    this->completeTransaction(success);
+  }
+
+
+  /**
+   * Tell the subscribers that a transaction has finished
+   * @param transaction The finished transaction
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::raiseTransactionEvent(I2CTransaction& transaction) {
+    I2CTransactionEventSender.raiseEvent(transaction);
+  }
+
+
+  /**
+   * Clear ADDR by reading SR1 then SR2. The IRQ handler has already read SR1.
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::clearAddress() const {
+    I2C_GetLastEvent(_i2c);
+  }
+
+
+  /**
+   * Switch the TXE/RXNE interrupts on or off
+   */
+
+  template<class TI2C,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void I2CTransactionEngine<TI2C,TDmaWriter,TDmaReader,TQueueSize>::enableBufferInterrupts(bool enable) const {
+    I2C_ITConfig(_i2c,I2C_IT_BUF,enable ? ENABLE : DISABLE);
+  }
+}
@@ -46,7 +46,9 @@ namespace stm32plus {
       };
 
       enum {
-        E_I2C_TIMEOUT=1         ///< timed out waiting for a response
+        E_I2C_TIMEOUT=1,        ///< timed out waiting for a response
+        E_QUEUE_FULL,           ///< the transaction engine queue is full
+        E_TRANSACTION_FAILED    ///< a transaction failed, the cause is the I2CEventType
       };
 
     protected:
@@ -0,0 +1,192 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * A pool of equal sized blocks carved out of caller supplied storage. Free blocks are
+   * linked through their first word so allocate() and free() are a couple of loads and
+   * stores and the pool can never fragment.
+   */
+
+  class FixedBlockPool {
+
+    public:
+
+      /**
+       * Statistics maintained as the pool is used
+       */
+
+      struct Statistics {
+        uint16_t blockSize;                 ///< size of each block in bytes
+        uint16_t blockCount;                ///< number of blocks in the pool
+        uint16_t blocksUsed;                ///< blocks currently allocated
+        uint16_t peakBlocksUsed;            ///< high water mark of blocksUsed
+        uint32_t allocations;               ///< total successful allocations
+        uint32_t failures;                  ///< allocations refused because the pool was empty
+      };
+
+    protected:
+      uint8_t *_start;
+      uint8_t *_end;
+      void *_freeList;
+      Statistics _statistics;
+
+    public:
+      FixedBlockPool();
+
+      static uint16_t roundBlockSize(uint16_t blockSize);
+      static uint32_t storageSize(uint16_t blockSize,uint16_t blockCount);
+
+      void initialise(void *storage,uint16_t blockSize,uint16_t blockCount);
+
+      void *allocate();
+      void free(void *ptr);
+
+      bool contains(const void *ptr) const;
+      uint16_t getBlockSize() const;
+      const Statistics& getStatistics() const;
+  };
+
+
+  /**
+   * Constructor. The pool is empty until initialise() is called.
+   */
+
+  inline FixedBlockPool::FixedBlockPool()
+    : _start(nullptr),
+      _end(nullptr),
+      _freeList(nullptr) {
+
+    memset(&_statistics,0,sizeof(_statistics));
+  }
+
+
+  /**
+   * Round a block size up to a multiple of 8 so that every block is suitably aligned for
+   * any type, and so that there is room for the free list link.
+   */
+
+  inline uint16_t FixedBlockPool::roundBlockSize(uint16_t blockSize) {
+
+    if(blockSize<sizeof(void *))
+      blockSize=sizeof(void *);
+
+    return (blockSize+7) & ~7;
+  }
+
+
+  /**
+   * Get the number of bytes of storage needed for a pool
+   */
+
+  inline uint32_t FixedBlockPool::storageSize(uint16_t blockSize,uint16_t blockCount) {
+    return static_cast<uint32_t>(roundBlockSize(blockSize))*blockCount;
+  }
+
+
+  /**
+   * Build the free list. The storage must be 8 byte aligned and at least storageSize() bytes.
+   * @param storage The memory for the blocks
+   * @param blockSize The size of each block, rounded up by roundBlockSize()
+   * @param blockCount The number of blocks
+   */
+
+  inline void FixedBlockPool::initialise(void *storage,uint16_t blockSize,uint16_t blockCount) {
+
+    uint8_t *ptr;
+
+    blockSize=roundBlockSize(blockSize);
+
+    memset(&_statistics,0,sizeof(_statistics));
+    _statistics.blockSize=blockSize;
+    _statistics.blockCount=blockCount;
+
+    _start=reinterpret_cast<uint8_t *>(storage);
+    _end=_start+static_cast<uint32_t>(blockSize)*blockCount;
+    _freeList=nullptr;
+
+    // link backwards so that the first allocation gets the lowest address
+
+    for(ptr=_end;ptr!=_start;) {
+      ptr-=blockSize;
+      *reinterpret_cast<void **>(ptr)=_freeList;
+      _freeList=ptr;
+    }
+  }
+
+
+  /**
+   * Allocate a block
+   * @return The block or nullptr if the pool is empty
+   */
+
+  inline void *FixedBlockPool::allocate() {
+
+    void *block;
+
+    if((block=_freeList)==nullptr) {
+      _statistics.failures++;
+      return nullptr;
+    }
+
+    _freeList=*reinterpret_cast<void **>(block);
+
+    _statistics.allocations++;
+    if(++_statistics.blocksUsed>_statistics.peakBlocksUsed)
+      _statistics.peakBlocksUsed=_statistics.blocksUsed;
+
+    return block;
+  }
+
+
+  /**
+   * Return a block to the pool
+   * @param ptr A block returned by allocate()
+   */
+
+  inline void FixedBlockPool::free(void *ptr) {
+
+    *reinterpret_cast<void **>(ptr)=_freeList;
+    _freeList=ptr;
+
+    _statistics.blocksUsed--;
+  }
+
+
+  /**
+   * Check if a pointer belongs to this pool
+   */
+
+  inline bool FixedBlockPool::contains(const void *ptr) const {
+
+    const uint8_t *p;
+
+    p=reinterpret_cast<const uint8_t *>(ptr);
+    return p>=_start && p<_end;
+  }
+
+
+  /**
+   * Get the (rounded) block size
+   */
+
+  inline uint16_t FixedBlockPool::getBlockSize() const {
+    return _statistics.blockSize;
+  }
+
+
+  /**
+   * Get the statistics
+   */
+
+  inline const FixedBlockPool::Statistics& FixedBlockPool::getStatistics() const {
+    return _statistics;
+  }
+}
@@ -0,0 +1,280 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Lock-free multiple producer, single consumer queue. Any number of IRQ handlers at any
+   * priorities, and normal code, can write. One context reads. Producers never wait for
+   * each other, so a high priority IRQ that preempts a lower priority producer part way
+   * through a write doesn't spin.
+   *
+   * A producer reserves space and registers itself as an active writer with a single
+   * compare-and-swap on a word that holds the reserve index in the top 24 bits and the active
+   * writer count in the bottom 8. It copies its data in and then decrements the count. The
+   * producer that takes the count to zero publishes everything reserved up to that
+   * moment, because all of it has been written. Writes are all or nothing.
+   *
+   * The compare-and-swap is LDREX/STREX from concurrent/atomic.h. The F0 doesn't have those
+   * so it's done with interrupts suspended there.
+   *
+   * Indexes run freely and wrap at 2^24, so the size limit is 2^23 elements. T must be a
+   * type that can be copied with memcpy.
+   */
+
+  template<typename T>
+  class MpscRingQueue : public RingQueueBase<T> {
+
+    public:
+      enum {
+        WRITER_BITS = 8,
+        WRITER_MASK = (1 << WRITER_BITS)-1,
+        INDEX_MASK = 0xffffff,
+        MAX_SIZE = 1UL << 23
+      };
+
+    protected:
+      volatile uint32_t _reservation;     // reserve index << 8 | active writers
+      volatile uint32_t _writeIndex;      // published to the consumer
+      volatile uint32_t _readIndex;
+
+    protected:
+      void publish(uint32_t index);
+      static bool compareAndSwap(volatile uint32_t *ptr,uint32_t oldval,uint32_t newval);
+
+    public:
+      MpscRingQueue(uint32_t size);
+      MpscRingQueue(T *storage,uint32_t storageSize);
+
+      bool write(const T *input,uint32_t count);
+      bool write(const T& input);
+
+      uint32_t read(T *output,uint32_t count);
+      bool read(T& output);
+
+      uint32_t acquireRead(const T*& span);
+      void commitRead(uint32_t count);
+
+      uint32_t availableToRead() const;
+  };
+
+
+  /**
+   * Constructor. The storage is allocated on the heap.
+   * @param size The maximum number of elements, up to MAX_SIZE. The storage is rounded up to
+   *   a power of two.
+   */
+
+  template<typename T>
+  inline MpscRingQueue<T>::MpscRingQueue(uint32_t size)
+    : RingQueueBase<T>(size),
+      _reservation(0),
+      _writeIndex(0),
+      _readIndex(0) {
+  }
+
+
+  /**
+   * Constructor. The caller supplies the storage.
+   * @param storage Where to keep the elements
+   * @param storageSize The number of elements in storage. A power of two up to MAX_SIZE.
+   */
+
+  template<typename T>
+  inline MpscRingQueue<T>::MpscRingQueue(T *storage,uint32_t storageSize)
+    : RingQueueBase<T>(storage,storageSize),
+      _reservation(0),
+      _writeIndex(0),
+      _readIndex(0) {
+  }
+
+
+  /**
+   * Get the number of elements that can be read
+   */
+
+  template<typename T>
+  inline uint32_t MpscRingQueue<T>::availableToRead() const {
+    return (_writeIndex-_readIndex) & INDEX_MASK;
+  }
+
+
+  /**
+   * Write elements. Safe to call from any context.
+   * @param input The elements
+   * @param count How many to write
+   * @return false if there isn't room for all of them, in which case nothing is written
+   */
+
+  template<typename T>
+  inline bool MpscRingQueue<T>::write(const T *input,uint32_t count) {
+
+    uint32_t reservation,start;
+
+    // reserve the space and count ourselves in
+
+    do {
+      reservation=_reservation;
+      start=reservation >> WRITER_BITS;
+
+      if(((start-_readIndex) & INDEX_MASK)+count>this->_size || (reservation & WRITER_MASK)==WRITER_MASK)
+        return false;
+
+    } while(!compareAndSwap(&_reservation,reservation,reservation+(count << WRITER_BITS)+1));
+
+    __DMB();
+
+    this->copyIn(start,input,count);
+
+    __DMB();
+
+    // count ourselves out. The last writer out publishes.
+
+    do {
+      reservation=_reservation;
+    } while(!compareAndSwap(&_reservation,reservation,reservation-1));
+
+    if(((reservation-1) & WRITER_MASK)==0)
+      publish(reservation >> WRITER_BITS);
+
+    return true;
+  }
+
+
+  /**
+   * Write one element. Safe to call from any context.
+   * @param input The element
+   * @return false if the queue is full
+   */
+
+  template<typename T>
+  inline bool MpscRingQueue<T>::write(const T& input) {
+    return write(&input,1);
+  }
+
+
+  /**
+   * Move the consumer's write index forward to index. A writer that was preempted before
+   * it could publish an older index mustn't move it back.
+   */
+
+  template<typename T>
+  inline void MpscRingQueue<T>::publish(uint32_t index) {
+
+    uint32_t current;
+
+    do {
+      current=_writeIndex;
+
+      if(((index-current) & INDEX_MASK)>MAX_SIZE)
+        return;
+
+    } while(!compareAndSwap(&_writeIndex,current,index));
+  }
+
+
+  /**
+   * Read up to a number of elements. Consumer only.
+   * @param output Where to put them
+   * @param count The most to read
+   * @return How many were read
+   */
+
+  template<typename T>
+  inline uint32_t MpscRingQueue<T>::read(T *output,uint32_t count) {
+
+    uint32_t available;
+
+    if(count>(available=availableToRead()))
+      count=available;
+
+    __DMB();
+
+    this->copyOut(_readIndex,output,count);
+    commitRead(count);
+
+    return count;
+  }
+
+
+  /**
+   * Read one element. Consumer only.
+   * @param output Where to put it
+   * @return false if the queue is empty
+   */
+
+  template<typename T>
+  inline bool MpscRingQueue<T>::read(T& output) {
+
+    if(availableToRead()==0)
+      return false;
+
+    __DMB();
+
+    output=this->_buffer[_readIndex & this->_mask];
+    commitRead(1);
+
+    return true;
+  }
+
+
+  /**
+   * Get the contiguous data at the read position. Consumer only.
+   * @param[out] span The start of the data
+   * @return The number of elements that can be read there. Zero if the queue is empty.
+   */
+
+  template<typename T>
+  inline uint32_t MpscRingQueue<T>::acquireRead(const T*& span) {
+
+    uint32_t count;
+
+    count=this->contiguous(_readIndex,availableToRead());
+    span=&this->_buffer[_readIndex & this->_mask];
+
+    __DMB();
+    return count;
+  }
+
+
+  /**
+   * Release elements consumed from a span from acquireRead() or by read(). Consumer only.
+   * @param count The number consumed
+   */
+
+  template<typename T>
+  inline void MpscRingQueue<T>::commitRead(uint32_t count) {
+    __DMB();
+    _readIndex=(_readIndex+count) & INDEX_MASK;
+  }
+
+
+  /**
+   * Atomically replace oldval with newval
+   * @return false if the value wasn't oldval or the exclusive store was interrupted
+   */
+
+  template<typename T>
+  inline bool MpscRingQueue<T>::compareAndSwap(volatile uint32_t *ptr,uint32_t oldval,uint32_t newval) {
+
+#if defined(STM32PLUS_F0)
+
+    IrqSuspend suspender;
+
+    if(*ptr!=oldval)
+      return false;
+
+    *ptr=newval;
+    return true;
+
+#else
+    return sync_bool_compare_and_swap(ptr,oldval,newval);
+#endif
+  }
+}
@@ -0,0 +1,305 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Deterministic heap made from a set of size-class pools for small objects backed by a
+   * TLSF heap for everything else. The pools and the TLSF heap share a single arena: the
+   * pools are carved from the start and the TLSF heap gets what's left.
+   *
+   * A request is served from the smallest pool whose blocks are big enough. If that pool
+   * is empty the request overflows into the TLSF heap, which is counted in the statistics
+   * so you can see which pool needs more blocks. Requests bigger than the largest pool go
+   * straight to the TLSF heap. free() tells the two apart by address.
+   *
+   * Example:
+   *   static const PoolHeap::Definition pools[]={ { 16,64 },{ 32,32 },{ 64,16 } };
+   *   static uint64_t arena[2048];
+   *
+   *   PoolHeap heap;
+   *   heap.initialise(arena,sizeof(arena),pools,sizeof(pools)/sizeof(pools[0]));
+   *
+   * When the library is built with STM32PLUS_ALLOCATOR_POOL (scons allocator=pool) a global
+   * PoolHeap returned by getPoolHeap() serves operator new/delete and the bundled STL. See
+   * lib/src/memory/PoolHeap.cpp.
+   */
+
+  class PoolHeap {
+
+    public:
+      enum {
+        MAX_POOLS = 8,                      ///< maximum number of size-class pools
+        MAX_POOL_BLOCK_SIZE = 256           ///< largest block size that a pool can have
+      };
+
+      /**
+       * Definition of one size class
+       */
+
+      struct Definition {
+        uint16_t blockSize;
+        uint16_t blockCount;
+      };
+
+    protected:
+      FixedBlockPool _pools[MAX_POOLS];
+      uint32_t _overflows[MAX_POOLS];
+      uint8_t _sizeClasses[MAX_POOL_BLOCK_SIZE/8+1];
+      uint8_t _poolCount;
+      uint8_t *_poolStart;
+      uint8_t *_poolEnd;
+      TlsfHeap _tlsf;
+
+    protected:
+      FixedBlockPool *findPool(const void *ptr);
+
+    public:
+      PoolHeap();
+
+      bool initialise(void *arena,uint32_t size,const Definition *pools,uint8_t poolCount);
+
+      void *allocate(uint32_t size);
+      void *reallocate(void *ptr,uint32_t size);
+      void free(void *ptr);
+
+      uint32_t usableSize(const void *ptr) const;
+
+      uint8_t getPoolCount() const;
+      const FixedBlockPool& getPool(uint8_t index) const;
+      uint32_t getPoolOverflows(uint8_t index) const;
+      const TlsfHeap& getTlsfHeap() const;
+  };
+
+
+#if defined(STM32PLUS_ALLOCATOR_POOL)
+
+  /*
+   * The global heap and the hook that sets it up, both in lib/src/memory/PoolHeap.cpp.
+   * configurePoolHeap() is weak: provide your own to choose the arena and the pools.
+   */
+
+  PoolHeap& getPoolHeap();
+  void configurePoolHeap(PoolHeap& heap);
+
+#endif
+
+
+  /**
+   * Constructor. The heap is unusable until initialise() is called.
+   */
+
+  inline PoolHeap::PoolHeap()
+    : _poolCount(0),
+      _poolStart(nullptr),
+      _poolEnd(nullptr) {
+
+    memset(_overflows,0,sizeof(_overflows));
+    memset(_sizeClasses,0xff,sizeof(_sizeClasses));
+  }
+
+
+  /**
+   * Build the heap
+   * @param arena The memory to use, ideally 8 byte aligned
+   * @param size The size of the memory in bytes
+   * @param pools The size classes. Block sizes are rounded up to a multiple of 8 and must not
+   *   exceed MAX_POOL_BLOCK_SIZE. The order doesn't matter.
+   * @param poolCount The number of entries in pools, up to MAX_POOLS. Zero gives a pure TLSF heap.
+   * @return false if the definitions are invalid or do not leave room for the TLSF heap
+   */
+
+  inline bool PoolHeap::initialise(void *arena,uint32_t size,const Definition *pools,uint8_t poolCount) {
+
+    uint8_t *ptr,*end;
+    uint16_t blockSize;
+    uint8_t i,j;
+
+    if(poolCount>MAX_POOLS)
+      return false;
+
+    ptr=reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(arena)+7) & ~static_cast<uintptr_t>(7));
+    end=reinterpret_cast<uint8_t *>(arena)+size;
+
+    _poolStart=ptr;
+    _poolCount=poolCount;
+
+    memset(_overflows,0,sizeof(_overflows));
+    memset(_sizeClasses,0xff,sizeof(_sizeClasses));
+
+    for(i=0;i<poolCount;i++) {
+
+      blockSize=FixedBlockPool::roundBlockSize(pools[i].blockSize);
+
+      if(blockSize>MAX_POOL_BLOCK_SIZE || FixedBlockPool::storageSize(blockSize,pools[i].blockCount)>static_cast<uint32_t>(end-ptr))
+        return false;
+
+      _pools[i].initialise(ptr,blockSize,pools[i].blockCount);
+      ptr+=FixedBlockPool::storageSize(blockSize,pools[i].blockCount);
+
+      // this pool serves every size class it fits better than the pools seen so far
+
+      for(j=1;j<=blockSize/8;j++)
+        if(_sizeClasses[j]==0xff || _pools[_sizeClasses[j]].getBlockSize()>blockSize)
+          _sizeClasses[j]=i;
+    }
+
+    // a zero byte request is served like a one byte request
+
+    _sizeClasses[0]=_sizeClasses[1];
+    _poolEnd=ptr;
+
+    return _tlsf.initialise(ptr,end-ptr);
+  }
+
+
+  /**
+   * Allocate memory
+   * @param size The number of bytes required
+   * @return The 8 byte aligned memory or nullptr if there is none
+   */
+
+  inline void *PoolHeap::allocate(uint32_t size) {
+
+    uint8_t index;
+    void *ptr;
+
+    if(size<=MAX_POOL_BLOCK_SIZE && (index=_sizeClasses[(size+7)/8])!=0xff) {
+
+      if((ptr=_pools[index].allocate())!=nullptr)
+        return ptr;
+
+      _overflows[index]++;
+    }
+
+    return _tlsf.allocate(size);
+  }
+
+
+  /**
+   * Free memory
+   * @param ptr Memory returned by allocate() or reallocate(). nullptr is ignored.
+   */
+
+  inline void PoolHeap::free(void *ptr) {
+
+    FixedBlockPool *pool;
+
+    if(!ptr)
+      return;
+
+    if((pool=findPool(ptr))!=nullptr)
+      pool->free(ptr);
+    else
+      _tlsf.free(ptr);
+  }
+
+
+  /**
+   * Resize an allocation
+   * @param ptr The existing memory, or nullptr to allocate
+   * @param size The new size in bytes
+   * @return The new memory or nullptr, in which case the original is untouched
+   */
+
+  inline void *PoolHeap::reallocate(void *ptr,uint32_t size) {
+
+    FixedBlockPool *pool;
+    void *newptr;
+
+    if(!ptr)
+      return allocate(size);
+
+    if((pool=findPool(ptr))==nullptr)
+      return _tlsf.reallocate(ptr,size);
+
+    if(size<=pool->getBlockSize())
+      return ptr;
+
+    if((newptr=allocate(size))==nullptr)
+      return nullptr;
+
+    memcpy(newptr,ptr,pool->getBlockSize());
+    pool->free(ptr);
+
+    return newptr;
+  }
+
+
+  /**
+   * Find the pool that owns a pointer. The pools are contiguous so a single range check
+   * rejects TLSF pointers.
+   * @return The pool or nullptr if it's a TLSF allocation
+   */
+
+  inline FixedBlockPool *PoolHeap::findPool(const void *ptr) {
+
+    const uint8_t *p;
+
+    p=reinterpret_cast<const uint8_t *>(ptr);
+
+    if(p>=_poolStart && p<_poolEnd)
+      for(uint8_t i=0;i<_poolCount;i++)
+        if(_pools[i].contains(ptr))
+          return &_pools[i];
+
+    return nullptr;
+  }
+
+
+  /**
+   * Get the number of bytes that can actually be used in an allocation
+   */
+
+  inline uint32_t PoolHeap::usableSize(const void *ptr) const {
+
+    FixedBlockPool *pool;
+
+    if((pool=const_cast<PoolHeap *>(this)->findPool(ptr))!=nullptr)
+      return pool->getBlockSize();
+
+    return _tlsf.usableSize(ptr);
+  }
+
+
+  /**
+   * Get the number of pools
+   */
+
+  inline uint8_t PoolHeap::getPoolCount() const {
+    return _poolCount;
+  }
+
+
+  /**
+   * Get a pool, for its statistics
+   */
+
+  inline const FixedBlockPool& PoolHeap::getPool(uint8_t index) const {
+    return _pools[index];
+  }
+
+
+  /**
+   * Get the number of requests that overflowed into the TLSF heap because a pool was empty
+   */
+
+  inline uint32_t PoolHeap::getPoolOverflows(uint8_t index) const {
+    return _overflows[index];
+  }
+
+
+  /**
+   * Get the TLSF heap, for its statistics
+   */
+
+  inline const TlsfHeap& PoolHeap::getTlsfHeap() const {
+    return _tlsf;
+  }
+}
@@ -0,0 +1,150 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Storage shared by the SpscRingQueue and MpscRingQueue classes. The storage is a power of
+   * two elements long so that an index is wrapped with a mask. The usable size can be
+   * smaller than the storage, which lets a caller keep the exact size it asked for.
+   *
+   * Elements are moved with memcpy so T must be a type that can be copied that way.
+   */
+
+  template<typename T>
+  class RingQueueBase {
+
+    protected:
+      T *_buffer;
+      uint32_t _mask;                   // storage size - 1
+      uint32_t _size;                   // maximum number of elements held
+      bool _ownsBuffer;
+
+    protected:
+      RingQueueBase(uint32_t size);
+      RingQueueBase(T *storage,uint32_t storageSize);
+      ~RingQueueBase();
+
+      void copyIn(uint32_t index,const T *input,uint32_t count);
+      void copyOut(uint32_t index,T *output,uint32_t count) const;
+      uint32_t contiguous(uint32_t index,uint32_t count) const;
+
+    public:
+      static uint32_t roundUpPowerOf2(uint32_t value);
+
+      /**
+       * @return the maximum number of elements held
+       */
+
+      uint32_t getSize() const {
+        return _size;
+      }
+  };
+
+
+  /**
+   * Constructor. The storage is allocated on the heap.
+   * @param size The maximum number of elements. The storage is rounded up to a power of two.
+   */
+
+  template<typename T>
+  inline RingQueueBase<T>::RingQueueBase(uint32_t size)
+    : _mask(roundUpPowerOf2(size)-1),
+      _size(size),
+      _ownsBuffer(true) {
+
+    _buffer=new T[_mask+1];
+  }
+
+
+  /**
+   * Constructor. The caller supplies the storage.
+   * @param storage Where to keep the elements
+   * @param storageSize The number of elements in storage. Must be a power of two.
+   */
+
+  template<typename T>
+  inline RingQueueBase<T>::RingQueueBase(T *storage,uint32_t storageSize)
+    : _buffer(storage),
+      _mask(storageSize-1),
+      _size(storageSize),
+      _ownsBuffer(false) {
+  }
+
+
+  /**
+   * Destructor
+   */
+
+  template<typename T>
+  inline RingQueueBase<T>::~RingQueueBase() {
+    if(_ownsBuffer)
+      delete[] _buffer;
+  }
+
+
+  /**
+   * Copy elements into the storage starting at a free running index, in at most two pieces
+   */
+
+  template<typename T>
+  inline void RingQueueBase<T>::copyIn(uint32_t index,const T *input,uint32_t count) {
+
+    uint32_t first;
+
+    first=contiguous(index,count);
+    memcpy(&_buffer[index & _mask],input,first*sizeof(T));
+
+    if(count>first)
+      memcpy(_buffer,input+first,(count-first)*sizeof(T));
+  }
+
+
+  /**
+   * Copy elements out of the storage starting at a free running index, in at most two pieces
+   */
+
+  template<typename T>
+  inline void RingQueueBase<T>::copyOut(uint32_t index,T *output,uint32_t count) const {
+
+    uint32_t first;
+
+    first=contiguous(index,count);
+    memcpy(output,&_buffer[index & _mask],first*sizeof(T));
+
+    if(count>first)
+      memcpy(output+first,_buffer,(count-first)*sizeof(T));
+  }
+
+
+  /**
+   * How many of count elements starting at index are before the end of the storage
+   */
+
+  template<typename T>
+  inline uint32_t RingQueueBase<T>::contiguous(uint32_t index,uint32_t count) const {
+
+    uint32_t toEnd;
+
+    toEnd=_mask+1-(index & _mask);
+    return count<toEnd ? count : toEnd;
+  }
+
+
+  /**
+   * Round a value up to the next power of two
+   * @param value The value, at least 1
+   * @return The power of two
+   */
+
+  template<typename T>
+  inline uint32_t RingQueueBase<T>::roundUpPowerOf2(uint32_t value) {
+    return value<=1 ? 1 : 1UL << (32-__builtin_clz(value-1));
+  }
+}
@@ -0,0 +1,280 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Lock-free single producer, single consumer queue. The producer and consumer can each be
+   * an IRQ handler or normal code, in either direction, and neither needs to suspend
+   * interrupts. The read and write indexes run freely and wrap at 2^32. The element count
+   * is their difference, so the whole size is usable.
+   *
+   * Bulk read() and write() copy with at most two memcpy calls. For zero copy, ask for a
+   * contiguous span, fill or drain it directly (for example with DMA) and then commit it:
+   *
+   *   uint8_t *span;
+   *   uint32_t count;
+   *
+   *   if((count=queue.acquireWrite(span))!=0) {
+   *     count=fillFromSomewhere(span,count);
+   *     queue.commitWrite(count);
+   *   }
+   *
+   * Only the producer may call the write methods and only the consumer may call the read
+   * methods. T must be a type that can be copied with memcpy.
+   */
+
+  template<typename T>
+  class SpscRingQueue : public RingQueueBase<T> {
+
+    protected:
+      volatile uint32_t _writeIndex;
+      volatile uint32_t _readIndex;
+
+    public:
+      SpscRingQueue(uint32_t size);
+      SpscRingQueue(T *storage,uint32_t storageSize);
+
+      uint32_t write(const T *input,uint32_t count);
+      bool write(const T& input);
+
+      uint32_t read(T *output,uint32_t count);
+      bool read(T& output);
+      uint32_t skip(uint32_t count);
+
+      uint32_t acquireWrite(T*& span);
+      void commitWrite(uint32_t count);
+
+      uint32_t acquireRead(const T*& span);
+      void commitRead(uint32_t count);
+
+      uint32_t availableToWrite() const;
+      uint32_t availableToRead() const;
+  };
+
+
+  /**
+   * Constructor. The storage is allocated on the heap.
+   * @param size The maximum number of elements. The storage is rounded up to a power of two.
+   */
+
+  template<typename T>
+  inline SpscRingQueue<T>::SpscRingQueue(uint32_t size)
+    : RingQueueBase<T>(size),
+      _writeIndex(0),
+      _readIndex(0) {
+  }
+
+
+  /**
+   * Constructor. The caller supplies the storage.
+   * @param storage Where to keep the elements
+   * @param storageSize The number of elements in storage. Must be a power of two.
+   */
+
+  template<typename T>
+  inline SpscRingQueue<T>::SpscRingQueue(T *storage,uint32_t storageSize)
+    : RingQueueBase<T>(storage,storageSize),
+      _writeIndex(0),
+      _readIndex(0) {
+  }
+
+
+  /**
+   * Get the number of elements that can be written. Exact for the producer, a lower bound
+   * for anyone else.
+   */
+
+  template<typename T>
+  inline uint32_t SpscRingQueue<T>::availableToWrite() const {
+    return this->_size-(_writeIndex-_readIndex);
+  }
+
+
+  /**
+   * Get the number of elements that can be read. Exact for the consumer, a lower bound for
+   * anyone else.
+   */
+
+  template<typename T>
+  inline uint32_t SpscRingQueue<T>::availableToRead() const {
+    return _writeIndex-_readIndex;
+  }
+
+
+  /**
+   * Write as many elements as there is room for
+   * @param input The elements
+   * @param count How many to write
+   * @return How many were written
+   */
+
+  template<typename T>
+  inline uint32_t SpscRingQueue<T>::write(const T *input,uint32_t count) {
+
+    uint32_t available;
+
+    if(count>(available=availableToWrite()))
+      count=available;
+
+    __DMB();      // the consumer has finished with the space before we overwrite it
+
+    this->copyIn(_writeIndex,input,count);
+    commitWrite(count);
+
+    return count;
+  }
+
+
+  /**
+   * Write one element
+   * @param input The element
+   * @return false if the queue is full
+   */
+
+  template<typename T>
+  inline bool SpscRingQueue<T>::write(const T& input) {
+
+    if(availableToWrite()==0)
+      return false;
+
+    __DMB();
+
+    this->_buffer[_writeIndex & this->_mask]=input;
+    commitWrite(1);
+
+    return true;
+  }
+
+
+  /**
+   * Read up to a number of elements
+   * @param output Where to put them
+   * @param count The most to read
+   * @return How many were read
+   */
+
+  template<typename T>
+  inline uint32_t SpscRingQueue<T>::read(T *output,uint32_t count) {
+
+    uint32_t available;
+
+    if(count>(available=availableToRead()))
+      count=available;
+
+    __DMB();      // see the producer's data, not what was there before
+
+    this->copyOut(_readIndex,output,count);
+    commitRead(count);
+
+    return count;
+  }
+
+
+  /**
+   * Read one element
+   * @param output Where to put it
+   * @return false if the queue is empty
+   */
+
+  template<typename T>
+  inline bool SpscRingQueue<T>::read(T& output) {
+
+    if(availableToRead()==0)
+      return false;
+
+    __DMB();
+
+    output=this->_buffer[_readIndex & this->_mask];
+    commitRead(1);
+
+    return true;
+  }
+
+
+  /**
+   * Discard up to a number of elements
+   * @param count The most to discard
+   * @return How many were discarded
+   */
+
+  template<typename T>
+  inline uint32_t SpscRingQueue<T>::skip(uint32_t count) {
+
+    uint32_t available;
+
+    if(count>(available=availableToRead()))
+      count=available;
+
+    commitRead(count);
+    return count;
+  }
+
+
+  /**
+   * Get the contiguous free space at the write position
+   * @param[out] span The start of the space
+   * @return The number of elements that can be written there. Zero if the queue is full.
+   */
+
+  template<typename T>
+  inline uint32_t SpscRingQueue<T>::acquireWrite(T*& span) {
+
+    uint32_t count;
+
+    count=this->contiguous(_writeIndex,availableToWrite());
+    span=&this->_buffer[_writeIndex & this->_mask];
+
+    __DMB();
+    return count;
+  }
+
+
+  /**
+   * Publish elements written into a span from acquireWrite() or by write()
+   * @param count The number written, no more than acquireWrite() returned
+   */
+
+  template<typename T>
+  inline void SpscRingQueue<T>::commitWrite(uint32_t count) {
+    __DMB();      // the data is visible before the index that publishes it
+    _writeIndex=_writeIndex+count;
+  }
+
+
+  /**
+   * Get the contiguous data at the read position
+   * @param[out] span The start of the data
+   * @return The number of elements that can be read there. Zero if the queue is empty.
+   */
+
+  template<typename T>
+  inline uint32_t SpscRingQueue<T>::acquireRead(const T*& span) {
+
+    uint32_t count;
+
+    count=this->contiguous(_readIndex,availableToRead());
+    span=&this->_buffer[_readIndex & this->_mask];
+
+    __DMB();
+    return count;
+  }
+
+
+  /**
+   * Release elements consumed from a span from acquireRead() or by read()
+   * @param count The number consumed, no more than acquireRead() returned
+   */
+
+  template<typename T>
+  inline void SpscRingQueue<T>::commitRead(uint32_t count) {
+    __DMB();      // finished reading the data before the producer can reuse the space
+    _readIndex=_readIndex+count;
+  }
+}
@@ -0,0 +1,609 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Two Level Segregated Fit heap. allocate() and free() run in bounded time regardless of
+   * the heap state: free blocks are kept in a two dimensional array of lists indexed by the
+   * most significant bit of the size (first level) and the next SL_LOG2 bits (second level).
+   * A bitmap per level lets a suitable list be found with a pair of count-leading-zeros
+   * instructions, and neighbouring free blocks are merged immediately on free so the heap
+   * does not silently fragment into unusable slivers over a long uptime.
+   *
+   * Every block carries a header with a pointer to its physical predecessor and its payload
+   * size. The low bit of the size marks a free block. Free blocks additionally keep their
+   * list links in the first words of the payload. The arena is terminated by a zero length
+   * sentinel block that is never free.
+   *
+   * The heap is not interrupt safe. Don't allocate or free from an IRQ handler.
+   */
+
+  class TlsfHeap {
+
+    public:
+      enum {
+        ALIGN_LOG2 = 3,                                   ///< 8 byte payload alignment (AAPCS)
+        ALIGN = 1 << ALIGN_LOG2,
+        SL_LOG2 = 3,                                      ///< 8 second level lists per first level
+        SL_COUNT = 1 << SL_LOG2,
+        FL_SHIFT = SL_LOG2+ALIGN_LOG2,
+        FL_INDEX_MAX = 22,                                ///< largest allocation is under 4Mb, largest arena under 8Mb
+        FL_COUNT = FL_INDEX_MAX-FL_SHIFT+2,               ///< includes the level for free blocks of 4Mb and over
+        SMALL_BLOCK_SIZE = 1 << FL_SHIFT
+      };
+
+      /**
+       * Statistics maintained as the heap is used
+       */
+
+      struct Statistics {
+        uint32_t arenaSize;                 ///< bytes available for blocks after the headers are deducted
+        uint32_t bytesUsed;                 ///< payload bytes in allocated blocks
+        uint32_t peakBytesUsed;             ///< high water mark of bytesUsed
+        uint32_t blocksUsed;                ///< number of allocated blocks
+        uint32_t blocksFree;                ///< number of free blocks
+        uint32_t allocations;               ///< total successful allocations
+        uint32_t failures;                  ///< total failed allocations
+      };
+
+    protected:
+      struct Block {
+        Block *prevPhysical;
+        uint32_t size;                      // payload size, bit 0 is the free flag
+        Block *nextFree;                    // only valid in free blocks
+        Block *prevFree;                    // only valid in free blocks
+      };
+
+      enum {
+        HEADER_SIZE = (offsetof(Block,nextFree)+ALIGN-1) & ~(ALIGN-1),
+        MIN_BLOCK_SIZE = (sizeof(Block)-HEADER_SIZE+ALIGN-1) & ~(ALIGN-1),
+        FREE_BIT = 1
+      };
+
+      uint32_t _flBitmap;
+      uint32_t _slBitmap[FL_COUNT];
+      Block *_lists[FL_COUNT][SL_COUNT];
+      Block *_first;
+      Statistics _statistics;
+
+    protected:
+      static uint32_t blockSize(const Block *block);
+      static bool isFree(const Block *block);
+      static Block *nextPhysical(const Block *block);
+      static Block *fromPointer(const void *ptr);
+      static void *toPointer(Block *block);
+      static uint8_t msb(uint32_t value);
+      static uint8_t lsb(uint32_t value);
+      static void mapping(uint32_t size,uint8_t& fl,uint8_t& sl);
+
+      void insertFreeBlock(Block *block);
+      void removeFreeBlock(Block *block);
+      Block *findFreeBlock(uint32_t size);
+      Block *mergeNeighbours(Block *block);
+      void split(Block *block,uint32_t size);
+
+    public:
+      TlsfHeap();
+
+      bool initialise(void *arena,uint32_t size);
+
+      void *allocate(uint32_t size);
+      void *reallocate(void *ptr,uint32_t size);
+      void free(void *ptr);
+
+      bool contains(const void *ptr) const;
+      uint32_t usableSize(const void *ptr) const;
+      uint32_t largestFreeBlock() const;
+      uint32_t bytesFree() const;
+      uint8_t fragmentation() const;
+
+      const Statistics& getStatistics() const;
+  };
+
+
+  /**
+   * Constructor. The heap is unusable until initialise() is called.
+   */
+
+  inline TlsfHeap::TlsfHeap()
+    : _flBitmap(0),
+      _first(nullptr) {
+
+    memset(&_statistics,0,sizeof(_statistics));
+  }
+
+
+  /**
+   * Build the heap in the given arena. Any previous contents are forgotten.
+   * @param arena The memory to use. It will be aligned up to 8 bytes.
+   * @param size The size of the memory in bytes
+   * @return false if the arena is too small or too large
+   */
+
+  inline bool TlsfHeap::initialise(void *arena,uint32_t size) {
+
+    uint8_t *start,*end;
+    Block *sentinel;
+    uint32_t payload;
+
+    memset(_slBitmap,0,sizeof(_slBitmap));
+    memset(_lists,0,sizeof(_lists));
+    memset(&_statistics,0,sizeof(_statistics));
+
+    _flBitmap=0;
+    _first=nullptr;
+
+    // align both ends and leave room for the first header and the sentinel
+
+    start=reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(arena)+ALIGN-1) & ~static_cast<uintptr_t>(ALIGN-1));
+    end=reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(arena)+size) & ~static_cast<uintptr_t>(ALIGN-1));
+
+    if(end<=start || static_cast<uint32_t>(end-start)<2*HEADER_SIZE+MIN_BLOCK_SIZE)
+      return false;
+
+    payload=(end-start)-2*HEADER_SIZE;
+
+    if(payload>=(static_cast<uint32_t>(1) << (FL_INDEX_MAX+1)))
+      return false;
+
+    _first=reinterpret_cast<Block *>(start);
+    _first->prevPhysical=nullptr;
+    _first->size=payload;
+
+    sentinel=nextPhysical(_first);
+    sentinel->prevPhysical=_first;
+    sentinel->size=0;
+
+    insertFreeBlock(_first);
+
+    _statistics.arenaSize=payload;
+    return true;
+  }
+
+
+  /**
+   * Get the payload size of a block
+   */
+
+  inline uint32_t TlsfHeap::blockSize(const Block *block) {
+    return block->size & ~static_cast<uint32_t>(FREE_BIT);
+  }
+
+
+  /**
+   * Return true if the block is free
+   */
+
+  inline bool TlsfHeap::isFree(const Block *block) {
+    return (block->size & FREE_BIT)!=0;
+  }
+
+
+  /**
+   * Get the block that physically follows this one
+   */
+
+  inline TlsfHeap::Block *TlsfHeap::nextPhysical(const Block *block) {
+    return reinterpret_cast<Block *>(const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(block))+HEADER_SIZE+blockSize(block));
+  }
+
+
+  /**
+   * Convert a user pointer to its block
+   */
+
+  inline TlsfHeap::Block *TlsfHeap::fromPointer(const void *ptr) {
+    return reinterpret_cast<Block *>(const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(ptr))-HEADER_SIZE);
+  }
+
+
+  /**
+   * Convert a block to its user pointer
+   */
+
+  inline void *TlsfHeap::toPointer(Block *block) {
+    return reinterpret_cast<uint8_t *>(block)+HEADER_SIZE;
+  }
+
+
+  /**
+   * Index of the most significant set bit. Compiles to CLZ on the M3/M4.
+   */
+
+  inline uint8_t TlsfHeap::msb(uint32_t value) {
+    return 31-__builtin_clz(value);
+  }
+
+
+  /**
+   * Index of the least significant set bit
+   */
+
+  inline uint8_t TlsfHeap::lsb(uint32_t value) {
+    return __builtin_ctz(value);
+  }
+
+
+  /**
+   * Map a size to its first and second level list indices
+   * @param size The payload size
+   * @param[out] fl The first level index
+   * @param[out] sl The second level index
+   */
+
+  inline void TlsfHeap::mapping(uint32_t size,uint8_t& fl,uint8_t& sl) {
+
+    uint8_t bit;
+
+    if(size<SMALL_BLOCK_SIZE) {
+      fl=0;
+      sl=size >> ALIGN_LOG2;
+    }
+    else {
+      bit=msb(size);
+      fl=bit-FL_SHIFT+1;
+      sl=(size >> (bit-SL_LOG2)) ^ SL_COUNT;
+    }
+  }
+
+
+  /**
+   * Put a block on the front of its free list
+   */
+
+  inline void TlsfHeap::insertFreeBlock(Block *block) {
+
+    uint8_t fl,sl;
+
+    mapping(blockSize(block),fl,sl);
+
+    block->size|=FREE_BIT;
+    block->prevFree=nullptr;
+    block->nextFree=_lists[fl][sl];
+
+    if(block->nextFree)
+      block->nextFree->prevFree=block;
+
+    _lists[fl][sl]=block;
+    _flBitmap|=1 << fl;
+    _slBitmap[fl]|=1 << sl;
+
+    _statistics.blocksFree++;
+  }
+
+
+  /**
+   * Unlink a block from its free list
+   */
+
+  inline void TlsfHeap::removeFreeBlock(Block *block) {
+
+    uint8_t fl,sl;
+
+    mapping(blockSize(block),fl,sl);
+
+    if(block->prevFree)
+      block->prevFree->nextFree=block->nextFree;
+    else {
+
+      _lists[fl][sl]=block->nextFree;
+
+      if(!block->nextFree) {
+        if(!(_slBitmap[fl]&=~(1 << sl)))
+          _flBitmap&=~(1 << fl);
+      }
+    }
+
+    if(block->nextFree)
+      block->nextFree->prevFree=block->prevFree;
+
+    block->size&=~static_cast<uint32_t>(FREE_BIT);
+    _statistics.blocksFree--;
+  }
+
+
+  /**
+   * Find a free block at least as big as size. The size is rounded up to the start of the
+   * next list so that any block in the chosen list is good enough without searching it.
+   * @param size The payload size
+   * @return The block, still on its free list, or nullptr
+   */
+
+  inline TlsfHeap::Block *TlsfHeap::findFreeBlock(uint32_t size) {
+
+    uint8_t fl,sl;
+    uint32_t map;
+
+    if(size>=SMALL_BLOCK_SIZE)
+      size+=(1 << (msb(size)-SL_LOG2))-1;
+
+    mapping(size,fl,sl);
+
+    if(fl>=FL_COUNT)
+      return nullptr;
+
+    // search this first level from sl upwards, then the next populated first level
+
+    if(!(map=_slBitmap[fl] & (~static_cast<uint32_t>(0) << sl))) {
+
+      if(fl+1>=FL_COUNT || !(map=_flBitmap & (~static_cast<uint32_t>(0) << (fl+1))))
+        return nullptr;
+
+      fl=lsb(map);
+      map=_slBitmap[fl];
+    }
+
+    return _lists[fl][lsb(map)];
+  }
+
+
+  /**
+   * Split off the tail of a used block if it's big enough to be a block in its own right
+   * @param block The used block
+   * @param size The payload size to keep
+   */
+
+  inline void TlsfHeap::split(Block *block,uint32_t size) {
+
+    Block *remainder;
+    uint32_t available;
+
+    available=blockSize(block);
+
+    if(available<size+HEADER_SIZE+MIN_BLOCK_SIZE)
+      return;
+
+    block->size=size;
+
+    remainder=nextPhysical(block);
+    remainder->prevPhysical=block;
+    remainder->size=available-size-HEADER_SIZE;
+
+    nextPhysical(remainder)->prevPhysical=remainder;
+
+    insertFreeBlock(mergeNeighbours(remainder));
+  }
+
+
+  /**
+   * Absorb free physical neighbours into a block that is not on a free list
+   * @param block The block
+   * @return The merged block, which may start before the original
+   */
+
+  inline TlsfHeap::Block *TlsfHeap::mergeNeighbours(Block *block) {
+
+    Block *neighbour;
+
+    // the following block
+
+    neighbour=nextPhysical(block);
+
+    if(isFree(neighbour)) {
+      removeFreeBlock(neighbour);
+      block->size+=HEADER_SIZE+blockSize(neighbour);
+      nextPhysical(block)->prevPhysical=block;
+    }
+
+    // the preceding block
+
+    neighbour=block->prevPhysical;
+
+    if(neighbour && isFree(neighbour)) {
+      removeFreeBlock(neighbour);
+      neighbour->size+=HEADER_SIZE+blockSize(block);
+      nextPhysical(neighbour)->prevPhysical=neighbour;
+      block=neighbour;
+    }
+
+    return block;
+  }
+
+
+  /**
+   * Allocate memory
+   * @param size The number of bytes required
+   * @return The 8 byte aligned memory or nullptr if there is no free block big enough
+   */
+
+  inline void *TlsfHeap::allocate(uint32_t size) {
+
+    Block *block;
+
+    if(size<MIN_BLOCK_SIZE)
+      size=MIN_BLOCK_SIZE;
+
+    size=(size+ALIGN-1) & ~static_cast<uint32_t>(ALIGN-1);
+
+    if(!_first || size>=(static_cast<uint32_t>(1) << FL_INDEX_MAX) || (block=findFreeBlock(size))==nullptr) {
+      _statistics.failures++;
+      return nullptr;
+    }
+
+    removeFreeBlock(block);
+    split(block,size);
+
+    _statistics.bytesUsed+=blockSize(block);
+    _statistics.blocksUsed++;
+    _statistics.allocations++;
+
+    if(_statistics.bytesUsed>_statistics.peakBytesUsed)
+      _statistics.peakBytesUsed=_statistics.bytesUsed;
+
+    return toPointer(block);
+  }
+
+
+  /**
+   * Free memory. Adjacent free blocks are merged immediately.
+   * @param ptr Memory returned by allocate(). nullptr is ignored.
+   */
+
+  inline void TlsfHeap::free(void *ptr) {
+
+    Block *block;
+
+    if(!ptr)
+      return;
+
+    block=fromPointer(ptr);
+
+    _statistics.bytesUsed-=blockSize(block);
+    _statistics.blocksUsed--;
+
+    insertFreeBlock(mergeNeighbours(block));
+  }
+
+
+  /**
+   * Resize an allocation. Shrinking, or growing into a free neighbour, happens in place.
+   * Otherwise a new block is allocated and the contents copied.
+   * @param ptr The existing memory, or nullptr to allocate
+   * @param size The new size in bytes
+   * @return The new memory, or nullptr if it could not be allocated in which case the
+   *   original is untouched
+   */
+
+  inline void *TlsfHeap::reallocate(void *ptr,uint32_t size) {
+
+    Block *block,*next;
+    uint32_t current,combined;
+    void *newptr;
+
+    if(!ptr)
+      return allocate(size);
+
+    block=fromPointer(ptr);
+    current=blockSize(block);
+
+    if(size<MIN_BLOCK_SIZE)
+      size=MIN_BLOCK_SIZE;
+
+    size=(size+ALIGN-1) & ~static_cast<uint32_t>(ALIGN-1);
+
+    if(size<=current)
+      return ptr;
+
+    // try to grow into the following free block
+
+    next=nextPhysical(block);
+
+    if(isFree(next) && (combined=current+HEADER_SIZE+blockSize(next))>=size) {
+
+      removeFreeBlock(next);
+      block->size=combined;
+      nextPhysical(block)->prevPhysical=block;
+
+      split(block,size);
+
+      _statistics.bytesUsed+=blockSize(block)-current;
+
+      if(_statistics.bytesUsed>_statistics.peakBytesUsed)
+        _statistics.peakBytesUsed=_statistics.bytesUsed;
+
+      return ptr;
+    }
+
+    if((newptr=allocate(size))==nullptr)
+      return nullptr;
+
+    memcpy(newptr,ptr,current);
+    free(ptr);
+
+    return newptr;
+  }
+
+
+  /**
+   * Check if a pointer lies within this heap's arena
+   */
+
+  inline bool TlsfHeap::contains(const void *ptr) const {
+
+    const uint8_t *p;
+
+    p=reinterpret_cast<const uint8_t *>(ptr);
+
+    return _first &&
+           p>=reinterpret_cast<const uint8_t *>(_first) &&
+           p<reinterpret_cast<const uint8_t *>(_first)+_statistics.arenaSize+2*HEADER_SIZE;
+  }
+
+
+  /**
+   * Get the number of bytes that can actually be used in an allocation. This is at least as
+   * many as were requested.
+   */
+
+  inline uint32_t TlsfHeap::usableSize(const void *ptr) const {
+    return blockSize(fromPointer(ptr));
+  }
+
+
+  /**
+   * Get the size of the largest free block. Only the highest populated list needs to be
+   * looked at, and lists near the top of a heap are short.
+   * @return The largest payload that can be allocated right now
+   */
+
+  inline uint32_t TlsfHeap::largestFreeBlock() const {
+
+    const Block *block;
+    uint32_t largest;
+    uint8_t fl;
+
+    if(!_flBitmap)
+      return 0;
+
+    fl=msb(_flBitmap);
+    largest=0;
+
+    for(block=_lists[fl][msb(_slBitmap[fl])];block;block=block->nextFree)
+      if(blockSize(block)>largest)
+        largest=blockSize(block);
+
+    return largest;
+  }
+
+
+  /**
+   * Get the total payload bytes in free blocks. The header of each free block is not
+   * counted because it cannot be allocated.
+   */
+
+  inline uint32_t TlsfHeap::bytesFree() const {
+    return _statistics.arenaSize-_statistics.bytesUsed-(_statistics.blocksUsed+_statistics.blocksFree-1)*HEADER_SIZE;
+  }
+
+
+  /**
+   * Get the fragmentation of the free space as a percentage: 0 when all the free space is
+   * in one block, approaching 100 as it's scattered across many small blocks.
+   */
+
+  inline uint8_t TlsfHeap::fragmentation() const {
+
+    uint32_t free;
+
+    if((free=bytesFree())==0)
+      return 0;
+
+    return 100-static_cast<uint8_t>((static_cast<uint64_t>(largestFreeBlock())*100)/free);
+  }
+
+
+  /**
+   * Get the statistics
+   */
+
+  inline const TlsfHeap::Statistics& TlsfHeap::getStatistics() const {
+    return _statistics;
+  }
+}
@@ -27,7 +27,8 @@ namespace stm32plus {
 
           uint16_t ftp_maxRequestLineLength;            ///< size includes the verb, and all parameters. Default is 200
           uint16_t ftp_outputStreamBufferMaxSize;       ///< buffer size of the stream-of-streams class. Default is 256
-          uint16_t ftp_dataConnectionSendBufferSize;    ///< data connection send buffer size. Default is 2920 (2*MTU for ethernet)
+          uint16_t ftp_dataConnectionSendBufferSize;    ///< data connection send buffer size. Default is 4096 (a multiple of the sector size)
+          uint16_t ftp_dataConnectionTransferBufferSize;  ///< upload and directory listing buffer size. Default is 4096 (a multiple of the sector size)
 
           /**
            * Constructor
@@ -36,7 +37,8 @@ namespace stm32plus {
           Parameters() {
             ftp_maxRequestLineLength=200;
             ftp_outputStreamBufferMaxSize=256;
-            ftp_dataConnectionSendBufferSize=2918;
+            ftp_dataConnectionSendBufferSize=4096;
+            ftp_dataConnectionTransferBufferSize=4096;
           }
         };
 
@@ -64,6 +66,7 @@ namespace stm32plus {
 
         void clearDataConnection();       ///< this is a callback for the data connection server to clear itself
         uint16_t getDataConnectionSendBufferSize() const;
+        uint16_t getDataConnectionTransferBufferSize() const;
         void updateLastActiveTime();
     };
 
@@ -143,6 +146,15 @@ namespace stm32plus {
     }
 
 
+    /**
+     * Get the data connection transfer buffer size
+     */
+
+    inline uint16_t FtpServerConnectionBase::getDataConnectionTransferBufferSize() const {
+      return _params.ftp_dataConnectionTransferBufferSize;
+    }
+
+
     /**
      * Update the last active time
      */
@@ -14,7 +14,18 @@ namespace stm32plus {
     class FtpServerConnectionBase;
 
     /**
-     * Data connection for the FTP server. There can be only one data connection at any one time
+     * Data connection for the FTP server. There can be only one data connection at any one time.
+     *
+     * Uploads are received into a transfer buffer that is allocated once per data connection and
+     * written to the upload stream only when it's full, so a file stream sees large writes that
+     * are a multiple of the sector size and can use multi-block transfers. The same buffer holds
+     * the text of directory listings so that no memory is allocated per listing line. A listing
+     * is queued a full buffer at a time and only sent when flush() is called.
+     *
+     * With the defaults the receive window, send buffer and transfer buffer take 12Kb of RAM
+     * per data connection, up from 4Kb. F1 users short of RAM can reduce them with
+     * tcp_receiveBufferSize here and ftp_dataConnectionSendBufferSize and
+     * ftp_dataConnectionTransferBufferSize in the server connection parameters.
      */
 
     class FtpServerDataConnection : public TcpConnection {
@@ -32,15 +43,6 @@ namespace stm32plus {
         };
 
 
-        /**
-         * General constants
-         */
-
-        enum {
-          UPLOAD_TRANSFER_BUFFER_SIZE = 512   // amount read from receive buffer and written to output stream (512b matches SD Card sector size)
-        };
-
-
         /**
          * Data connection parameters
          */
@@ -52,7 +54,7 @@ namespace stm32plus {
            */
 
           Parameters() {
-            tcp_receiveBufferSize=1024;       // for uploads, increase the receive buffer to 1Kb
+            tcp_receiveBufferSize=4096;       // for uploads, a large receive window keeps the sender streaming
           }
         };
 
@@ -61,12 +63,19 @@ namespace stm32plus {
         TcpOutputStreamOfStreams _outputStreams;
         Direction _direction;
         scoped_ptr<OutputStream> _uploadStream;
+        scoped_array<uint8_t> _transferBuffer;
+        uint16_t _transferBufferSize;
+        uint16_t _transferBufferUsed;
+        bool _listingFailed;
 
         enum class State : uint8_t {
           NOT_STARTED,
           RUNNING
         } _state;
 
+      protected:
+        bool flushTransferBuffer();
+
       public:
         FtpServerDataConnection(const Parameters& params,FtpServerConnectionBase *serverbase);
         ~FtpServerDataConnection();
@@ -77,7 +86,7 @@ namespace stm32plus {
         bool flush();
         bool finished() const;
 
-        void addString(const char *str);
+        bool addString(const char *str);
         void addStream(InputStream *stream,bool owned);
         void setUploadStream(OutputStream *stream);
         void setDirection(Direction dir);
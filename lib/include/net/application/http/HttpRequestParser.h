@@ -0,0 +1,732 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * Incremental HTTP/1.x request parser. The parser owns a single fixed-size buffer that the
+     * caller receives network data straight into (getWritePointer()/commit()) and then calls
+     * parse() repeatedly. Each call returns the next element of the request: the request line,
+     * each header, body data and finally the end of the message. Nothing is copied and nothing
+     * is allocated after construction. The request line and header fields are tokenised in place
+     * and nul-terminated so the spans can also be used as C strings.
+     *
+     * The request line and all the headers must fit in the buffer together. The method, URI and
+     * version remain valid until the first parse() call after MESSAGE_COMPLETE, which is when the
+     * parser moves on to the next request. A header's name and value are only valid until the
+     * next parse() call.
+     *
+     * Body data is returned as spans of whatever has arrived so far. Both Content-Length and
+     * chunked transfer coding are supported; chunk framing and trailers are stripped. Pipelined
+     * requests are supported because data following the end of one message is kept and parsed as
+     * the start of the next.
+     */
+
+    class HttpRequestParser {
+
+      public:
+
+        /**
+         * Error codes
+         */
+
+        enum {
+          E_BAD_REQUEST = 1,          ///< the request is malformed
+          E_REQUEST_TOO_LARGE         ///< the request line and headers don't fit in the buffer
+        };
+
+
+        /**
+         * The outcome of a call to parse()
+         */
+
+        enum class Result : uint8_t {
+          NEED_MORE,                  ///< receive more data into the buffer and call again
+          REQUEST_LINE,               ///< the method, URI and version are available
+          HEADER,                     ///< a header name and value are available
+          HEADERS_COMPLETE,           ///< the blank line that ends the headers has been seen
+          BODY,                       ///< some body data is available
+          MESSAGE_COMPLETE,           ///< the request is complete
+          ERROR                       ///< the request could not be parsed. The parser must be reset.
+        };
+
+      protected:
+
+        enum class State : uint8_t {
+          REQUEST_LINE,
+          HEADERS,
+          BODY,
+          CHUNK_SIZE,
+          CHUNK_DATA,
+          CHUNK_DATA_END,
+          CHUNK_TRAILERS,
+          COMPLETE,
+          FAILED
+        };
+
+        scoped_array<char> _buffer;
+        uint16_t _bufferSize;
+        uint16_t _parsePos;             // start of unparsed data
+        uint16_t _scanPos;              // how far we've already looked for a line feed
+        uint16_t _writePos;             // end of received data
+        uint16_t _bodyBase;             // first byte after the headers, the buffer is recycled from here
+        State _state;
+
+        HttpStringSpan _method;
+        HttpStringSpan _uri;
+        HttpStringSpan _headerName;
+        HttpStringSpan _headerValue;
+        HttpStringSpan _body;
+        HttpVersion _version;
+
+        uint32_t _contentLength;
+        uint32_t _bodyRemaining;
+        bool _chunked;
+        bool _keepAlive;
+
+      protected:
+        char *nextLine(uint16_t& length);
+        void compact();
+        void startMessage();
+        Result fail(uint32_t errorCode);
+
+        Result parseRequestLine();
+        Result parseHeader();
+        Result parseBodyData();
+        Result parseChunkSize();
+
+        void processHeader();
+        static void decodeUri(char *uri,uint16_t& length);
+        static int8_t hexValue(char c);
+
+      public:
+        HttpRequestParser(uint16_t bufferSize);
+
+        char *getWritePointer(uint16_t& space);
+        void commit(uint16_t count);
+
+        Result parse();
+        void reset();
+
+        const HttpStringSpan& getMethodName() const;
+        bool getMethod(HttpMethod& method) const;
+        const HttpStringSpan& getUri() const;
+        HttpVersion getVersion() const;
+        const HttpStringSpan& getHeaderName() const;
+        const HttpStringSpan& getHeaderValue() const;
+        const HttpStringSpan& getBody() const;
+
+        uint32_t getContentLength() const;
+        bool isChunked() const;
+        bool hasBody() const;
+        bool isKeepAlive() const;
+        bool hasBufferedData() const;
+    };
+
+
+    /**
+     * Constructor
+     * @param bufferSize The size of the buffer. The request line and all the headers must fit.
+     */
+
+    inline HttpRequestParser::HttpRequestParser(uint16_t bufferSize)
+      : _buffer(new char[bufferSize]),
+        _bufferSize(bufferSize) {
+      reset();
+    }
+
+
+    /**
+     * Discard everything and get ready for a new request
+     */
+
+    inline void HttpRequestParser::reset() {
+      _parsePos=_scanPos=_writePos=0;
+      startMessage();
+    }
+
+
+    /**
+     * Get the address and size of the free space at the end of the buffer. Receive data into
+     * it and then call commit() with the number of bytes received.
+     * @param[out] space The number of bytes that can be written
+     * @return The address to write to
+     */
+
+    inline char *HttpRequestParser::getWritePointer(uint16_t& space) {
+      space=_bufferSize-_writePos;
+      return _buffer.get()+_writePos;
+    }
+
+
+    /**
+     * Tell the parser about data received into the buffer
+     * @param count The number of bytes received at the write pointer
+     */
+
+    inline void HttpRequestParser::commit(uint16_t count) {
+      _writePos+=count;
+    }
+
+
+    /**
+     * Parse the next element of the request
+     * @return What was found
+     */
+
+    inline HttpRequestParser::Result HttpRequestParser::parse() {
+
+      Result result;
+
+      for(;;) {
+
+        switch(_state) {
+
+          case State::REQUEST_LINE:
+            result=parseRequestLine();
+            break;
+
+          case State::HEADERS:
+            result=parseHeader();
+            break;
+
+          case State::BODY:
+          case State::CHUNK_DATA:
+
+            // all the data has been returned, move on
+
+            if(_bodyRemaining==0) {
+
+              if(_state==State::BODY) {
+                _state=State::COMPLETE;
+                return Result::MESSAGE_COMPLETE;
+              }
+
+              _state=State::CHUNK_DATA_END;
+              continue;
+            }
+
+            result=parseBodyData();
+            break;
+
+          case State::CHUNK_SIZE:
+            if((result=parseChunkSize())==Result::BODY)
+              continue;
+            break;
+
+          case State::CHUNK_DATA_END:
+          case State::CHUNK_TRAILERS: {
+
+            uint16_t length;
+
+            if(nextLine(length)==nullptr)
+              result=Result::NEED_MORE;
+            else if(_state==State::CHUNK_DATA_END) {
+
+              // the CRLF after the chunk data
+
+              if(length!=0)
+                return fail(E_BAD_REQUEST);
+
+              _state=State::CHUNK_SIZE;
+              continue;
+            }
+            else {
+
+              // trailers are ignored up to the blank line
+
+              if(length==0) {
+                _state=State::COMPLETE;
+                return Result::MESSAGE_COMPLETE;
+              }
+
+              continue;
+            }
+            break;
+          }
+
+          case State::COMPLETE:
+
+            // move on to the next (possibly pipelined) request
+
+            startMessage();
+            continue;
+
+          default:
+            return Result::ERROR;
+        }
+
+        if(result!=Result::NEED_MORE)
+          return result;
+
+        // make room for more data. if there isn't any then the headers are too big
+
+        compact();
+
+        if(_writePos==_bufferSize)
+          return fail(E_REQUEST_TOO_LARGE);
+
+        return Result::NEED_MORE;
+      }
+    }
+
+
+    /**
+     * Get the next complete line from the buffer. The line feed (and carriage return, if there
+     * is one) are replaced by nul.
+     * @param[out] length The length of the line excluding the terminator
+     * @return The start of the line or nullptr if a complete line is not in the buffer yet
+     */
+
+    inline char *HttpRequestParser::nextLine(uint16_t& length) {
+
+      char *start,*lf;
+
+      start=_buffer.get()+_parsePos;
+
+      if((lf=static_cast<char *>(memchr(_buffer.get()+_scanPos,'\n',_writePos-_scanPos)))==nullptr) {
+        _scanPos=_writePos;
+        return nullptr;
+      }
+
+      *lf='\0';
+      length=lf-start;
+
+      if(length && start[length-1]=='\r')
+        start[--length]='\0';
+
+      _parsePos=_scanPos=lf-_buffer.get()+1;
+      return start;
+    }
+
+
+    /**
+     * Move unparsed data down to make room for more. Before the headers are complete the data
+     * moves to the start of the buffer. After that the data moves to the end of the headers so
+     * that the request line stays valid.
+     */
+
+    inline void HttpRequestParser::compact() {
+
+      uint16_t base,count;
+
+      if(_state==State::HEADERS)
+        return;
+
+      base=_state==State::REQUEST_LINE ? 0 : _bodyBase;
+
+      if(_parsePos==base)
+        return;
+
+      count=_writePos-_parsePos;
+      memmove(_buffer.get()+base,_buffer.get()+_parsePos,count);
+
+      _scanPos-=_parsePos-base;
+      _parsePos=base;
+      _writePos=base+count;
+    }
+
+
+    /**
+     * Clear down the per-request state and keep whatever data has arrived for the next request
+     */
+
+    inline void HttpRequestParser::startMessage() {
+
+      _state=State::REQUEST_LINE;
+      compact();
+
+      _method=HttpStringSpan();
+      _uri=HttpStringSpan();
+      _headerName=HttpStringSpan();
+      _headerValue=HttpStringSpan();
+      _body=HttpStringSpan();
+      _version=HttpVersion::HTTP_1_0;
+
+      _bodyBase=0;
+      _contentLength=0;
+      _bodyRemaining=0;
+      _chunked=false;
+      _keepAlive=false;
+    }
+
+
+    /**
+     * Enter the failed state
+     * @param errorCode The error to report
+     * @return Result::ERROR
+     */
+
+    inline HttpRequestParser::Result HttpRequestParser::fail(uint32_t errorCode) {
+      _state=State::FAILED;
+      errorProvider.set(ErrorProvider::ERROR_PROVIDER_NET_HTTP_REQUEST_PARSER,errorCode);
+      return Result::ERROR;
+    }
+
+
+    /**
+     * Parse the request line: METHOD SP URI SP VERSION
+     * e.g. GET http://www.foo.com/this/file.html HTTP/1.1
+     * e.g. GET /this/file.html HTTP/1.1
+     */
+
+    inline HttpRequestParser::Result HttpRequestParser::parseRequestLine() {
+
+      char *line,*uri,*version,*path;
+      uint16_t length,uriLength;
+
+      // RFC 7230 3.5: ignore blank lines ahead of the request line
+
+      do {
+        if((line=nextLine(length))==nullptr)
+          return Result::NEED_MORE;
+      } while(length==0);
+
+      if((uri=static_cast<char *>(memchr(line,' ',length)))==nullptr)
+        return fail(E_BAD_REQUEST);
+
+      *uri++='\0';
+      _method.set(line,uri-line-1);
+
+      if((version=strchr(uri,' '))==nullptr)
+        return fail(E_BAD_REQUEST);
+
+      *version++='\0';
+      uriLength=version-uri-1;
+
+      // version
+
+      if(!strcmp(version,"HTTP/1.1")) {
+        _version=HttpVersion::HTTP_1_1;
+        _keepAlive=true;
+      }
+      else if(!strcmp(version,"HTTP/1.0"))
+        _version=HttpVersion::HTTP_1_0;
+      else
+        return fail(E_BAD_REQUEST);
+
+      // URI may be absolute. deal with that.
+
+      decodeUri(uri,uriLength);
+
+      if((path=strstr(uri,"://"))!=nullptr) {
+
+        if((path=strchr(path+3,'/'))!=nullptr)
+          _uri.set(path,uriLength-(path-uri));
+        else
+          _uri.set("/index.html",11);       // only host and protocol found, default to /index.html
+      }
+      else
+        _uri.set(uri,uriLength);
+
+      _state=State::HEADERS;
+      return Result::REQUEST_LINE;
+    }
+
+
+    /**
+     * Parse a header line: NAME ':' OWS VALUE OWS
+     */
+
+    inline HttpRequestParser::Result HttpRequestParser::parseHeader() {
+
+      char *line,*colon,*value,*end;
+      uint16_t length;
+
+      if((line=nextLine(length))==nullptr)
+        return Result::NEED_MORE;
+
+      // blank line ends the headers
+
+      if(length==0) {
+
+        _bodyBase=_parsePos;
+
+        // with no body the next parse() returns MESSAGE_COMPLETE straight away
+
+        _bodyRemaining=_contentLength;
+        _state=_chunked ? State::CHUNK_SIZE : State::BODY;
+
+        return Result::HEADERS_COMPLETE;
+      }
+
+      if((colon=static_cast<char *>(memchr(line,':',length)))==nullptr || colon==line)
+        return fail(E_BAD_REQUEST);
+
+      *colon='\0';
+      _headerName.set(line,colon-line);
+
+      // trim the value
+
+      end=line+length;
+
+      for(value=colon+1;value<end && (*value==' ' || *value=='\t');value++);
+      while(end>value && (end[-1]==' ' || end[-1]=='\t'))
+        *--end='\0';
+
+      _headerValue.set(value,end-value);
+
+      processHeader();
+      return Result::HEADER;
+    }
+
+
+    /**
+     * Take note of the headers that affect the parsing
+     */
+
+    inline void HttpRequestParser::processHeader() {
+
+      if(_headerName.equalsIgnoreCase("Content-Length"))
+        _contentLength=strtoul(_headerValue.ptr,nullptr,10);
+      else if(_headerName.equalsIgnoreCase("Transfer-Encoding"))
+        _chunked=_headerValue.equalsIgnoreCase("chunked");
+      else if(_headerName.equalsIgnoreCase("Connection")) {
+        if(_headerValue.equalsIgnoreCase("close"))
+          _keepAlive=false;
+        else if(_headerValue.equalsIgnoreCase("keep-alive"))
+          _keepAlive=true;
+      }
+    }
+
+
+    /**
+     * Return as much of the remaining body (or chunk) as has been received
+     */
+
+    inline HttpRequestParser::Result HttpRequestParser::parseBodyData() {
+
+      uint16_t count;
+
+      if((count=_writePos-_parsePos)==0)
+        return Result::NEED_MORE;
+
+      if(count>_bodyRemaining)
+        count=_bodyRemaining;
+
+      _body.set(_buffer.get()+_parsePos,count);
+
+      _parsePos+=count;
+      _scanPos=_parsePos;
+      _bodyRemaining-=count;
+
+      return Result::BODY;
+    }
+
+
+    /**
+     * Parse a chunk size line: HEX [';' extensions]
+     * @return Result::BODY if the line was parsed, otherwise NEED_MORE or ERROR
+     */
+
+    inline HttpRequestParser::Result HttpRequestParser::parseChunkSize() {
+
+      char *line;
+      uint16_t length;
+      int8_t digit;
+      uint32_t size;
+
+      if((line=nextLine(length))==nullptr)
+        return Result::NEED_MORE;
+
+      if(hexValue(*line)<0)
+        return fail(E_BAD_REQUEST);
+
+      for(size=0;(digit=hexValue(*line))>=0;line++) {
+
+        if(size>0x0fffffff)
+          return fail(E_BAD_REQUEST);
+
+        size=(size << 4) | digit;
+      }
+
+      // the last chunk is followed by optional trailers
+
+      if(size==0)
+        _state=State::CHUNK_TRAILERS;
+      else {
+        _bodyRemaining=size;
+        _state=State::CHUNK_DATA;
+      }
+
+      return Result::BODY;
+    }
+
+
+    /**
+     * Decode %xx escapes in place
+     * @param uri The URI
+     * @param[in,out] length The URI length, updated to the decoded length
+     */
+
+    inline void HttpRequestParser::decodeUri(char *uri,uint16_t& length) {
+
+      const char *src,*end;
+      int8_t hi,lo;
+
+      src=uri;
+      end=uri+length;
+
+      while(src<end) {
+
+        if(*src=='%' && end-src>=3 && (hi=hexValue(src[1]))>=0 && (lo=hexValue(src[2]))>=0) {
+          *uri++=static_cast<char>((hi << 4) | lo);
+          src+=3;
+        }
+        else
+          *uri++=*src++;
+      }
+
+      length-=end-uri;
+      *uri='\0';
+    }
+
+
+    /**
+     * Get the value of a hex digit
+     * @param c The character
+     * @return 0..15 or -1 if not a hex digit
+     */
+
+    inline int8_t HttpRequestParser::hexValue(char c) {
+
+      if(c>='0' && c<='9')
+        return c-'0';
+      if(c>='a' && c<='f')
+        return c-'a'+10;
+      if(c>='A' && c<='F')
+        return c-'A'+10;
+
+      return -1;
+    }
+
+
+    /**
+     * Get the method name, e.g. "GET"
+     */
+
+    inline const HttpStringSpan& HttpRequestParser::getMethodName() const {
+      return _method;
+    }
+
+
+    /**
+     * Get the method as one of the known constants
+     * @param[out] method The method
+     * @return false if the method is not one that we know about
+     */
+
+    inline bool HttpRequestParser::getMethod(HttpMethod& method) const {
+
+      static const char *const names[]={ "OPTIONS","GET","HEAD","POST","PUT","DELETE","TRACE","CONNECT" };
+
+      for(uint8_t i=0;i<sizeof(names)/sizeof(names[0]);i++)
+        if(_method.equals(names[i])) {
+          method=static_cast<HttpMethod>(i);
+          return true;
+        }
+
+      return false;
+    }
+
+
+    /**
+     * Get the decoded URI path. Absolute URIs have had the scheme and host removed.
+     */
+
+    inline const HttpStringSpan& HttpRequestParser::getUri() const {
+      return _uri;
+    }
+
+
+    /**
+     * Get the HTTP version
+     */
+
+    inline HttpVersion HttpRequestParser::getVersion() const {
+      return _version;
+    }
+
+
+    /**
+     * Get the name of the header returned by the last parse()
+     */
+
+    inline const HttpStringSpan& HttpRequestParser::getHeaderName() const {
+      return _headerName;
+    }
+
+
+    /**
+     * Get the value of the header returned by the last parse()
+     */
+
+    inline const HttpStringSpan& HttpRequestParser::getHeaderValue() const {
+      return _headerValue;
+    }
+
+
+    /**
+     * Get the body data returned by the last parse(). This is not nul-terminated.
+     */
+
+    inline const HttpStringSpan& HttpRequestParser::getBody() const {
+      return _body;
+    }
+
+
+    /**
+     * Get the value of the Content-Length header, zero if there wasn't one
+     */
+
+    inline uint32_t HttpRequestParser::getContentLength() const {
+      return _contentLength;
+    }
+
+
+    /**
+     * Return true if the body uses chunked transfer coding
+     */
+
+    inline bool HttpRequestParser::isChunked() const {
+      return _chunked;
+    }
+
+
+    /**
+     * Return true if the request has a body
+     */
+
+    inline bool HttpRequestParser::hasBody() const {
+      return _chunked || _contentLength>0;
+    }
+
+
+    /**
+     * Return true if the client wants the connection kept open after this request. This is
+     * the HTTP/1.1 default unless "Connection: close" was sent, and the HTTP/1.0 default
+     * is to close unless "Connection: keep-alive" was sent.
+     */
+
+    inline bool HttpRequestParser::isKeepAlive() const {
+      return _keepAlive;
+    }
+
+
+    /**
+     * Return true if there is received data in the buffer that hasn't been parsed yet,
+     * for example a pipelined request.
+     */
+
+    inline bool HttpRequestParser::hasBufferedData() const {
+      return _parsePos!=_writePos;
+    }
+  }
+}
@@ -17,7 +17,13 @@ namespace stm32plus {
      * parsed. This template follows the CRTP pattern of you parameterising it with your
      * implementation.
      *
-     * We support HTTP/1.1 and HTTP/1.0 connections. In HTTP/1.1 mode
+     * We support HTTP/1.1 and HTTP/1.0 connections. In HTTP/1.1 mode the connection is kept
+     * alive for further requests unless the client asks us to close it, and pipelined requests
+     * are processed in turn.
+     *
+     * Requests are parsed by HttpRequestParser directly out of a fixed buffer that is allocated
+     * once when the connection is created. The subclass receives each header as a pair of spans
+     * that refer into that buffer, and _uri remains valid until the response has been written.
      */
 
     template<class TImpl>
@@ -32,13 +38,13 @@ namespace stm32plus {
         struct Parameters : TcpConnection::Parameters {
 
           bool http_version11;                      ///< are we operating in HTTP/1.1 mode? default is true.
-          uint16_t http_maxRequestLineLength;       ///< size includes the verb, URL and HTTP version. Default is 200
+          uint16_t http_requestBufferSize;          ///< the request line and all the headers must fit in this buffer. Default is 512
           uint16_t http_outputStreamBufferMaxSize;  ///< buffer size of the stream-of-streams class. Default is 256
           uint16_t http_maxRequestsPerConnection;   ///< in http1.1, close connection after this many requests. 0 = never, default is 5.
 
           Parameters() {
             http_version11=false;
-            http_maxRequestLineLength=200;
+            http_requestBufferSize=512;
             http_outputStreamBufferMaxSize=256;
             http_maxRequestsPerConnection=5;
           }
@@ -46,15 +52,14 @@ namespace stm32plus {
 
       protected:
         const Parameters& _params;          ///< reference to the parameters class
-        uint32_t _contentLength;            ///< value of the Content-Length header
         OutputStream *_requestBody;         ///< derivation sets this non-null when it wants the request body
         uint32_t _responseSize;             ///< derivation sets this non-zero along with response body so Content-Length header can be sent back to client
-        TcpTextLineReceiver _currentLine;   ///< current line that we're processing
+        HttpRequestParser _request;         ///< the request parser and its buffer
         TcpOutputStreamOfStreams _output;   ///< the output streams that form the response
         uint16_t _requestsServed;           ///< count of requests served so far
-        std::string _version;
-        std::string _action;
-        std::string _uri;
+        HttpVersion _version;               ///< the request version
+        HttpStringSpan _action;             ///< the request method, e.g. "GET"
+        const char *_uri;                   ///< the decoded request path
 
         /**
          * States that we transition through while processing a request
@@ -73,18 +78,17 @@ namespace stm32plus {
         HttpServerConnection(const Parameters& params);
 
         void changeState(State newState);
-        void processRequestHeader(const std::string& header);
+        bool isKeepAlive() const;
+        const char *getVersionString() const;
+        const char *getConnectionHeader() const;
 
         void addConnectionHeader(std::string& response);
         void addContentTypeHeader(std::string& response);
         void addContentTypeHeader(std::string& response,const char *contentType);
         void addContentLengthHeader(std::string& response,uint32_t contentLength);
 
-        void readRequestLine();
-        void readRequestHeaders();
-        void readRequestBody();
-        void parseRequestLine();
-        std::string decodeUri(const std::string& uri);
+        bool fillRequestBuffer();
+        bool responseCompleted();
 
       public:
         bool handleRead();              ///< implementation requirement from the TcpConnectionArray
@@ -100,164 +104,97 @@ namespace stm32plus {
     inline HttpServerConnection<TImpl>::HttpServerConnection(const Parameters& params)
       : TcpConnection(params),
         _params(params),
-        _contentLength(0),
         _requestBody(nullptr),
         _responseSize(0),
-        _currentLine(params.http_maxRequestLineLength),
+        _request(params.http_requestBufferSize),
         _output(*this,params.http_outputStreamBufferMaxSize),
         _requestsServed(0),
+        _version(HttpVersion::HTTP_1_0),
+        _uri(""),
         _state(State::READING_REQUEST_LINE) {
     }
 
 
     /**
-     * Some data is ready for reading
+     * Some data is ready for reading. The request is parsed straight out of the parser's buffer
+     * and any data left over after one request (a pipelined request) is kept for the next one.
      * @return true always: we don't want to ever abandon the client's wait() call
      */
 
     template<class TImpl>
     inline bool HttpServerConnection<TImpl>::handleRead() {
 
-      while(getDataAvailable()) {
+      for(;;) {
 
-        switch(_state) {
+        // nothing more to read while a response is being written
 
-          case State::READING_REQUEST_LINE:       // first line of a request. contains the verb, URL, http version
-            readRequestLine();
-            break;
+        if(_state!=State::READING_REQUEST_LINE &&
+           _state!=State::READING_REQUEST_HEADERS &&
+           _state!=State::READING_REQUEST_BODY)
+          return true;
 
-          case State::READING_REQUEST_HEADERS:
-            readRequestHeaders();
-            break;
+        switch(_request.parse()) {
 
-          case State::READING_REQUEST_BODY:
-            readRequestBody();
+          case HttpRequestParser::Result::NEED_MORE:
+            if(!fillRequestBuffer())
+              return true;
             break;
 
-          default:                // not a read state
-            return true;
-        }
-      }
-
-      return true;
-    }
-
-
-    /**
-     * Read the request line
-     */
-
-    template<class TImpl>
-    inline void HttpServerConnection<TImpl>::readRequestLine() {
-
-      _currentLine.add(*this);
-
-      if(_currentLine.ready()) {
-        parseRequestLine();
-        changeState(State::READING_REQUEST_HEADERS);
-        _currentLine.reset();
-      }
-    }
-
-
-    /**
-     * Parse the request line: ACTION SP URI SP PROTOCOL
-     * e.g. GET http://www.foo.com/this/file.html HTTP/1.1
-     * e.g. GET /this/file.html HTTP/1.1
-     */
-
-    template<class TImpl>
-    inline void HttpServerConnection<TImpl>::parseRequestLine() {
-
-      std::string::size_type pos,pos2;
-      const std::string& request(_currentLine.str());
-
-      if((pos=request.find(' '))!=std::string::npos) {
-
-        // first the action
-
-        _action=request.substr(0,pos);
-
-        if((pos2=request.find(' ',pos+1))!=std::string::npos) {
-
-          // now URI and protocol
-
-          _uri=decodeUri(request.substr(pos+1,pos2-pos-1));
-          _version=request.substr(pos2+1);
-
-          // URI may be absolute. deal with that.
-
-          if((pos=_uri.find("://"))!=std::string::npos) {
-
-            // found the abs prefix, find the URI at the end
-
-            if((pos=_uri.find('/',pos+3))!=std::string::npos)
-              _uri=_uri.substr(pos);      // URI found, keep it
-            else
-              _uri="/index.html";         // only host and protocol found, default to /index.html
-          }
-        }
-      }
-    }
-
+          case HttpRequestParser::Result::REQUEST_LINE:
+            _action=_request.getMethodName();
+            _uri=_request.getUri().ptr;
+            _version=_request.getVersion();
+            changeState(State::READING_REQUEST_HEADERS);
+            break;
 
-    /**
-     * Read the request headers
-     */
+          case HttpRequestParser::Result::HEADER:
+            static_cast<TImpl *>(this)->handleRequestHeader(_request.getHeaderName(),_request.getHeaderValue());
+            break;
 
-    template<class TImpl>
-    inline void HttpServerConnection<TImpl>::readRequestHeaders() {
+          case HttpRequestParser::Result::HEADERS_COMPLETE:
+            if(_request.hasBody())
+              changeState(State::READING_REQUEST_BODY);
+            break;
 
-      _currentLine.add(*this);
+          case HttpRequestParser::Result::BODY:
+            if(_requestBody)
+              _requestBody->write(_request.getBody().ptr,_request.getBody().length);
+            break;
 
-      if(_currentLine.ready()) {
+          case HttpRequestParser::Result::MESSAGE_COMPLETE:
+            changeState(State::WRITING_BEGIN);
+            break;
 
-        if(_currentLine.length()==0) {
-          if(_contentLength>0)
-            changeState(State::READING_REQUEST_BODY);                       // there's a body to read
-          else
-            changeState(State::WRITING_BEGIN);                              // zero length = request complete
-        }
-        else {
-          processRequestHeader(_currentLine);                               // got a header, see if we care about it
-          static_cast<TImpl *>(this)->handleRequestHeader(_currentLine);    // notify the subclass
+          default:                // malformed or too large, we can't continue with this client
+            delete this;
+            return true;
         }
-
-        _currentLine.reset();                                               // ready for reading next header
       }
     }
 
 
     /**
-     * Read the request body
+     * Receive whatever is available from the connection into the free space in the request buffer
+     * @return true if some data was received
      */
 
     template<class TImpl>
-    inline void HttpServerConnection<TImpl>::readRequestBody() {
-
-      uint8_t buf[100];
-      uint32_t size,actuallyReceived;
-
-      // loop until we've read all
-
-      while(_contentLength && getDataAvailable()) {
-
-        // read a chunk
-
-        size=std::min((uint32_t)sizeof(buf),_contentLength);
+    inline bool HttpServerConnection<TImpl>::fillRequestBuffer() {
 
-        if(!receive(buf,size,actuallyReceived,0))
-          return;
+      char *ptr;
+      uint16_t space;
+      uint32_t available,actuallyReceived;
 
-        // write or discard
+      if((available=getDataAvailable())==0)
+        return false;
 
-        if(_requestBody)
-          _requestBody->write(buf,actuallyReceived);
+      ptr=_request.getWritePointer(space);
 
-        // reduce data to read
+      if(!receive(ptr,std::min(available,static_cast<uint32_t>(space)),actuallyReceived,0) || actuallyReceived==0)
+        return false;
 
-        _contentLength-=size;
-      }
+      _request.commit(actuallyReceived);
+      return true;
     }
 
 
@@ -290,32 +227,46 @@ namespace stm32plus {
 
         // any more data to write?
 
-        if(_output.completed()) {
+        if(_output.completed())
+          return responseCompleted();
+      }
 
-          _requestsServed++;
+      return true;
+    }
 
-          // if this is not HTTP/1.1 or we have served the max number of connections then close the connection
 
-          if(strcasecmp(_version.c_str(),"HTTP/1.1")!=0 ||
-             !_params.http_version11 ||
-             (_params.http_maxRequestsPerConnection && _requestsServed>=_params.http_maxRequestsPerConnection)) {
+    /**
+     * The response has been completely written. Close the connection or get ready for the next request.
+     * @return true always: we don't want to ever abandon the client's wait() call
+     */
 
-            delete this;
-            return true;
-          }
+    template<class TImpl>
+    inline bool HttpServerConnection<TImpl>::responseCompleted() {
 
-          // reset and move on to next request from client
+      _requestsServed++;
 
-          _contentLength=0;
+      // if this is not HTTP/1.1 or we have served the max number of connections then close the connection
 
-          _action.clear();
-          _uri.clear();
-          _version.clear();
+      if(!isKeepAlive() ||
+         (_params.http_maxRequestsPerConnection && _requestsServed>=_params.http_maxRequestsPerConnection)) {
 
-          changeState(State::READING_REQUEST_LINE);
-        }
+        delete this;
+        return true;
       }
 
+      // reset and move on to next request from client
+
+      _action=HttpStringSpan();
+      _uri="";
+      _version=HttpVersion::HTTP_1_0;
+
+      changeState(State::READING_REQUEST_LINE);
+
+      // the client may have pipelined the next request, it's already in the buffer
+
+      if(_request.hasBufferedData())
+        return handleRead();
+
       return true;
     }
 
@@ -332,22 +283,26 @@ namespace stm32plus {
 
 
     /**
-     * Process an incoming request header
-     * @param header The header, as supplied by the client
+     * Check if the connection will be kept open after this request. The server must permit
+     * HTTP/1.1 and the client must have asked for keep-alive, either by default in HTTP/1.1
+     * or explicitly in HTTP/1.0.
+     * @return true if the connection will be kept open
      */
 
     template<class TImpl>
-    inline void HttpServerConnection<TImpl>::processRequestHeader(const std::string& header) {
+    inline bool HttpServerConnection<TImpl>::isKeepAlive() const {
+      return _params.http_version11 && _request.isKeepAlive();
+    }
 
-      std::string::size_type pos;
 
-      // we only care about Content-Length since the client may be doing a POST
+    /**
+     * Get the HTTP version string to send back in the status line
+     * @return "HTTP/1.1" or "HTTP/1.0"
+     */
 
-      if(!strcasecmp(header.c_str(),"Content-Length:")) {
-        for(pos=15;pos!=header.length() && isspace(header[pos]);pos++);
-        if(pos!=header.length())
-          _contentLength=atoi(header.c_str()+pos);
-      }
+    template<class TImpl>
+    inline const char *HttpServerConnection<TImpl>::getVersionString() const {
+      return _version==HttpVersion::HTTP_1_1 ? "HTTP/1.1" : "HTTP/1.0";
     }
 
 
@@ -358,13 +313,23 @@ namespace stm32plus {
 
     template<class TImpl>
     inline void HttpServerConnection<TImpl>::addConnectionHeader(std::string& response) {
+      response+=getConnectionHeader();
+    }
+
 
-      if(!strcasecmp(_version.c_str(),"HTTP/1.1") &&
-          _params.http_version11 &&
+    /**
+     * Get the Connection: close/keep-alive header line for the current response
+     * @return The CRLF terminated header line
+     */
+
+    template<class TImpl>
+    inline const char *HttpServerConnection<TImpl>::getConnectionHeader() const {
+
+      if(isKeepAlive() &&
           (_params.http_maxRequestsPerConnection==0 || _requestsServed!=_params.http_maxRequestsPerConnection-1))
-        response+="Connection: keep-alive\r\n";
+        return "Connection: keep-alive\r\n";
       else
-        response+="Connection: close\r\n";
+        return "Connection: close\r\n";
     }
 
 
@@ -376,13 +341,12 @@ namespace stm32plus {
     template<class TImpl>
     inline void HttpServerConnection<TImpl>::addContentTypeHeader(std::string& response) {
 
-      std::string::size_type pos;
       const char *ext;
 
-      if((pos=_uri.find_last_of('.'))==std::string::npos)
+      if((ext=strrchr(_uri,'.'))==nullptr)
         return;       // not found
 
-      ext=&_uri.c_str()[pos+1];
+      ext++;
 
       if(!strcasecmp(ext,"htm") || !strcasecmp(ext,"html"))
         addContentTypeHeader(response,"text/html");
@@ -433,35 +397,5 @@ namespace stm32plus {
       response+=buffer;
       response+="\r\n";
     }
-
-
-    /**
-     * Decode the URI by replacing %xx chars
-     * @param uri
-     * @return
-     */
-
-    template<class TImpl>
-    inline std::string HttpServerConnection<TImpl>::decodeUri(const std::string& uri) {
-
-      std::string ret;
-      std::string::size_type i;
-      uint8_t ch;
-
-      ret.reserve(uri.length());
-
-      for(i=0;i<uri.length();i++) {
-
-        if(uri[i]=='%' && i<=uri.length()-3) {
-
-          ch=((uri[i+1]-'0')*16)+(uri[i+2]-'0');
-          ret+=static_cast<char>(ch);
-          i+=2;
-        }
-        else
-          ret+=uri[i];
-      }
-      return ret;
-    }
   }
 }
@@ -0,0 +1,44 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * One stored encoding of a static asset. The response headers that never change (Content-Type,
+     * ETag, Cache-Control, Content-Encoding...) are generated at build time so nothing needs to be
+     * formatted at runtime except the status line, Content-Length and Connection.
+     *
+     * If the body is memory mapped (internal flash, or external flash on a memory mapped bus) then
+     * 'body' points at it and it's sent in-place. If 'body' is nullptr then the body is read on
+     * demand from offset 'storageOffset' in external storage such as SPI flash or a FAT file.
+     */
+
+    struct HttpStaticAssetRepresentation {
+      const char *headers;                ///< CRLF terminated header lines, nullptr if this representation doesn't exist
+      const char *etag;                   ///< the quoted entity tag, e.g. "\"5d41402a\""
+      const uint8_t *body;                ///< the memory mapped body, or nullptr
+      uint32_t storageOffset;             ///< offset of the body in external storage when 'body' is nullptr
+      uint32_t size;                      ///< the size of the body in bytes
+    };
+
+
+    /**
+     * A static asset in a bundle. An asset may be stored gzip-compressed, uncompressed or both.
+     * The gzip representation is served to clients that accept it. Instances are usually
+     * const and generated into flash by utils/httpassets/httpassets.py.
+     */
+
+    struct HttpStaticAsset {
+      const char *path;                               ///< the URI path, e.g. "/index.html"
+      HttpStaticAssetRepresentation identity;         ///< the uncompressed body
+      HttpStaticAssetRepresentation gzip;             ///< the gzip-compressed body
+    };
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * A read-only set of static assets. The asset array must be sorted by path in strcmp()
+     * order. The generator does this so that lookups can use a binary search.
+     */
+
+    class HttpStaticAssetBundle {
+
+      protected:
+        const HttpStaticAsset *_assets;
+        uint16_t _assetCount;
+
+      public:
+        HttpStaticAssetBundle(const HttpStaticAsset *assets,uint16_t assetCount);
+
+        const HttpStaticAsset *find(const char *path) const;
+        uint16_t getAssetCount() const;
+    };
+
+
+    /**
+     * Constructor
+     * @param assets The array of assets, sorted by path
+     * @param assetCount The number of assets in the array
+     */
+
+    inline HttpStaticAssetBundle::HttpStaticAssetBundle(const HttpStaticAsset *assets,uint16_t assetCount)
+      : _assets(assets),
+        _assetCount(assetCount) {
+    }
+
+
+    /**
+     * Find an asset by path. A request for "/" is treated as a request for "/index.html". Any
+     * query string is ignored.
+     * @param path The URI path, optionally followed by a query string
+     * @return The asset, or nullptr if not found
+     */
+
+    inline const HttpStaticAsset *HttpStaticAssetBundle::find(const char *path) const {
+
+      uint16_t first,last,mid;
+      size_t len;
+      int cmp;
+
+      len=strcspn(path,"?");
+
+      if(len==1 && path[0]=='/') {
+        path="/index.html";
+        len=strlen(path);
+      }
+
+      first=0;
+      last=_assetCount;
+
+      while(first<last) {
+
+        mid=(first+last)/2;
+
+        // compare the path part only. a shorter path that matches the start of the asset path
+        // sorts before it, as it does with strcmp()
+
+        if((cmp=strncmp(path,_assets[mid].path,len))==0) {
+
+          if(_assets[mid].path[len]=='\0')
+            return &_assets[mid];
+
+          cmp=-1;
+        }
+
+        if(cmp<0)
+          last=mid;
+        else
+          first=mid+1;
+      }
+
+      return nullptr;
+    }
+
+
+    /**
+     * Get the number of assets in the bundle
+     * @return The asset count
+     */
+
+    inline uint16_t HttpStaticAssetBundle::getAssetCount() const {
+      return _assetCount;
+    }
+  }
+}
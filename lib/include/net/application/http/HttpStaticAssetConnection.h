@@ -0,0 +1,627 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * An HTTP connection that serves GET and HEAD requests from a read-only HttpStaticAssetBundle.
+     * Derive your connection class from this instead of HttpServerConnection, supply handleClosed()
+     * and handleCallback() as usual, and pass the bundle to the constructor.
+     *
+     * Responses are built in a fixed header buffer from the precomputed headers in the bundle and
+     * memory mapped bodies are transmitted in-place, so nothing is allocated per request. The
+     * following are supported:
+     *
+     *  - gzip bodies are served to clients that send "Accept-Encoding: gzip".
+     *  - "If-None-Match" is compared with the representation's ETag and a 304 sent on a match.
+     *  - A single "Range: bytes=" range is honoured with a 206 or 416 response. Multiple ranges
+     *    are ignored and the whole body is sent.
+     *
+     * If a body is not memory mapped then the subclass must supply:
+     *
+     *   bool readAssetBody(const HttpStaticAssetRepresentation& rep,uint32_t offset,void *buffer,uint32_t size,uint32_t& actuallyRead);
+     *
+     * and set http_assetReadBufferSize to the size of the read buffer.
+     *
+     * A request for a path that isn't in the bundle is passed to the subclass's handleUnknownAsset().
+     * The default sends a 404. A subclass that wants to serve dynamic content can instead return
+     * true after adding the response to _output as with a plain HttpServerConnection.
+     */
+
+    template<class TImpl>
+    class HttpStaticAssetConnection : public HttpServerConnection<TImpl> {
+
+      public:
+
+        typedef HttpServerConnection<TImpl> HttpServerConnectionType;
+        typedef typename HttpServerConnectionType::State State;
+
+
+        /**
+         * Parameters for this class
+         */
+
+        struct Parameters : HttpServerConnectionType::Parameters {
+
+          uint16_t http_assetHeaderBufferSize;    ///< size of the response header buffer, spare space carries the start of the body. Default is 512.
+          uint16_t http_assetReadBufferSize;      ///< size of the buffer for bodies that are not memory mapped. Default is 0 (all bodies are memory mapped).
+
+          Parameters() {
+            http_assetHeaderBufferSize=512;
+            http_assetReadBufferSize=0;
+          }
+        };
+
+      protected:
+        const HttpStaticAssetBundle& _bundle;
+        const HttpStaticAsset *_asset;                  // asset found for the current request
+        const HttpStaticAssetRepresentation *_representation;   // representation being sent, nullptr if not sending an asset
+
+        scoped_array<char> _header;                     // the response header
+        uint16_t _headerSize;
+        uint16_t _headerLength;
+        uint16_t _headerPos;
+
+        scoped_array<uint8_t> _readBuffer;              // for bodies that are not memory mapped
+        uint16_t _readBufferSize;
+        uint16_t _readBufferPos;
+        uint16_t _readBufferLength;
+
+        uint32_t _bodyPos;                              // next body byte to send
+        uint32_t _bodyEnd;                              // one past the last body byte to send
+
+        uint32_t _rangeFirst;                           // the requested range
+        uint32_t _rangeLast;
+        bool _rangeRequested;
+        bool _rangeSuffix;
+
+        bool _acceptGzip;
+        bool _identityNotModified;
+        bool _gzipNotModified;
+
+      protected:
+        HttpStaticAssetConnection(const Parameters& params,const HttpStaticAssetBundle& bundle);
+
+        bool prepareResponse();
+        void prepareStatusResponse(const char *status,const char *extraHeaders);
+        bool writeStaticResponse();
+        bool writeBody(uint32_t maxSize);
+
+        void appendHeader(const char *str);
+        void appendHeader(uint32_t value);
+
+        void parseRange(const HttpStringSpan& value);
+        static bool acceptsGzip(const HttpStringSpan& value);
+        static bool etagMatches(const HttpStringSpan& value,const HttpStaticAssetRepresentation& rep);
+
+      public:
+        typename HttpServerConnectionType::State handleStateChange(State newState);
+        void handleRequestHeader(const HttpStringSpan& name,const HttpStringSpan& value);
+        bool handleUnknownAsset();
+        bool readAssetBody(const HttpStaticAssetRepresentation& rep,uint32_t offset,void *buffer,uint32_t size,uint32_t& actuallyRead);
+
+        bool handleWrite();
+    };
+
+
+    /**
+     * Constructor
+     * @param params The parameters
+     * @param bundle The assets to serve. Must live as long as this connection.
+     */
+
+    template<class TImpl>
+    inline HttpStaticAssetConnection<TImpl>::HttpStaticAssetConnection(const Parameters& params,const HttpStaticAssetBundle& bundle)
+      : HttpServerConnectionType(params),
+        _bundle(bundle),
+        _asset(nullptr),
+        _representation(nullptr),
+        _header(new char[params.http_assetHeaderBufferSize]),
+        _headerSize(params.http_assetHeaderBufferSize),
+        _headerLength(0),
+        _headerPos(0),
+        _readBufferSize(params.http_assetReadBufferSize),
+        _readBufferPos(0),
+        _readBufferLength(0) {
+
+      if(_readBufferSize)
+        _readBuffer.reset(new uint8_t[_readBufferSize]);
+    }
+
+
+    /**
+     * State change notification from the base class. The asset is looked up when the request line
+     * has been received so that the conditional headers can be checked against it as they arrive,
+     * and the response is prepared when the base class is ready to write.
+     * @param newState The proposed new state
+     * @return The actual new state
+     */
+
+    template<class TImpl>
+    inline typename HttpStaticAssetConnection<TImpl>::State HttpStaticAssetConnection<TImpl>::handleStateChange(State newState) {
+
+      if(newState==State::READING_REQUEST_HEADERS) {
+
+        _asset=_bundle.find(this->_uri);
+        _representation=nullptr;
+        _rangeRequested=false;
+        _acceptGzip=false;
+        _identityNotModified=false;
+        _gzipNotModified=false;
+      }
+      else if(newState==State::WRITING_RESPONSE) {
+        if(!prepareResponse())
+          _representation=nullptr;
+      }
+
+      return newState;
+    }
+
+
+    /**
+     * A request header has arrived. Note the ones that affect the response.
+     * @param name The header name
+     * @param value The header value
+     */
+
+    template<class TImpl>
+    inline void HttpStaticAssetConnection<TImpl>::handleRequestHeader(const HttpStringSpan& name,const HttpStringSpan& value) {
+
+      if(_asset==nullptr)
+        return;
+
+      if(name.equalsIgnoreCase("Accept-Encoding"))
+        _acceptGzip=acceptsGzip(value);
+      else if(name.equalsIgnoreCase("If-None-Match")) {
+        _identityNotModified=_asset->identity.headers && etagMatches(value,_asset->identity);
+        _gzipNotModified=_asset->gzip.headers && etagMatches(value,_asset->gzip);
+      }
+      else if(name.equalsIgnoreCase("Range"))
+        parseRange(value);
+    }
+
+
+    /**
+     * Build the response for the current request
+     * @return true if a static response is ready, false if the subclass added a response to _output
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::prepareResponse() {
+
+      HttpMethod method;
+      bool notModified;
+      uint32_t size;
+
+      // only GET and HEAD are supported
+
+      if(!this->_request.getMethod(method) || (method!=HttpMethod::GET && method!=HttpMethod::HEAD)) {
+        prepareStatusResponse(" 405 Method Not Allowed\r\n","Allow: GET, HEAD\r\n");
+        return true;
+      }
+
+      if(_asset==nullptr) {
+        if(static_cast<TImpl *>(this)->handleUnknownAsset())
+          return false;
+
+        prepareStatusResponse(" 404 Not Found\r\n",nullptr);
+        return true;
+      }
+
+      // choose the representation. if the client doesn't accept gzip and there's no uncompressed
+      // version then we send gzip anyway because every browser can decode it.
+
+      if(_asset->gzip.headers && (_acceptGzip || _asset->identity.headers==nullptr)) {
+        _representation=&_asset->gzip;
+        notModified=_gzipNotModified;
+      }
+      else {
+        _representation=&_asset->identity;
+        notModified=_identityNotModified;
+      }
+
+      size=_representation->size;
+      _headerLength=_headerPos=0;
+      _bodyPos=0;
+      _bodyEnd=size;
+
+      appendHeader(this->getVersionString());
+
+      if(notModified) {
+        appendHeader(" 304 Not Modified\r\n");
+        _bodyEnd=0;
+      }
+      else if(_rangeRequested) {
+
+        // resolve the range against the body size
+
+        if(_rangeSuffix) {
+          _bodyPos=_rangeLast>=size ? 0 : size-_rangeLast;
+          _rangeLast=size-1;
+        }
+        else {
+          _bodyPos=_rangeFirst;
+          _rangeLast=std::min(_rangeLast,size-1);
+        }
+
+        if(_bodyPos>=size) {
+
+          appendHeader(" 416 Range Not Satisfiable\r\nContent-Range: bytes */");
+          appendHeader(size);
+          appendHeader("\r\n");
+
+          _bodyPos=_bodyEnd=0;
+        }
+        else {
+
+          appendHeader(" 206 Partial Content\r\nContent-Range: bytes ");
+          appendHeader(_bodyPos);
+          appendHeader("-");
+          appendHeader(_rangeLast);
+          appendHeader("/");
+          appendHeader(size);
+          appendHeader("\r\n");
+
+          _bodyEnd=_rangeLast+1;
+        }
+      }
+      else
+        appendHeader(" 200 OK\r\n");
+
+      appendHeader(_representation->headers);
+
+      // a 304 has no body so it does not get a Content-Length
+
+      if(!notModified) {
+        appendHeader("Content-Length: ");
+        appendHeader(_bodyEnd-_bodyPos);
+        appendHeader("\r\n");
+      }
+
+      appendHeader(this->getConnectionHeader());
+      appendHeader("\r\n");
+
+      // HEAD gets the headers only
+
+      if(method==HttpMethod::HEAD)
+        _bodyPos=_bodyEnd;
+
+      // the start of a memory mapped body rides along in the spare header buffer space so
+      // that small assets go out in a single send
+
+      if(_representation->body && _headerLength<_headerSize) {
+
+        size=std::min(static_cast<uint32_t>(_headerSize-_headerLength),_bodyEnd-_bodyPos);
+
+        memcpy(_header.get()+_headerLength,_representation->body+_bodyPos,size);
+        _headerLength+=size;
+        _bodyPos+=size;
+      }
+
+      _readBufferPos=_readBufferLength=0;
+      return true;
+    }
+
+
+    /**
+     * Prepare a response that has no body
+     * @param status The status code and text, CRLF terminated
+     * @param extraHeaders Additional CRLF terminated header lines, or nullptr
+     */
+
+    template<class TImpl>
+    inline void HttpStaticAssetConnection<TImpl>::prepareStatusResponse(const char *status,const char *extraHeaders) {
+
+      // point at an empty representation so that handleWrite() knows we're sending
+
+      static const HttpStaticAssetRepresentation empty={ "",nullptr,nullptr,0,0 };
+
+      _representation=&empty;
+      _headerLength=_headerPos=0;
+      _bodyPos=_bodyEnd=0;
+
+      appendHeader(this->getVersionString());
+      appendHeader(status);
+
+      if(extraHeaders)
+        appendHeader(extraHeaders);
+
+      appendHeader("Content-Length: 0\r\n");
+      appendHeader(this->getConnectionHeader());
+      appendHeader("\r\n");
+    }
+
+
+    /**
+     * Append to the header buffer. Output that doesn't fit is dropped and the header length is
+     * set past the end of the buffer so that writeStaticResponse() can detect the overflow.
+     * @param str The string to append
+     */
+
+    template<class TImpl>
+    inline void HttpStaticAssetConnection<TImpl>::appendHeader(const char *str) {
+
+      uint16_t len;
+
+      len=strlen(str);
+
+      if(_headerLength+len<=_headerSize)
+        memcpy(_header.get()+_headerLength,str,len);
+
+      _headerLength+=len;
+    }
+
+
+    /**
+     * Append a decimal number to the header buffer
+     * @param value The number to append
+     */
+
+    template<class TImpl>
+    inline void HttpStaticAssetConnection<TImpl>::appendHeader(uint32_t value) {
+
+      char buffer[12];
+
+      StringUtil::modp_uitoa10(value,buffer);
+      appendHeader(buffer);
+    }
+
+
+    /**
+     * Some data is ready for writing. Send the static response if there is one, otherwise let
+     * the base class write _output.
+     * @return true always: we don't want to ever abandon the client's wait() call
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::handleWrite() {
+
+      if(this->_state!=State::WRITING_RESPONSE || _representation==nullptr)
+        return HttpServerConnectionType::handleWrite();
+
+      if(!writeStaticResponse()) {
+        delete this;
+        return true;
+      }
+
+      if(_headerPos==_headerLength && _bodyPos==_bodyEnd) {
+        _representation=nullptr;
+        return this->responseCompleted();
+      }
+
+      return true;
+    }
+
+
+    /**
+     * Send the next part of the static response. At most one transmit window's worth of data
+     * is sent so that other connections get a turn.
+     * @return false if the connection failed
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::writeStaticResponse() {
+
+      uint32_t actuallySent,maxSize;
+
+      if(_headerLength>_headerSize)
+        return false;                 // the precomputed headers don't fit, increase http_assetHeaderBufferSize
+
+      maxSize=std::max(this->getTransmitWindowSize(),this->getRemoteMss());
+
+      // the header goes out first
+
+      if(_headerPos!=_headerLength) {
+
+        if(!this->send(_header.get()+_headerPos,_headerLength-_headerPos,actuallySent,0))
+          return false;
+
+        _headerPos+=actuallySent;
+        return true;
+      }
+
+      return _bodyPos==_bodyEnd || writeBody(maxSize);
+    }
+
+
+    /**
+     * Send some of the body
+     * @param maxSize The maximum number of bytes to send
+     * @return false if the connection failed
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::writeBody(uint32_t maxSize) {
+
+      uint32_t actuallySent,actuallyRead,count;
+
+      count=std::min(maxSize,_bodyEnd-_bodyPos);
+
+      // memory mapped bodies are sent in-place
+
+      if(_representation->body) {
+
+        if(!this->send(_representation->body+_bodyPos,count,actuallySent,0))
+          return false;
+
+        _bodyPos+=actuallySent;
+        return true;
+      }
+
+      // other bodies are read through the buffer
+
+      if(_readBufferSize==0)
+        return false;
+
+      if(_readBufferPos==_readBufferLength) {
+
+        count=std::min(count,static_cast<uint32_t>(_readBufferSize));
+
+        if(!static_cast<TImpl *>(this)->readAssetBody(*_representation,_bodyPos,_readBuffer.get(),count,actuallyRead) || actuallyRead==0)
+          return false;
+
+        _readBufferPos=0;
+        _readBufferLength=actuallyRead;
+      }
+
+      if(!this->send(_readBuffer.get()+_readBufferPos,_readBufferLength-_readBufferPos,actuallySent,0))
+        return false;
+
+      _readBufferPos+=actuallySent;
+      _bodyPos+=actuallySent;
+      return true;
+    }
+
+
+    /**
+     * Parse a Range header. Only a single byte range is supported.
+     * e.g. "bytes=0-499", "bytes=500-", "bytes=-500"
+     * @param value The header value
+     */
+
+    template<class TImpl>
+    inline void HttpStaticAssetConnection<TImpl>::parseRange(const HttpStringSpan& value) {
+
+      const char *ptr;
+      char *end;
+
+      _rangeRequested=false;
+
+      if(value.length<7 || strncasecmp(value.ptr,"bytes=",6)!=0 || strchr(value.ptr,',')!=nullptr)
+        return;
+
+      ptr=value.ptr+6;
+      _rangeSuffix=*ptr=='-';
+
+      if(_rangeSuffix) {
+
+        // last N bytes
+
+        _rangeLast=strtoul(ptr+1,&end,10);
+
+        if(end==ptr+1 || *end!='\0' || _rangeLast==0)
+          return;
+      }
+      else {
+
+        // first to last, or first to the end
+
+        _rangeFirst=strtoul(ptr,&end,10);
+
+        if(end==ptr || *end!='-')
+          return;
+
+        ptr=end+1;
+
+        if(*ptr=='\0')
+          _rangeLast=UINT32_MAX;
+        else {
+          _rangeLast=strtoul(ptr,&end,10);
+
+          if(end==ptr || *end!='\0' || _rangeLast<_rangeFirst)
+            return;
+        }
+      }
+
+      _rangeRequested=true;
+    }
+
+
+    /**
+     * Check if an Accept-Encoding header accepts gzip. A q-value of zero rejects it.
+     * @param value The header value
+     * @return true if gzip is acceptable
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::acceptsGzip(const HttpStringSpan& value) {
+
+      const char *ptr;
+
+      for(ptr=value.ptr;*ptr;) {
+
+        // skip separators
+
+        while(*ptr==' ' || *ptr==',')
+          ptr++;
+
+        if(strncasecmp(ptr,"gzip",4)==0 && (ptr[4]=='\0' || ptr[4]==',' || ptr[4]==';' || ptr[4]==' ')) {
+
+          ptr+=4;
+
+          while(*ptr==' ')
+            ptr++;
+
+          if(*ptr!=';')
+            return true;
+
+          // check for q=0
+
+          for(ptr++;*ptr==' ';ptr++);
+
+          if((ptr[0]!='q' && ptr[0]!='Q') || ptr[1]!='=')
+            return true;
+
+          for(ptr+=2;*ptr=='0' || *ptr=='.';ptr++);
+          return *ptr>='1' && *ptr<='9';
+        }
+
+        // move to the next coding
+
+        while(*ptr && *ptr!=',')
+          ptr++;
+      }
+
+      return false;
+    }
+
+
+    /**
+     * Check if an If-None-Match header matches a representation's ETag. Weak comparison is used
+     * so W/ prefixes are ignored.
+     * @param value The header value, a list of quoted entity tags or "*"
+     * @param rep The representation
+     * @return true if there's a match
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::etagMatches(const HttpStringSpan& value,const HttpStaticAssetRepresentation& rep) {
+
+      if(value.equals("*"))
+        return true;
+
+      return rep.etag!=nullptr && strstr(value.ptr,rep.etag)!=nullptr;
+    }
+
+
+    /**
+     * Default handler for a path that isn't in the bundle
+     * @return false to send a 404
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::handleUnknownAsset() {
+      return false;
+    }
+
+
+    /**
+     * Default body reader for bodies that are not memory mapped. Subclasses that store their
+     * bundle in external storage must replace this.
+     * @return false
+     */
+
+    template<class TImpl>
+    inline bool HttpStaticAssetConnection<TImpl>::readAssetBody(const HttpStaticAssetRepresentation& /* rep */,uint32_t /* offset */,void * /* buffer */,uint32_t /* size */,uint32_t& actuallyRead) {
+      actuallyRead=0;
+      return false;
+    }
+  }
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * A pointer and length referring to text held in someone else's buffer. The spans handed
+     * out by HttpRequestParser are also nul-terminated in place so ptr can be used as a C string.
+     */
+
+    struct HttpStringSpan {
+
+      const char *ptr;
+      uint16_t length;
+
+
+      /**
+       * Constructor
+       */
+
+      HttpStringSpan()
+        : ptr(""),
+          length(0) {
+      }
+
+
+      /**
+       * Set the span
+       * @param p The first character
+       * @param len The number of characters
+       */
+
+      void set(const char *p,uint16_t len) {
+        ptr=p;
+        length=len;
+      }
+
+
+      /**
+       * Case sensitive comparison with a C string
+       * @param str The string to compare with
+       * @return true if equal
+       */
+
+      bool equals(const char *str) const {
+        return strlen(str)==length && memcmp(ptr,str,length)==0;
+      }
+
+
+      /**
+       * Case insensitive comparison with a C string
+       * @param str The string to compare with
+       * @return true if equal
+       */
+
+      bool equalsIgnoreCase(const char *str) const {
+        return strlen(str)==length && strncasecmp(ptr,str,length)==0;
+      }
+    };
+  }
+}
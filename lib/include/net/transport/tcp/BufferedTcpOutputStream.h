@@ -0,0 +1,202 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+
+    /**
+     * A buffered output stream for writing to a TCP connection. Small writes, such as those made
+     * by TextOutputStream and the << operators, are coalesced in a local buffer and only sent
+     * when the buffer is full or when flush() is called. Writes that are larger than the buffer
+     * bypass it when it is empty so that bulk data is not copied.
+     *
+     * This is the Nagle rule applied at the stream level. TcpConnection::send() waits for its data
+     * to be acknowledged before it returns so there is never any unacknowledged data in flight when
+     * the application writes, and the stream must hold the tail back itself (like a TCP_CORK)
+     * until the caller says that the message is complete by calling flush(). close() and the
+     * destructor also flush.
+     *
+     * Each send waits for its acknowledgement so the buffer should hold several segments to keep
+     * the round trips down. The default is the transmit window when the stream is created, in
+     * whole multiples of the remote MSS, limited to MAX_DEFAULT_SEGMENTS segments.
+     */
+
+    class BufferedTcpOutputStream : public TcpOutputStream {
+
+      public:
+        enum {
+          MAX_DEFAULT_SEGMENTS = 4      ///< upper limit on the default buffer size, in segments
+        };
+
+      protected:
+        scoped_array<uint8_t> _buffer;
+        uint16_t _bufferSize;
+        uint16_t _bufferPos;
+
+      public:
+        BufferedTcpOutputStream(TcpConnection& conn,uint16_t bufferSize=0);
+        virtual ~BufferedTcpOutputStream();
+
+        uint16_t getBufferedSize() const;
+
+        // overrides from OutputStream
+
+        virtual bool write(uint8_t c) override;
+        virtual bool write(const void *buffer,uint32_t size) override;
+        virtual bool flush() override;
+        virtual bool close() override;
+    };
+
+
+    /**
+     * Constructor
+     * @param conn The connection. It must have been established so that the remote MSS is known.
+     * @param bufferSize The size of the coalescing buffer. Zero (the default) means size it from the transmit window.
+     */
+
+    inline BufferedTcpOutputStream::BufferedTcpOutputStream(TcpConnection& conn,uint16_t bufferSize)
+      : TcpOutputStream(conn),
+        _bufferPos(0) {
+
+      uint16_t mss,segments;
+
+      if(bufferSize==0) {
+
+        // whole segments that fit in the window, at least one and not too many
+
+        mss=conn.getRemoteMss();
+        segments=conn.getTransmitWindowSize()/mss;
+
+        if(segments==0)
+          segments=1;
+        else if(segments>MAX_DEFAULT_SEGMENTS)
+          segments=MAX_DEFAULT_SEGMENTS;
+
+        bufferSize=segments*mss;
+      }
+
+      _bufferSize=bufferSize;
+      _buffer.reset(new uint8_t[_bufferSize]);
+    }
+
+
+    /**
+     * Destructor, push out anything still buffered
+     */
+
+    inline BufferedTcpOutputStream::~BufferedTcpOutputStream() {
+      flush();
+    }
+
+
+    /**
+     * Get the number of bytes waiting in the buffer
+     * @return The buffered byte count
+     */
+
+    inline uint16_t BufferedTcpOutputStream::getBufferedSize() const {
+      return _bufferPos;
+    }
+
+
+    /**
+     * Write a single byte into the buffer
+     * @param c The byte to write
+     * @return true if it worked
+     */
+
+    inline bool BufferedTcpOutputStream::write(uint8_t c) {
+
+      _buffer[_bufferPos++]=c;
+
+      if(_bufferPos==_bufferSize)
+        return flush();
+
+      return true;
+    }
+
+
+    /**
+     * Write a stream of bytes. Whole buffers are sent as soon as they are available and
+     * any remainder is held in the buffer.
+     * @param buffer The buffer address
+     * @param size The number of bytes to write
+     */
+
+    inline bool BufferedTcpOutputStream::write(const void *buffer,uint32_t size) {
+
+      const uint8_t *ptr;
+      uint32_t count;
+
+      ptr=reinterpret_cast<const uint8_t *>(buffer);
+
+      while(size) {
+
+        // if nothing is buffered then whole buffers can go straight out from the caller's memory
+
+        if(_bufferPos==0 && size>=_bufferSize) {
+
+          count=size-(size % _bufferSize);
+
+          if(!TcpOutputStream::write(ptr,count))
+            return false;
+        }
+        else {
+
+          // top up the buffer and send it if it's full
+
+          count=std::min(size,static_cast<uint32_t>(_bufferSize-_bufferPos));
+
+          memcpy(_buffer.get()+_bufferPos,ptr,count);
+          _bufferPos+=count;
+
+          if(_bufferPos==_bufferSize && !flush())
+            return false;
+        }
+
+        ptr+=count;
+        size-=count;
+      }
+
+      return true;
+    }
+
+
+    /**
+     * Send whatever is in the buffer
+     * @return true if it worked
+     */
+
+    inline bool BufferedTcpOutputStream::flush() {
+
+      uint16_t count;
+
+      if(_bufferPos==0)
+        return true;
+
+      // the buffer is emptied even on failure, there's nothing to retry into
+
+      count=_bufferPos;
+      _bufferPos=0;
+
+      return TcpOutputStream::write(_buffer.get(),count);
+    }
+
+
+    /**
+     * Flush the buffer. The underlying connection must be deleted to close it
+     * @return true if the flush worked
+     */
+
+    inline bool BufferedTcpOutputStream::close() {
+      return flush();
+    }
+  }
+}
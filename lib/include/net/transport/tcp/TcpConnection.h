@@ -128,6 +128,7 @@ namespace stm32plus {
 
         uint16_t getTransmitWindowSize() const;
         uint16_t getDataAvailable() const;
+        uint16_t getRemoteMss() const;
 
         uint32_t getLastActiveTime() const;
 
@@ -263,6 +264,17 @@ namespace stm32plus {
     }
 
 
+    /**
+     * Get the maximum segment size advertised by the remote end, or the RFC default of 536 if it
+     * did not send one. Writers that want to fill whole segments should buffer this much data.
+     * @return The remote MSS
+     */
+
+    inline uint16_t TcpConnection::getRemoteMss() const {
+      return _remoteMss;
+    }
+
+
     /**
      * Try to abort this connection by sending an RST to the other end.
      * @return true if it was in an abortable state and an RST has been sent
@@ -0,0 +1,99 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * A TaskSignal raised when a TCP connection has buffered data for the application or has
+     * closed. A task can use this instead of the blocking receive() so that other tasks run
+     * while the connection is idle:
+     *
+     *   TASK_AWAIT(_dataReady);
+     *
+     *   if(_connection.getDataAvailable())
+     *     _connection.receive(_buffer,sizeof(_buffer),_actuallyReceived);
+     *   else if(_connection.isRemoteEndClosed())
+     *     ...
+     *
+     * The signal must be destroyed before the connection.
+     */
+
+    class TcpConnectionTaskSignal : public TaskSignal {
+
+      protected:
+        TcpConnection& _connection;
+
+      protected:
+        void onDataReady(TcpConnectionDataReadyEvent& event);
+        void onClosed(TcpConnectionClosedEvent& event);
+
+      public:
+        TcpConnectionTaskSignal(TcpConnection& connection);
+        ~TcpConnectionTaskSignal();
+    };
+
+
+    /**
+     * Constructor
+     * @param connection The connection to subscribe to
+     */
+
+    inline TcpConnectionTaskSignal::TcpConnectionTaskSignal(TcpConnection& connection)
+      : _connection(connection) {
+
+      _connection.TcpConnectionDataReadyEventSender.insertSubscriber(
+          TcpConnectionDataReadyEventSourceSlot::bind(this,&TcpConnectionTaskSignal::onDataReady)
+        );
+
+      _connection.TcpConnectionClosedEventSender.insertSubscriber(
+          TcpConnectionClosedEventSourceSlot::bind(this,&TcpConnectionTaskSignal::onClosed)
+        );
+
+      // data that arrived before we subscribed
+
+      if(_connection.getDataAvailable())
+        raise();
+    }
+
+
+    /**
+     * Destructor
+     */
+
+    inline TcpConnectionTaskSignal::~TcpConnectionTaskSignal() {
+
+      _connection.TcpConnectionDataReadyEventSender.removeSubscriber(
+          TcpConnectionDataReadyEventSourceSlot::bind(this,&TcpConnectionTaskSignal::onDataReady)
+        );
+
+      _connection.TcpConnectionClosedEventSender.removeSubscriber(
+          TcpConnectionClosedEventSourceSlot::bind(this,&TcpConnectionTaskSignal::onClosed)
+        );
+    }
+
+
+    /**
+     * Data has been buffered
+     */
+
+    inline void TcpConnectionTaskSignal::onDataReady(TcpConnectionDataReadyEvent& /* event */) {
+      raise();
+    }
+
+
+    /**
+     * The connection has closed
+     */
+
+    inline void TcpConnectionTaskSignal::onClosed(TcpConnectionClosedEvent& /* event */) {
+      raise();
+    }
+  }
+}
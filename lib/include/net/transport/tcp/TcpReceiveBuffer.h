@@ -12,23 +12,25 @@ namespace stm32plus {
 
 
     /**
-     * Simple wrapper for the circular buffer used for received data that ensures
-     * IRQ-safe access to the methods.
+     * The buffer for received data. The network stack writes to it and the application reads
+     * from it, which is the single producer and consumer case handled by SpscRingQueue
+     * without suspending interrupts. The storage is a power of two in size but no more than
+     * the requested size is used, so the advertised receive window is unchanged.
      */
 
     class TcpReceiveBuffer {
 
       protected:
-        volatile circular_buffer<uint8_t> _receiveBuffer;
+        SpscRingQueue<uint8_t> _receiveBuffer;
 
       public:
         TcpReceiveBuffer(uint32_t size);
 
-        void read(uint8_t *output,uint32_t size) volatile;
-        void write(const uint8_t *input,uint32_t size) volatile;
+        void read(uint8_t *output,uint32_t size);
+        void write(const uint8_t *input,uint32_t size);
 
-        uint32_t availableToWrite() const volatile;
-        uint32_t availableToRead() const volatile;
+        uint32_t availableToWrite() const;
+        uint32_t availableToRead() const;
     };
 
 
@@ -41,24 +43,20 @@ namespace stm32plus {
       : _receiveBuffer(size) {
     }
 
-    inline void TcpReceiveBuffer::read(uint8_t *output,uint32_t size) volatile {
-      IrqSuspend suspender;
+    inline void TcpReceiveBuffer::read(uint8_t *output,uint32_t size) {
       _receiveBuffer.read(output,size);
     }
 
 
-    inline void TcpReceiveBuffer::write(const uint8_t *input,uint32_t size) volatile {
-      IrqSuspend suspender;
+    inline void TcpReceiveBuffer::write(const uint8_t *input,uint32_t size) {
       _receiveBuffer.write(input,size);
     }
 
-    inline uint32_t TcpReceiveBuffer::availableToWrite() const volatile {
-      IrqSuspend suspend;
+    inline uint32_t TcpReceiveBuffer::availableToWrite() const {
       return _receiveBuffer.availableToWrite();
     }
 
-    inline uint32_t TcpReceiveBuffer::availableToRead() const volatile {
-      IrqSuspend suspend;
+    inline uint32_t TcpReceiveBuffer::availableToRead() const {
       return _receiveBuffer.availableToRead();
     }
   }
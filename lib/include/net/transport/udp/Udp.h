@@ -17,6 +17,11 @@ namespace stm32plus {
      * Implementation of the UDP protocol over IP. Datagrams are received asynchronously from the IP
      * layer and passed on to the upper layers. Functionality is provided for sending and receiving
      * datagrams synchronously to the caller.
+     *
+     * Any number of UdpSocket objects can be bound to local ports with udpBind(). Each socket
+     * has its own receive ring that is filled directly by the receive path so concurrent services
+     * on different ports don't compete for a single receive buffer. Incoming datagrams are matched
+     * to sockets through a small hash table of bucket chains.
      */
 
     template<class TNetworkLayer>
@@ -31,9 +36,11 @@ namespace stm32plus {
         struct Parameters {
 
           bool udp_sendPortUnreachable;     ///< datagrams sent to ports with no handler will get an ICMP error message (if ICMP is configured in). default is true
+          uint16_t udp_socketTableSize;     ///< number of buckets in the bound socket table. Must be a power of 2. default is 8
 
           Parameters() {
             udp_sendPortUnreachable=true;
+            udp_socketTableSize=8;
           }
         };
 
@@ -45,6 +52,7 @@ namespace stm32plus {
         enum {
           E_TIMED_OUT = 1,    ///< timed out while waiting for data
           E_MSG_SIZE,         ///< data was received, but more is available and has been lost
+          E_PORT_IN_USE       ///< a socket is already bound to this port
         };
 
         DECLARE_EVENT_SOURCE(UdpReceive);
@@ -57,11 +65,16 @@ namespace stm32plus {
         volatile uint16_t *_awaitingBufferSize;       ///< buffer size, updated with actual value
         volatile uint16_t _awaitingDatagramSize;      ///< the actual size received
         volatile IpPacketHeader _ipPacketHeader;      ///< the underlying IP packet header
+        scoped_array<UdpSocket *> _sockets;           ///< bound socket table, chained buckets
+        uint16_t _socketTableMask;                    ///< table size - 1
 
       protected:
         void onReceive(IpPacketEvent& ned);
         void onNotification(NetEventDescriptor& ned);
 
+        UdpSocket *& getSocketBucket(uint16_t portNumber) const;
+        UdpSocket *findSocket(uint16_t portNumber) const;
+
         volatile NetBuffer *_waitForThisBuffer;
 
       public:
@@ -81,6 +94,13 @@ namespace stm32plus {
         bool udpReceive(uint16_t portNumber,void *buffer,uint16_t& size,uint32_t receiveTimeout=0);
         const volatile IpPacketHeader& udpGetIpPacketHeader() const;
         const volatile IpAddress& udpGetRemoteAddress() const;
+
+        // socket functions
+
+        bool udpBind(UdpSocket& socket);
+        void udpUnbind(UdpSocket& socket);
+
+        uint16_t udpSendMany(const UdpSocket& socket,const UdpSocketDatagram *datagrams,uint16_t count);
     };
 
 
@@ -102,6 +122,12 @@ namespace stm32plus {
       _waitForThisBuffer=nullptr;
       _awaiting=false;
 
+      // create the empty socket table
+
+      _socketTableMask=_params.udp_socketTableSize-1;
+      _sockets.reset(new UdpSocket *[_params.udp_socketTableSize]);
+      std::fill_n(_sockets.get(),_params.udp_socketTableSize,nullptr);
+
       // subscribe for receive and notification events from the IP implementation
 
       this->IpReceiveEventSender.insertSubscriber(IpReceiveEventSourceSlot::bind(this,&Udp<TNetworkLayer>::onReceive));
@@ -141,9 +167,23 @@ namespace stm32plus {
 
       UdpDatagram *datagram=reinterpret_cast<UdpDatagram *>(ipe.ipPacket.payload);
 
+      // is there a socket bound to the destination port?
+
+      UdpSocket *socket=findSocket(NetUtil::ntohs(datagram->udp_destinationPort));
+
+      if(socket) {
+
+        socket->push(ipe.ipPacket.header->ip_sourceAddress,
+                     NetUtil::ntohs(datagram->udp_sourcePort),
+                     datagram->udp_data,
+                     NetUtil::ntohs(datagram->udp_length)-UdpDatagram::getHeaderSize());
+
+        handled=true;
+      }
+
       // are we waiting for a datagram?
 
-      if(_awaiting) {
+      else if(_awaiting) {
 
         // the destination port must match
 
@@ -397,6 +437,108 @@ namespace stm32plus {
     }
 
 
+    /**
+     * Get the socket table bucket for a port
+     * @param portNumber The port number
+     * @return A reference to the head of the bucket chain
+     */
+
+    template<class TNetworkLayer>
+    inline UdpSocket *& Udp<TNetworkLayer>::getSocketBucket(uint16_t portNumber) const {
+      return _sockets[(portNumber ^ (portNumber >> 8)) & _socketTableMask];
+    }
+
+
+    /**
+     * Find the socket bound to a port
+     * @param portNumber The port number
+     * @return The socket, or nullptr if there isn't one
+     */
+
+    template<class TNetworkLayer>
+    inline UdpSocket *Udp<TNetworkLayer>::findSocket(uint16_t portNumber) const {
+
+      UdpSocket *socket;
+
+      for(socket=getSocketBucket(portNumber);socket;socket=socket->getNext())
+        if(socket->getLocalPort()==portNumber)
+          return socket;
+
+      return nullptr;
+    }
+
+
+    /**
+     * Bind a socket to its local port. From now on datagrams arriving for the port are placed
+     * in the socket's receive ring and the UdpReceive event subscribers will see them as handled.
+     * The socket is linked in with a single pointer write so this is safe against the receive
+     * path running at the same time.
+     * @param socket The socket to bind. It must stay in scope until it's unbound.
+     * @return false if another socket already has this port
+     */
+
+    template<class TNetworkLayer>
+    inline bool Udp<TNetworkLayer>::udpBind(UdpSocket& socket) {
+
+      if(findSocket(socket.getLocalPort()))
+        return this->setError(ErrorProvider::ERROR_PROVIDER_NET_UDP,E_PORT_IN_USE);
+
+      UdpSocket *& bucket(getSocketBucket(socket.getLocalPort()));
+
+      socket.setNext(bucket);
+      __DMB();
+      bucket=&socket;
+
+      return true;
+    }
+
+
+    /**
+     * Unbind a socket from its local port
+     * @param socket The socket to unbind
+     */
+
+    template<class TNetworkLayer>
+    inline void Udp<TNetworkLayer>::udpUnbind(UdpSocket& socket) {
+
+      UdpSocket *prev;
+      UdpSocket *& bucket(getSocketBucket(socket.getLocalPort()));
+
+      if(bucket==&socket) {
+        bucket=socket.getNext();
+        return;
+      }
+
+      for(prev=bucket;prev;prev=prev->getNext())
+        if(prev->getNext()==&socket) {
+          prev->setNext(socket.getNext());
+          return;
+        }
+    }
+
+
+    /**
+     * Send a batch of datagrams from a socket's local port. Each datagram is sent asynchronously
+     * (see udpSend()) so this call does not wait for any of them to reach the wire.
+     * @param socket The socket to send from. Its local port is the source port.
+     * @param datagrams The datagrams to send
+     * @param count The number of datagrams
+     * @return The number of datagrams accepted for sending. Stops at the first failure.
+     */
+
+    template<class TNetworkLayer>
+    inline uint16_t Udp<TNetworkLayer>::udpSendMany(const UdpSocket& socket,const UdpSocketDatagram *datagrams,uint16_t count) {
+
+      uint16_t i;
+
+      for(i=0;i<count;i++,datagrams++)
+        if(!udpSend(datagrams->remoteAddress,socket.getLocalPort(),datagrams->remotePort,datagrams->data,datagrams->size,true,0))
+          break;
+
+      return i;
+    }
+
+
     /**
      * Notification event notification from the stack
      * @param ned The network event descriptor
@@ -0,0 +1,223 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * A UDP socket bound to a local port. Bind it to the stack with udpBind() and datagrams
+     * arriving for the port are copied into a fixed-capacity ring of slots by the receive
+     * path, which may be running in IRQ context. The application drains the ring with
+     * recvMany() and release(). There is exactly one producer (the stack) and one consumer
+     * (the application) so the ring needs no locking: the producer only writes _head and the
+     * consumer only writes _tail.
+     *
+     * If the ring is full when a datagram arrives then it's dropped and counted. Datagrams
+     * larger than the slot size are truncated and flagged.
+     */
+
+    class UdpSocket {
+
+      protected:
+        uint16_t _localPort;
+        uint16_t _capacity;                     // slots in the ring, one more than the usable count
+        uint16_t _slotSize;                     // max payload per slot
+        scoped_array<UdpSocketDatagram> _slots;
+        scoped_array<uint8_t> _data;
+        volatile uint16_t _head;                // next slot the producer will write
+        volatile uint16_t _tail;                // next slot the consumer will read
+        volatile uint32_t _dropped;
+        UdpSocket *_next;                       // bucket chain in the Udp socket table
+
+      protected:
+        uint16_t nextIndex(uint16_t index) const;
+
+      public:
+        UdpSocket(uint16_t localPort,uint16_t maxDatagrams,uint16_t maxDatagramSize);
+
+        uint16_t getLocalPort() const;
+        uint32_t getDroppedCount() const;
+        uint16_t available() const;
+
+        bool push(const IpAddress& remoteAddress,uint16_t remotePort,const void *data,uint16_t size);
+
+        uint16_t recvMany(const UdpSocketDatagram **datagrams,uint16_t maxDatagrams) const;
+        void release(uint16_t count);
+
+        UdpSocket *getNext() const;
+        void setNext(UdpSocket *next);
+    };
+
+
+    /**
+     * Constructor
+     * @param localPort The port to bind to
+     * @param maxDatagrams The number of datagrams the ring can hold before new arrivals are dropped
+     * @param maxDatagramSize The largest payload that can be stored. Larger datagrams are truncated.
+     */
+
+    inline UdpSocket::UdpSocket(uint16_t localPort,uint16_t maxDatagrams,uint16_t maxDatagramSize)
+      : _localPort(localPort),
+        _capacity(maxDatagrams+1),
+        _slotSize(maxDatagramSize),
+        _slots(new UdpSocketDatagram[maxDatagrams+1]),
+        _data(new uint8_t[(maxDatagrams+1)*static_cast<uint32_t>(maxDatagramSize)]),
+        _head(0),
+        _tail(0),
+        _dropped(0),
+        _next(nullptr) {
+
+      // the data pointers are fixed
+
+      for(uint16_t i=0;i<_capacity;i++)
+        _slots[i].data=_data.get()+i*static_cast<uint32_t>(_slotSize);
+    }
+
+
+    /**
+     * Get the local port
+     * @return The port number
+     */
+
+    inline uint16_t UdpSocket::getLocalPort() const {
+      return _localPort;
+    }
+
+
+    /**
+     * Get the number of datagrams dropped because the ring was full
+     * @return The drop count
+     */
+
+    inline uint32_t UdpSocket::getDroppedCount() const {
+      return _dropped;
+    }
+
+
+    /**
+     * Get the number of datagrams waiting in the ring
+     * @return The number of datagrams
+     */
+
+    inline uint16_t UdpSocket::available() const {
+
+      uint16_t head,tail;
+
+      head=_head;
+      tail=_tail;
+
+      return head>=tail ? head-tail : _capacity-tail+head;
+    }
+
+
+    /**
+     * Advance a ring index
+     */
+
+    inline uint16_t UdpSocket::nextIndex(uint16_t index) const {
+      return ++index==_capacity ? 0 : index;
+    }
+
+
+    /**
+     * Store an incoming datagram. Called by the stack.
+     * @param remoteAddress The sender's address
+     * @param remotePort The sender's port
+     * @param data The payload
+     * @param size The payload size
+     * @return false if the ring was full and the datagram was dropped
+     */
+
+    inline bool UdpSocket::push(const IpAddress& remoteAddress,uint16_t remotePort,const void *data,uint16_t size) {
+
+      uint16_t head,next;
+
+      head=_head;
+
+      if((next=nextIndex(head))==_tail) {
+        _dropped++;
+        return false;
+      }
+
+      UdpSocketDatagram& slot(_slots[head]);
+
+      slot.remoteAddress.ipAddress=remoteAddress.ipAddress;
+      slot.remotePort=remotePort;
+      slot.truncated=size>_slotSize;
+      slot.size=std::min(size,_slotSize);
+
+      memcpy(const_cast<uint8_t *>(slot.data),data,slot.size);
+
+      // make sure the slot is written before the consumer can see it
+
+      __DMB();
+      _head=next;
+
+      return true;
+    }
+
+
+    /**
+     * Get pointers to the datagrams waiting in the ring without copying them. This
+     * does not block. The datagrams stay in the ring until release() is called.
+     * @param datagrams Array to receive the datagram pointers, in order of arrival
+     * @param maxDatagrams The size of the array
+     * @return The number of pointers stored, which may be zero
+     */
+
+    inline uint16_t UdpSocket::recvMany(const UdpSocketDatagram **datagrams,uint16_t maxDatagrams) const {
+
+      uint16_t head,index,count;
+
+      head=_head;
+      index=_tail;
+
+      for(count=0;count<maxDatagrams && index!=head;count++) {
+        datagrams[count]=&_slots[index];
+        index=nextIndex(index);
+      }
+
+      return count;
+    }
+
+
+    /**
+     * Release datagrams previously returned by recvMany() so their slots can be reused
+     * @param count The number of datagrams to release, oldest first
+     */
+
+    inline void UdpSocket::release(uint16_t count) {
+
+      uint16_t tail;
+
+      count=std::min(count,available());
+
+      for(tail=_tail;count;count--)
+        tail=nextIndex(tail);
+
+      // the consumer must have finished with the slots before the producer can reuse them
+
+      __DMB();
+      _tail=tail;
+    }
+
+
+    /**
+     * Socket table chain accessors, used by Udp
+     */
+
+    inline UdpSocket *UdpSocket::getNext() const {
+      return _next;
+    }
+
+    inline void UdpSocket::setNext(UdpSocket *next) {
+      _next=next;
+    }
+  }
+}
@@ -0,0 +1,27 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace net {
+
+    /**
+     * A datagram as seen by a UdpSocket. For received datagrams the data pointer refers to
+     * a slot in the socket's receive ring and is valid until the slot is released. For datagrams
+     * passed to udpSendMany() the caller fills in all the members.
+     */
+
+    struct UdpSocketDatagram {
+      IpAddress remoteAddress;              ///< where the datagram came from or is going to
+      uint16_t remotePort;                  ///< the remote port number
+      uint16_t size;                        ///< number of bytes at 'data'
+      bool truncated;                       ///< received datagram was larger than the socket's slot size
+      const uint8_t *data;                  ///< the payload
+    };
+  }
+}
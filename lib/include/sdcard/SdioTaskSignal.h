@@ -0,0 +1,83 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * A TaskSignal raised by any SDIO interrupt event: the end of a data transfer or one of
+   * the errors. Subscribe it to an SdCard that includes the SdioInterruptFeature and
+   * check succeeded() after the wait.
+   */
+
+  class SdioTaskSignal : public TaskSignal {
+
+    protected:
+      SdioEventSource& _source;
+      volatile SdioEventType _lastEvent;
+
+    protected:
+      void onInterrupt(SdioEventType set);
+
+    public:
+      SdioTaskSignal(SdioEventSource& source);
+      ~SdioTaskSignal();
+
+      /**
+       * @return the event that last raised the signal
+       */
+
+      SdioEventType getLastEvent() const {
+        return _lastEvent;
+      }
+
+      /**
+       * @return true if the last transfer ended without an error
+       */
+
+      bool succeeded() const {
+        return _lastEvent==SdioEventType::EVENT_DATA_END;
+      }
+  };
+
+
+  /**
+   * Constructor
+   * @param source The SDIO interrupt feature to subscribe to
+   */
+
+  inline SdioTaskSignal::SdioTaskSignal(SdioEventSource& source)
+    : _source(source),
+      _lastEvent(SdioEventType::EVENT_DATA_END) {
+
+    _source.SdioInterruptEventSender.insertSubscriber(
+        SdioInterruptEventSourceSlot::bind(this,&SdioTaskSignal::onInterrupt)
+      );
+  }
+
+
+  /**
+   * Destructor
+   */
+
+  inline SdioTaskSignal::~SdioTaskSignal() {
+    _source.SdioInterruptEventSender.removeSubscriber(
+        SdioInterruptEventSourceSlot::bind(this,&SdioTaskSignal::onInterrupt)
+      );
+  }
+
+
+  /**
+   * SDIO interrupt
+   */
+
+  inline void SdioTaskSignal::onInterrupt(SdioEventType set) {
+    _lastEvent=set;
+    raise();
+  }
+}
@@ -29,7 +29,9 @@ namespace stm32plus {
 
     public:
       enum {
-        E_SPI_ERROR = 1
+        E_SPI_ERROR = 1,
+        E_QUEUE_FULL,             ///< the transaction scheduler queue is full
+        E_TRANSACTION_FAILED      ///< a scheduled transaction had a DMA error
       };
 
     protected:
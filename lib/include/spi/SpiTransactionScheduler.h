@@ -0,0 +1,477 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * The chip select and bus settings for one device on a shared SPI bus. The scheduler
+   * switches the peripheral to these settings before a transaction for the device when they
+   * differ from the last device's.
+   */
+
+  struct SpiDeviceConfig {
+
+    GpioPinRef chipSelect;          ///< active low chip select, already configured as an output
+    uint16_t baudRatePrescaler;     ///< SPI_BaudRatePrescaler_xxx
+    uint16_t cpol;                  ///< SPI_CPOL_Low or SPI_CPOL_High
+    uint16_t cpha;                  ///< SPI_CPHA_1Edge or SPI_CPHA_2Edge
+
+    SpiDeviceConfig() {}
+
+    SpiDeviceConfig(const GpioPinRef& cs,uint16_t prescaler,uint16_t polarity=SPI_CPOL_Low,uint16_t phase=SPI_CPHA_1Edge)
+      : chipSelect(cs),
+        baudRatePrescaler(prescaler),
+        cpol(polarity),
+        cpha(phase) {
+    }
+
+    /**
+     * @return the CR1 bits that this device needs
+     */
+
+    uint16_t getControlBits() const {
+      return baudRatePrescaler | cpol | cpha;
+    }
+  };
+
+
+  /**
+   * One chip select cycle: assert CS, send an optional command, then an optional data phase
+   * that transmits, receives or does both, then release CS. Lengths are in units of the DMA
+   * feature size, i.e. bytes unless the features were declared for half-words.
+   *
+   * For a receive the data phase clocks out txData if it's set (full duplex) or the current
+   * contents of rxData if not, so fill rxData with the filler the device expects (usually
+   * 0x00 or 0xff) before submitting a read. A transaction FAILS if a DMA transfer error ends it.
+   */
+
+  struct SpiTransaction : Transaction {
+
+    const SpiDeviceConfig *device;    ///< the target device
+    const void *command;              ///< command bytes, sent first and their replies discarded
+    uint16_t commandLength;
+    const void *txData;               ///< data phase transmit buffer, or nullptr
+    void *rxData;                     ///< data phase receive buffer, or nullptr
+    uint16_t length;                  ///< data phase length
+
+    SpiTransaction()
+      : device(nullptr),
+        command(nullptr),
+        commandLength(0),
+        txData(nullptr),
+        rxData(nullptr),
+        length(0) {
+    }
+
+    /**
+     * Set up the transaction
+     */
+
+    void set(const SpiDeviceConfig& dev,const void *cmd,uint16_t cmdLength,const void *tx,void *rx,uint16_t len) {
+      device=&dev;
+      command=cmd;
+      commandLength=cmdLength;
+      txData=tx;
+      rxData=rx;
+      length=len;
+    }
+  };
+
+
+  /**
+   * The signature for transaction completion events: void myHandler(SpiTransaction& t);
+   */
+
+  DECLARE_EVENT_SIGNATURE(SpiTransaction,void(SpiTransaction&));
+
+
+  /**
+   * Per-bus SPI transaction scheduler. The transactions queued with submit() may be for any
+   * number of devices and are run from the DMA completion interrupts: the CPU only steps in
+   * between phases to switch the bus settings, move the chip selects and start the next DMA
+   * transfer, so devices sharing the bus no longer serialise on polling loops. See
+   * TransactionQueue for submit(), wait() and isIdle().
+   *
+   * Both DMA channels must include their interrupt features. Receive phases end on the RX
+   * channel's transfer complete. Transmit-only phases end on the TX channel's transfer
+   * complete followed by a short wait in the IRQ for the last frame to leave the shift
+   * register (two frames at most).
+   *
+   * The DMA features switch the SPI DMA requests on permanently; the scheduler takes them
+   * over and enables them per phase. While the scheduler is busy don't use the synchronous
+   * Spi methods or other DMA users on the same peripheral. isIdle() tells you when it's safe.
+   *
+   * Example:
+   *
+   *   typedef Spi1<> MySpi;
+   *   typedef Spi1TxDmaChannel<Spi1TxDmaChannelInterruptFeature,SpiDmaWriterFeature<MySpi> > MyTx;
+   *   typedef Spi1RxDmaChannel<Spi1RxDmaChannelInterruptFeature,SpiDmaReaderFeature<MySpi> > MyRx;
+   *
+   *   SpiTransactionScheduler<MySpi,MyTx,MyRx> scheduler(spi,tx,rx);
+   *   SpiDeviceConfig flash(GpioPinRef(GPIOA,GPIO_Pin_4),SPI_BaudRatePrescaler_2);
+   *
+   *   static const uint8_t readCommand[4]={ 0x03,0,0,0 };
+   *   SpiTransaction t;
+   *
+   *   t.set(flash,readCommand,sizeof(readCommand),nullptr,buffer,sizeof(buffer));
+   *   scheduler.submit(t);
+   *
+   * @tparam TSpi The SPI peripheral type
+   * @tparam TDmaWriter The TX DMA channel type with SpiDmaWriterFeature and its interrupt feature
+   * @tparam TDmaReader The RX DMA channel type with SpiDmaReaderFeature and its interrupt feature
+   * @tparam TQueueSize The maximum number of transactions waiting for the bus
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize=8>
+  class SpiTransactionScheduler : public TransactionQueue<SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>,
+                                                          SpiTransaction,
+                                                          TQueueSize,
+                                                          ErrorProvider::ERROR_PROVIDER_SPI,
+                                                          Spi::E_QUEUE_FULL,
+                                                          Spi::E_TRANSACTION_FAILED> {
+
+    public:
+      DECLARE_EVENT_SOURCE(SpiTransaction);
+
+      typedef TransactionQueue<SpiTransactionScheduler,
+                               SpiTransaction,
+                               TQueueSize,
+                               ErrorProvider::ERROR_PROVIDER_SPI,
+                               Spi::E_QUEUE_FULL,
+                               Spi::E_TRANSACTION_FAILED> TransactionQueueType;
+
+      friend TransactionQueueType;
+
+    protected:
+      enum class Phase : uint8_t {
+        IDLE,
+        COMMAND,
+        DATA
+      };
+
+      enum {
+        CONTROL_MASK = SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA
+      };
+
+      TSpi& _spi;
+      TDmaWriter& _dmaWriter;
+      TDmaReader& _dmaReader;
+
+      Phase _phase;
+      bool _receiving;
+
+    protected:
+      void onTxDmaInterrupt(DmaEventType det);
+      void onRxDmaInterrupt(DmaEventType det);
+
+      void startTransaction();
+      void raiseTransactionEvent(SpiTransaction& transaction);
+
+      void configure(const SpiDeviceConfig& device) const;
+      void startPhase();
+      void startWrite(const void *data,uint16_t length);
+      void startRead(const void *txData,void *rxData,uint16_t length);
+      void endPhase();
+      void abort();
+      void finish(bool success);
+      void drain() const;
+
+    public:
+      SpiTransactionScheduler(TSpi& spi,TDmaWriter& dmaWriter,TDmaReader& dmaReader);
+      ~SpiTransactionScheduler();
+  };
+
+
+  /**
+   * Constructor
+   * @param spi The SPI peripheral
+   * @param dmaWriter The TX DMA channel
+   * @param dmaReader The RX DMA channel
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::SpiTransactionScheduler(TSpi& spi,TDmaWriter& dmaWriter,TDmaReader& dmaReader)
+    : _spi(spi),
+      _dmaWriter(dmaWriter),
+      _dmaReader(dmaReader),
+      _phase(Phase::IDLE),
+      _receiving(false) {
+
+    SPI_I2S_DMACmd(_spi,SPI_I2S_DMAReq_Tx | SPI_I2S_DMAReq_Rx,DISABLE);
+
+    _dmaWriter.DmaInterruptEventSender.insertSubscriber(
+        DmaInterruptEventSourceSlot::bind(this,&SpiTransactionScheduler::onTxDmaInterrupt)
+      );
+
+    _dmaReader.DmaInterruptEventSender.insertSubscriber(
+        DmaInterruptEventSourceSlot::bind(this,&SpiTransactionScheduler::onRxDmaInterrupt)
+      );
+
+    _dmaWriter.enableInterrupts(DMA_IT_TC | DMA_IT_TE);
+    _dmaReader.enableInterrupts(DMA_IT_TC | DMA_IT_TE);
+  }
+
+
+  /**
+   * Destructor
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::~SpiTransactionScheduler() {
+
+    _dmaWriter.disableInterrupts(DMA_IT_TC | DMA_IT_TE);
+    _dmaReader.disableInterrupts(DMA_IT_TC | DMA_IT_TE);
+
+    _dmaWriter.DmaInterruptEventSender.removeSubscriber(
+        DmaInterruptEventSourceSlot::bind(this,&SpiTransactionScheduler::onTxDmaInterrupt)
+      );
+
+    _dmaReader.DmaInterruptEventSender.removeSubscriber(
+        DmaInterruptEventSourceSlot::bind(this,&SpiTransactionScheduler::onRxDmaInterrupt)
+      );
+  }
+
+
+  /**
+   * Select the device for the transaction that TransactionQueue has just made current and
+   * start its first phase. Called from the IRQ or with interrupts suspended.
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::startTransaction() {
+
+    configure(*this->_current->device);
+    this->_current->device->chipSelect.reset();
+
+    _phase=Phase::COMMAND;
+    startPhase();
+  }
+
+
+  /**
+   * Switch the bus speed and mode if this device needs different settings. The peripheral
+   * must be disabled while CR1 is changed and the bus is idle here.
+   * @param device The device about to be selected
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::configure(const SpiDeviceConfig& device) const {
+
+    SPI_TypeDef *peripheral;
+    uint16_t bits;
+
+    peripheral=_spi;
+    bits=device.getControlBits();
+
+    if((peripheral->CR1 & CONTROL_MASK)!=bits) {
+      SPI_Cmd(peripheral,DISABLE);
+      peripheral->CR1=(peripheral->CR1 & ~CONTROL_MASK) | bits;
+      SPI_Cmd(peripheral,ENABLE);
+    }
+  }
+
+
+  /**
+   * Start the current phase, skipping empty ones. The transaction finishes when there are
+   * no phases left.
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::startPhase() {
+
+    if(_phase==Phase::COMMAND) {
+
+      if(this->_current->commandLength) {
+        startWrite(this->_current->command,this->_current->commandLength);
+        return;
+      }
+
+      _phase=Phase::DATA;
+    }
+
+    if(this->_current->length) {
+
+      if(this->_current->rxData)
+        startRead(this->_current->txData ? this->_current->txData : this->_current->rxData,this->_current->rxData,this->_current->length);
+      else
+        startWrite(this->_current->txData,this->_current->length);
+
+      return;
+    }
+
+    finish(true);
+  }
+
+
+  /**
+   * Start a transmit-only phase. The RX DMA request stays off and what's received is
+   * thrown away at the end.
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::startWrite(const void *data,uint16_t length) {
+
+    _receiving=false;
+
+    drain();
+    SPI_I2S_DMACmd(_spi,SPI_I2S_DMAReq_Tx,ENABLE);
+    _dmaWriter.beginWrite(data,length);
+  }
+
+
+  /**
+   * Start a receive phase. The RX stream is armed before the TX stream starts the clock.
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::startRead(const void *txData,void *rxData,uint16_t length) {
+
+    _receiving=true;
+
+    drain();
+    SPI_I2S_DMACmd(_spi,SPI_I2S_DMAReq_Rx,ENABLE);
+    _dmaReader.beginRead(rxData,length);
+
+    SPI_I2S_DMACmd(_spi,SPI_I2S_DMAReq_Tx,ENABLE);
+    _dmaWriter.beginWrite(txData,length);
+  }
+
+
+  /**
+   * TX DMA interrupt. Ends a transmit-only phase once the last frame is on the wire.
+   * @param det The event type
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::onTxDmaInterrupt(DmaEventType det) {
+
+    SPI_TypeDef *peripheral;
+
+    if(this->_current==nullptr)
+      return;
+
+    if(det==DmaEventType::EVENT_TRANSFER_ERROR) {
+      abort();
+      return;
+    }
+
+    if(det!=DmaEventType::EVENT_COMPLETE || _receiving)
+      return;
+
+    // transfer complete means the last frame is in DR, not that it has been sent
+
+    peripheral=_spi;
+
+    while(SPI_I2S_GetFlagStatus(peripheral,SPI_I2S_FLAG_TXE)==RESET);
+    while(SPI_I2S_GetFlagStatus(peripheral,SPI_I2S_FLAG_BSY)==SET);
+
+    endPhase();
+  }
+
+
+  /**
+   * RX DMA interrupt. Ends a receive phase: the last frame received is the last one sent.
+   * @param det The event type
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::onRxDmaInterrupt(DmaEventType det) {
+
+    if(this->_current==nullptr)
+      return;
+
+    if(det==DmaEventType::EVENT_TRANSFER_ERROR)
+      abort();
+    else if(det==DmaEventType::EVENT_COMPLETE && _receiving) {
+      while(SPI_I2S_GetFlagStatus(_spi,SPI_I2S_FLAG_BSY)==SET);
+      endPhase();
+    }
+  }
+
+
+  /**
+   * A phase is finished. Move on to the next one.
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::endPhase() {
+
+    SPI_I2S_DMACmd(_spi,SPI_I2S_DMAReq_Tx | SPI_I2S_DMAReq_Rx,DISABLE);
+
+    if(_phase==Phase::COMMAND) {
+      _phase=Phase::DATA;
+      startPhase();
+    }
+    else
+      finish(true);
+  }
+
+
+  /**
+   * A DMA transfer error. Stop both streams and fail the transaction.
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::abort() {
+
+    SPI_I2S_DMACmd(_spi,SPI_I2S_DMAReq_Tx | SPI_I2S_DMAReq_Rx,DISABLE);
+
+    DMA_Cmd(_dmaWriter,DISABLE);
+    DMA_Cmd(_dmaReader,DISABLE);
+
+    while(SPI_I2S_GetFlagStatus(_spi,SPI_I2S_FLAG_BSY)==SET);
+
+    finish(false);
+  }
+
+
+  /**
+   * Release the chip select and finish the current transaction
+   * @param success true if it worked
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::finish(bool success) {
+
+    this->_current->device->chipSelect.set();
+
+    _phase=Phase::IDLE;
+    this->completeTransaction(success);
+  }
+
+
+  /**
+   * Tell the subscribers that a transaction has finished
+   * @param transaction The finished transaction
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::raiseTransactionEvent(SpiTransaction& transaction) {
+    SpiTransactionEventSender.raiseEvent(transaction);
+  }
+
+
+  /**
+   * Empty the receive side and clear any overrun left by a transmit-only phase so that
+   * enabling the RX DMA request doesn't pick up a stale frame.
+   */
+
+  template<class TSpi,class TDmaWriter,class TDmaReader,uint8_t TQueueSize>
+  inline void SpiTransactionScheduler<TSpi,TDmaWriter,TDmaReader,TQueueSize>::drain() const {
+
+    SPI_TypeDef *peripheral;
+
+    peripheral=_spi;
+
+    while(SPI_I2S_GetFlagStatus(peripheral,SPI_I2S_FLAG_RXNE)==SET)
+      (void)peripheral->DR;
+
+    (void)peripheral->SR;
+  }
+}
@@ -100,10 +100,22 @@ __STL_BEGIN_NAMESPACE
 
 
 #ifdef STM32PLUS_BUILD
+#if defined(STM32PLUS_ALLOCATOR_POOL) || defined(STM32PLUS_HEAP_PROFILER)
+// pool/TLSF heap and/or heap profiler, see lib/src/memory/PoolHeap.cpp and lib/src/debug/HeapProfiler.cpp
+extern "C" {
+  void *stm32plus_malloc(size_t);
+  void stm32plus_free(void *);
+  void *stm32plus_realloc(void *,size_t);
+}
+#define stm32_malloc stm32plus_malloc
+#define stm32_free stm32plus_free
+#define stm32_realloc stm32plus_realloc
+#else
 #define stm32_malloc malloc
 #define stm32_free free
 #define stm32_realloc realloc
 #endif
+#endif
 
 // Malloc-based allocator.  Typically slower than default below.
 // Typically thread-safe and more storage efficient.
@@ -177,7 +189,7 @@ __malloc_alloc_template<__inst>::_S_oom_malloc(size_t __n)
         __my_malloc_handler = __malloc_alloc_oom_handler;
         if (0 == __my_malloc_handler) { __THROW_BAD_ALLOC; }
         (*__my_malloc_handler)();
-        __result = malloc(__n);
+        __result = stm32_malloc(__n);
         if (__result) return(__result);
     }
 }
@@ -192,7 +204,7 @@ void* __malloc_alloc_template<__inst>::_S_oom_realloc(void* __p, size_t __n)
         __my_malloc_handler = __malloc_alloc_oom_handler;
         if (0 == __my_malloc_handler) { __THROW_BAD_ALLOC; }
         (*__my_malloc_handler)();
-        __result = realloc(__p, __n);
+        __result = stm32_realloc(__p, __n);
         if (__result) return(__result);
     }
 }
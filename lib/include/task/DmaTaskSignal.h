@@ -0,0 +1,87 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * A TaskSignal raised when a DMA channel or stream completes or fails. The DMA must include
+   * its interrupt feature with the complete and error interrupts enabled. Half complete and
+   * double buffer events are ignored.
+   *
+   *   DmaTaskSignal _rxDone(_dma);
+   *   ...
+   *   _rxDone.clear();
+   *   _dma.beginRead(_buffer,sizeof(_buffer));
+   *   TASK_AWAIT(_rxDone);
+   *
+   *   if(_rxDone.failed())
+   *     ...
+   */
+
+  class DmaTaskSignal : public TaskSignal {
+
+    protected:
+      DmaEventSource& _source;
+      volatile DmaEventType _lastEvent;
+
+    protected:
+      void onInterrupt(DmaEventType det);
+
+    public:
+      DmaTaskSignal(DmaEventSource& source);
+      ~DmaTaskSignal();
+
+      /**
+       * @return true if the last transfer ended with an error
+       */
+
+      bool failed() const {
+        return _lastEvent==DmaEventType::EVENT_TRANSFER_ERROR;
+      }
+  };
+
+
+  /**
+   * Constructor
+   * @param source The DMA to subscribe to
+   */
+
+  inline DmaTaskSignal::DmaTaskSignal(DmaEventSource& source)
+    : _source(source),
+      _lastEvent(DmaEventType::EVENT_COMPLETE) {
+
+    _source.DmaInterruptEventSender.insertSubscriber(
+        DmaInterruptEventSourceSlot::bind(this,&DmaTaskSignal::onInterrupt)
+      );
+  }
+
+
+  /**
+   * Destructor
+   */
+
+  inline DmaTaskSignal::~DmaTaskSignal() {
+    _source.DmaInterruptEventSender.removeSubscriber(
+        DmaInterruptEventSourceSlot::bind(this,&DmaTaskSignal::onInterrupt)
+      );
+  }
+
+
+  /**
+   * DMA interrupt
+   */
+
+  inline void DmaTaskSignal::onInterrupt(DmaEventType det) {
+
+    if(det==DmaEventType::EVENT_COMPLETE || det==DmaEventType::EVENT_TRANSFER_ERROR) {
+      _lastEvent=det;
+      raise();
+    }
+  }
+}
@@ -0,0 +1,181 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+/**
+ * Task body macros. A task's run() method is one switch statement and each wait point is
+ * a case label, so a task resumes where it left off without having a stack of its own.
+ * The rules that go with that:
+ *
+ *   - Local variables don't survive a wait. Keep state in class members.
+ *   - Waits can only be used in run() itself, not in functions that it calls.
+ *   - Don't put a switch statement around a wait.
+ */
+
+#define TASK_BEGIN() switch(_line) { case 0:
+
+#define TASK_END() } _line=0; return TaskState::FINISHED
+
+/**
+ * Go to the back of the ready queue so other tasks get a turn
+ */
+
+#define TASK_YIELD() \
+  _line=__LINE__; return TaskState::READY; case __LINE__:
+
+/**
+ * Poll a condition, yielding until it's true. For flags set by code that can't raise a
+ * TaskSignal. The task stays on the ready queue so the CPU won't sleep while it waits.
+ */
+
+#define TASK_WAIT_UNTIL(condition) \
+  _line=__LINE__; case __LINE__: if(!(condition)) return TaskState::READY
+
+/**
+ * Wait for a TaskSignal to be raised
+ */
+
+#define TASK_AWAIT(signal) \
+  _timedOut=false; _line=__LINE__; case __LINE__: \
+  if(!(signal).acquire(*this)) return TaskState::WAITING
+
+/**
+ * Wait for a TaskSignal to be raised or for a number of executor timer ticks to pass.
+ * Check timedOut() afterwards to find out which.
+ */
+
+#define TASK_AWAIT_TIMEOUT(signal,ticks) \
+  startTimeout(ticks); _line=__LINE__; case __LINE__: \
+  if(!(signal).acquire(*this)) return TaskState::WAITING
+
+/**
+ * Sleep for a number of executor timer ticks
+ */
+
+#define TASK_SLEEP(ticks) \
+  startTimeout(ticks); _line=__LINE__; case __LINE__: \
+  if(!_timedOut) return TaskState::WAITING
+
+
+namespace stm32plus {
+
+  class TaskSignal;
+  class TaskExecutor;
+
+
+  /**
+   * What a task's run() method says about itself when it returns
+   */
+
+  enum class TaskState : uint8_t {
+    READY,      ///< it wants to run again as soon as possible
+    WAITING,    ///< it's waiting for a signal or a timer and will be woken by it
+    FINISHED    ///< it's done
+  };
+
+
+  /**
+   * Base class for a stackless cooperative task run by a TaskExecutor. Derive from this and
+   * implement run() using the TASK_ macros, for example:
+   *
+   *   class Echo : public Task {
+   *
+   *     DmaTaskSignal _rxComplete;
+   *     ...
+   *
+   *     virtual TaskState run() override {
+   *       TASK_BEGIN();
+   *
+   *       for(;;) {
+   *         startReceive();
+   *         TASK_AWAIT_TIMEOUT(_rxComplete,1000);
+   *
+   *         if(timedOut())
+   *           continue;
+   *
+   *         startSend();
+   *         TASK_AWAIT(_txComplete);
+   *       }
+   *
+   *       TASK_END();
+   *     }
+   *   };
+   *
+   * A task costs a few words of RAM plus its own members. A context switch is one virtual
+   * call and a jump through the switch statement.
+   */
+
+  class Task {
+
+    protected:
+      Task *_readyNext;                 // ready queue link
+      Task *_waitNext;                  // signal wait list links
+      Task **_waitPrev;                 // the pointer that points at us on the wait list
+      TaskSignal *_waitingOn;
+      TaskExecutor *_executor;
+      TimerWheelEntry _timer;
+      uint16_t _line;
+      volatile bool _queued;
+      volatile bool _signalled;
+      volatile bool _timedOut;
+      bool _finished;
+
+      friend class TaskSignal;
+      friend class TaskExecutor;
+
+    protected:
+      void startTimeout(uint32_t ticks);
+      void onTimeout(TimerWheelEntry& entry);
+
+    public:
+      Task();
+      virtual ~Task() {}
+
+      /**
+       * Run the task up to its next wait point
+       * @return What to do with the task now
+       */
+
+      virtual TaskState run()=0;
+
+      /**
+       * @return true if the last TASK_AWAIT_TIMEOUT ended because the time ran out
+       */
+
+      bool timedOut() const {
+        return _timedOut;
+      }
+
+      /**
+       * @return true if run() has reached TASK_END()
+       */
+
+      bool isFinished() const {
+        return _finished;
+      }
+  };
+
+
+  /**
+   * Constructor
+   */
+
+  inline Task::Task()
+    : _readyNext(nullptr),
+      _waitNext(nullptr),
+      _waitPrev(nullptr),
+      _waitingOn(nullptr),
+      _executor(nullptr),
+      _timer(TimerWheelEntry::CallbackType::bind(this,&Task::onTimeout)),
+      _line(0),
+      _queued(false),
+      _signalled(false),
+      _timedOut(false),
+      _finished(false) {
+  }
+}
@@ -0,0 +1,277 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Single core cooperative executor for Task objects. Tasks that are ready to run are kept
+   * on an intrusive FIFO queue. Each call to runOnce() takes the first one off the queue
+   * and runs it to its next wait point. A TaskSignal raised from an IRQ, or a timer, puts
+   * waiting tasks back on the queue. Nothing is allocated.
+   *
+   * Timeouts and sleeps need a TimerWheel. Something else has to keep it advanced:
+   * call TimerWheel::advance() from your SysTick handler, or use TimerDrivenTaskExecutor
+   * with a TimerWheelTimerDriver so that the CPU can sleep between deadlines.
+   *
+   *   TimerWheel wheel;
+   *   TaskExecutor executor(wheel);
+   *
+   *   executor.start(task1);
+   *   executor.start(task2);
+   *   executor.run();                   // doesn't return
+   */
+
+  class TaskExecutor {
+
+    protected:
+      Task *_head;
+      Task *_tail;
+      TimerWheel *_wheel;
+
+    protected:
+      virtual void scheduleTimer(TimerWheelEntry& entry,uint32_t ticks);
+      virtual void cancelTimer(TimerWheelEntry& entry);
+
+      friend class Task;
+      friend class TaskSignal;
+
+    public:
+      TaskExecutor();
+      TaskExecutor(TimerWheel& wheel);
+      virtual ~TaskExecutor() {}
+
+      void start(Task& task);
+      void ready(Task& task);
+
+      bool runOnce();
+      void run();
+
+      /**
+       * @return true if no task is ready to run
+       */
+
+      bool isIdle() const {
+        return _head==nullptr;
+      }
+  };
+
+
+  /**
+   * A TaskExecutor that sets its timers through a tickless TimerWheelTimerDriver
+   */
+
+  template<class TTimer>
+  class TimerDrivenTaskExecutor : public TaskExecutor {
+
+    protected:
+      TimerWheelTimerDriver<TTimer>& _driver;
+
+    protected:
+      virtual void scheduleTimer(TimerWheelEntry& entry,uint32_t ticks) override {
+        _driver.schedule(entry,ticks);
+      }
+
+      virtual void cancelTimer(TimerWheelEntry& entry) override {
+        _driver.cancel(entry);
+      }
+
+    public:
+      TimerDrivenTaskExecutor(TimerWheel& wheel,TimerWheelTimerDriver<TTimer>& driver)
+        : TaskExecutor(wheel),
+          _driver(driver) {
+      }
+  };
+
+
+  /**
+   * Constructor for tasks that don't use timeouts or sleeps
+   */
+
+  inline TaskExecutor::TaskExecutor()
+    : _head(nullptr),
+      _tail(nullptr),
+      _wheel(nullptr) {
+  }
+
+
+  /**
+   * Constructor
+   * @param wheel The timer wheel used for timeouts and sleeps
+   */
+
+  inline TaskExecutor::TaskExecutor(TimerWheel& wheel)
+    : _head(nullptr),
+      _tail(nullptr),
+      _wheel(&wheel) {
+  }
+
+
+  /**
+   * Start, or restart, a task from the top of its run() method. The task must not be
+   * running on any executor.
+   * @param task The task
+   */
+
+  inline void TaskExecutor::start(Task& task) {
+
+    task._executor=this;
+    task._waitingOn=nullptr;
+    task._line=0;
+    task._signalled=false;
+    task._timedOut=false;
+    task._finished=false;
+
+    ready(task);
+  }
+
+
+  /**
+   * Put a task at the back of the ready queue if it's not already on it. Safe to call from
+   * an IRQ.
+   * @param task The task
+   */
+
+  inline void TaskExecutor::ready(Task& task) {
+
+    IrqSuspend suspender;
+
+    if(task._queued)
+      return;
+
+    task._queued=true;
+    task._readyNext=nullptr;
+
+    if(_tail)
+      _tail->_readyNext=&task;
+    else
+      _head=&task;
+
+    _tail=&task;
+  }
+
+
+  /**
+   * Run the task at the front of the ready queue up to its next wait point
+   * @return false if there was nothing to run
+   */
+
+  inline bool TaskExecutor::runOnce() {
+
+    Task *task;
+
+    {
+      IrqSuspend suspender;
+
+      if((task=_head)==nullptr)
+        return false;
+
+      if((_head=task->_readyNext)==nullptr)
+        _tail=nullptr;
+
+      task->_queued=false;
+    }
+
+    switch(task->run()) {
+
+      case TaskState::READY:
+        ready(*task);
+        break;
+
+      case TaskState::FINISHED:
+        task->_finished=true;
+        if(_wheel)
+          cancelTimer(task->_timer);
+        break;
+
+      default:
+        break;
+    }
+
+    return true;
+  }
+
+
+  /**
+   * Run tasks forever. The CPU sleeps when none are ready. Interrupts are suspended while
+   * checking the queue so that a wake-up can't be missed: WFI still returns for a pending
+   * interrupt, which then runs when they're resumed.
+   */
+
+  inline void TaskExecutor::run() {
+
+    for(;;) {
+
+      while(runOnce());
+
+      IrqSuspend suspender;
+
+      if(_head==nullptr)
+        __WFI();
+    }
+  }
+
+
+  /**
+   * Set a timer on the wheel
+   */
+
+  inline void TaskExecutor::scheduleTimer(TimerWheelEntry& entry,uint32_t ticks) {
+    _wheel->schedule(entry,ticks);
+  }
+
+
+  /**
+   * Cancel a timer on the wheel
+   */
+
+  inline void TaskExecutor::cancelTimer(TimerWheelEntry& entry) {
+    _wheel->cancel(entry);
+  }
+
+
+  /*
+   * The Task methods that need the complete executor
+   */
+
+  /**
+   * Start the timer for a timed wait. It's cancelled when the wait ends early.
+   * @param ticks The timeout in wheel ticks
+   */
+
+  inline void Task::startTimeout(uint32_t ticks) {
+
+    _timedOut=false;
+    _executor->scheduleTimer(_timer,ticks);
+  }
+
+
+  /**
+   * Timer expiry. A signal that has already woken us wins, otherwise leave the signal's
+   * wait list and get back on the ready queue.
+   */
+
+  inline void Task::onTimeout(TimerWheelEntry& /* entry */) {
+
+    IrqSuspend suspender;
+
+    if(_signalled)
+      return;
+
+    _timedOut=true;
+
+    if(_waitingOn) {
+      if((*_waitPrev=_waitNext)!=nullptr)
+        _waitNext->_waitPrev=_waitPrev;
+
+      _waitingOn=nullptr;
+    }
+
+    _executor->ready(*this);
+  }
+}
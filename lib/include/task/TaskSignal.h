@@ -0,0 +1,136 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * An event that tasks can wait for with TASK_AWAIT. raise() wakes every waiting task. If
+   * nobody is waiting then the signal stays raised and the next task to wait on it
+   * continues straight away, so a completion that comes in before the task waits for it
+   * isn't lost. raise() can be called from an IRQ.
+   *
+   * Derive from this to adapt an event source, see DmaTaskSignal for an example.
+   */
+
+  class TaskSignal {
+
+    protected:
+      Task *_waiters;
+      volatile bool _raised;
+
+    public:
+      TaskSignal();
+
+      void raise();
+      void clear();
+      bool acquire(Task& task);
+
+      /**
+       * @return true if the signal was raised while nobody was waiting
+       */
+
+      bool isRaised() const {
+        return _raised;
+      }
+  };
+
+
+  /**
+   * Constructor
+   */
+
+  inline TaskSignal::TaskSignal()
+    : _waiters(nullptr),
+      _raised(false) {
+  }
+
+
+  /**
+   * Wake every waiting task, or leave the signal raised if there aren't any
+   */
+
+  inline void TaskSignal::raise() {
+
+    Task *task;
+
+    IrqSuspend suspender;
+
+    if(_waiters==nullptr) {
+      _raised=true;
+      return;
+    }
+
+    while((task=_waiters)!=nullptr) {
+
+      if((_waiters=task->_waitNext)!=nullptr)
+        _waiters->_waitPrev=&_waiters;
+
+      task->_waitingOn=nullptr;
+      task->_signalled=true;
+      task->_executor->ready(*task);
+    }
+  }
+
+
+  /**
+   * Forget a raise that nobody has waited for yet. Call before starting an operation whose
+   * completion raises the signal if an earlier one might have been left over.
+   */
+
+  inline void TaskSignal::clear() {
+    _raised=false;
+  }
+
+
+  /**
+   * Called by the TASK_AWAIT macros each time the task runs at the wait point. The task
+   * carries on if it's been woken by this signal, if its timeout has expired or if the
+   * signal was raised before it got here. Otherwise it's added to the wait list.
+   * @param task The waiting task
+   * @return true if the wait is over
+   */
+
+  inline bool TaskSignal::acquire(Task& task) {
+
+    IrqSuspend suspender;
+
+    if(task._signalled) {
+      task._signalled=false;
+    }
+    else if(task._timedOut) {
+      return true;
+    }
+    else if(_raised) {
+      _raised=false;
+    }
+    else {
+
+      // not already waiting: link on to the front of the list
+
+      if(task._waitingOn!=this) {
+
+        if((task._waitNext=_waiters)!=nullptr)
+          _waiters->_waitPrev=&task._waitNext;
+
+        _waiters=&task;
+        task._waitPrev=&_waiters;
+        task._waitingOn=this;
+      }
+
+      return false;
+    }
+
+    // the wait has ended early: stop the timeout if there is one
+
+    if(task._executor->_wheel)
+      task._executor->cancelTimer(task._timer);
+
+    return true;
+  }
+}
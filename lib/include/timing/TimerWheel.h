@@ -0,0 +1,446 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  class TimerWheel;
+
+
+  /**
+   * A one-shot or periodic timer registered with a TimerWheel. The entry is linked into the
+   * wheel directly so scheduling allocates nothing. It must stay in scope while it's
+   * pending: cancel it before it goes.
+   */
+
+  class TimerWheelEntry {
+
+    public:
+      typedef wink::slot<void (TimerWheelEntry&)> CallbackType;
+
+    protected:
+      TimerWheelEntry *_next;
+      TimerWheelEntry **_pprev;         // the pointer that points at us, nullptr when not pending
+      uint32_t _expires;
+      uint32_t _period;
+      uint8_t _level;
+      uint8_t _slot;
+      CallbackType _callback;
+
+      friend class TimerWheel;
+
+    public:
+      void *context;                    ///< free for the owner's use
+
+    public:
+
+      /**
+       * Constructor
+       * @param callback Called from TimerWheel::advance() when the timer expires
+       */
+
+      TimerWheelEntry(const CallbackType& callback)
+        : _pprev(nullptr),
+        _period(0),
+        _callback(callback),
+        context(nullptr) {
+      }
+
+      /**
+       * @return true if the timer is scheduled and hasn't expired yet
+       */
+
+      bool isPending() const {
+        return _pprev!=nullptr;
+      }
+
+      /**
+       * @return the tick at which the timer expires next
+       */
+
+      uint32_t getExpiry() const {
+        return _expires;
+      }
+  };
+
+
+  /**
+   * Hierarchical timer wheel. There are 4 levels of 64 slots. Level 0 has one slot per tick,
+   * and each higher level has slots 64 times longer than the level below. An entry goes in
+   * the level whose range covers its remaining time. When a level 0 rotation completes, the
+   * next slot up is cascaded back down. Scheduling and cancelling are O(1), expiry is O(1)
+   * per entry, and the range covers 2^24 ticks (about 4.6 hours at 1ms). Longer timers
+   * are parked at the top level and re-cascaded until they're due.
+   *
+   * The wheel doesn't read a clock. advance() is told the time, which can come from:
+   *
+   *   - MillisecondTimer: call advance(MillisecondTimer::millis()) from your SysTick
+   *     handler or the main loop.
+   *   - A hardware timer in tickless mode: see TimerWheelTimerDriver.
+   *   - A virtual clock when testing on a host.
+   *
+   * getNextDeadline() says when advance() next has work to do so the caller can sleep
+   * until then. Callbacks are run from advance() with interrupts enabled. They may schedule
+   * or cancel any entry, including their own. schedule() and cancel() may be called from
+   * any IRQ level.
+   */
+
+  class TimerWheel {
+
+    public:
+      enum {
+        LEVELS = 4,
+        SLOT_BITS = 6,
+        SLOTS = 1 << SLOT_BITS,
+        SLOT_MASK = SLOTS-1,
+        MAX_DELAY = (1UL << (LEVELS*SLOT_BITS))-1
+      };
+
+    protected:
+      TimerWheelEntry *_slots[LEVELS][SLOTS];
+      TimerWheelEntry *_expiring;       // the slot being run by expire()
+      uint64_t _occupied[LEVELS];       // bit per non-empty slot
+      volatile uint32_t _now;           // the last tick processed
+      uint32_t _count;
+
+    protected:
+      void insert(TimerWheelEntry& entry);
+      void unlink(TimerWheelEntry& entry);
+      void cascade(uint8_t level);
+      void expire(uint8_t slot);
+
+      static uint8_t lowestBit(uint64_t bits);
+
+    public:
+      TimerWheel(uint32_t now=0);
+
+      void schedule(TimerWheelEntry& entry,uint32_t delay,uint32_t period=0);
+      void scheduleAt(TimerWheelEntry& entry,uint32_t when,uint32_t period=0);
+      bool cancel(TimerWheelEntry& entry);
+
+      void advance(uint32_t now);
+      bool getNextDeadline(uint32_t& when) const;
+
+      /**
+       * @return the last tick processed by advance()
+       */
+
+      uint32_t getNow() const {
+        return _now;
+      }
+
+      /**
+       * @return the number of pending timers
+       */
+
+      uint32_t getCount() const {
+        return _count;
+      }
+  };
+
+
+  /**
+   * Constructor
+   * @param now The current time in ticks
+   */
+
+  inline TimerWheel::TimerWheel(uint32_t now)
+    : _expiring(nullptr),
+      _now(now),
+      _count(0) {
+
+    memset(_slots,0,sizeof(_slots));
+    memset(_occupied,0,sizeof(_occupied));
+  }
+
+
+  /**
+   * Schedule a timer relative to the last tick processed. A pending timer is moved.
+   * @param entry The timer
+   * @param delay Ticks until it expires, at least 1
+   * @param period Ticks between repeats, or zero for a one-shot. Periodic timers don't
+   *   drift: each expiry is one period after the last one was due, not after it ran.
+   */
+
+  inline void TimerWheel::schedule(TimerWheelEntry& entry,uint32_t delay,uint32_t period) {
+    scheduleAt(entry,_now+(delay ? delay : 1),period);
+  }
+
+
+  /**
+   * Schedule a timer at an absolute tick. A time in the past expires on the next advance().
+   * @param entry The timer
+   * @param when The tick at which to expire
+   * @param period Ticks between repeats, or zero for a one-shot
+   */
+
+  inline void TimerWheel::scheduleAt(TimerWheelEntry& entry,uint32_t when,uint32_t period) {
+
+    IrqSuspend suspender;
+
+    if(entry.isPending())
+      unlink(entry);
+
+    entry._expires=when;
+    entry._period=period;
+
+    insert(entry);
+  }
+
+
+  /**
+   * Cancel a timer
+   * @param entry The timer
+   * @return true if it was pending
+   */
+
+  inline bool TimerWheel::cancel(TimerWheelEntry& entry) {
+
+    IrqSuspend suspender;
+
+    if(!entry.isPending())
+      return false;
+
+    unlink(entry);
+    return true;
+  }
+
+
+  /**
+   * Process every tick up to and including now. Ticks with nothing to do are skipped, so a
+   * long sleep costs no more than the timers that were due during it.
+   * @param now The current time in ticks
+   */
+
+  inline void TimerWheel::advance(uint32_t now) {
+
+    uint32_t next,target;
+    uint64_t bits;
+    uint8_t slot;
+
+    while(static_cast<int32_t>(now-_now)>0) {
+
+      {
+        IrqSuspend suspender;
+
+        next=_now+1;
+        slot=next & SLOT_MASK;
+
+        // the first tick of a rotation pulls the next slot of each higher level down
+
+        if(slot==0) {
+          for(uint8_t level=1;level<LEVELS;level++) {
+            cascade(level);
+            if(((next >> (level*SLOT_BITS)) & SLOT_MASK)!=0)
+              break;
+          }
+        }
+
+        if((_occupied[0] & (1ULL << slot))==0) {
+
+          // skip to the next occupied slot in this rotation, the end of the rotation or now
+
+          bits=_occupied[0] >> slot;
+          target=bits ? next+lowestBit(bits) : (next | SLOT_MASK)+1;
+
+          if(static_cast<int32_t>(target-now)>0)
+            target=now+1;
+
+          _now=target-1;
+          continue;
+        }
+
+        _now=next;
+      }
+
+      expire(slot);
+    }
+  }
+
+
+  /**
+   * Get the next tick at which advance() has something to do. That's an expiry or a cascade
+   * that brings timers closer, so the answer may be earlier than the next expiry but is
+   * never later.
+   * @param[out] when The tick
+   * @return false if there are no timers
+   */
+
+  inline bool TimerWheel::getNextDeadline(uint32_t& when) const {
+
+    uint32_t next,base,candidate,span;
+    uint8_t start;
+    uint64_t bits;
+    bool found;
+
+    IrqSuspend suspender;
+
+    if(_count==0)
+      return false;
+
+    next=_now+1;
+    found=false;
+
+    for(uint8_t level=0;level<LEVELS;level++) {
+
+      if(!_occupied[level])
+        continue;
+
+      // level 0 slots expire at their tick, higher slots cascade at the start of theirs.
+      // The current slot of a higher level is only still to come if we're at its start.
+
+      span=1UL << (level*SLOT_BITS);
+      base=(next >> ((level+1)*SLOT_BITS)) << ((level+1)*SLOT_BITS);
+      start=(next >> (level*SLOT_BITS)) & SLOT_MASK;
+
+      if((next & (span-1))!=0)
+        start++;
+
+      bits=start<SLOTS ? _occupied[level] >> start : 0;
+
+      if(bits)
+        candidate=base+(start+lowestBit(bits))*span;
+      else
+        candidate=base+(SLOTS+lowestBit(_occupied[level]))*span;
+
+      if(!found || static_cast<int32_t>(candidate-when)<0) {
+        when=candidate;
+        found=true;
+      }
+    }
+
+    return found;
+  }
+
+
+  /**
+   * Link an entry into the level and slot that covers its remaining time
+   */
+
+  inline void TimerWheel::insert(TimerWheelEntry& entry) {
+
+    uint32_t next,delta,position;
+    uint8_t level;
+
+    next=_now+1;
+    delta=entry._expires-next;
+
+    if(static_cast<int32_t>(delta)<0)
+      delta=0;
+
+    if(delta>MAX_DELAY)
+      delta=MAX_DELAY;
+
+    // the lowest level whose range covers the delta
+
+    for(level=0;level<LEVELS-1 && delta>=(1UL << ((level+1)*SLOT_BITS));level++);
+
+    position=next+delta;
+
+    entry._level=level;
+    entry._slot=(position >> (level*SLOT_BITS)) & SLOT_MASK;
+
+    TimerWheelEntry *& head=_slots[level][entry._slot];
+
+    if((entry._next=head)!=nullptr)
+      head->_pprev=&entry._next;
+
+    head=&entry;
+    entry._pprev=&head;
+
+    _occupied[level]|=1ULL << entry._slot;
+    _count++;
+  }
+
+
+  /**
+   * Take an entry out of its slot, or the expiring list. The slot's bit is only cleared if
+   * the slot is now empty.
+   */
+
+  inline void TimerWheel::unlink(TimerWheelEntry& entry) {
+
+    if((*entry._pprev=entry._next)!=nullptr)
+      entry._next->_pprev=entry._pprev;
+
+    if(_slots[entry._level][entry._slot]==nullptr)
+      _occupied[entry._level]&=~(1ULL << entry._slot);
+
+    entry._pprev=nullptr;
+    _count--;
+  }
+
+
+  /**
+   * Re-insert every entry in the level's current slot. They land in lower levels.
+   */
+
+  inline void TimerWheel::cascade(uint8_t level) {
+
+    TimerWheelEntry *entry;
+    uint8_t slot;
+
+    slot=((_now+1) >> (level*SLOT_BITS)) & SLOT_MASK;
+
+    while((entry=_slots[level][slot])!=nullptr) {
+      unlink(*entry);
+      insert(*entry);
+    }
+  }
+
+
+  /**
+   * Run everything in a level 0 slot. The slot is moved to the expiring list first so that
+   * periodic timers re-linked into the same slot for the next rotation don't run again now.
+   * Each entry is unlinked, and re-linked if periodic, before its callback so that the
+   * callback can do what it likes with it, including cancelling others that are expiring.
+   */
+
+  inline void TimerWheel::expire(uint8_t slot) {
+
+    TimerWheelEntry *entry;
+
+    {
+      IrqSuspend suspender;
+
+      if((_expiring=_slots[0][slot])!=nullptr)
+        _expiring->_pprev=&_expiring;
+
+      _slots[0][slot]=nullptr;
+      _occupied[0]&=~(1ULL << slot);
+    }
+
+    for(;;) {
+
+      {
+        IrqSuspend suspender;
+
+        if((entry=_expiring)==nullptr)
+          return;
+
+        unlink(*entry);
+
+        if(entry->_period) {
+          entry->_expires+=entry->_period;
+          insert(*entry);
+        }
+      }
+
+      entry->_callback(*entry);
+    }
+  }
+
+
+  /**
+   * Index of the lowest set bit of a non-zero value
+   */
+
+  inline uint8_t TimerWheel::lowestBit(uint64_t bits) {
+    return __builtin_ctzll(bits);
+  }
+}
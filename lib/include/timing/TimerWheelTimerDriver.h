@@ -0,0 +1,235 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * Tickless driver for a TimerWheel. A hardware timer counts wheel ticks and its channel 1
+   * compare interrupt is programmed for the wheel's next deadline, so the CPU only
+   * wakes when there's something to do. The timer also wakes it once per 65536 ticks to
+   * extend the 16-bit counter to the wheel's 32-bit time. That's every 65 seconds at 1ms
+   * per tick. SysTick can be left stopped and the main loop can __WFI() whenever it's idle.
+   *
+   * Use a general purpose timer: the advanced timers have a separate compare IRQ. The timer
+   * must include its interrupt feature. Set it up to count up at the wheel's tick
+   * rate with an auto-reload of 0xffff, for example:
+   *
+   *   Timer4<Timer4InternalClockFeature,Timer4InterruptFeature> timer;
+   *   timer.setTimeBaseByFrequency(1000,0xffff);          // 1ms ticks
+   *
+   *   TimerWheel wheel;
+   *   TimerWheelTimerDriver<decltype(timer)> driver(timer,wheel);
+   *
+   *   driver.schedule(myEntry,250,250);                   // every 250ms
+   *
+   *   for(;;)
+   *     __WFI();
+   *
+   * Timer callbacks run in the timer's IRQ. Always schedule through this class so that the
+   * compare is moved when a new timer is earlier than the current deadline.
+   *
+   * @tparam TTimer The timer type
+   */
+
+  template<class TTimer>
+  class TimerWheelTimerDriver {
+
+    protected:
+      TTimer& _timer;
+      TimerWheel& _wheel;
+      volatile uint32_t _high;            // counter overflows << 16
+
+    protected:
+      void onInterrupt(TimerEventType tet,uint8_t timerNumber);
+      void reprogram(bool inCompareIrq);
+
+    public:
+      TimerWheelTimerDriver(TTimer& timer,TimerWheel& wheel);
+      ~TimerWheelTimerDriver();
+
+      uint32_t now() const;
+
+      void schedule(TimerWheelEntry& entry,uint32_t delay,uint32_t period=0);
+      bool cancel(TimerWheelEntry& entry);
+  };
+
+
+  /**
+   * Constructor. The wheel's time is taken as the start so the timer's counter is set to
+   * match it, and the timer is started.
+   * @param timer The timer, set up but not enabled
+   * @param wheel The wheel to drive
+   */
+
+  template<class TTimer>
+  inline TimerWheelTimerDriver<TTimer>::TimerWheelTimerDriver(TTimer& timer,TimerWheel& wheel)
+    : _timer(timer),
+      _wheel(wheel),
+      _high(wheel.getNow() & 0xffff0000) {
+
+    _timer.setCounter(wheel.getNow() & 0xffff);
+
+    _timer.TimerInterruptEventSender.insertSubscriber(
+        TimerInterruptEventSourceSlot::bind(this,&TimerWheelTimerDriver<TTimer>::onInterrupt)
+      );
+
+    // enabling both sets up the NVIC. The compare is switched on and off as needed.
+
+    _timer.clearPendingInterruptsFlag(TIM_IT_Update | TIM_IT_CC1);
+    _timer.enableInterrupts(TIM_IT_Update | TIM_IT_CC1);
+    _timer.Timer::enablePeripheral();
+
+    IrqSuspend suspender;
+    reprogram(false);
+  }
+
+
+  /**
+   * Destructor
+   */
+
+  template<class TTimer>
+  inline TimerWheelTimerDriver<TTimer>::~TimerWheelTimerDriver() {
+
+    _timer.Timer::disablePeripheral();
+    _timer.disableInterrupts(TIM_IT_Update | TIM_IT_CC1);
+
+    _timer.TimerInterruptEventSender.removeSubscriber(
+        TimerInterruptEventSourceSlot::bind(this,&TimerWheelTimerDriver<TTimer>::onInterrupt)
+      );
+  }
+
+
+  /**
+   * Get the current time in ticks. An overflow that hasn't been serviced yet is allowed for.
+   * @return The 32-bit time
+   */
+
+  template<class TTimer>
+  inline uint32_t TimerWheelTimerDriver<TTimer>::now() const {
+
+    uint32_t high,count;
+    TIM_TypeDef *peripheral;
+
+    IrqSuspend suspender;
+
+    peripheral=_timer;
+    high=_high;
+    count=peripheral->CNT & 0xffff;
+
+    if(TIM_GetFlagStatus(peripheral,TIM_FLAG_Update)==SET && count<0x8000)
+      high+=0x10000;
+
+    return high+count;
+  }
+
+
+  /**
+   * Schedule a timer relative to now
+   * @param entry The timer
+   * @param delay Ticks until it expires
+   * @param period Ticks between repeats, or zero for a one-shot
+   */
+
+  template<class TTimer>
+  inline void TimerWheelTimerDriver<TTimer>::schedule(TimerWheelEntry& entry,uint32_t delay,uint32_t period) {
+
+    IrqSuspend suspender;
+
+    // the wheel may be behind real time while the CPU sleeps so schedule absolutely
+
+    _wheel.scheduleAt(entry,now()+(delay ? delay : 1),period);
+    reprogram(false);
+  }
+
+
+  /**
+   * Cancel a timer. The compare is left alone: an early wake-up is harmless.
+   * @param entry The timer
+   * @return true if it was pending
+   */
+
+  template<class TTimer>
+  inline bool TimerWheelTimerDriver<TTimer>::cancel(TimerWheelEntry& entry) {
+    return _wheel.cancel(entry);
+  }
+
+
+  /**
+   * Timer interrupt. Extend the counter, run what's due and set up the next wake-up.
+   */
+
+  template<class TTimer>
+  inline void TimerWheelTimerDriver<TTimer>::onInterrupt(TimerEventType tet,uint8_t /* timerNumber */) {
+
+    // the IRQ handler clears the flag after raising the event. now() would count the
+    // overflow twice if it was still set.
+
+    if(tet==TimerEventType::EVENT_UPDATE) {
+      TIM_ClearITPendingBit(static_cast<TIM_TypeDef *>(_timer),TIM_IT_Update);
+      _high+=0x10000;
+    }
+    else if(tet!=TimerEventType::EVENT_COMPARE1)
+      return;
+
+    _wheel.advance(now());
+
+    IrqSuspend suspender;
+    reprogram(tet==TimerEventType::EVENT_COMPARE1);
+  }
+
+
+  /**
+   * Point the compare at the next deadline if it's within one counter period, otherwise
+   * rely on the overflow interrupt. If the deadline passes while it's being set then the
+   * wheel is advanced here, so in that rare case callbacks run with interrupts suspended.
+   * Called with interrupts suspended.
+   * @param inCompareIrq true in the compare IRQ, which clears the compare flag after we
+   *   return. A match on the very next tick could be lost so that case waits it out.
+   */
+
+  template<class TTimer>
+  inline void TimerWheelTimerDriver<TTimer>::reprogram(bool inCompareIrq) {
+
+    TIM_TypeDef *peripheral;
+    uint32_t when;
+    int32_t delta;
+
+    peripheral=_timer;
+
+    for(;;) {
+
+      if(!_wheel.getNextDeadline(when)) {
+        TIM_ITConfig(peripheral,TIM_IT_CC1,DISABLE);
+        return;
+      }
+
+      if((delta=static_cast<int32_t>(when-now()))>=0x10000) {
+        TIM_ITConfig(peripheral,TIM_IT_CC1,DISABLE);
+        return;
+      }
+
+      if(delta>0) {
+
+        TIM_SetCompare1(peripheral,when & 0xffff);
+        TIM_ClearITPendingBit(peripheral,TIM_IT_CC1);
+        TIM_ITConfig(peripheral,TIM_IT_CC1,ENABLE);
+
+        // still in the future after setting the compare: it will fire
+
+        if(static_cast<int32_t>(when-now())>(inCompareIrq ? 1 : 0))
+          return;
+
+        while(static_cast<int32_t>(when-now())>0);
+      }
+
+      _wheel.advance(now());
+    }
+  }
+}
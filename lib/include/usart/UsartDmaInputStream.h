@@ -0,0 +1,313 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+
+  /**
+   * @brief Input stream for the USART that receives by DMA into a ring buffer.
+   *
+   * The DMA channel runs the USART reader feature in circular mode so the hardware writes
+   * continuously into the ring and the current write position is simply the buffer size minus
+   * the DMA data counter. Reading is a copy out of the ring in at most two chunks with no per-byte
+   * interrupts or polling of the USART.
+   *
+   * The USART IDLE interrupt is used to detect the end of a burst. A multi-byte read() blocks
+   * until either all the requested data has arrived or the line has gone idle with some data
+   * waiting, in which case it returns that partial burst with actuallyRead set accordingly.
+   *
+   * The USART must be declared with its UsartInterruptFeature and the DMA channel must have
+   * only the UsartDmaReaderFeature so that its DMA_InitTypeDef can be switched to circular mode.
+   * The ring must be large enough to hold the data that arrives between reads because the DMA
+   * will overwrite unread data when it laps the reader.
+   *
+   * @tparam TUsart The USART peripheral type, e.g. Usart1<Usart1InterruptFeature>
+   * @tparam TDma The DMA channel type, e.g. Usart1RxDmaChannel<Usart1RxDmaFeature<>>
+   */
+
+  template<class TUsart,class TDma>
+  class UsartDmaInputStream : public InputStream {
+
+    protected:
+      TUsart& _usart;
+      TDma& _dma;
+      scoped_array<uint8_t> _buffer;
+      uint32_t _bufferSize;
+      uint32_t _readIndex;
+      volatile uint32_t _idleIndex;
+      volatile bool _idle;
+
+    protected:
+      void onInterrupt(UsartEventType uet);
+      uint32_t getWriteIndex();
+      uint32_t copyOut(uint8_t *dest,uint32_t size);
+
+    public:
+      UsartDmaInputStream(TUsart& usart,TDma& dma,uint32_t bufferSize);
+      virtual ~UsartDmaInputStream();
+
+      uint32_t dataAvailable();
+
+      // overrides from InputStream
+
+      virtual int16_t read() override;
+      virtual bool read(void *buffer,uint32_t size,uint32_t& actuallyRead) override;
+      virtual bool skip(uint32_t howMuch) override;
+      virtual bool available() override;
+
+      /**
+       * Doesn't do anything.
+       * @return always true
+       */
+
+      virtual bool close() override {
+        return true;
+      }
+
+      /**
+       * Not supported.
+       * @return always false and E_OPERATION_NOT_SUPPORTED
+       */
+
+      virtual bool reset() override {
+        return errorProvider.set(ErrorProvider::ERROR_PROVIDER_USART_INPUT_STREAM,E_OPERATION_NOT_SUPPORTED);
+      }
+  };
+
+
+  /**
+   * Constructor. Allocates the ring buffer, starts the circular DMA transfer and
+   * enables the USART IDLE interrupt.
+   * @param usart The USART peripheral
+   * @param dma The DMA channel with the USART reader feature
+   * @param bufferSize The size of the ring buffer in bytes
+   */
+
+  template<class TUsart,class TDma>
+  inline UsartDmaInputStream<TUsart,TDma>::UsartDmaInputStream(TUsart& usart,TDma& dma,uint32_t bufferSize)
+    : _usart(usart),
+      _dma(dma),
+      _buffer(new uint8_t[bufferSize]),
+      _bufferSize(bufferSize),
+      _readIndex(0),
+      _idleIndex(0),
+      _idle(false) {
+
+    // subscribe to the USART interrupts and enable IDLE
+
+    _usart.UsartInterruptEventSender.insertSubscriber(
+        UsartInterruptEventSourceSlot::bind(this,&UsartDmaInputStream<TUsart,TDma>::onInterrupt)
+      );
+
+    _usart.enableInterrupts(USART_IT_IDLE);
+
+    // start the circular transfer. On the F4 the FIFO must be off because bytes held in it
+    // have been counted off NDTR but aren't in the ring yet.
+
+    static_cast<DMA_InitTypeDef&>(_dma).DMA_Mode=DMA_Mode_Circular;
+
+#if defined(STM32PLUS_F4)
+    static_cast<DMA_InitTypeDef&>(_dma).DMA_FIFOMode=DMA_FIFOMode_Disable;
+#endif
+
+    _dma.beginRead(_buffer.get(),_bufferSize);
+  }
+
+
+  /**
+   * Destructor. Stop the DMA before the ring is freed.
+   */
+
+  template<class TUsart,class TDma>
+  inline UsartDmaInputStream<TUsart,TDma>::~UsartDmaInputStream() {
+
+    _usart.disableInterrupts(USART_IT_IDLE);
+
+    _usart.UsartInterruptEventSender.removeSubscriber(
+        UsartInterruptEventSourceSlot::bind(this,&UsartDmaInputStream<TUsart,TDma>::onInterrupt)
+      );
+
+    DMA_Cmd(_dma,DISABLE);
+  }
+
+
+  /**
+   * USART interrupt callback. The F1 and F4 can only clear the IDLE flag with a read of SR
+   * followed by a read of DR. If a byte has arrived then DR belongs to the DMA, and its read
+   * of DR after our read of SR clears IDLE for us. The ring position of the idle is latched
+   * with it so that read() can tell if it's stale.
+   * @param uet The event type
+   */
+
+  template<class TUsart,class TDma>
+  inline void UsartDmaInputStream<TUsart,TDma>::onInterrupt(UsartEventType uet) {
+
+    if(uet==UsartEventType::EVENT_IDLE) {
+
+#if !defined(STM32PLUS_F0)
+      if(USART_GetFlagStatus(_usart,USART_FLAG_RXNE)==RESET)
+        USART_ReceiveData(_usart);
+#endif
+
+      _idleIndex=getWriteIndex();
+      _idle=true;
+    }
+  }
+
+
+  /**
+   * Get the position in the ring that the DMA will write next
+   * @return The write index
+   */
+
+  template<class TUsart,class TDma>
+  inline uint32_t UsartDmaInputStream<TUsart,TDma>::getWriteIndex() {
+
+    uint32_t index;
+
+    // the counter can read as zero for an instant before it reloads
+
+    index=_bufferSize-DMA_GetCurrDataCounter(_dma);
+    return index==_bufferSize ? 0 : index;
+  }
+
+
+  /**
+   * Get the number of bytes waiting in the ring
+   * @return The number of bytes that can be read without blocking
+   */
+
+  template<class TUsart,class TDma>
+  inline uint32_t UsartDmaInputStream<TUsart,TDma>::dataAvailable() {
+
+    uint32_t writeIndex;
+
+    writeIndex=getWriteIndex();
+
+    if(writeIndex>=_readIndex)
+      return writeIndex-_readIndex;
+
+    return _bufferSize-_readIndex+writeIndex;
+  }
+
+
+  /**
+   * Copy out as much as is available up to the size requested. The copy is done in at
+   * most two chunks, one either side of the wrap point.
+   * @param dest Where to copy to, or nullptr to discard the data
+   * @param size The maximum to copy
+   * @return The number of bytes copied
+   */
+
+  template<class TUsart,class TDma>
+  inline uint32_t UsartDmaInputStream<TUsart,TDma>::copyOut(uint8_t *dest,uint32_t size) {
+
+    uint32_t count,chunk,remaining;
+
+    if((count=dataAvailable())>size)
+      count=size;
+
+    remaining=count;
+
+    while(remaining) {
+
+      chunk=std::min(remaining,_bufferSize-_readIndex);
+
+      if(dest) {
+        memcpy(dest,_buffer.get()+_readIndex,chunk);
+        dest+=chunk;
+      }
+
+      remaining-=chunk;
+
+      if((_readIndex+=chunk)==_bufferSize)
+        _readIndex=0;
+    }
+
+    return count;
+  }
+
+
+  /*
+   * Read a byte, blocking until one arrives
+   */
+
+  template<class TUsart,class TDma>
+  inline int16_t UsartDmaInputStream<TUsart,TDma>::read() {
+
+    uint8_t data;
+
+    while(getWriteIndex()==_readIndex);
+
+    data=_buffer[_readIndex];
+
+    if(++_readIndex==_bufferSize)
+      _readIndex=0;
+
+    return data;
+  }
+
+
+  /*
+   * Read many bytes. Blocks until all the bytes are read or the line goes idle
+   * with some data waiting.
+   */
+
+  template<class TUsart,class TDma>
+  inline bool UsartDmaInputStream<TUsart,TDma>::read(void *buffer,uint32_t size,uint32_t& actuallyRead) {
+
+    uint8_t *ptr;
+    uint32_t count;
+
+    ptr=static_cast<uint8_t *>(buffer);
+    actuallyRead=0;
+
+    while(actuallyRead<size) {
+
+      count=copyOut(ptr,size-actuallyRead);
+
+      ptr+=count;
+      actuallyRead+=count;
+
+      // end of a burst: hand back what we've got. The idle must be at the position we've
+      // read up to. One left over from an earlier burst is somewhere behind us and doesn't
+      // cut this read short.
+
+      if(_idle && actuallyRead>0 && _idleIndex==_readIndex && dataAvailable()==0) {
+        _idle=false;
+        break;
+      }
+    }
+
+    return true;
+  }
+
+
+  /*
+   * Skip forward, blocking until enough data has arrived
+   */
+
+  template<class TUsart,class TDma>
+  inline bool UsartDmaInputStream<TUsart,TDma>::skip(uint32_t howMuch) {
+
+    while(howMuch)
+      howMuch-=copyOut(nullptr,howMuch);
+
+    return true;
+  }
+
+
+  /*
+   * Check if data is available
+   */
+
+  template<class TUsart,class TDma>
+  inline bool UsartDmaInputStream<TUsart,TDma>::available() {
+    return getWriteIndex()!=_readIndex;
+  }
+}
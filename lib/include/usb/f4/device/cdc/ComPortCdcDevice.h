@@ -84,13 +84,12 @@ namespace stm32plus {
            }
          };
 
-       protected:
-
          enum {
            DATA_IN_EP_ADDRESS = EndpointDescriptor::IN | 1,     // data in endpoint address
            DATA_OUT_EP_ADDRESS = EndpointDescriptor::OUT | 1,   // data out endpoint address
          };
 
+       protected:
          uint16_t _maxInPacketSize;
          uint16_t _maxOutPacketSize;
          scoped_array<uint8_t> _rxBuffer;
@@ -112,8 +111,13 @@ namespace stm32plus {
         bool initialise(Parameters& params);
 
         bool transmit(const void *data,uint16_t len);
+        bool beginTransmit(const void *data,uint16_t len);
         bool isTransmittingData() const;
         void beginReceive();
+
+        uint16_t getMaxInPacketSize() const;
+        uint16_t getMaxOutPacketSize() const;
+        uint16_t getRxBufferSize() const;
     };
 
 
@@ -413,6 +417,31 @@ namespace stm32plus {
     }
 
 
+    /**
+     * Start a transmission without waiting for, or tracking, a previous one. This is for
+     * code that manages the IN endpoint itself from the CLASS_DATA_IN event, such as
+     * ComPortCdcOutputStream, and is safe to call from the USB IRQ. A zero length is allowed
+     * and sends a zero length packet. Don't mix this with transmit().
+     * @param data The data buffer to send. Must remain in scope until the CLASS_DATA_IN event.
+     * @param len The size of the data buffer
+     * @return true if it worked
+     */
+
+    template<class TPhy,template <class> class... Features>
+    inline bool ComPortCdcDevice<TPhy,Features...>::beginTransmit(const void *data,uint16_t len) {
+
+      USBD_StatusTypeDef status;
+
+      if(this->_deviceHandle.dev_state!=USBD_STATE_CONFIGURED)
+        return this->setError(ErrorProvider::ERROR_PROVIDER_USB_DEVICE,this->E_UNCONFIGURED);
+
+      if((status=USBD_LL_Transmit(&this->_deviceHandle,DATA_IN_EP_ADDRESS,(uint8_t *)data,len))!=USBD_OK)
+        return this->setError(ErrorProvider::ERROR_PROVIDER_USB_IN_ENDPOINT,ComPortCdcDeviceDataInEndpoint<Device<TPhy>>::E_TRANSMIT_FAILED,status);
+
+      return true;
+    }
+
+
     /**
      * Check if the bulk IN endpoint is transmitting
      * @return true if the endpoint is transmitting
@@ -438,5 +467,36 @@ namespace stm32plus {
           _rxBuffer.get(),
           _rxBufferSize);
     }
+
+
+    /**
+     * Get the maximum packet size of the bulk IN endpoint
+     */
+
+    template<class TPhy,template <class> class... Features>
+    inline uint16_t ComPortCdcDevice<TPhy,Features...>::getMaxInPacketSize() const {
+      return _maxInPacketSize;
+    }
+
+
+    /**
+     * Get the maximum packet size of the bulk OUT endpoint
+     */
+
+    template<class TPhy,template <class> class... Features>
+    inline uint16_t ComPortCdcDevice<TPhy,Features...>::getMaxOutPacketSize() const {
+      return _maxOutPacketSize;
+    }
+
+
+    /**
+     * Get the size of the buffer that beginReceive() receives into. A CdcDataReceivedEvent
+     * will never carry more than this.
+     */
+
+    template<class TPhy,template <class> class... Features>
+    inline uint16_t ComPortCdcDevice<TPhy,Features...>::getRxBufferSize() const {
+      return _rxBufferSize;
+    }
   }
 }
@@ -0,0 +1,321 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace usb {
+
+    /**
+     * @brief Input stream over the bulk OUT endpoint of a ComPortCdcDevice.
+     *
+     * Each CDC_DATA_RECEIVED event is copied by the USB IRQ into a ring buffer and the
+     * endpoint is re-armed straight away if the ring has room for another full receive buffer
+     * (ComPortCdcDevice::Parameters::cdc_com_port_rx_buffer_size). If it doesn't then the
+     * endpoint is left un-armed and the hardware NAKs the host until the application has read
+     * enough to make room, so data is never dropped. The IRQ is the only writer of the head
+     * and the application the only writer of the tail so the ring needs no locking.
+     *
+     * Don't call ComPortCdcDevice::beginReceive() yourself when this stream is in use.
+     *
+     * @tparam TDevice The ComPortCdcDevice type
+     */
+
+    template<class TDevice>
+    class ComPortCdcInputStream : public InputStream {
+
+      protected:
+        TDevice& _device;
+        scoped_array<uint8_t> _buffer;
+        uint32_t _bufferSize;
+        volatile uint32_t _head;              // next write, moved by the IRQ
+        volatile uint32_t _tail;              // next read, moved by the application
+        volatile bool _paused;                // endpoint not armed because the ring is full
+
+      protected:
+        void onEvent(UsbEventDescriptor& event);
+        void onDataReceived(const CdcDataReceivedEvent& event);
+
+        uint32_t spaceAvailable() const;
+        uint32_t copyOut(uint8_t *dest,uint32_t size);
+        void resume();
+
+      public:
+        ComPortCdcInputStream(TDevice& device,uint32_t bufferSize);
+        virtual ~ComPortCdcInputStream();
+
+        uint32_t dataAvailable() const;
+
+        // overrides from InputStream
+
+        virtual int16_t read() override;
+        virtual bool read(void *buffer,uint32_t size,uint32_t& actuallyRead) override;
+        virtual bool skip(uint32_t howMuch) override;
+        virtual bool available() override;
+
+        /**
+         * Doesn't do anything.
+         * @return always true
+         */
+
+        virtual bool close() override {
+          return true;
+        }
+
+        /**
+         * Not supported.
+         * @return always false and E_OPERATION_NOT_SUPPORTED
+         */
+
+        virtual bool reset() override {
+          return errorProvider.set(ErrorProvider::ERROR_PROVIDER_USB_DEVICE,E_OPERATION_NOT_SUPPORTED);
+        }
+    };
+
+
+    /**
+     * Constructor
+     * @param device The CDC device. Must not have been initialised yet so that the first
+     *   receive lands in this stream.
+     * @param bufferSize The ring size in bytes. Must be larger than the device's receive
+     *   buffer and should be several times larger for full bandwidth.
+     */
+
+    template<class TDevice>
+    inline ComPortCdcInputStream<TDevice>::ComPortCdcInputStream(TDevice& device,uint32_t bufferSize)
+      : _device(device),
+        _buffer(new uint8_t[bufferSize]),
+        _bufferSize(bufferSize),
+        _head(0),
+        _tail(0),
+        _paused(false) {
+
+      _device.UsbEventSender.insertSubscriber(
+          UsbEventSourceSlot::bind(this,&ComPortCdcInputStream<TDevice>::onEvent)
+        );
+    }
+
+
+    /**
+     * Destructor
+     */
+
+    template<class TDevice>
+    inline ComPortCdcInputStream<TDevice>::~ComPortCdcInputStream() {
+
+      _device.UsbEventSender.removeSubscriber(
+          UsbEventSourceSlot::bind(this,&ComPortCdcInputStream<TDevice>::onEvent)
+        );
+    }
+
+
+    /**
+     * Event handler, called in the USB IRQ
+     * @param event The event descriptor
+     */
+
+    template<class TDevice>
+    inline void ComPortCdcInputStream<TDevice>::onEvent(UsbEventDescriptor& event) {
+
+      switch(event.eventType) {
+
+        case UsbEventDescriptor::EventType::CDC_DATA_RECEIVED:
+          onDataReceived(static_cast<CdcDataReceivedEvent&>(event));
+          break;
+
+        case UsbEventDescriptor::EventType::CLASS_INIT:
+          _paused=false;                      // the device arms the endpoint itself on init
+          break;
+
+        default:
+          break;
+      }
+    }
+
+
+    /**
+     * Copy a received transfer into the ring and re-arm the endpoint if there's room for
+     * another one
+     * @param event The received data
+     */
+
+    template<class TDevice>
+    inline void ComPortCdcInputStream<TDevice>::onDataReceived(const CdcDataReceivedEvent& event) {
+
+      uint32_t size,chunk,head;
+      const uint8_t *src;
+
+      src=event.data;
+      head=_head;
+
+      // the endpoint is only ever armed when there's room so this can't truncate
+
+      size=std::min(event.size,spaceAvailable());
+
+      while(size) {
+
+        chunk=std::min(size,_bufferSize-head);
+        memcpy(_buffer.get()+head,src,chunk);
+
+        src+=chunk;
+        size-=chunk;
+
+        if((head+=chunk)==_bufferSize)
+          head=0;
+      }
+
+      _head=head;
+
+      if(spaceAvailable()>=_device.getRxBufferSize())
+        _device.beginReceive();
+      else
+        _paused=true;
+    }
+
+
+    /**
+     * Re-arm the endpoint if it was paused and there's now room. The IRQ can't change _paused
+     * while the endpoint is un-armed so the check outside the suspension is safe.
+     */
+
+    template<class TDevice>
+    inline void ComPortCdcInputStream<TDevice>::resume() {
+
+      if(_paused && spaceAvailable()>=_device.getRxBufferSize()) {
+
+        IrqSuspend suspender;
+
+        _paused=false;
+        _device.beginReceive();
+      }
+    }
+
+
+    /**
+     * Get the number of bytes waiting in the ring
+     * @return The number of bytes that can be read without blocking
+     */
+
+    template<class TDevice>
+    inline uint32_t ComPortCdcInputStream<TDevice>::dataAvailable() const {
+
+      uint32_t head,tail;
+
+      head=_head;
+      tail=_tail;
+
+      return head>=tail ? head-tail : _bufferSize-tail+head;
+    }
+
+
+    /**
+     * Get the free space in the ring. One byte is kept back to tell full from empty.
+     */
+
+    template<class TDevice>
+    inline uint32_t ComPortCdcInputStream<TDevice>::spaceAvailable() const {
+      return _bufferSize-1-dataAvailable();
+    }
+
+
+    /**
+     * Copy out as much as is available up to the size requested, in at most two chunks
+     * @param dest Where to copy to, or nullptr to discard the data
+     * @param size The maximum to copy
+     * @return The number of bytes copied
+     */
+
+    template<class TDevice>
+    inline uint32_t ComPortCdcInputStream<TDevice>::copyOut(uint8_t *dest,uint32_t size) {
+
+      uint32_t count,chunk,remaining,tail;
+
+      if((count=dataAvailable())>size)
+        count=size;
+
+      remaining=count;
+      tail=_tail;
+
+      while(remaining) {
+
+        chunk=std::min(remaining,_bufferSize-tail);
+
+        if(dest) {
+          memcpy(dest,_buffer.get()+tail,chunk);
+          dest+=chunk;
+        }
+
+        remaining-=chunk;
+
+        if((tail+=chunk)==_bufferSize)
+          tail=0;
+      }
+
+      _tail=tail;
+
+      if(count)
+        resume();
+
+      return count;
+    }
+
+
+    /*
+     * Read a byte, blocking until one arrives
+     */
+
+    template<class TDevice>
+    inline int16_t ComPortCdcInputStream<TDevice>::read() {
+
+      uint8_t data;
+
+      while(!copyOut(&data,1));
+      return data;
+    }
+
+
+    /*
+     * Read many bytes. Blocks until at least one byte is available and then returns as much
+     * as there is, up to size.
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcInputStream<TDevice>::read(void *buffer,uint32_t size,uint32_t& actuallyRead) {
+
+      actuallyRead=0;
+
+      if(size)
+        while((actuallyRead=copyOut(static_cast<uint8_t *>(buffer),size))==0);
+
+      return true;
+    }
+
+
+    /*
+     * Skip forward, blocking until enough data has arrived
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcInputStream<TDevice>::skip(uint32_t howMuch) {
+
+      while(howMuch)
+        howMuch-=copyOut(nullptr,howMuch);
+
+      return true;
+    }
+
+
+    /*
+     * Check if data is available
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcInputStream<TDevice>::available() {
+      return _head!=_tail;
+    }
+  }
+}
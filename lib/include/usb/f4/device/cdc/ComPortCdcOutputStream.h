@@ -0,0 +1,339 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#pragma once
+
+
+namespace stm32plus {
+  namespace usb {
+
+    /**
+     * @brief Output stream over the bulk IN endpoint of a ComPortCdcDevice.
+     *
+     * write() copies into a ring buffer and returns as soon as the data fits. If the endpoint
+     * is idle a transfer is started immediately. Everything written while a transfer is in
+     * flight is aggregated and sent as one multi-packet transfer from the completion
+     * interrupt, so the bus sees full size packets back to back instead of one small transfer
+     * per write() call. Data is sent straight out of the ring without copying.
+     *
+     * When the last transfer before the ring runs dry is an exact multiple of the packet size
+     * a zero length packet is sent after it so that the host's read completes.
+     *
+     * The IRQ is the only writer of the tail and the application the only writer of the head.
+     * Don't call ComPortCdcDevice::transmit() when this stream is in use.
+     *
+     * @tparam TDevice The ComPortCdcDevice type
+     */
+
+    template<class TDevice>
+    class ComPortCdcOutputStream : public OutputStream {
+
+      protected:
+        TDevice& _device;
+        scoped_array<uint8_t> _buffer;
+        uint32_t _bufferSize;
+        volatile uint32_t _head;              // next write, moved by the application
+        volatile uint32_t _tail;              // start of the oldest unsent data, moved by the IRQ
+        volatile uint32_t _inFlight;          // bytes in the transfer on the wire
+        volatile bool _busy;                  // a transfer, possibly a ZLP, is on the wire
+
+      protected:
+        void onEvent(UsbEventDescriptor& event);
+        void onDataIn();
+
+        uint32_t dataQueued() const;
+        void startTransfer();
+        void kick();
+        bool isConfigured();
+
+      public:
+        ComPortCdcOutputStream(TDevice& device,uint32_t bufferSize);
+        virtual ~ComPortCdcOutputStream();
+
+        uint32_t spaceAvailable() const;
+
+        // overrides from OutputStream
+
+        virtual bool write(uint8_t c) override;
+        virtual bool write(const void *buffer,uint32_t size) override;
+        virtual bool flush() override;
+        virtual bool close() override;
+    };
+
+
+    /**
+     * Constructor
+     * @param device The CDC device
+     * @param bufferSize The ring size in bytes. A few times the IN packet size is enough to
+     *   keep the endpoint streaming.
+     */
+
+    template<class TDevice>
+    inline ComPortCdcOutputStream<TDevice>::ComPortCdcOutputStream(TDevice& device,uint32_t bufferSize)
+      : _device(device),
+        _buffer(new uint8_t[bufferSize]),
+        _bufferSize(bufferSize),
+        _head(0),
+        _tail(0),
+        _inFlight(0),
+        _busy(false) {
+
+      _device.UsbEventSender.insertSubscriber(
+          UsbEventSourceSlot::bind(this,&ComPortCdcOutputStream<TDevice>::onEvent)
+        );
+    }
+
+
+    /**
+     * Destructor
+     */
+
+    template<class TDevice>
+    inline ComPortCdcOutputStream<TDevice>::~ComPortCdcOutputStream() {
+
+      _device.UsbEventSender.removeSubscriber(
+          UsbEventSourceSlot::bind(this,&ComPortCdcOutputStream<TDevice>::onEvent)
+        );
+    }
+
+
+    /**
+     * Event handler, called in the USB IRQ
+     * @param event The event descriptor
+     */
+
+    template<class TDevice>
+    inline void ComPortCdcOutputStream<TDevice>::onEvent(UsbEventDescriptor& event) {
+
+      switch(event.eventType) {
+
+        case UsbEventDescriptor::EventType::CLASS_DATA_IN:
+          if(static_cast<DeviceClassSdkDataInEvent&>(event).endpointNumber==(TDevice::DATA_IN_EP_ADDRESS & 0x7f))
+            onDataIn();
+          break;
+
+        case UsbEventDescriptor::EventType::CLASS_INIT:
+        case UsbEventDescriptor::EventType::CLASS_DEINIT:
+
+          // the host has gone or come back: anything queued is for a session that's over
+
+          _busy=false;
+          _inFlight=0;
+          _tail=_head;
+          break;
+
+        default:
+          break;
+      }
+    }
+
+
+    /**
+     * A transfer has completed. Release its data and send whatever has been queued since.
+     */
+
+    template<class TDevice>
+    inline void ComPortCdcOutputStream<TDevice>::onDataIn() {
+
+      uint32_t sent,tail;
+
+      sent=_inFlight;
+
+      if((tail=_tail+sent)>=_bufferSize)
+        tail-=_bufferSize;
+
+      _tail=tail;
+      _inFlight=0;
+      _busy=false;
+
+      if(dataQueued())
+        startTransfer();
+      else if(sent && (sent % _device.getMaxInPacketSize())==0) {
+
+        // the host can't tell the transfer ended on a packet boundary
+
+        _busy=true;
+        if(!_device.beginTransmit(nullptr,0))
+          _busy=false;
+      }
+    }
+
+
+    /**
+     * Start a transfer of as much of the queued data as is contiguous in the ring. When more
+     * data follows, the length is cut to whole packets so that the continuation starts a
+     * full packet. Called from the IRQ or with interrupts suspended.
+     */
+
+    template<class TDevice>
+    inline void ComPortCdcOutputStream<TDevice>::startTransfer() {
+
+      uint32_t queued,chunk,packetSize,whole;
+
+      if((queued=dataQueued())==0)
+        return;
+
+      packetSize=_device.getMaxInPacketSize();
+
+      chunk=std::min(queued,_bufferSize-_tail);
+      chunk=std::min(chunk,static_cast<uint32_t>(0xffff-(0xffff % packetSize)));
+
+      if(chunk<queued && (whole=chunk-(chunk % packetSize))!=0)
+        chunk=whole;
+
+      _inFlight=chunk;
+      _busy=true;
+
+      if(!_device.beginTransmit(_buffer.get()+_tail,chunk)) {
+        _inFlight=0;
+        _busy=false;
+      }
+    }
+
+
+    /**
+     * Start a transfer from the application if the endpoint is idle
+     */
+
+    template<class TDevice>
+    inline void ComPortCdcOutputStream<TDevice>::kick() {
+
+      if(!_busy) {
+
+        IrqSuspend suspender;
+
+        if(!_busy)
+          startTransfer();
+      }
+    }
+
+
+    /**
+     * Check the device is configured. Waiting for space when it isn't would never end.
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcOutputStream<TDevice>::isConfigured() {
+
+      if(_device.getDeviceHandle().dev_state!=USBD_STATE_CONFIGURED)
+        return _device.setError(ErrorProvider::ERROR_PROVIDER_USB_DEVICE,TDevice::E_UNCONFIGURED);
+
+      return true;
+    }
+
+
+    /**
+     * Get the number of bytes queued that are not yet part of a transfer
+     */
+
+    template<class TDevice>
+    inline uint32_t ComPortCdcOutputStream<TDevice>::dataQueued() const {
+
+      uint32_t head,tail;
+
+      head=_head;
+      tail=_tail;
+
+      return (head>=tail ? head-tail : _bufferSize-tail+head)-_inFlight;
+    }
+
+
+    /**
+     * Get the number of bytes that can be written without blocking
+     */
+
+    template<class TDevice>
+    inline uint32_t ComPortCdcOutputStream<TDevice>::spaceAvailable() const {
+
+      uint32_t head,tail;
+
+      head=_head;
+      tail=_tail;
+
+      return _bufferSize-1-(head>=tail ? head-tail : _bufferSize-tail+head);
+    }
+
+
+    /*
+     * Write a byte, blocking while the ring is full
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcOutputStream<TDevice>::write(uint8_t c) {
+      return write(&c,1);
+    }
+
+
+    /*
+     * Write many bytes, blocking while the ring is full
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcOutputStream<TDevice>::write(const void *buffer,uint32_t size) {
+
+      const uint8_t *src;
+      uint32_t chunk,head;
+
+      src=static_cast<const uint8_t *>(buffer);
+
+      while(size) {
+
+        if(!isConfigured())
+          return false;
+
+        // copy what fits, in at most two pieces
+
+        head=_head;
+
+        while(size && (chunk=std::min(std::min(size,spaceAvailable()),_bufferSize-head))!=0) {
+
+          memcpy(_buffer.get()+head,src,chunk);
+
+          src+=chunk;
+          size-=chunk;
+
+          if((head+=chunk)==_bufferSize)
+            head=0;
+
+          _head=head;
+        }
+
+        kick();
+      }
+
+      return true;
+    }
+
+
+    /*
+     * Wait until everything has been sent to the host
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcOutputStream<TDevice>::flush() {
+
+      while(_busy || _head!=_tail) {
+
+        if(!isConfigured())
+          return false;
+
+        kick();
+      }
+
+      return true;
+    }
+
+
+    /*
+     * Flush the stream
+     */
+
+    template<class TDevice>
+    inline bool ComPortCdcOutputStream<TDevice>::close() {
+      return flush();
+    }
+  }
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#include "config/stm32plus.h"
+#include "config/debug.h"
+#include "config/concurrent.h"
+
+
+#if defined(STM32PLUS_HEAP_PROFILER)
+
+namespace stm32plus {
+
+  /**
+   * Get the global profiler
+   * @return The profiler
+   */
+
+  HeapProfiler& getHeapProfiler() {
+
+    static HeapProfiler profiler;
+    return profiler;
+  }
+
+
+  /**
+   * Allocate from the underlying heap and record it. IRQs are suspended because neither the
+   * heap nor the profiler is reentrant.
+   * @param size The number of bytes the application wants
+   * @param address The return address of the application's call
+   * @return The memory, or nullptr
+   */
+
+  void *profiledAllocate(uint32_t size,const void *address) {
+
+    void *block;
+
+    IrqSuspend suspender;
+
+#if defined(STM32PLUS_ALLOCATOR_POOL)
+    block=getPoolHeap().allocate(size+HeapProfiler::HEADER_SIZE);
+#else
+    block=malloc(size+HeapProfiler::HEADER_SIZE);
+#endif
+
+    return getHeapProfiler().recordAllocation(block,size,address);
+  }
+
+
+  /**
+   * Record a free and give the block back to the underlying heap. IRQs are suspended as for
+   * profiledAllocate().
+   * @param ptr The memory from profiledAllocate(), or nullptr
+   */
+
+  void profiledFree(void *ptr) {
+
+    void *block;
+
+    IrqSuspend suspender;
+
+    if((block=getHeapProfiler().recordFree(ptr))==nullptr)
+      return;
+
+#if defined(STM32PLUS_ALLOCATOR_POOL)
+    getPoolHeap().free(block);
+#else
+    free(block);
+#endif
+  }
+}
+
+
+/*
+ * C linkage hooks used by the bundled STL's malloc allocator (stl/stl_alloc.h)
+ */
+
+extern "C" {
+
+  void *stm32plus_malloc(size_t size) {
+    return stm32plus::profiledAllocate(size,__builtin_return_address(0));
+  }
+
+  void stm32plus_free(void *ptr) {
+    stm32plus::profiledFree(ptr);
+  }
+
+  void *stm32plus_realloc(void *ptr,size_t size) {
+
+    void *newptr;
+    uint32_t oldSize;
+
+    if(!ptr)
+      return stm32plus::profiledAllocate(size,__builtin_return_address(0));
+
+    // always move so that the new size is charged to the caller
+
+    if((newptr=stm32plus::profiledAllocate(size,__builtin_return_address(0)))==nullptr)
+      return nullptr;
+
+    oldSize=stm32plus::getHeapProfiler().allocationSize(ptr);
+    memcpy(newptr,ptr,oldSize<size ? oldSize : size);
+
+    stm32plus::profiledFree(ptr);
+    return newptr;
+  }
+}
+
+#endif
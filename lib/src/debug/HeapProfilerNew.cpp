@@ -0,0 +1,43 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#include "config/stm32plus.h"
+#include "config/debug.h"
+
+
+#if defined(STM32PLUS_HEAP_PROFILER)
+
+/*
+ * Global new and delete that record the caller with the heap profiler. These are in their
+ * own object so that the linker only pulls them in if the application doesn't define its
+ * own. To profile new and delete remove the malloc based versions from your LibraryHacks.cpp.
+ */
+
+void *operator new(size_t size) {
+  return stm32plus::profiledAllocate(size,__builtin_return_address(0));
+}
+
+void *operator new[](size_t size) {
+  return stm32plus::profiledAllocate(size,__builtin_return_address(0));
+}
+
+void operator delete(void *p) {
+  stm32plus::profiledFree(p);
+}
+
+void operator delete[](void *p) {
+  stm32plus::profiledFree(p);
+}
+
+void operator delete(void *p,size_t) {
+  stm32plus::profiledFree(p);
+}
+
+void operator delete[](void *p,size_t) {
+  stm32plus::profiledFree(p);
+}
+
+#endif
@@ -17,6 +17,9 @@
 //     can come off the stack. Without this you'd pay the 3Kb penalty for the entire life
 //     of your app. With this, you pay only while you do the JPEG decode.
 //  -- move the whole lot into the stm32plus::display namespace
+//  -- widen the input buffer offsets so that the source stream can be read in large,
+//     sector-sized chunks. The stuffing area is now separate from the read area.
+//  -- short-circuit the IDCT for blocks, rows and columns that have no AC coefficients.
 
 #include "config/stm32plus.h"
 #include "config/display/tft.h"
@@ -97,8 +100,8 @@ namespace stm32plus {
 
     static uint8_t gTemFlag;
     static uint8_t *gInBuf;
-    static uint8_t gInBufOfs;
-    static uint8_t gInBufLeft;
+    static uint16_t gInBufOfs;
+    static uint16_t gInBufLeft;
 
     static uint16_t gBitBuf;
     static uint8_t gBitsLeft;
@@ -138,10 +141,11 @@ namespace stm32plus {
       uint32_t actuallyRead;
 
       // Reserve a few bytes at the beginning of the buffer for putting back ("stuffing") chars.
-      gInBufOfs=4;
+      // The read itself is always a full MAX_IN_BUF_SIZE so that block devices see aligned requests.
+      gInBufOfs=PJPG_STUFF_BUF_SIZE;
       gInBufLeft=0;
 
-      gDataSource->read(gInBuf + gInBufOfs,MAX_IN_BUF_SIZE - gInBufOfs,actuallyRead);
+      gDataSource->read(gInBuf + gInBufOfs,MAX_IN_BUF_SIZE,actuallyRead);
       gInBufLeft=actuallyRead;
     }
 
@@ -1091,6 +1095,15 @@ namespace stm32plus {
       int16_t* pSrc=gCoeffBuf;
 
       for(i=0;i < 8;i++) {
+
+        // a row with no AC terms transforms to its DC value in every column
+
+        if((pSrc[1] | pSrc[2] | pSrc[3] | pSrc[4] | pSrc[5] | pSrc[6] | pSrc[7])==0) {
+          pSrc[1]=pSrc[2]=pSrc[3]=pSrc[4]=pSrc[5]=pSrc[6]=pSrc[7]=pSrc[0];
+          pSrc+=8;
+          continue;
+        }
+
         int16_t src4=*(pSrc + 5);
         int16_t src7=*(pSrc + 3);
         int16_t x4=src4 - src7;
@@ -1149,6 +1162,19 @@ namespace stm32plus {
       int16_t* pSrc=gCoeffBuf;
 
       for(i=0;i < 8;i++) {
+
+        // likewise a column with no AC terms is a constant
+
+        if((pSrc[1*8] | pSrc[2*8] | pSrc[3*8] | pSrc[4*8] | pSrc[5*8] | pSrc[6*8] | pSrc[7*8])==0) {
+
+          int16_t dc=clamp(DESCALE(pSrc[0]) + 128);
+
+          pSrc[0*8]=pSrc[1*8]=pSrc[2*8]=pSrc[3*8]=dc;
+          pSrc[4*8]=pSrc[5*8]=pSrc[6*8]=pSrc[7*8]=dc;
+          pSrc++;
+          continue;
+        }
+
         int16_t src4=*(pSrc + 5 * 8);
         int16_t src7=*(pSrc + 3 * 8);
         int16_t x4=src4 - src7;
@@ -1365,9 +1391,31 @@ namespace stm32plus {
       }
     }
     /*----------------------------------------------------------------------------*/
-    static void transformBlock(uint8_t mcuBlock) {
-      idctRows();
-      idctCols();
+    static void idctDCOnly(void) {
+
+      uint8_t i;
+      int16_t dc,*pSrc;
+
+      // with no AC terms both IDCT passes reduce to a constant block
+
+      dc=clamp(DESCALE(gCoeffBuf[0]) + 128);
+      pSrc=gCoeffBuf;
+
+      for(i=0;i < 64;i+=8) {
+        pSrc[0]=pSrc[1]=pSrc[2]=pSrc[3]=dc;
+        pSrc[4]=pSrc[5]=pSrc[6]=pSrc[7]=dc;
+        pSrc+=8;
+      }
+    }
+    /*----------------------------------------------------------------------------*/
+    static void transformBlock(uint8_t mcuBlock,bool dcOnly) {
+
+      if(dcOnly)
+        idctDCOnly();
+      else {
+        idctRows();
+        idctCols();
+      }
 
       switch(gScanType) {
         case PJPG_GRAYSCALE: {
@@ -1511,10 +1559,18 @@ namespace stm32plus {
           }
         }
 
-        while(k < 64)
-          gCoeffBuf[ZAG[k++]]=0;
+        // an end-of-block as the first AC symbol leaves a DC-only block that does not
+        // need the coefficient buffer cleared or the full IDCT run over it
 
-        transformBlock(mcuBlock);
+        if(k==1)
+          transformBlock(mcuBlock,true);
+        else {
+
+          while(k < 64)
+            gCoeffBuf[ZAG[k++]]=0;
+
+          transformBlock(mcuBlock,false);
+        }
       }
 
       return 0;
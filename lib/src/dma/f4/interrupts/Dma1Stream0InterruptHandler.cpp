@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA1_Stream0_IRQHandler() {
 
       if(DMA_GetITStatus(DMA1_Stream0,DMA_IT_TCIF0)!=RESET) {
-        DmaInterruptFeature<1,0>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<1,0>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<1,0>::getCompleteEventType(DMA1_Stream0));
         DMA_ClearITPendingBit(DMA1_Stream0,DMA_IT_TCIF0);
       }
       else if(DMA_GetITStatus(DMA1_Stream0,DMA_IT_HTIF0)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA1_Stream1_IRQHandler() {
 
       if(DMA_GetITStatus(DMA1_Stream1,DMA_IT_TCIF1)!=RESET) {
-        DmaInterruptFeature<1,1>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<1,1>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<1,1>::getCompleteEventType(DMA1_Stream1));
         DMA_ClearITPendingBit(DMA1_Stream1,DMA_IT_TCIF1);
       }
       else if(DMA_GetITStatus(DMA1_Stream1,DMA_IT_HTIF1)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA1_Stream2_IRQHandler() {
 
       if(DMA_GetITStatus(DMA1_Stream2,DMA_IT_TCIF2)!=RESET) {
-        DmaInterruptFeature<1,2>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<1,2>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<1,2>::getCompleteEventType(DMA1_Stream2));
         DMA_ClearITPendingBit(DMA1_Stream2,DMA_IT_TCIF2);
       }
       else if(DMA_GetITStatus(DMA1_Stream2,DMA_IT_HTIF2)!=RESET) {
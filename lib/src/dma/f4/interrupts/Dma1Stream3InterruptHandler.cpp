@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA1_Stream3_IRQHandler() {
 
       if(DMA_GetITStatus(DMA1_Stream3,DMA_IT_TCIF3)!=RESET) {
-        DmaInterruptFeature<1,3>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<1,3>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<1,3>::getCompleteEventType(DMA1_Stream3));
         DMA_ClearITPendingBit(DMA1_Stream3,DMA_IT_TCIF3);
       }
       else if(DMA_GetITStatus(DMA1_Stream3,DMA_IT_HTIF3)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA1_Stream4_IRQHandler() {
 
       if(DMA_GetITStatus(DMA1_Stream4,DMA_IT_TCIF4)!=RESET) {
-        DmaInterruptFeature<1,4>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<1,4>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<1,4>::getCompleteEventType(DMA1_Stream4));
         DMA_ClearITPendingBit(DMA1_Stream4,DMA_IT_TCIF4);
       }
       else if(DMA_GetITStatus(DMA1_Stream4,DMA_IT_HTIF4)!=RESET) {
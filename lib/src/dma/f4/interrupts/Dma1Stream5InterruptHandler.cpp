@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA1_Stream5_IRQHandler() {
 
       if(DMA_GetITStatus(DMA1_Stream5,DMA_IT_TCIF5)!=RESET) {
-        DmaInterruptFeature<1,5>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<1,5>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<1,5>::getCompleteEventType(DMA1_Stream5));
         DMA_ClearITPendingBit(DMA1_Stream5,DMA_IT_TCIF5);
       }
       else if(DMA_GetITStatus(DMA1_Stream5,DMA_IT_HTIF5)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA1_Stream7_IRQHandler() {
 
       if(DMA_GetITStatus(DMA1_Stream7,DMA_IT_TCIF7)!=RESET) {
-        DmaInterruptFeature<1,7>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<1,7>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<1,7>::getCompleteEventType(DMA1_Stream7));
         DMA_ClearITPendingBit(DMA1_Stream7,DMA_IT_TCIF7);
       }
       else if(DMA_GetITStatus(DMA1_Stream7,DMA_IT_HTIF7)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream0_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream0,DMA_IT_TCIF0)!=RESET) {
-        DmaInterruptFeature<2,0>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,0>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,0>::getCompleteEventType(DMA2_Stream0));
         DMA_ClearITPendingBit(DMA2_Stream0,DMA_IT_TCIF0);
       }
       else if(DMA_GetITStatus(DMA2_Stream0,DMA_IT_HTIF0)!=RESET) {
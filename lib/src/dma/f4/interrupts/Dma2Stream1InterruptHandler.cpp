@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream1_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream1,DMA_IT_TCIF1)!=RESET) {
-        DmaInterruptFeature<2,1>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,1>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,1>::getCompleteEventType(DMA2_Stream1));
         DMA_ClearITPendingBit(DMA2_Stream1,DMA_IT_TCIF1);
       }
       else if(DMA_GetITStatus(DMA2_Stream1,DMA_IT_HTIF1)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream2_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream2,DMA_IT_TCIF2)!=RESET) {
-        DmaInterruptFeature<2,2>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,2>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,2>::getCompleteEventType(DMA2_Stream2));
         DMA_ClearITPendingBit(DMA2_Stream2,DMA_IT_TCIF2);
       }
       else if(DMA_GetITStatus(DMA2_Stream2,DMA_IT_HTIF2)!=RESET) {
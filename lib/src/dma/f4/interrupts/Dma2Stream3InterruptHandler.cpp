@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream3_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream3,DMA_IT_TCIF3)!=RESET) {
-        DmaInterruptFeature<2,3>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,3>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,3>::getCompleteEventType(DMA2_Stream3));
         DMA_ClearITPendingBit(DMA2_Stream3,DMA_IT_TCIF3);
       }
       else if(DMA_GetITStatus(DMA2_Stream3,DMA_IT_HTIF3)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream4_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream4,DMA_IT_TCIF4)!=RESET) {
-        DmaInterruptFeature<2,4>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,4>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,4>::getCompleteEventType(DMA2_Stream4));
         DMA_ClearITPendingBit(DMA2_Stream4,DMA_IT_TCIF4);
       }
       else if(DMA_GetITStatus(DMA2_Stream4,DMA_IT_HTIF4)!=RESET) {
@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream5_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream5,DMA_IT_TCIF5)!=RESET) {
-        DmaInterruptFeature<2,5>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,5>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,5>::getCompleteEventType(DMA2_Stream5));
         DMA_ClearITPendingBit(DMA2_Stream5,DMA_IT_TCIF5);
       }
       else if(DMA_GetITStatus(DMA2_Stream5,DMA_IT_HTIF5)!=RESET) {
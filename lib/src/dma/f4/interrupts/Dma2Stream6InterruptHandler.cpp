@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream6_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream6,DMA_IT_TCIF6)!=RESET) {
-        DmaInterruptFeature<2,6>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,6>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,6>::getCompleteEventType(DMA2_Stream6));
         DMA_ClearITPendingBit(DMA2_Stream6,DMA_IT_TCIF6);
       }
       else if(DMA_GetITStatus(DMA2_Stream6,DMA_IT_HTIF6)!=RESET) {
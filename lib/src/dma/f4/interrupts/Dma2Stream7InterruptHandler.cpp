@@ -30,7 +30,7 @@ extern "C" {
     void __attribute__ ((interrupt("IRQ"))) DMA2_Stream7_IRQHandler() {
 
       if(DMA_GetITStatus(DMA2_Stream7,DMA_IT_TCIF7)!=RESET) {
-        DmaInterruptFeature<2,7>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaEventType::EVENT_COMPLETE);
+        DmaInterruptFeature<2,7>::_dmaInstance->DmaInterruptEventSender.raiseEvent(DmaInterruptFeature<2,7>::getCompleteEventType(DMA2_Stream7));
         DMA_ClearITPendingBit(DMA2_Stream7,DMA_IT_TCIF7);
       }
       else if(DMA_GetITStatus(DMA2_Stream7,DMA_IT_HTIF7)!=RESET) {
@@ -66,6 +66,29 @@ namespace stm32plus {
         if(_offset % sectorSize == 0 && !_iterator.next())
           return false;
 
+        // whole sectors that are contiguous in this cluster go straight into the caller's
+        // buffer in one multi-block read. The SDIO DMA needs a word aligned buffer so an
+        // unaligned one is bounced through the sector buffer.
+
+        remainingInFile=fileLength - _offset;
+
+        if(sectorOffset == 0 && size_ >= sectorSize && remainingInFile >= sectorSize && (reinterpret_cast<uintptr_t>(current) & 3) == 0) {
+
+          copySize=std::min(std::min(size_,remainingInFile) / sectorSize,_iterator.getSectorsRemainingInCluster());
+
+          if(!_iterator.readSectors(current,copySize))
+            return false;
+
+          copySize*=sectorSize;
+
+          size_-=copySize;
+          current+=copySize;
+          _offset+=copySize;
+          actuallyRead_+=copySize;
+
+          continue;
+        }
+
         // read a sector
 
         if(!_iterator.readSector(_sectorBuffer))
@@ -73,7 +96,6 @@ namespace stm32plus {
 
         // calculate the copy size
 
-        remainingInFile=fileLength - _offset;
         available=remainingInFile < sectorSize - sectorOffset ? remainingInFile : sectorSize - sectorOffset;
         copySize=size_ < available ? size_ : available;
 
@@ -162,6 +184,28 @@ namespace stm32plus {
           dirent.sdir.DIR_FstClusHI=_iterator.getClusterNumber() >> 16;
         }
 
+        // whole sectors that are contiguous in this cluster are written straight from the
+        // caller's buffer in one multi-block write if it's word aligned for the SDIO DMA
+
+        if(size_ >= sectorSize && (reinterpret_cast<uintptr_t>(current) & 3) == 0) {
+
+          amountToCopy=std::min(size_ / sectorSize,_iterator.getSectorsRemainingInCluster());
+
+          if(!_iterator.writeSectors(current,amountToCopy))
+            return false;
+
+          amountToCopy*=sectorSize;
+
+          current+=amountToCopy;
+          size_-=amountToCopy;
+          _offset+=amountToCopy;
+
+          if(_offset > dirent.sdir.DIR_FileSize)
+            dirent.sdir.DIR_FileSize=_offset;
+
+          continue;
+        }
+
         if(size_ < sectorSize && getLength() != _offset) {
 
           // must be the last part to write, and we are not at the end of the file
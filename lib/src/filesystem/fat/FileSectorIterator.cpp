@@ -91,6 +91,52 @@ namespace stm32plus {
     }
 
 
+  /**
+   * Get the number of sectors from the current one to the end of the cluster, including the current one.
+   * @return The number of sectors that can be transferred with readSectors() or writeSectors().
+   */
+
+    uint32_t FileSectorIterator::getSectorsRemainingInCluster() const {
+      return _sectorsPerCluster-_sectorIndexInCluster;
+    }
+
+
+  /**
+   * Read consecutive sectors from the cluster, starting at the current sector. The iterator
+   * is left on the last sector read so the next call to next() moves past it.
+   * @param buffer_ A caller-supplied buffer that will receive the sector data.
+   * @param count_ The number of sectors. Must not exceed getSectorsRemainingInCluster().
+   * @return false if the read fails.
+   */
+
+    bool FileSectorIterator::readSectors(void *buffer_,uint32_t count_) {
+
+      if(!_fs.readSectorsFromCluster(_iterator.current(),_sectorIndexInCluster,buffer_,count_))
+        return false;
+
+      _sectorIndexInCluster+=count_-1;
+      return true;
+    }
+
+
+  /**
+   * Write consecutive sectors to the cluster, starting at the current sector. The iterator
+   * is left on the last sector written so the next call to next() moves past it.
+   * @param buffer_ A caller supplied buffer that holds the sector data to write.
+   * @param count_ The number of sectors. Must not exceed getSectorsRemainingInCluster().
+   * @return false if the write fails.
+   */
+
+    bool FileSectorIterator::writeSectors(const void *buffer_,uint32_t count_) {
+
+      if(!_fs.writeSectorsToCluster(_iterator.current(),_sectorIndexInCluster,buffer_,count_))
+        return false;
+
+      _sectorIndexInCluster+=count_-1;
+      return true;
+    }
+
+
   /**
    * Return the current sector number.
    * @return The number of the current sector (a linear sequence from the start of the device).
@@ -229,6 +229,36 @@ namespace stm32plus {
   }
 
 
+  /**
+   * Address the slave for writing and see if it acknowledges. This is the 'ACK polling' that
+   * devices such as EEPROMs use to signal the end of an internal write cycle: they ignore
+   * their address until the cycle is over.
+   * @return true if the slave acknowledged, false if it didn't or there was a timeout. The
+   *   error provider is only set for the timeout.
+   */
+
+  bool I2CMasterPollingFeature::isSlaveReady() const {
+
+    bool ready;
+
+    // a zero length write. The peripheral generates the STOP after either the ACK or the NACK.
+
+    I2C_TransferHandling(_i2c,_slaveAddress,0,I2C_AutoEnd_Mode,I2C_Generate_Start_Write);
+
+    // wait for STOPF
+
+    if(!checkEvent(I2C_ISR_STOPF))
+      return false;
+
+    ready=I2C_GetFlagStatus(_i2c,I2C_ISR_NACKF)==RESET;
+
+    // clear STOPF and NACKF
+
+    I2C_ClearFlag(_i2c,I2C_ICR_STOPCF | I2C_ICR_NACKCF);
+    return ready;
+  }
+
+
   /**
    * Check that an event has occurred, or timeout
    * @param eventId The event to check
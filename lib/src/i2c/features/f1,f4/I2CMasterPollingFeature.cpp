@@ -209,6 +209,58 @@ namespace stm32plus {
   }
 
 
+  /**
+   * Address the slave for writing and see if it acknowledges. This is the 'ACK polling' that
+   * devices such as EEPROMs use to signal the end of an internal write cycle: they ignore
+   * their address until the cycle is over.
+   * @return true if the slave acknowledged, false if it didn't or there was a timeout. The
+   *   error provider is only set for the timeout.
+   */
+
+  bool I2CMasterPollingFeature::isSlaveReady() const {
+
+    uint32_t timeoutStart;
+
+    // generate the start condition
+
+    I2C_GenerateSTART(_i2c,ENABLE);
+
+    // Test on I2C EV5 and clear it
+
+    if(!checkEvent(I2C_EVENT_MASTER_MODE_SELECT))
+      return false;
+
+    // send the slave address and wait for either ADDR (ACK) or AF (NACK)
+
+    I2C_Send7bitAddress(_i2c,_slaveAddress,I2C_Direction_Transmitter);
+
+    timeoutStart=MillisecondTimer::millis();
+
+    for(;;) {
+
+      if(I2C_GetFlagStatus(_i2c,I2C_FLAG_ADDR)!=RESET) {
+
+        // reading SR1 then SR2 clears ADDR
+
+        I2C_GetLastEvent(_i2c);
+        I2C_GenerateSTOP(_i2c,ENABLE);
+        return true;
+      }
+
+      if(I2C_GetFlagStatus(_i2c,I2C_FLAG_AF)!=RESET) {
+        I2C_GenerateSTOP(_i2c,ENABLE);
+        I2C_ClearFlag(_i2c,I2C_FLAG_AF);
+        return false;
+      }
+
+      if(MillisecondTimer::millis()-timeoutStart>_timeout) {
+        I2C_GenerateSTOP(_i2c,ENABLE);
+        return errorProvider.set(ErrorProvider::ERROR_PROVIDER_I2C,I2C::E_I2C_TIMEOUT);
+      }
+    }
+  }
+
+
   /**
    * Check that an event has occurred, or timeout
    * @param eventId The event to check
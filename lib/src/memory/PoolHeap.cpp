@@ -0,0 +1,96 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#include "config/stm32plus.h"
+#include "config/allocator.h"
+#include "config/concurrent.h"
+
+
+#if defined(STM32PLUS_ALLOCATOR_POOL)
+
+/*
+ * The size of the default arena. Override configurePoolHeap() if you need a different size
+ * without rebuilding the library.
+ */
+
+#if !defined(STM32PLUS_POOL_HEAP_SIZE)
+#define STM32PLUS_POOL_HEAP_SIZE 16384
+#endif
+
+
+namespace stm32plus {
+
+  /**
+   * Default heap configuration: a static arena with size classes suited to the network
+   * stack's packet headers and STL nodes. Replace this by defining your own
+   * configurePoolHeap(PoolHeap&) that calls heap.initialise().
+   * @param heap The global heap
+   */
+
+  void __attribute__((weak)) configurePoolHeap(PoolHeap& heap) {
+
+    static const PoolHeap::Definition pools[]={
+      { 16,STM32PLUS_POOL_HEAP_SIZE/256 },
+      { 32,STM32PLUS_POOL_HEAP_SIZE/512 },
+      { 64,STM32PLUS_POOL_HEAP_SIZE/1024 },
+      { 128,STM32PLUS_POOL_HEAP_SIZE/2048 }
+    };
+
+    static uint64_t arena[STM32PLUS_POOL_HEAP_SIZE/sizeof(uint64_t)];
+
+    heap.initialise(arena,sizeof(arena),pools,sizeof(pools)/sizeof(pools[0]));
+  }
+
+
+  /**
+   * Get the global heap, configuring it on first use. That may be from a static
+   * constructor so it can't rely on being set up by main().
+   * @return The global heap
+   */
+
+  PoolHeap& getPoolHeap() {
+
+    static PoolHeap heap;
+    static bool configured=false;
+
+    if(!configured) {
+      configured=true;
+      configurePoolHeap(heap);
+    }
+
+    return heap;
+  }
+}
+
+
+/*
+ * C linkage hooks used by the bundled STL's malloc allocator (stl/stl_alloc.h). The heap
+ * profiler supplies its own that forward to the pool heap. The heap isn't reentrant so IRQs
+ * are suspended around each call, the same job that __malloc_lock() does for newlib.
+ */
+
+#if !defined(STM32PLUS_HEAP_PROFILER)
+
+extern "C" {
+
+  void *stm32plus_malloc(size_t size) {
+    stm32plus::IrqSuspend suspender;
+    return stm32plus::getPoolHeap().allocate(size);
+  }
+
+  void stm32plus_free(void *ptr) {
+    stm32plus::IrqSuspend suspender;
+    stm32plus::getPoolHeap().free(ptr);
+  }
+
+  void *stm32plus_realloc(void *ptr,size_t size) {
+    stm32plus::IrqSuspend suspender;
+    return stm32plus::getPoolHeap().reallocate(ptr,size);
+  }
+}
+
+#endif
+#endif
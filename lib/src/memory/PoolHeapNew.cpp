@@ -0,0 +1,51 @@
+/*
+ * This file is a part of the open source stm32plus library.
+ * Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+ * Please see website for licensing terms.
+ */
+
+#include "config/stm32plus.h"
+#include "config/allocator.h"
+#include "config/concurrent.h"
+
+
+#if defined(STM32PLUS_ALLOCATOR_POOL) && !defined(STM32PLUS_HEAP_PROFILER)
+
+/*
+ * Global new and delete backed by the pool heap. These are in their own object so that the
+ * linker only pulls them in if the application doesn't define its own. To use them remove
+ * the malloc based versions from your LibraryHacks.cpp. IRQs are suspended around each call
+ * because the heap isn't reentrant.
+ */
+
+void *operator new(size_t size) {
+  stm32plus::IrqSuspend suspender;
+  return stm32plus::getPoolHeap().allocate(size);
+}
+
+void *operator new[](size_t size) {
+  stm32plus::IrqSuspend suspender;
+  return stm32plus::getPoolHeap().allocate(size);
+}
+
+void operator delete(void *p) {
+  stm32plus::IrqSuspend suspender;
+  stm32plus::getPoolHeap().free(p);
+}
+
+void operator delete[](void *p) {
+  stm32plus::IrqSuspend suspender;
+  stm32plus::getPoolHeap().free(p);
+}
+
+void operator delete(void *p,size_t) {
+  stm32plus::IrqSuspend suspender;
+  stm32plus::getPoolHeap().free(p);
+}
+
+void operator delete[](void *p,size_t) {
+  stm32plus::IrqSuspend suspender;
+  stm32plus::getPoolHeap().free(p);
+}
+
+#endif
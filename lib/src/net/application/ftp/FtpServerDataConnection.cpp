@@ -18,10 +18,9 @@ namespace stm32plus {
 
 
     /**
-     * Constructor. As this is the data connection and most activity is likely to be downloading
-     * we will boost the output streams buffer size to 2*MTU so that the delayed ACK avoidance
-     * algorithm that sends size/2 bytes-per send will result in MTU bytes being sent per segment.
-     * Typically this will result in a buffer size of 1460*2 = 2920 bytes per data connection.
+     * Constructor. As this is the data connection the output streams buffer is large (4Kb by default)
+     * so that each send pushes out several full segments and file reads are sector aligned multi-block
+     * transfers. The transfer buffer for uploads and listings is allocated here, once.
      * @param params The TCP parameters
      * @param serverbase The command connection that we belong to
      */
@@ -31,6 +30,10 @@ namespace stm32plus {
         _commandConnection(serverbase),
         _outputStreams(*this,serverbase->getDataConnectionSendBufferSize()),
         _direction(Direction::NOT_STARTED),
+        _transferBuffer(new uint8_t[serverbase->getDataConnectionTransferBufferSize()]),
+        _transferBufferSize(serverbase->getDataConnectionTransferBufferSize()),
+        _transferBufferUsed(0),
+        _listingFailed(false),
         _state(State::NOT_STARTED) {
     }
 
@@ -74,45 +77,81 @@ namespace stm32plus {
 
 
     /**
-     * Handle the possibility of a read. Read out the received data in chunks until
-     * we've got it all. A chunk size is 512b which matches the SD card sector size
-     * though it's likely we'll fragment somewhere during the transfer and end up straddling
-     * sectors.
+     * Handle the possibility of a read. The received data is accumulated in the transfer buffer
+     * and written to the upload stream a full buffer at a time so that the stream sees large,
+     * sector aligned writes. The remainder is written when the client closes the connection.
      * @return true if there were no errors (being closed is not an error)
      */
 
     bool FtpServerDataConnection::handleRead() {
 
-      uint32_t actuallyRead,totalRead;
-      uint8_t transferBuffer[UPLOAD_TRANSFER_BUFFER_SIZE];      // default is 512 bytes
+      uint32_t available,actuallyRead,totalRead;
 
       // transfer out all data
 
       totalRead=0;
-      while(getDataAvailable()>0) {
+      while((available=getDataAvailable())>0) {
 
-        // receive any data available
+        // receive what's available straight into the free space in the transfer buffer. Never ask
+        // for more than is available because receive() would block waiting for it.
 
-        if(!receive(transferBuffer,UPLOAD_TRANSFER_BUFFER_SIZE,actuallyRead))
-          return false;
-
-        // write back to the stream
+        available=std::min(available,static_cast<uint32_t>(_transferBufferSize-_transferBufferUsed));
 
-        if(actuallyRead>0 && !_uploadStream->write(transferBuffer,actuallyRead))
+        if(!receive(_transferBuffer.get()+_transferBufferUsed,available,actuallyRead))
           return false;
 
+        _transferBufferUsed+=actuallyRead;
         totalRead+=actuallyRead;
+
+        // write to the stream when full
+
+        if(_transferBufferUsed==_transferBufferSize && !flushTransferBuffer())
+          return false;
       }
 
       if(totalRead)
         _commandConnection->updateLastActiveTime();
 
+      // the client closes the connection at the end of the upload
+
+      if(isRemoteEndClosed() && !flushTransferBuffer())
+        return false;
+
       return true;
     }
 
 
     /**
-     * Flush all pending data when reading
+     * Write out the transfer buffer. For an upload it goes to the upload stream. For a download
+     * (a directory listing) it's queued on the output streams. Nothing is sent to the client
+     * until flush() because the listing is built before the 150 reply goes out.
+     * @return true if it worked
+     */
+
+    bool FtpServerDataConnection::flushTransferBuffer() {
+
+      std::string *str;
+      uint16_t count;
+
+      if(_transferBufferUsed==0)
+        return true;
+
+      count=_transferBufferUsed;
+      _transferBufferUsed=0;
+
+      if(_direction==Direction::UPLOAD)
+        return _uploadStream->write(_transferBuffer.get(),count);
+
+      if((str=new std::string(reinterpret_cast<const char *>(_transferBuffer.get()),count))==nullptr)
+        return false;
+
+      addStream(new StlStringInputStream(str,true),true);
+      return true;
+    }
+
+
+    /**
+     * Flush all pending data when reading. For a directory listing this is where it's sent.
      * @return true if it worked
      */
 
@@ -120,6 +159,9 @@ namespace stm32plus {
 
       if(_direction==Direction::DOWNLOAD) {
 
+        if(_listingFailed || !flushTransferBuffer())
+          return false;
+
         while(!_outputStreams.completed())
           if(!handleWrite())
             return false;
@@ -141,30 +183,52 @@ namespace stm32plus {
       // if uploading then the remote end closing == finished
 
       if(_direction==Direction::DOWNLOAD)
-        return _state==State::RUNNING && _outputStreams.completed();
+        return _state==State::RUNNING && _outputStreams.completed() && _transferBufferUsed==0;
       else if(_direction==Direction::UPLOAD)
-        return getDataAvailable()==0 && isRemoteEndClosed();
+        return getDataAvailable()==0 && isRemoteEndClosed() && _transferBufferUsed==0;
       else
         return false;
     }
 
 
     /**
-     * Add a new string to the output streams
+     * Add a line of text, e.g. a directory listing entry. The text and a CRLF are appended to
+     * the transfer buffer. A full buffer is queued on the output streams and everything is
+     * sent to the client by flush(). A failure is remembered and reported by flush().
+     * @param str The line to add, without the CRLF
+     * @return true if it worked
      */
 
-    void FtpServerDataConnection::addString(const char *str) {
+    bool FtpServerDataConnection::addString(const char *str) {
+
+      uint32_t len,count;
 
-      std::string *newstr;
+      _state=State::RUNNING;
+
+      if(_listingFailed)
+        return false;
 
-      newstr=new std::string(str);
-      (*newstr)+="\r\n";
+      for(len=strlen(str);len;len-=count,str+=count) {
 
-      addStream(
-        new StlStringInputStream(
-            newstr,true),
-            true
-          );
+        if(_transferBufferUsed==_transferBufferSize && !flushTransferBuffer()) {
+          _listingFailed=true;
+          return false;
+        }
+
+        count=std::min(len,static_cast<uint32_t>(_transferBufferSize-_transferBufferUsed));
+        memcpy(_transferBuffer.get()+_transferBufferUsed,str,count);
+        _transferBufferUsed+=count;
+      }
+
+      if(_transferBufferSize-_transferBufferUsed<2 && !flushTransferBuffer()) {
+        _listingFailed=true;
+        return false;
+      }
+
+      _transferBuffer[_transferBufferUsed++]='\r';
+      _transferBuffer[_transferBufferUsed++]='\n';
+
+      return true;
     }
 
 
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the open source stm32plus library.
+# Copyright (c) 2011,2012,2013,2014 Andy Brown <www.andybrown.me.uk>
+# Please see website for licensing terms.
+#
+# Generate a C++ header containing an HttpStaticAssetBundle from a directory of web assets.
+# Each file is stored uncompressed and gzip-compressed (when that's smaller), with its response
+# headers and ETag computed here so that nothing needs to be formatted at runtime.
+#
+# usage: httpassets.py [options] <asset-directory> <output-header>
+#
+
+import argparse
+import gzip
+import hashlib
+import os
+import sys
+
+CONTENT_TYPES = {
+  "htm": "text/html",
+  "html": "text/html",
+  "js": "application/javascript",
+  "css": "text/css",
+  "json": "application/json",
+  "txt": "text/plain",
+  "svg": "image/svg+xml",
+  "png": "image/png",
+  "jpg": "image/jpeg",
+  "jpeg": "image/jpeg",
+  "gif": "image/gif",
+  "ico": "image/x-icon",
+  "pdf": "application/pdf",
+  "woff": "font/woff",
+  "woff2": "font/woff2",
+}
+
+# these are already compressed, gzip won't help
+
+INCOMPRESSIBLE = { "png", "jpg", "jpeg", "gif", "woff", "woff2" }
+
+
+def c_string(s):
+  return '"' + s.replace("\\", "\\\\").replace('"', '\\"').replace("\r", "\\r").replace("\n", "\\n") + '"'
+
+
+def c_bytes(data):
+  lines = []
+  for i in range(0, len(data), 16):
+    lines.append("  " + ",".join("0x%02x" % b for b in data[i:i+16]) + ",")
+  return "\n".join(lines)
+
+
+def make_headers(content_type, etag, cache_control, gzipped, vary):
+  headers = "Content-Type: %s\r\n" % content_type
+  headers += "ETag: %s\r\n" % etag
+  headers += "Cache-Control: %s\r\n" % cache_control
+  headers += "Accept-Ranges: bytes\r\n"
+  if gzipped:
+    headers += "Content-Encoding: gzip\r\n"
+  if vary:
+    headers += "Vary: Accept-Encoding\r\n"
+  return headers
+
+
+def main():
+
+  parser = argparse.ArgumentParser(description="Generate a static asset bundle for HttpStaticAssetConnection")
+  parser.add_argument("directory", help="the directory containing the assets")
+  parser.add_argument("output", help="the C++ header file to write")
+  parser.add_argument("--name", default="WebAssets", help="prefix for the generated identifiers")
+  parser.add_argument("--cache-control", default="no-cache", help="the Cache-Control header value")
+  parser.add_argument("--gzip-only", action="store_true", help="drop the uncompressed body when a gzip body is stored")
+  args = parser.parse_args()
+
+  assets = []
+
+  for root, dirs, files in os.walk(args.directory):
+    dirs.sort()
+    for filename in sorted(files):
+      fullpath = os.path.join(root, filename)
+      path = "/" + os.path.relpath(fullpath, args.directory).replace(os.sep, "/")
+      ext = filename.rsplit(".", 1)[-1].lower() if "." in filename else ""
+      with open(fullpath, "rb") as f:
+        data = f.read()
+      assets.append((path, ext, data))
+
+  # the bundle is binary searched with strcmp so it must be in byte order
+
+  assets.sort(key=lambda a: a[0].encode("utf-8"))
+
+  out = []
+  out.append("/*")
+  out.append(" * Generated by utils/httpassets/httpassets.py. Do not edit.")
+  out.append(" */")
+  out.append("")
+  out.append("#pragma once")
+  out.append("")
+  out.append("")
+
+  entries = []
+
+  for index, (path, ext, data) in enumerate(assets):
+
+    content_type = CONTENT_TYPES.get(ext, "application/octet-stream")
+
+    gzdata = None
+    if ext not in INCOMPRESSIBLE:
+      compressed = gzip.compress(data, compresslevel=9, mtime=0)
+      if len(compressed) < len(data):
+        gzdata = compressed
+
+    identity = data if gzdata is None or not args.gzip_only else None
+    vary = gzdata is not None and identity is not None
+
+    reps = []
+    for body, gzipped in ((identity, False), (gzdata, True)):
+      if body is None:
+        reps.append("{ nullptr,nullptr,nullptr,0,0 }")
+        continue
+
+      etag = '"%s"' % hashlib.sha1(body).hexdigest()[:16]
+      headers = make_headers(content_type, etag, args.cache_control, gzipped, vary)
+      symbol = "%s_%d_%s" % (args.name, index, "gz" if gzipped else "id")
+
+      out.append("// %s%s, %d bytes" % (path, " (gzip)" if gzipped else "", len(body)))
+      out.append("")
+      out.append("static const uint8_t %s[]={" % symbol)
+      out.append(c_bytes(body))
+      out.append("};")
+      out.append("")
+
+      reps.append("{ %s,%s,%s,0,%d }" % (c_string(headers), c_string(etag), symbol, len(body)))
+
+    entries.append("  { %s,\n    %s,\n    %s }" % (c_string(path), reps[0], reps[1]))
+
+  out.append("")
+  out.append("static const stm32plus::net::HttpStaticAsset %s[]={" % args.name)
+  out.append(",\n".join(entries))
+  out.append("};")
+  out.append("")
+  out.append("static const uint16_t %sCount=%d;" % (args.name, len(assets)))
+  out.append("")
+
+  with open(args.output, "w") as f:
+    f.write("\n".join(out))
+
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())